@@ -7,22 +7,28 @@
 
 //#define DEBUG 1
 
-#include <asm/unaligned.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/gpio/consumer.h>
 #include <linux/i2c.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/workqueue.h>
 #include <media/v4l2-ctrls.h>
 #include <media/v4l2-device.h>
 #include <media/v4l2-event.h>
 #include <media/v4l2-fwnode.h>
 #include <media/v4l2-mediabus.h>
+#include <media/mipi-csi2.h>
 
 #include "fr_imx662_regs.h"
 #include "fr_max96792.h"
 #include "fr_max96793.h"
+#include "fr_sensor_core.h"
+#include "fr_stats.h"
+#include "fr_sync_group.h"
+#include "fr_trace.h"
 
 #define IMX662_K_FACTOR				1000LL
 #define IMX662_M_FACTOR				1000000LL
@@ -35,12 +41,16 @@
 #define IMX662_LINK_FREQ_720			(720000000/2)
 #define IMX662_LINK_FREQ_594			(594000000/2)
 
-#define IMX662_MODE_STANDBY			0x01
-#define IMX662_MODE_STREAMING			0x00
+#define IMX662_STANDBY_SETTLE_US		29000
+#define IMX662_FRAME_SYNC_EVENTS		4
 
 #define IMX662_MIN_SHR0_LENGTH			4
 #define IMX662_MIN_INTEGRATION_LINES		1
 
+#define IMX662_HMAX_MAX				0xFFFF
+#define IMX662_VMAX_MAX				0xFFFFF
+#define IMX662_VMAX_STEP			2
+
 #define IMX662_ANA_GAIN_MIN			0
 #define IMX662_ANA_GAIN_MAX			240
 #define IMX662_ANA_GAIN_STEP			1
@@ -69,15 +79,15 @@ enum pad_types {
 #define IMX662_PIXEL_ARRAY_WIDTH	1920U
 #define IMX662_PIXEL_ARRAY_HEIGHT	1080U
 
+#define IMX662_WINDOW_H_STEP		4U
+#define IMX662_WINDOW_V_STEP		2U
+#define IMX662_WINDOW_H_OFFSET		8U
+#define IMX662_WINDOW_V_OFFSET		12U
+
 #define V4L2_CID_FRAME_RATE		(V4L2_CID_USER_IMX_BASE + 1)
 #define V4L2_CID_OPERATION_MODE		(V4L2_CID_USER_IMX_BASE + 2)
 #define V4L2_CID_SYNC_MODE		(V4L2_CID_USER_IMX_BASE + 3)
 
-struct imx662_reg_list {
-	unsigned int num_of_regs;
-	const struct imx662_reg *regs;
-};
-
 struct imx662_mode {
 
 	unsigned int width;
@@ -87,8 +97,8 @@ struct imx662_mode {
 	unsigned int min_fps;
 	unsigned int hmax;
 	struct v4l2_rect crop;
-	struct imx662_reg_list reg_list;
-	struct imx662_reg_list reg_list_format;
+	struct fr_sensor_reg_list reg_list;
+	struct fr_sensor_reg_list reg_list_format;
 };
 
 static const s64 imx662_link_freq_menu[] = {
@@ -131,8 +141,8 @@ static const struct imx662_mode modes_12bit[] = {
 		.pixel_rate = 96000000,
 		.min_fps = 1000000,
 		.crop = {
-			.left = 0,
-			.top = 0,
+			.left = 320,
+			.top = 180,
 			.width = IMX662_1280x720_WIDTH,
 			.height = IMX662_1280x720_HEIGHT,
 		},
@@ -154,8 +164,8 @@ static const struct imx662_mode modes_12bit[] = {
 		.pixel_rate = 48000000,
 		.min_fps = 1000000,
 		.crop = {
-			.left = 0,
-			.top = 0,
+			.left = 632,
+			.top = 300,
 			.width = IMX662_640x480_WIDTH,
 			.height = IMX662_640x480_HEIGHT,
 		},
@@ -226,8 +236,8 @@ static const struct imx662_mode modes_10bit[] = {
 		.pixel_rate = 144000000,
 		.min_fps = 1000000,
 		.crop = {
-			.left = 0,
-			.top = 0,
+			.left = 320,
+			.top = 180,
 			.width = IMX662_1280x720_WIDTH,
 			.height = IMX662_1280x720_HEIGHT,
 		},
@@ -249,8 +259,8 @@ static const struct imx662_mode modes_10bit[] = {
 		.pixel_rate = 72000000,
 		.min_fps = 1000000,
 		.crop = {
-			.left = 0,
-			.top = 0,
+			.left = 632,
+			.top = 300,
 			.width = IMX662_640x480_WIDTH,
 			.height = IMX662_640x480_HEIGHT,
 		},
@@ -274,43 +284,36 @@ static const u32 codes[] = {
 };
 
 struct imx662 {
-	struct v4l2_subdev sd;
-	struct media_pad pad[NUM_PADS];
+	struct fr_sensor core;
 
-	unsigned int fmt_code;
+	struct media_pad pad[NUM_PADS];
 
-	struct gpio_desc *reset_gpio;
 	struct gpio_desc *xmaster;
 
 	struct v4l2_ctrl_handler ctrl_handler;
 	struct v4l2_ctrl *pixel_rate;
 	struct v4l2_ctrl *link_freq;
 	struct v4l2_ctrl *exposure;
-	struct v4l2_ctrl *framerate;
 	struct v4l2_ctrl *operation_mode;
 	struct v4l2_ctrl *sync_mode;
 	struct v4l2_ctrl *vflip;
 	struct v4l2_ctrl *hflip;
-	struct v4l2_ctrl *vblank;
-	struct v4l2_ctrl *hblank;
 	struct v4l2_ctrl *blklvl;
 
-	u64 line_time;
-	u32 frame_length;
-
-	const char *gmsl;
-	struct device *ser_dev;
-	struct device *dser_dev;
-	struct gmsl_link_ctx g_ctx;
-
 	const struct imx662_mode *mode;
-	struct mutex mutex;
-	bool streaming;
+	struct v4l2_rect crop;
+
+	struct dentry *debugfs;
 };
 
 static inline struct imx662 *to_imx662(struct v4l2_subdev *_sd)
 {
-	return container_of(_sd, struct imx662, sd);
+	return container_of(_sd, struct imx662, core.sd);
+}
+
+static inline struct imx662 *core_to_imx662(struct fr_sensor *core)
+{
+	return container_of(core, struct imx662, core);
 }
 
 static inline void get_mode_table(unsigned int code,
@@ -365,116 +368,11 @@ static const char * const imx662_sync_mode_menu[] = {
 
 };
 
-static int imx662_read_reg(struct imx662 *imx662, u16 reg, u32 len, u32 *val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
-	struct i2c_msg msgs[2];
-	u8 addr_buf[2] = { reg >> 8, reg & 0xff };
-	u8 data_buf[4] = { 0, };
-	int ret;
-
-	if (len > 4)
-		return -EINVAL;
-
-	msgs[0].addr = client->addr;
-	msgs[0].flags = 0;
-	msgs[0].len = ARRAY_SIZE(addr_buf);
-	msgs[0].buf = addr_buf;
-
-	msgs[1].addr = client->addr;
-	msgs[1].flags = I2C_M_RD;
-	msgs[1].len = len;
-	msgs[1].buf = &data_buf[4 - len];
-
-	ret = i2c_transfer(client->adapter, msgs, ARRAY_SIZE(msgs));
-	if (ret != ARRAY_SIZE(msgs))
-		return -EIO;
-
-	*val = get_unaligned_be32(data_buf);
-
-	return 0;
-}
-
-static int imx662_write_reg(struct imx662 *imx662, u16 reg, u32 len, u32 val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
-	u8 buf[6];
-
-	if (len > 4)
-		return -EINVAL;
-
-	put_unaligned_be16(reg, buf);
-	put_unaligned_le32(val, buf + 2);
-
-	if (i2c_master_send(client, buf, len + 2) != len + 2)
-		return -EIO;
-
-	return 0;
-}
-
-static int imx662_write_hold_reg(struct imx662 *imx662, u16 reg, u32 len, u32 val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
-	struct device *dev = &client->dev;
-	int ret;
-
-	ret = imx662_write_reg(imx662, REGHOLD, 1, 0x01);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n",
-								__func__);
-		return ret;
-	}
-
-	ret = imx662_write_reg(imx662, reg, len, val);
-	if (ret)
-		goto reghold_off;
-
-	ret = imx662_write_reg(imx662, REGHOLD, 1, 0x00);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n",
-								__func__);
-		return ret;
-	}
-
-	return 0;
-
-reghold_off:
-	ret = imx662_write_reg(imx662, REGHOLD, 1, 0x00);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n",
-								__func__);
-		return ret;
-	}
-	return ret;
-
-}
-
-static int imx662_write_table(struct imx662 *imx662,
-				 const struct imx662_reg *regs, u32 len)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
-	unsigned int i;
-	int ret;
-
-	for (i = 0; i < len; i++) {
-		ret = imx662_write_reg(imx662, regs[i].address, 1, regs[i].val);
-		if (ret) {
-			dev_err_ratelimited(&client->dev,
-					"Failed to write reg 0x%4.4x. error = %d\n",
-					regs[i].address, ret);
-
-			return ret;
-		}
-	}
-
-	return 0;
-}
-
 static u32 imx662_get_format_code(struct imx662 *imx662, u32 code)
 {
 	unsigned int i;
 
-	lockdep_assert_held(&imx662->mutex);
+	lockdep_assert_held(&imx662->core.mutex);
 
 	for (i = 0; i < ARRAY_SIZE(codes); i++)
 		if (codes[i] == code)
@@ -495,7 +393,7 @@ static int imx662_open(struct v4l2_subdev *sd, struct v4l2_subdev_fh *fh)
 		v4l2_subdev_get_try_format(sd, fh->state, METADATA_PAD);
 	struct v4l2_rect *try_crop;
 
-	mutex_lock(&imx662->mutex);
+	mutex_lock(&imx662->core.mutex);
 
 	try_fmt_img->width = modes_12bit[0].width;
 	try_fmt_img->height = modes_12bit[0].height;
@@ -514,7 +412,7 @@ static int imx662_open(struct v4l2_subdev *sd, struct v4l2_subdev_fh *fh)
 	try_crop->width = IMX662_PIXEL_ARRAY_WIDTH;
 	try_crop->height = IMX662_PIXEL_ARRAY_HEIGHT;
 
-	mutex_unlock(&imx662->mutex);
+	mutex_unlock(&imx662->core.mutex);
 
 	return 0;
 }
@@ -529,17 +427,23 @@ static bool imx662_is_binning_mode(struct imx662 *imx662)
 		return false;
 }
 
+static bool imx662_is_window_mode(const struct imx662_mode *mode)
+{
+	return mode->reg_list.regs == mode_crop_1280x720 ||
+	       mode->reg_list.regs == mode_crop_640x480;
+}
+
 static int imx662_set_exposure(struct imx662 *imx662, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
 	struct device *dev = &client->dev;
 	const struct imx662_mode *mode = imx662->mode;
 	u64 exposure;
 	int ret;
 
-	exposure = imx662->vblank->val + mode->height - val;
+	exposure = imx662->core.vblank->val + mode->height - val;
 
-	ret = imx662_write_hold_reg(imx662, SHR0_LOW, 3, exposure);
+	ret = fr_sensor_write_hold_reg(&imx662->core, SHR0_LOW, 3, exposure);
 	if (ret) {
 		dev_err(dev, "%s failed to set exposure\n", __func__);
 		return ret;
@@ -553,7 +457,7 @@ static void imx662_adjust_exposure_range(struct imx662 *imx662)
 	const struct imx662_mode *mode = imx662->mode;
 	u64 exposure_max;
 
-	exposure_max = imx662->vblank->val + mode->height - IMX662_MIN_SHR0_LENGTH;
+	exposure_max = imx662->core.vblank->val + mode->height - IMX662_MIN_SHR0_LENGTH;
 
 	__v4l2_ctrl_modify_range(imx662->exposure, IMX662_MIN_INTEGRATION_LINES,
 				exposure_max, 1,
@@ -562,11 +466,12 @@ static void imx662_adjust_exposure_range(struct imx662 *imx662)
 
 static int imx662_set_frame_rate(struct imx662 *imx662, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
-	ret = imx662_write_hold_reg(imx662, VMAX_LOW, 3, imx662->frame_length);
+	ret = fr_sensor_write_hold_reg(&imx662->core, VMAX_LOW, 3,
+				imx662->core.frame_length);
 
 	if (ret) {
 		dev_err(dev, "%s failed to set frame rate\n", __func__);
@@ -577,52 +482,83 @@ static int imx662_set_frame_rate(struct imx662 *imx662, u64 val)
 
 }
 
-static void imx662_update_frame_rate(struct imx662 *imx662, u64 val)
+static int imx662_set_hmax_register(struct imx662 *imx662)
 {
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
+	struct device *dev = &client->dev;
+	int ret;
 
-	const struct imx662_mode *mode = imx662->mode;
-	u32 update_vblank;
+	ret = fr_sensor_write_hold_reg(&imx662->core, HMAX_LOW, 2,
+				imx662->core.hmax);
+	if (ret)
+		dev_err(dev, "%s failed to write HMAX register\n", __func__);
 
-	imx662->frame_length = (IMX662_M_FACTOR * IMX662_G_FACTOR) /
-						(val * imx662->line_time);
-	imx662->frame_length = (imx662->frame_length % 2) ?
-				imx662->frame_length + 1 : imx662->frame_length;
+	dev_dbg(dev, "%s: hmax: 0x%x\n", __func__, imx662->core.hmax);
 
-	update_vblank = imx662->frame_length - mode->height;
+	return ret;
 
-	__v4l2_ctrl_modify_range(imx662->vblank, update_vblank,
-				 update_vblank, 1, update_vblank);
+}
 
-	__v4l2_ctrl_s_ctrl(imx662->vblank, update_vblank);
+static u32 imx662_min_frame_length(struct imx662 *imx662)
+{
+	const struct imx662_mode *mode = imx662->mode;
 
+	if (imx662_is_binning_mode(imx662))
+		return mode->height * 2 + IMX662_MIN_FRAME_LENGTH_DELTA;
+
+	return mode->height + IMX662_MIN_FRAME_LENGTH_DELTA;
 }
 
-static int imx662_set_hmax_register(struct imx662 *imx662)
+static int imx662_set_window_position(struct imx662 *imx662)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
 	struct device *dev = &client->dev;
-	const struct imx662_mode *mode = imx662->mode;
 	int ret;
 
-	ret = imx662_write_hold_reg(imx662, HMAX_LOW, 2, mode->hmax);
+	ret = fr_sensor_write_reg(&imx662->core, REGHOLD, 1, 0x01);
+	if (ret) {
+		dev_err(dev, "%s failed to write reghold register\n",
+								__func__);
+		return ret;
+	}
+
+	ret = fr_sensor_write_reg(&imx662->core, PIX_HST_LOW, 2,
+				imx662->crop.left + IMX662_WINDOW_H_OFFSET);
 	if (ret)
-		dev_err(dev, "%s failed to write HMAX register\n", __func__);
+		goto reghold_off;
 
-	dev_dbg(dev, "%s: hmax: 0x%x\n", __func__, mode->hmax);
+	ret = fr_sensor_write_reg(&imx662->core, PIX_VST_LOW, 2,
+				imx662->crop.top + IMX662_WINDOW_V_OFFSET);
+	if (ret)
+		goto reghold_off;
 
-	return ret;
+	ret = fr_sensor_write_reg(&imx662->core, REGHOLD, 1, 0x00);
+	if (ret) {
+		dev_err(dev, "%s failed to write reghold register\n",
+								__func__);
+		return ret;
+	}
+
+	dev_dbg(dev, "%s: window start: (%d, %d)\n", __func__,
+				imx662->crop.left, imx662->crop.top);
 
+	return 0;
+
+reghold_off:
+	dev_err(dev, "%s failed to write window start\n", __func__);
+	fr_sensor_write_reg(&imx662->core, REGHOLD, 1, 0x00);
+	return ret;
 }
 
 static int imx662_set_data_rate(struct imx662 *imx662)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
 	switch (imx662->mode->linkfreq) {
 	case _IMX662_LINK_FREQ_720:
-		ret = imx662_write_reg(imx662, DATARATE_SEL, 1, 0x06);
+		ret = fr_sensor_write_reg(&imx662->core, DATARATE_SEL, 1, 0x06);
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
 								__func__);
@@ -630,7 +566,7 @@ static int imx662_set_data_rate(struct imx662 *imx662)
 		}
 		break;
 	case _IMX662_LINK_FREQ_594:
-		ret = imx662_write_reg(imx662, DATARATE_SEL, 1, 0x07);
+		ret = fr_sensor_write_reg(&imx662->core, DATARATE_SEL, 1, 0x07);
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
 								__func__);
@@ -647,21 +583,24 @@ static int imx662_set_data_rate(struct imx662 *imx662)
 
 static int imx662_set_test_pattern(struct imx662 *imx662, u32 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
 	if (val) {
-		ret = imx662_write_table(imx662, mode_enable_pattern_generator,
+		ret = fr_sensor_write_table(&imx662->core,
+				mode_enable_pattern_generator,
 				ARRAY_SIZE(mode_enable_pattern_generator));
 		if (ret)
 			goto fail;
 
-		ret = imx662_write_reg(imx662, TPG_PATSEL_DUOUT, 1, val - 1);
+		ret = fr_sensor_write_reg(&imx662->core, TPG_PATSEL_DUOUT, 1,
+					val - 1);
 		if (ret)
 			goto fail;
 	} else {
-		ret = imx662_write_table(imx662, mode_disable_pattern_generator,
+		ret = fr_sensor_write_table(&imx662->core,
+				mode_disable_pattern_generator,
 				ARRAY_SIZE(mode_disable_pattern_generator));
 		if (ret)
 			goto fail;
@@ -677,7 +616,7 @@ fail:
 
 static void imx662_update_blklvl_range(struct imx662 *imx662)
 {
-	switch (imx662->fmt_code) {
+	switch (imx662->core.fmt_code) {
 	case MEDIA_BUS_FMT_SRGGB12_1X12:
 		__v4l2_ctrl_modify_range(imx662->blklvl, IMX662_BLACK_LEVEL_MIN,
 					IMX662_MAX_BLACK_LEVEL_12BPP,
@@ -698,17 +637,18 @@ static void imx662_update_blklvl_range(struct imx662 *imx662)
 
 static int imx662_set_blklvl(struct imx662 *imx662, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
 	struct device *dev = &client->dev;
 	u64 black_level_reg;
 	int ret;
 
-	if (imx662->fmt_code == MEDIA_BUS_FMT_SRGGB10_1X10)
+	if (imx662->core.fmt_code == MEDIA_BUS_FMT_SRGGB10_1X10)
 		black_level_reg = val;
 	else
 		black_level_reg = val >> 2;
 
-	ret = imx662_write_hold_reg(imx662, BLKLEVEL_LOW, 2, black_level_reg);
+	ret = fr_sensor_write_hold_reg(&imx662->core, BLKLEVEL_LOW, 2,
+				black_level_reg);
 
 	if (ret) {
 		dev_err(dev, "%s failed to adjust blklvl register\n",
@@ -729,7 +669,7 @@ static int imx662_set_operation_mode(struct imx662 *imx662, u32 val)
 
 static int imx662_set_sync_mode(struct imx662 *imx662, u32 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
 	struct device *dev = &client->dev;
 	int ret = 0;
 	u8 extmode;
@@ -739,7 +679,7 @@ static int imx662_set_sync_mode(struct imx662 *imx662, u32 val)
 	else
 		extmode = 0;
 
-	ret = imx662_write_reg(imx662, EXTMODE, 1, extmode);
+	ret = fr_sensor_write_reg(&imx662->core, EXTMODE, 1, extmode);
 	if (ret)
 		dev_err(dev, "%s: error setting sync mode\n", __func__);
 
@@ -748,7 +688,7 @@ static int imx662_set_sync_mode(struct imx662 *imx662, u32 val)
 
 static int imx662_configure_triggering_pins(struct imx662 *imx662)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
 	struct device *dev = &client->dev;
 	int ret = 0;
 	u8 xvs_xhs_drv = 0xF;
@@ -777,12 +717,35 @@ static int imx662_configure_triggering_pins(struct imx662 *imx662)
 		return -EINVAL;
 	}
 
-	ret = imx662_write_reg(imx662, XVS_XHS_DRV, 1, xvs_xhs_drv);
+	ret = fr_sensor_write_reg(&imx662->core, XVS_XHS_DRV, 1, xvs_xhs_drv);
 	if (ret) {
 		dev_err(dev, "%s: error setting Slave mode\n", __func__);
 		return ret;
 	}
 
+	/*
+	 * Forward XVS over the GMSL link in the direction it is driven:
+	 * from the sensor to the host in internal sync master mode, from the
+	 * host to the sensor in slave mode.
+	 */
+	if (fr_sensor_is_gmsl(&imx662->core)) {
+		if (xvs_xhs_drv == 0x0) {
+			ret = max96793_xvs_setup(imx662->core.ser_dev,
+							max96793_IN);
+			ret |= max96792_xvs_setup(imx662->core.dser_dev,
+							max96792_OUT);
+		} else if (imx662->operation_mode->val == SLAVE_MODE) {
+			ret = max96793_xvs_setup(imx662->core.ser_dev,
+							max96793_OUT);
+			ret |= max96792_xvs_setup(imx662->core.dser_dev,
+							max96792_IN);
+		}
+		if (ret) {
+			dev_err(dev, "%s: error forwarding XVS\n", __func__);
+			return ret;
+		}
+	}
+
 	dev_dbg(dev, "%s: XVS_XHS driver register: 0x%x\n", __func__, xvs_xhs_drv);
 
 	return 0;
@@ -792,24 +755,34 @@ static int imx662_set_ctrl(struct v4l2_ctrl *ctrl)
 {
 	struct imx662 *imx662 =
 		container_of(ctrl->handler, struct imx662, ctrl_handler);
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
 	int ret = 0;
 
 	switch (ctrl->id) {
 	case V4L2_CID_FRAME_RATE:
-		imx662_update_frame_rate(imx662, ctrl->val);
+		fr_sensor_update_frame_rate(&imx662->core, ctrl->val);
 		break;
 	case V4L2_CID_VBLANK:
 		imx662_adjust_exposure_range(imx662);
 		break;
 	}
 
-	if (pm_runtime_get_if_in_use(&client->dev) == 0)
+	/*
+	 * Controls are written whenever the sensor is powered, so that a
+	 * staged configuration stays valid. Otherwise they are applied on the
+	 * next staging or stream start.
+	 */
+	if (pm_runtime_get_if_active(&client->dev, true) <= 0) {
+		imx662->core.staged = false;
 		return 0;
+	}
+
+	WRITE_ONCE(imx662->core.i2c_class, FR_I2C_CONTROL);
 
 	switch (ctrl->id) {
 	case V4L2_CID_ANALOGUE_GAIN:
-		ret = imx662_write_hold_reg(imx662, GAIN_LOW, 2, ctrl->val);
+		ret = fr_sensor_write_hold_reg(&imx662->core, GAIN_LOW, 2,
+					ctrl->val);
 		break;
 	case V4L2_CID_EXPOSURE:
 		ret = imx662_set_exposure(imx662, ctrl->val);
@@ -818,10 +791,12 @@ static int imx662_set_ctrl(struct v4l2_ctrl *ctrl)
 		imx662_set_test_pattern(imx662, ctrl->val);
 		break;
 	case V4L2_CID_HFLIP:
-		ret = imx662_write_reg(imx662, HREVERSE, 1, ctrl->val);
+		ret = fr_sensor_write_reg(&imx662->core, HREVERSE, 1,
+					ctrl->val);
 		break;
 	case V4L2_CID_VFLIP:
-		ret = imx662_write_reg(imx662, VREVERSE, 1, ctrl->val);
+		ret = fr_sensor_write_reg(&imx662->core, VREVERSE, 1,
+					ctrl->val);
 		break;
 	case V4L2_CID_FRAME_RATE:
 		ret = imx662_set_frame_rate(imx662, ctrl->val);
@@ -831,13 +806,17 @@ static int imx662_set_ctrl(struct v4l2_ctrl *ctrl)
 		break;
 	case V4L2_CID_OPERATION_MODE:
 		ret = imx662_set_operation_mode(imx662, ctrl->val);
+		fr_sensor_invalidate_staging(&imx662->core);
 		break;
 	case V4L2_CID_SYNC_MODE:
 		ret = imx662_set_sync_mode(imx662, ctrl->val);
+		fr_sensor_invalidate_staging(&imx662->core);
 		break;
 	}
 
-	pm_runtime_put(&client->dev);
+	WRITE_ONCE(imx662->core.i2c_class, FR_I2C_OTHER);
+
+	pm_runtime_put_autosuspend(&client->dev);
 
 	return ret;
 }
@@ -946,11 +925,11 @@ static int imx662_get_pad_format(struct v4l2_subdev *sd,
 	if (fmt->pad >= NUM_PADS)
 		return -EINVAL;
 
-	mutex_lock(&imx662->mutex);
+	mutex_lock(&imx662->core.mutex);
 
 	if (fmt->which == V4L2_SUBDEV_FORMAT_TRY) {
 		struct v4l2_mbus_framefmt *try_fmt =
-			v4l2_subdev_get_try_format(&imx662->sd, sd_state,
+			v4l2_subdev_get_try_format(&imx662->core.sd, sd_state,
 							fmt->pad);
 		try_fmt->code = fmt->pad == IMAGE_PAD ?
 				imx662_get_format_code(imx662, try_fmt->code) :
@@ -962,19 +941,19 @@ static int imx662_get_pad_format(struct v4l2_subdev *sd,
 								fmt);
 			fmt->format.code =
 					imx662_get_format_code(imx662,
-								imx662->fmt_code);
+								imx662->core.fmt_code);
 		} else {
 			imx662_update_metadata_pad_format(fmt);
 		}
 	}
 
-	mutex_unlock(&imx662->mutex);
+	mutex_unlock(&imx662->core.mutex);
 	return 0;
 }
 
 static void imx662_set_limits(struct imx662 *imx662)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
 	struct device *dev = &client->dev;
 	const struct imx662_mode *mode = imx662->mode;
 	u64 vblank, max_framerate;
@@ -983,7 +962,7 @@ static void imx662_set_limits(struct imx662 *imx662)
 
 	vblank = IMX662_MIN_FRAME_LENGTH_DELTA;
 
-	__v4l2_ctrl_modify_range(imx662->vblank, vblank,
+	__v4l2_ctrl_modify_range(imx662->core.vblank, vblank,
 				 vblank, 1, vblank);
 	dev_dbg(dev, "%s: vblank: %lld\n", __func__, vblank);
 
@@ -991,7 +970,7 @@ static void imx662_set_limits(struct imx662 *imx662)
 				 mode->pixel_rate, 1, mode->pixel_rate);
 	dev_dbg(dev, "%s: pixel rate: %d\n", __func__, mode->pixel_rate);
 
-	if (!(strcmp(imx662->gmsl, "gmsl")))
+	if (fr_sensor_is_gmsl(&imx662->core))
 		__v4l2_ctrl_s_ctrl(imx662->link_freq, _GMSL_LINK_FREQ_1500);
 	else
 		__v4l2_ctrl_s_ctrl(imx662->link_freq, mode->linkfreq);
@@ -999,26 +978,28 @@ static void imx662_set_limits(struct imx662 *imx662)
 	dev_dbg(dev, "%s: linkfreq: %lld\n", __func__,
 					imx662_link_freq_menu[mode->linkfreq]);
 
-	imx662->line_time = (mode->hmax*IMX662_G_FACTOR) / (IMX662_XCLK_FREQ);
-	dev_dbg(dev, "%s: line time: %lld\n", __func__, imx662->line_time);
+	fr_sensor_set_hmax(&imx662->core, mode->hmax);
+	imx662->core.interval_fps = 0;
+	dev_dbg(dev, "%s: line time: %lld\n", __func__, imx662->core.line_time);
 
 	if (imx662_is_binning_mode(imx662))
-		imx662->frame_length = mode->height * 2 + vblank;
+		imx662->core.frame_length = mode->height * 2 + vblank;
 	else
-		imx662->frame_length = mode->height + vblank;
+		imx662->core.frame_length = mode->height + vblank;
 
-	dev_dbg(dev, "%s: frame length: %d\n", __func__, imx662->frame_length);
+	dev_dbg(dev, "%s: frame length: %d\n", __func__,
+						imx662->core.frame_length);
 
 	max_framerate = (IMX662_G_FACTOR * IMX662_M_FACTOR) /
-				(imx662->frame_length * imx662->line_time);
+			(imx662->core.frame_length * imx662->core.line_time);
 
-	__v4l2_ctrl_modify_range(imx662->framerate, mode->min_fps,
+	__v4l2_ctrl_modify_range(imx662->core.framerate, mode->min_fps,
 				 max_framerate, 1, max_framerate);
 	dev_dbg(dev, "%s: max framerate: %lld\n", __func__, max_framerate);
 
 	imx662_update_blklvl_range(imx662);
 
-	__v4l2_ctrl_s_ctrl(imx662->framerate, max_framerate);
+	__v4l2_ctrl_s_ctrl(imx662->core.framerate, max_framerate);
 }
 
 static int imx662_set_pad_format(struct v4l2_subdev *sd,
@@ -1032,7 +1013,7 @@ static int imx662_set_pad_format(struct v4l2_subdev *sd,
 	if (fmt->pad >= NUM_PADS)
 		return -EINVAL;
 
-	mutex_lock(&imx662->mutex);
+	mutex_lock(&imx662->core.mutex);
 
 	if (fmt->pad == IMAGE_PAD) {
 		const struct imx662_mode *mode_list;
@@ -1055,8 +1036,10 @@ static int imx662_set_pad_format(struct v4l2_subdev *sd,
 			*framefmt = fmt->format;
 		} else if (imx662->mode != mode) {
 			imx662->mode = mode;
-			imx662->fmt_code = fmt->format.code;
+			imx662->crop = mode->crop;
+			imx662->core.fmt_code = fmt->format.code;
 			imx662_set_limits(imx662);
+			fr_sensor_invalidate_staging(&imx662->core);
 		}
 	} else {
 		if (fmt->which == V4L2_SUBDEV_FORMAT_TRY) {
@@ -1068,7 +1051,7 @@ static int imx662_set_pad_format(struct v4l2_subdev *sd,
 		}
 	}
 
-	mutex_unlock(&imx662->mutex);
+	mutex_unlock(&imx662->core.mutex);
 
 	return 0;
 }
@@ -1080,9 +1063,9 @@ __imx662_get_pad_crop(struct imx662 *imx662,
 {
 	switch (which) {
 	case V4L2_SUBDEV_FORMAT_TRY:
-		return v4l2_subdev_get_try_crop(&imx662->sd, sd_state, pad);
+		return v4l2_subdev_get_try_crop(&imx662->core.sd, sd_state, pad);
 	case V4L2_SUBDEV_FORMAT_ACTIVE:
-		return &imx662->mode->crop;
+		return &imx662->crop;
 	}
 
 	return NULL;
@@ -1096,10 +1079,10 @@ static int imx662_get_selection(struct v4l2_subdev *sd,
 	case V4L2_SEL_TGT_CROP: {
 		struct imx662 *imx662 = to_imx662(sd);
 
-		mutex_lock(&imx662->mutex);
+		mutex_lock(&imx662->core.mutex);
 		sel->r = *__imx662_get_pad_crop(imx662, sd_state, sel->pad,
 						sel->which);
-		mutex_unlock(&imx662->mutex);
+		mutex_unlock(&imx662->core.mutex);
 
 		return 0;
 	}
@@ -1125,358 +1108,216 @@ static int imx662_get_selection(struct v4l2_subdev *sd,
 	return -EINVAL;
 }
 
-static int imx662_set_mode(struct imx662 *imx662)
+static int imx662_set_selection(struct v4l2_subdev *sd,
+				struct v4l2_subdev_state *sd_state,
+				struct v4l2_subdev_selection *sel)
 {
+	struct imx662 *imx662 = to_imx662(sd);
+	struct v4l2_rect *crop;
+	struct v4l2_rect prev;
+	int ret = 0;
 
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
-	struct device *dev = &client->dev;
-	const struct imx662_reg_list *reg_list;
-	int ret;
+	if (sel->target != V4L2_SEL_TGT_CROP || sel->pad != IMAGE_PAD)
+		return -EINVAL;
 
-	ret = imx662_write_table(imx662, mode_common_regs,
-					ARRAY_SIZE(mode_common_regs));
+	mutex_lock(&imx662->core.mutex);
 
-	if (ret) {
-		dev_err(dev, "%s failed to set common settings\n", __func__);
-		return ret;
+	if (sel->which == V4L2_SUBDEV_FORMAT_TRY)
+		crop = v4l2_subdev_get_try_crop(sd, sd_state, sel->pad);
+	else
+		crop = &imx662->crop;
+
+	/*
+	 * Only the window start can be changed, the window size is defined
+	 * by the selected mode. Sensor readout modes that do not use window
+	 * cropping keep their fixed position.
+	 */
+	if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE &&
+	    !imx662_is_window_mode(imx662->mode)) {
+		sel->r = *crop;
+		goto unlock;
 	}
 
-	reg_list = &imx662->mode->reg_list;
-	ret = imx662_write_table(imx662, reg_list->regs, reg_list->num_of_regs);
-	if (ret) {
-		dev_err(dev, "%s failed to set mode\n", __func__);
-		return ret;
+	prev = *crop;
+
+	crop->left = clamp_t(s32, sel->r.left, IMX662_PIXEL_ARRAY_LEFT,
+			     IMX662_PIXEL_ARRAY_WIDTH - crop->width);
+	crop->left = round_down(crop->left, IMX662_WINDOW_H_STEP);
+	crop->top = clamp_t(s32, sel->r.top, IMX662_PIXEL_ARRAY_TOP,
+			    IMX662_PIXEL_ARRAY_HEIGHT - crop->height);
+	crop->top = round_down(crop->top, IMX662_WINDOW_V_STEP);
+
+	/*
+	 * While streaming the new start position is written inside a
+	 * register hold group, so the sensor switches to it on the next
+	 * frame boundary without a stream restart.
+	 */
+	if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE && imx662->core.streaming &&
+	    (crop->left != prev.left || crop->top != prev.top)) {
+		ret = imx662_set_window_position(imx662);
+		if (ret)
+			*crop = prev;
+	} else if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE &&
+		   (crop->left != prev.left || crop->top != prev.top)) {
+		fr_sensor_invalidate_staging(&imx662->core);
 	}
 
-	reg_list = &imx662->mode->reg_list_format;
-	ret = imx662_write_table(imx662, reg_list->regs, reg_list->num_of_regs);
-	if (ret) {
-		dev_err(dev, "%s failed to set frame format\n", __func__);
-		return ret;
-	}
+	sel->r = *crop;
 
-	ret = imx662_set_hmax_register(imx662);
-	if (ret) {
-		dev_err(dev, "%s failed to write hmax register\n", __func__);
-		return ret;
-	}
+unlock:
+	mutex_unlock(&imx662->core.mutex);
 
-	ret = imx662_set_data_rate(imx662);
-	if (ret) {
-		dev_err(dev, "%s failed to set data rate\n", __func__);
-		return ret;
-	}
+	return ret;
+}
 
-	ret = imx662_configure_triggering_pins(imx662);
-	if (ret) {
-		dev_err(dev, "%s failed to configure triggering pins\n",
-								__func__);
-		return ret;
-	}
+/*
+ * Describe the CSI-2 stream seen by the receiver: the image on the data
+ * type of the active format and the virtual channel it arrives on.
+ */
+static int imx662_get_frame_desc(struct v4l2_subdev *sd, unsigned int pad,
+				 struct v4l2_mbus_frame_desc *fd)
+{
+	struct imx662 *imx662 = to_imx662(sd);
+	struct v4l2_mbus_frame_desc_entry *entry;
+	u8 vc = 0;
 
-	return ret;
+	if (pad >= NUM_PADS)
+		return -EINVAL;
+
+	if (fr_sensor_is_gmsl(&imx662->core))
+		vc = imx662->core.g_ctx.dst_vc;
+
+	memset(fd, 0, sizeof(*fd));
+	fd->type = V4L2_MBUS_FRAME_DESC_TYPE_CSI2;
+
+	mutex_lock(&imx662->core.mutex);
+
+	entry = &fd->entry[fd->num_entries++];
+	entry->stream = IMAGE_PAD;
+	entry->pixelcode = imx662->core.fmt_code;
+	entry->bus.csi2.vc = vc;
+	entry->bus.csi2.dt =
+		imx662->core.fmt_code == MEDIA_BUS_FMT_SRGGB10_1X10 ?
+		MIPI_CSI2_DT_RAW10 : MIPI_CSI2_DT_RAW12;
+
+	mutex_unlock(&imx662->core.mutex);
+
+	return 0;
 }
 
-static int imx662_start_streaming(struct imx662 *imx662)
+static int imx662_set_mode(struct fr_sensor *core)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
-	struct device *dev = &client->dev;
+	struct imx662 *imx662 = core_to_imx662(core);
+	struct device *dev = &core->client->dev;
+	const struct fr_sensor_reg_list *reg_list;
+	ktime_t start = ktime_get();
 	int ret;
 
-	if (!(strcmp(imx662->gmsl, "gmsl"))) {
-		ret = max96793_setup_streaming(imx662->ser_dev, imx662->fmt_code);
-		if (ret) {
-			dev_err(dev, "%s: Unable to setup streaming for serializer max96793\n",
-								__func__);
-			return ret;
-		}
-		ret = max96792_setup_streaming(imx662->dser_dev,
-							&client->dev);
-		if (ret) {
-			dev_err(dev, "%s: Unable to setup streaming for deserializer max96792\n",
-								__func__);
-			return ret;
-		}
-		ret = max96792_start_streaming(imx662->dser_dev, &client->dev);
+	/*
+	 * Common settings survive STREAMOFF/STREAMON, they only have to be
+	 * written once after the sensor has been powered up.
+	 */
+	if (!core->common_regs_written) {
+		ret = fr_sensor_write_table(core, mode_common_regs,
+					ARRAY_SIZE(mode_common_regs));
 		if (ret) {
-			dev_err(dev, "%s: Unable to start gmsl streaming\n",
+			dev_err(dev, "%s failed to set common settings\n",
 								__func__);
 			return ret;
 		}
-	}
 
-	ret = imx662_set_mode(imx662);
-	if (ret) {
-		dev_err(dev, "%s failed to set mode start stream\n", __func__);
-		return ret;
+		core->common_regs_written = true;
+		start = fr_latency_record(&core->latency,
+					  FR_STAGE_COMMON_REGS, start);
 	}
 
-	ret = __v4l2_ctrl_handler_setup(imx662->sd.ctrl_handler);
-	if (ret)
-		return ret;
-
-	ret = imx662_write_reg(imx662, STANDBY, 1, IMX662_MODE_STREAMING);
-
+	reg_list = &imx662->mode->reg_list;
+	ret = __fr_sensor_write_table(core, reg_list->regs,
+				   reg_list->num_of_regs, "mode");
 	if (ret) {
-		dev_err(dev, "%s failed to set STANDBY start stream\n",
-								__func__);
+		dev_err(dev, "%s failed to set mode\n", __func__);
 		return ret;
 	}
 
-	usleep_range(29000, 30000);
-
-	if (imx662->operation_mode->val == MASTER_MODE)
-		ret = imx662_write_reg(imx662, XMSTA, 1, 0x00);
-	else
-		ret = imx662_write_reg(imx662, XMSTA, 1, 0x01);
-
+	reg_list = &imx662->mode->reg_list_format;
+	ret = __fr_sensor_write_table(core, reg_list->regs,
+				   reg_list->num_of_regs, "format");
 	if (ret) {
-		dev_err(dev, "%s failed to set XMSTA start stream\n", __func__);
+		dev_err(dev, "%s failed to set frame format\n", __func__);
 		return ret;
 	}
 
-	return ret;
-}
-
-static void imx662_stop_streaming(struct imx662 *imx662)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
-	struct device *dev = &client->dev;
-	int ret;
-
-	if (!(strcmp(imx662->gmsl, "gmsl"))) {
-		max96793_bypassPCLK_dis(imx662->ser_dev);
-		max96792_stop_streaming(imx662->dser_dev, &client->dev);
-	}
-
-	ret = imx662_write_reg(imx662, XMSTA, 1, 0x01);
-	if (ret)
-		dev_err(dev, "%s failed to set XMSTA stop stream\n", __func__);
-
-	ret = imx662_write_reg(imx662, STANDBY, 1, IMX662_MODE_STANDBY);
-	if (ret)
-		dev_err(dev, "%s failed to set stream\n", __func__);
-
-	usleep_range(imx662->frame_length * imx662->line_time / IMX662_K_FACTOR,
-		imx662->frame_length * imx662->line_time / IMX662_K_FACTOR + 1000);
-
-}
-
-static int imx662_set_stream(struct v4l2_subdev *sd, int enable)
-{
-	struct imx662 *imx662 = to_imx662(sd);
-	struct i2c_client *client = v4l2_get_subdevdata(sd);
-	int ret = 0;
-
-	mutex_lock(&imx662->mutex);
-	if (imx662->streaming == enable) {
-		mutex_unlock(&imx662->mutex);
-		return 0;
-	}
-
-	if (enable) {
-		ret = pm_runtime_get_sync(&client->dev);
-		if (ret < 0) {
-			pm_runtime_put_noidle(&client->dev);
-			goto err_unlock;
-		}
-
-		ret = imx662_start_streaming(imx662);
+	if (imx662_is_window_mode(imx662->mode)) {
+		ret = imx662_set_window_position(imx662);
 		if (ret)
-			goto err_rpm_put;
-	} else {
-		imx662_stop_streaming(imx662);
-		pm_runtime_put(&client->dev);
-	}
-
-	imx662->streaming = enable;
-
-	__v4l2_ctrl_grab(imx662->vflip, enable);
-	__v4l2_ctrl_grab(imx662->hflip, enable);
-	__v4l2_ctrl_grab(imx662->operation_mode, enable);
-	__v4l2_ctrl_grab(imx662->sync_mode, enable);
-
-	mutex_unlock(&imx662->mutex);
-
-	return ret;
-
-err_rpm_put:
-	pm_runtime_put(&client->dev);
-err_unlock:
-	mutex_unlock(&imx662->mutex);
-
-	return ret;
-}
-
-static int imx662_gmsl_serdes_setup(struct imx662 *imx662)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
-	struct device *dev = &client->dev;
-	int ret = 0;
-	int des_err = 0;
-
-	if (!imx662 || !imx662->ser_dev || !imx662->dser_dev || !client)
-		return -EINVAL;
-
-	dev_dbg(dev, "enter %s function\n", __func__);
-
-	mutex_lock(&imx662->mutex);
-
-	ret = max96792_reset_control(imx662->dser_dev, &client->dev);
-
-	ret = max96792_gmsl3_setup(imx662->dser_dev);
-	if (ret) {
-		dev_err(dev, "deserializer gmsl setup failed\n");
-		goto error;
+			return ret;
 	}
 
-	ret = max96793_gmsl3_setup(imx662->ser_dev);
+	ret = imx662_set_hmax_register(imx662);
 	if (ret) {
-		dev_err(dev, "serializer gmsl setup failed\n");
-		goto error;
+		dev_err(dev, "%s failed to write hmax register\n", __func__);
+		return ret;
 	}
+	start = fr_latency_record(&core->latency, FR_STAGE_MODE_REGS,
+									start);
 
-	dev_dbg(dev, "%s: max96792_setup_link\n", __func__);
-	ret = max96792_setup_link(imx662->dser_dev, &client->dev);
+	ret = imx662_set_data_rate(imx662);
 	if (ret) {
-		dev_err(dev, "gmsl deserializer link config failed\n");
-		goto error;
+		dev_err(dev, "%s failed to set data rate\n", __func__);
+		return ret;
 	}
+	fr_latency_record(&core->latency, FR_STAGE_DATA_RATE, start);
 
-	dev_dbg(dev, "%s: max96793_setup_control\n", __func__);
-	ret = max96793_setup_control(imx662->ser_dev);
-
-	if (ret)
-		dev_err(dev, "gmsl serializer setup failed\n");
-
-	ret = max96793_gpio10_xtrig1_setup(imx662->ser_dev, "mipi");
+	ret = imx662_configure_triggering_pins(imx662);
 	if (ret) {
-		dev_err(dev, "gmsl serializer gpio10/xtrig1 pin config failed\n");
-		goto error;
+		dev_err(dev, "%s failed to configure triggering pins\n",
+								__func__);
+		return ret;
 	}
 
-	dev_dbg(dev, "%s: max96792_setup_control\n", __func__);
-	des_err = max96792_setup_control(imx662->dser_dev, &client->dev);
-	if (des_err)
-		dev_err(dev, "gmsl deserializer setup failed\n");
-
-error:
-	mutex_unlock(&imx662->mutex);
 	return ret;
 }
 
-static void imx662_gmsl_serdes_reset(struct imx662 *imx662)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
-
-	mutex_lock(&imx662->mutex);
-
-	max96793_reset_control(imx662->ser_dev);
-	max96792_reset_control(imx662->dser_dev, &client->dev);
-	max96792_power_off(imx662->dser_dev, &imx662->g_ctx);
-
-	mutex_unlock(&imx662->mutex);
-}
-
-static int imx662_power_on(struct device *dev)
-{
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx662 *imx662 = to_imx662(sd);
-
-	if (strcmp(imx662->gmsl, "gmsl")) {
-		gpiod_set_value_cansleep(imx662->reset_gpio, 1);
-		usleep_range(25000, 30000);
-	} else {
-		dev_info(dev, "%s: max96792_power_on\n", __func__);
-		max96792_power_on(imx662->dser_dev, &imx662->g_ctx);
-	}
-
-	return 0;
-}
-
-static int imx662_power_off(struct device *dev)
+static int imx662_communication_verify(struct imx662 *imx662)
 {
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx662 *imx662 = to_imx662(sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
+	struct device *dev = &client->dev;
 	int ret;
 
-	ret = imx662_write_reg(imx662, XVS_XHS_DRV, 1, 0xF);
+	ret = fr_sensor_identify(&imx662->core);
 	if (ret)
-		dev_err(dev, "%s: error setting XVS XHS to Hi-Z\n", __func__);
-
-	mutex_lock(&imx662->mutex);
-	if (strcmp(imx662->gmsl, "gmsl")) {
-		gpiod_set_value_cansleep(imx662->reset_gpio, 0);
-	} else {
-		dev_info(dev, "%s: max96792_power_off\n", __func__);
-		max96792_power_off(imx662->dser_dev, &imx662->g_ctx);
-	}
-	mutex_unlock(&imx662->mutex);
-
-	return 0;
-}
-
-static int __maybe_unused imx662_suspend(struct device *dev)
-{
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx662 *imx662 = to_imx662(sd);
+		return ret;
 
-	if (imx662->streaming)
-		imx662_stop_streaming(imx662);
+	dev_info(dev, "Detected imx662 sensor\n");
 
 	return 0;
 }
 
-static int __maybe_unused imx662_resume(struct device *dev)
+static int imx662_subscribe_event(struct v4l2_subdev *sd, struct v4l2_fh *fh,
+				  struct v4l2_event_subscription *sub)
 {
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
 	struct imx662 *imx662 = to_imx662(sd);
-	int ret;
-
-	if (imx662->streaming) {
-		ret = imx662_start_streaming(imx662);
-		if (ret)
-			goto error;
-	}
-
-	return 0;
-
-error:
-	imx662_stop_streaming(imx662);
-	imx662->streaming = 0;
-	return ret;
-}
-
-static int imx662_communication_verify(struct imx662 *imx662)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
-	struct device *dev = &client->dev;
-	int ret;
-	u32 val;
 
-	ret = imx662_read_reg(imx662, VMAX_LOW, 3, &val);
-
-	if (ret) {
-		dev_err(dev, "%s unable to communicate with sensor\n", __func__);
-		return ret;
+	switch (sub->type) {
+	case V4L2_EVENT_FRAME_SYNC:
+		if (imx662->core.xvs_irq <= 0)
+			return -EINVAL;
+		return v4l2_event_subscribe(fh, sub, IMX662_FRAME_SYNC_EVENTS,
+									NULL);
+	default:
+		return v4l2_ctrl_subdev_subscribe_event(sd, fh, sub);
 	}
-
-	dev_info(dev, "Detected imx662 sensor\n");
-
-	return 0;
 }
 
 static const struct v4l2_subdev_core_ops imx662_core_ops = {
-	.subscribe_event = v4l2_ctrl_subdev_subscribe_event,
+	.subscribe_event = imx662_subscribe_event,
 	.unsubscribe_event = v4l2_event_subdev_unsubscribe,
 };
 
 static const struct v4l2_subdev_video_ops imx662_video_ops = {
-	.s_stream = imx662_set_stream,
+	.s_stream = fr_sensor_s_stream,
+	.g_frame_interval = fr_sensor_g_frame_interval,
+	.s_frame_interval = fr_sensor_s_frame_interval,
 };
 
 static const struct v4l2_subdev_pad_ops imx662_pad_ops = {
@@ -1484,7 +1325,9 @@ static const struct v4l2_subdev_pad_ops imx662_pad_ops = {
 	.get_fmt = imx662_get_pad_format,
 	.set_fmt = imx662_set_pad_format,
 	.get_selection = imx662_get_selection,
+	.set_selection = imx662_set_selection,
 	.enum_frame_size = imx662_enum_frame_size,
+	.get_frame_desc = imx662_get_frame_desc,
 };
 
 static const struct v4l2_subdev_ops imx662_subdev_ops = {
@@ -1539,7 +1382,7 @@ static struct v4l2_ctrl_config imx662_ctrl_sync_mode[] = {
 static int imx662_init_controls(struct imx662 *imx662)
 {
 	struct v4l2_ctrl_handler *ctrl_hdlr;
-	struct i2c_client *client = v4l2_get_subdevdata(&imx662->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
 	struct device *dev = &client->dev;
 	struct v4l2_fwnode_device_properties props;
 	int ret;
@@ -1549,8 +1392,7 @@ static int imx662_init_controls(struct imx662 *imx662)
 	if (ret)
 		return ret;
 
-	mutex_init(&imx662->mutex);
-	ctrl_hdlr->lock = &imx662->mutex;
+	ctrl_hdlr->lock = &imx662->core.mutex;
 
 	imx662->pixel_rate = v4l2_ctrl_new_std(ctrl_hdlr, &imx662_ctrl_ops,
 						V4L2_CID_PIXEL_RATE, 0, 0, 1, 0);
@@ -1565,21 +1407,21 @@ static int imx662_init_controls(struct imx662 *imx662)
 	if (imx662->link_freq)
 		imx662->link_freq->flags |= V4L2_CTRL_FLAG_READ_ONLY;
 
-	imx662->vblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx662_ctrl_ops,
+	imx662->core.vblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx662_ctrl_ops,
 					V4L2_CID_VBLANK, 0, 0, 1, 0);
 
-	imx662->hblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx662_ctrl_ops,
+	imx662->core.hblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx662_ctrl_ops,
 					V4L2_CID_HBLANK, 0, 0, 1, 0);
 
-	if (imx662->hblank)
-		imx662->hblank->flags |= V4L2_CTRL_FLAG_READ_ONLY;
+	if (imx662->core.hblank)
+		imx662->core.hblank->flags |= V4L2_CTRL_FLAG_READ_ONLY;
 
 	imx662->exposure = v4l2_ctrl_new_std(ctrl_hdlr, &imx662_ctrl_ops,
 					V4L2_CID_EXPOSURE,
 					IMX662_MIN_INTEGRATION_LINES,
 					0xFF, 1, 0xFF);
 
-	imx662->framerate = v4l2_ctrl_new_custom(ctrl_hdlr,
+	imx662->core.framerate = v4l2_ctrl_new_custom(ctrl_hdlr,
 					imx662_ctrl_framerate, NULL);
 
 	imx662->operation_mode = v4l2_ctrl_new_custom(ctrl_hdlr,
@@ -1624,91 +1466,138 @@ static int imx662_init_controls(struct imx662 *imx662)
 	if (ret)
 		goto error;
 
-	imx662->sd.ctrl_handler = ctrl_hdlr;
+	imx662->core.grab_ctrls[0] = imx662->vflip;
+	imx662->core.grab_ctrls[1] = imx662->hflip;
+	imx662->core.grab_ctrls[2] = imx662->operation_mode;
+	imx662->core.grab_ctrls[3] = imx662->sync_mode;
 
-	mutex_lock(&imx662->mutex);
+	imx662->core.sd.ctrl_handler = ctrl_hdlr;
+
+	mutex_lock(&imx662->core.mutex);
 
 	imx662_set_limits(imx662);
 
-	mutex_unlock(&imx662->mutex);
+	mutex_unlock(&imx662->core.mutex);
 
 	return 0;
 
 error:
 	v4l2_ctrl_handler_free(ctrl_hdlr);
-	mutex_destroy(&imx662->mutex);
 
 	return ret;
 }
 
-static void imx662_free_controls(struct imx662 *imx662)
+/*
+ * Snapshot of the timing model the driver currently works with, one
+ * "key: value" pair per line. Times are derived from the line time, so
+ * userspace can plan exposure, trigger and CSI-2 bandwidth without
+ * repeating the driver's calculations.
+ */
+static int imx662_timing_show(struct seq_file *s, void *unused)
 {
-	v4l2_ctrl_handler_free(imx662->sd.ctrl_handler);
-	mutex_destroy(&imx662->mutex);
+	struct imx662 *imx662 = s->private;
+	const struct imx662_mode *mode;
+	u32 readout_lines;
+
+	mutex_lock(&imx662->core.mutex);
+
+	mode = imx662->mode;
+	readout_lines = imx662_min_frame_length(imx662) -
+					IMX662_MIN_FRAME_LENGTH_DELTA;
+
+	seq_printf(s, "mode: %ux%u\n", mode->width, mode->height);
+	seq_printf(s, "code: 0x%04x\n", imx662->core.fmt_code);
+	seq_printf(s, "hmax: %u\n", imx662->core.hmax);
+	seq_printf(s, "frame_length: %u\n", imx662->core.frame_length);
+	seq_printf(s, "line_time_ns: %llu\n", imx662->core.line_time);
+	seq_printf(s, "frame_time_us: %llu\n",
+		   imx662->core.frame_length * imx662->core.line_time /
+							IMX662_K_FACTOR);
+	seq_printf(s, "readout_lines: %u\n", readout_lines);
+	seq_printf(s, "readout_time_us: %llu\n",
+		   readout_lines * imx662->core.line_time / IMX662_K_FACTOR);
+	seq_printf(s, "min_shs_length: %d\n", IMX662_MIN_SHR0_LENGTH);
+	seq_printf(s, "min_frame_length_delta: %d\n",
+					IMX662_MIN_FRAME_LENGTH_DELTA);
+	seq_printf(s, "pixel_rate: %u\n", mode->pixel_rate);
+	seq_printf(s, "link_freq: %lld\n",
+				imx662_link_freq_menu[imx662->link_freq->val]);
+	seq_printf(s, "exposure_lines: %d\n", imx662->exposure->val);
+	seq_printf(s, "exposure_max_lines: %lld\n", imx662->exposure->maximum);
+
+	mutex_unlock(&imx662->core.mutex);
+
+	return 0;
 }
+DEFINE_SHOW_ATTRIBUTE(imx662_timing);
 
-static int imx662_check_hwcfg(struct device *dev, struct i2c_client *client)
+static void imx662_debugfs_init(struct imx662 *imx662)
 {
-	struct device_node *node = client->dev.of_node;
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx662 *imx662 = to_imx662(sd);
-	struct fwnode_handle *endpoint;
-	struct v4l2_fwnode_endpoint ep_cfg = {
-		.bus_type = V4L2_MBUS_CSI2_DPHY
-	};
-	const char *gmsl;
-	int ret = -EINVAL;
-
-	endpoint = fwnode_graph_get_next_endpoint(dev_fwnode(dev), NULL);
-	if (!endpoint) {
-		dev_err(dev, "endpoint node not found\n");
-		return -EINVAL;
-	}
+	struct i2c_client *client = v4l2_get_subdevdata(&imx662->core.sd);
+	char name[32];
 
-	if (v4l2_fwnode_endpoint_alloc_parse(endpoint, &ep_cfg)) {
-		dev_err(dev, "could not parse endpoint\n");
-		goto error_out;
-	}
+	snprintf(name, sizeof(name), "imx662-%s", dev_name(&client->dev));
 
-	if (ep_cfg.bus.mipi_csi2.num_data_lanes != 4) {
-		dev_err(dev, "only 4 data lanes are currently supported\n");
-		goto error_out;
-	}
+	imx662->debugfs = debugfs_create_dir(name, NULL);
+	debugfs_create_file("timing", 0444, imx662->debugfs, imx662,
+						&imx662_timing_fops);
+	fr_sensor_debugfs_create(&imx662->core, imx662->debugfs);
+}
 
-	if (!ep_cfg.nr_of_link_frequencies) {
-		dev_err(dev, "link-frequency property not found in DT\n");
-		goto error_out;
-	}
+static void imx662_free_controls(struct imx662 *imx662)
+{
+	v4l2_ctrl_handler_free(imx662->core.sd.ctrl_handler);
+}
 
-	if (ep_cfg.nr_of_link_frequencies != ARRAY_SIZE(imx662_link_freq_menu)) {
-		dev_err(dev, "Link frequency missing in dtree\n");
-		goto error_out;
-	}
+static bool imx662_is_master(struct fr_sensor *core)
+{
+	return core_to_imx662(core)->operation_mode->val == MASTER_MODE;
+}
 
-	for (int i = 0; i < ARRAY_SIZE(imx662_link_freq_menu); i++) {
-		if (ep_cfg.link_frequencies[i] != imx662_link_freq_menu[i]) {
-			dev_err(dev, "no supported link freq found\n");
-			goto error_out;
-		}
-	}
+static void imx662_frame_limits(struct fr_sensor *core,
+				struct fr_sensor_frame_limits *lim)
+{
+	struct imx662 *imx662 = core_to_imx662(core);
+	const struct imx662_mode *mode = imx662->mode;
 
-	ret = of_property_read_string(node, "gmsl", &gmsl);
-	if (ret) {
-		dev_warn(dev, "initializing mipi...\n");
-		imx662->gmsl = "mipi";
-	} else if (!strcmp(gmsl, "gmsl")) {
-		dev_warn(dev, "initializing GMSL...\n");
-		imx662->gmsl = "gmsl";
-	}
+	lim->width = mode->width;
+	lim->height = mode->height;
+	lim->pixel_rate = mode->pixel_rate;
+	lim->hmax_min = mode->hmax;
+	lim->vmax_min = imx662_min_frame_length(imx662);
+	lim->min_fps = mode->min_fps;
+}
 
-	ret = 0;
+/* XVS and XHS are left floating while the sensor is powered down */
+static void imx662_power_off(struct fr_sensor *core)
+{
+	if (fr_sensor_write_reg(core, XVS_XHS_DRV, 1, 0xF))
+		dev_err(&core->client->dev,
+			"%s: error setting XVS XHS to Hi-Z\n", __func__);
+}
 
-error_out:
-	v4l2_fwnode_endpoint_free(&ep_cfg);
-	fwnode_handle_put(endpoint);
+static const struct fr_sensor_ops imx662_sensor_ops = {
+	.set_mode = imx662_set_mode,
+	.is_master = imx662_is_master,
+	.frame_limits = imx662_frame_limits,
+	.power_off = imx662_power_off,
+};
 
-	return ret;
-}
+static const struct fr_sensor_desc imx662_desc = {
+	.reghold = REGHOLD,
+	.standby = STANDBY,
+	.xmsta = XMSTA,
+	.id_reg = VMAX_LOW,
+	.id_len = 3,
+	.xclk_freq = IMX662_XCLK_FREQ,
+	.hmax_max = IMX662_HMAX_MAX,
+	.vmax_max = IMX662_VMAX_MAX,
+	.vmax_step = IMX662_VMAX_STEP,
+	.settle_us = IMX662_STANDBY_SETTLE_US,
+	.link_freqs = imx662_link_freq_menu,
+	.num_link_freqs = ARRAY_SIZE(imx662_link_freq_menu),
+	.ops = &imx662_sensor_ops,
+};
 
 static const struct of_device_id imx662_dt_ids[] = {
 	{ .compatible = "framos,fr_imx662" },
@@ -1719,220 +1608,29 @@ static int imx662_probe(struct i2c_client *client)
 {
 	struct device *dev = &client->dev;
 	struct imx662 *imx662;
-	const struct of_device_id *match;
-	struct device_node *node = dev->of_node;
-	struct device_node *ser_node;
-	struct i2c_client *ser_i2c = NULL;
-	struct device_node *dser_node;
-	struct i2c_client *dser_i2c = NULL;
-	struct device_node *gmsl;
-	int value = 0xFFFF;
-	const char *str_value;
-	const char *str_value1[2];
-	int i;
 	int ret;
 
 	imx662 = devm_kzalloc(&client->dev, sizeof(*imx662), GFP_KERNEL);
 	if (!imx662)
 		return -ENOMEM;
 
-	v4l2_i2c_subdev_init(&imx662->sd, client, &imx662_subdev_ops);
-
-	match = of_match_device(imx662_dt_ids, dev);
-	if (!match)
-		return -ENODEV;
-
-	if (imx662_check_hwcfg(dev, client))
-		return -EINVAL;
-
-	if (strcmp(imx662->gmsl, "gmsl")) {
-		imx662->reset_gpio = devm_gpiod_get(dev, "reset", GPIOD_OUT_HIGH);
-		if (IS_ERR(imx662->reset_gpio)) {
-			dev_err(dev, "cannot get reset gpio\n");
-			return PTR_ERR(imx662->reset_gpio);
-		}
-	}
-
-	if (!(strcmp(imx662->gmsl, "gmsl"))) {
-		ret = of_property_read_u32(node, "reg", &imx662->g_ctx.sdev_reg);
-		if (ret < 0) {
-			dev_err(dev, "reg not found\n");
-			return ret;
-		}
-
-		ret = of_property_read_u32(node, "def-addr",
-							&imx662->g_ctx.sdev_def);
-		if (ret < 0) {
-			dev_err(dev, "def-addr not found\n");
-			return ret;
-		}
-
-		ser_node = of_parse_phandle(node, "gmsl-ser-device", 0);
-		if (ser_node == NULL) {
-			dev_err(dev, "missing %s handle\n", "gmsl-ser-device");
-			return ret;
-		}
-
-		ret = of_property_read_u32(ser_node, "reg", &imx662->g_ctx.ser_reg);
-		if (ret < 0) {
-			dev_err(dev, "serializer reg not found\n");
-			return ret;
-		}
-
-		ser_i2c = of_find_i2c_device_by_node(ser_node);
-		of_node_put(ser_node);
-
-		if (ser_i2c == NULL) {
-			dev_err(dev, "missing serializer dev handle\n");
-			return ret;
-		}
-		if (ser_i2c->dev.driver == NULL) {
-			dev_err(dev, "missing serializer driver\n");
-			return ret;
-		}
+	v4l2_i2c_subdev_init(&imx662->core.sd, client, &imx662_subdev_ops);
 
-		imx662->ser_dev = &ser_i2c->dev;
+	fr_sensor_init(&imx662->core, client, &imx662_desc);
 
-		dser_node = of_parse_phandle(node, "gmsl-dser-device", 0);
-		if (dser_node == NULL) {
-			dev_err(dev, "missing %s handle\n", "gmsl-dser-device");
-			return ret;
-		}
-
-		dser_i2c = of_find_i2c_device_by_node(dser_node);
-		of_node_put(dser_node);
-
-		if (dser_i2c == NULL) {
-			dev_err(dev, "missing deserializer dev handle\n");
-			return ret;
-		}
-		if (dser_i2c->dev.driver == NULL) {
-			dev_err(dev, "missing deserializer driver\n");
-			return ret;
-		}
-
-		imx662->dser_dev = &dser_i2c->dev;
-
-		gmsl = of_get_child_by_name(node, "gmsl-link");
-		if (gmsl == NULL) {
-			dev_err(dev, "missing gmsl-link device node\n");
-			ret = -EINVAL;
-			return ret;
-		}
-
-		ret = of_property_read_string(gmsl, "dst-csi-port", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No dst-csi-port found\n");
-			return ret;
-		}
-		imx662->g_ctx.dst_csi_port =
-		(!strcmp(str_value, "a")) ? GMSL_CSI_PORT_A : GMSL_CSI_PORT_B;
-
-		ret = of_property_read_string(gmsl, "src-csi-port", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No src-csi-port found\n");
-			return ret;
-		}
-		imx662->g_ctx.src_csi_port =
-		(!strcmp(str_value, "a")) ? GMSL_CSI_PORT_A : GMSL_CSI_PORT_B;
-
-		ret = of_property_read_string(gmsl, "csi-mode", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No csi-mode found\n");
-			return ret;
-		}
-
-		if (!strcmp(str_value, "1x4")) {
-			imx662->g_ctx.csi_mode = GMSL_CSI_1X4_MODE;
-		} else if (!strcmp(str_value, "2x4")) {
-			imx662->g_ctx.csi_mode = GMSL_CSI_2X4_MODE;
-		} else if (!strcmp(str_value, "2x2")) {
-			imx662->g_ctx.csi_mode = GMSL_CSI_2X2_MODE;
-		} else {
-			dev_err(dev, "invalid csi mode\n");
-			return ret;
-		}
-
-		ret = of_property_read_string(gmsl, "serdes-csi-link", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No serdes-csi-link found\n");
-			return ret;
-		}
-		imx662->g_ctx.serdes_csi_link =
-		(!strcmp(str_value, "a")) ? GMSL_SERDES_CSI_LINK_A : GMSL_SERDES_CSI_LINK_B;
-
-		ret = of_property_read_u32(gmsl, "st-vc", &value);
-		if (ret < 0) {
-			dev_err(dev, "No st-vc info\n");
-			return ret;
-		}
-
-		imx662->g_ctx.st_vc = value;
-
-		ret = of_property_read_u32(gmsl, "vc-id", &value);
-		if (ret < 0) {
-			dev_err(dev, "No vc-id info\n");
-			return ret;
-		}
-		imx662->g_ctx.dst_vc = value;
-
-		ret = of_property_read_u32(gmsl, "num-lanes", &value);
-		if (ret < 0) {
-			dev_err(dev, "No num-lanes info\n");
-			return ret;
-		}
-
-		imx662->g_ctx.num_csi_lanes = value;
-
-		imx662->g_ctx.num_streams =
-				of_property_count_strings(gmsl, "streams");
-		if (imx662->g_ctx.num_streams <= 0) {
-			dev_err(dev, "No streams found\n");
-			ret = -EINVAL;
-			return ret;
-		}
-
-		for (i = 0; i < imx662->g_ctx.num_streams; i++) {
-			of_property_read_string_index(gmsl, "streams", i, &str_value1[i]);
-			if (!str_value1[i]) {
-				dev_err(dev, "invalid stream info\n");
-				return ret;
-			}
-			if (!strcmp(str_value1[i], "raw12")) {
-				imx662->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_RAW_12;
-			} else if (!strcmp(str_value1[i], "embed")) {
-				imx662->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_EMBED;
-			} else if (!strcmp(str_value1[i], "ued-u1")) {
-				imx662->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_UED_U1;
-			} else {
-				dev_err(dev, "invalid stream data type\n");
-				return ret;
-			}
-		}
-
-		imx662->g_ctx.s_dev = dev;
-
-		ret = max96793_sdev_pair(imx662->ser_dev, &imx662->g_ctx);
-		if (ret) {
-			dev_err(dev, "gmsl ser pairing failed\n");
-			return ret;
-		}
-
-		ret = max96792_sdev_register(imx662->dser_dev, &imx662->g_ctx);
-		if (ret) {
-			dev_err(dev, "gmsl deserializer register failed\n");
-			return ret;
-		}
+	ret = fr_sensor_probe(&imx662->core);
+	if (ret)
+		return ret;
 
-		ret = imx662_gmsl_serdes_setup(imx662);
+	if (fr_sensor_is_gmsl(&imx662->core)) {
+		ret = fr_sensor_gmsl_serdes_setup(&imx662->core);
 		if (ret) {
 			dev_err(dev, "%s gmsl serdes setup failed\n", __func__);
 			return ret;
 		}
-
 	}
 
-	ret = imx662_power_on(dev);
+	ret = fr_sensor_runtime_resume(dev);
 	if (ret)
 		return ret;
 
@@ -1947,49 +1645,67 @@ static int imx662_probe(struct i2c_client *client)
 		return PTR_ERR(imx662->xmaster);
 	}
 
+	ret = fr_sensor_xvs_init(&imx662->core);
+	if (ret)
+		goto error_power_off;
+
 	imx662->mode = &modes_12bit[0];
-	imx662->fmt_code = MEDIA_BUS_FMT_SRGGB12_1X12;
+	imx662->crop = imx662->mode->crop;
+	imx662->core.fmt_code = MEDIA_BUS_FMT_SRGGB12_1X12;
 
-	pm_runtime_set_active(dev);
-	pm_runtime_enable(dev);
-	pm_runtime_idle(dev);
+	fr_sensor_pm_enable(&imx662->core);
 
 	ret = imx662_init_controls(imx662);
 	if (ret)
-		goto error_power_off;
+		goto error_pm_disable;
 
-	imx662->sd.internal_ops = &imx662_internal_ops;
-	imx662->sd.flags |= V4L2_SUBDEV_FL_HAS_DEVNODE |
+	imx662->core.sd.internal_ops = &imx662_internal_ops;
+	imx662->core.sd.flags |= V4L2_SUBDEV_FL_HAS_DEVNODE |
 				V4L2_SUBDEV_FL_HAS_EVENTS;
-	imx662->sd.entity.function = MEDIA_ENT_F_CAM_SENSOR;
+	imx662->core.sd.entity.function = MEDIA_ENT_F_CAM_SENSOR;
 
 	imx662->pad[IMAGE_PAD].flags = MEDIA_PAD_FL_SOURCE;
 	imx662->pad[METADATA_PAD].flags = MEDIA_PAD_FL_SOURCE;
 
-	ret = media_entity_pads_init(&imx662->sd.entity, NUM_PADS, imx662->pad);
+	ret = media_entity_pads_init(&imx662->core.sd.entity, NUM_PADS,
+				     imx662->pad);
 	if (ret) {
 		dev_err(dev, "failed to init entity pads: %d\n", ret);
 		goto error_handler_free;
 	}
 
-	ret = v4l2_async_register_subdev_sensor(&imx662->sd);
+	ret = fr_sensor_join_sync_group(&imx662->core);
+	if (ret)
+		goto error_media_entity;
+
+	ret = v4l2_async_register_subdev_sensor(&imx662->core.sd);
 	if (ret < 0) {
 		dev_err(dev, "failed to register sensor sub-device: %d\n", ret);
-		goto error_media_entity;
+		goto error_sync_leave;
 	}
 
+	imx662_debugfs_init(imx662);
+
 	return 0;
 
+error_sync_leave:
+	fr_sync_group_leave(&imx662->core.sync);
+
 error_media_entity:
-	media_entity_cleanup(&imx662->sd.entity);
+	media_entity_cleanup(&imx662->core.sd.entity);
 
 error_handler_free:
 	imx662_free_controls(imx662);
 
+error_pm_disable:
+	fr_sensor_pm_disable(&imx662->core);
+	mutex_destroy(&imx662->core.mutex);
+
+	return ret;
+
 error_power_off:
-	pm_runtime_disable(&client->dev);
-	pm_runtime_set_suspended(&client->dev);
-	imx662_power_off(&client->dev);
+	fr_sensor_runtime_suspend(&client->dev);
+	mutex_destroy(&imx662->core.mutex);
 
 	return ret;
 }
@@ -1999,35 +1715,39 @@ static void imx662_remove(struct i2c_client *client)
 	struct v4l2_subdev *sd = i2c_get_clientdata(client);
 	struct imx662 *imx662 = to_imx662(sd);
 
-	if (!(strcmp(imx662->gmsl, "gmsl"))) {
-		max96792_sdev_unregister(imx662->dser_dev, &client->dev);
-		imx662_gmsl_serdes_reset(imx662);
-	}
+	cancel_delayed_work_sync(&imx662->core.stage_work);
+
+	mutex_lock(&imx662->core.mutex);
+	fr_sensor_remove(&imx662->core);
+	mutex_unlock(&imx662->core.mutex);
 
+	debugfs_remove_recursive(imx662->debugfs);
 	v4l2_async_unregister_subdev(sd);
+	fr_sync_group_leave(&imx662->core.sync);
 	media_entity_cleanup(&sd->entity);
 	imx662_free_controls(imx662);
 
-	pm_runtime_disable(&client->dev);
-	if (!pm_runtime_status_suspended(&client->dev))
-		imx662_power_off(&client->dev);
-	pm_runtime_set_suspended(&client->dev);
+	fr_sensor_pm_disable(&imx662->core);
+	mutex_destroy(&imx662->core.mutex);
 }
 
 MODULE_DEVICE_TABLE(of, imx662_dt_ids);
 
-static const struct dev_pm_ops imx662_pm_ops = {
-	SET_SYSTEM_SLEEP_PM_OPS(imx662_suspend, imx662_resume)
-	SET_RUNTIME_PM_OPS(imx662_power_off, imx662_power_on, NULL)
+/* Lets the sensor be instantiated without device tree, from software nodes */
+static const struct i2c_device_id imx662_id[] = {
+	{ "fr_imx662" },
+	{ }
 };
+MODULE_DEVICE_TABLE(i2c, imx662_id);
 
 static struct i2c_driver imx662_i2c_driver = {
 	.driver = {
 		.name = "fr_imx662",
 		.of_match_table	= imx662_dt_ids,
-		.pm = &imx662_pm_ops,
+		.pm = &fr_sensor_pm_ops,
 	},
 	.probe = imx662_probe,
+	.id_table = imx662_id,
 	.remove = imx662_remove,
 };
 
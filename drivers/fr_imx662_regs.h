@@ -5,6 +5,8 @@
  * fr_imx662_regs.h - imx662 sensor mode tables
  */
 
+#include "fr_sensor_core.h"
+
 #define STANDBY			0x3000
 #define REGHOLD			0x3001
 #define XMSTA			0x3002
@@ -67,17 +69,12 @@
 #define IMX662_MODE_BINNING_H2V2_HEIGHT	550
 
 
-struct imx662_reg {
-	u16 address;
-	u8 val;
-};
-
 #define IMX662_MIN_FRAME_LENGTH_DELTA	70
 
 #define IMX662_TO_LOW_BYTE(x) (x & 0xFF)
 #define IMX662_TO_MID_BYTE(x) (x >> 8)
 
-static const struct imx662_reg mode_common_regs[] = {
+static const struct fr_sensor_reg mode_common_regs[] = {
 
 	{LANEMODE,		0x03},
 	{INCK_SEL,		0x01},
@@ -177,7 +174,7 @@ static const struct imx662_reg mode_common_regs[] = {
 
 };
 
-static const struct imx662_reg raw12_framefmt_regs[] = {
+static const struct fr_sensor_reg raw12_framefmt_regs[] = {
 
 	{ADBIT,			0x01},
 	{MDBIT,			0x01},
@@ -188,7 +185,7 @@ static const struct imx662_reg raw12_framefmt_regs[] = {
 
 };
 
-static const struct imx662_reg raw12_h2v2_framefmt_regs[] = {
+static const struct fr_sensor_reg raw12_h2v2_framefmt_regs[] = {
 
 	{ADBIT,			0x00},
 	{MDBIT,			0x01},
@@ -199,7 +196,7 @@ static const struct imx662_reg raw12_h2v2_framefmt_regs[] = {
 
 };
 
-static const struct imx662_reg raw10_framefmt_regs[] = {
+static const struct fr_sensor_reg raw10_framefmt_regs[] = {
 
 	{ADBIT,			0x00},
 	{MDBIT,			0x00},
@@ -210,7 +207,7 @@ static const struct imx662_reg raw10_framefmt_regs[] = {
 
 };
 
-static const struct imx662_reg mode_1920x1080[] = {
+static const struct fr_sensor_reg mode_1920x1080[] = {
 
 	{WINMODE,		0x04},
 	{ADDMODE,		0x00},
@@ -229,7 +226,7 @@ static const struct imx662_reg mode_1920x1080[] = {
 
 };
 
-static const struct imx662_reg mode_crop_1280x720[] = {
+static const struct fr_sensor_reg mode_crop_1280x720[] = {
 
 	{WINMODE,		0x04},
 	{ADDMODE,		0x00},
@@ -248,7 +245,7 @@ static const struct imx662_reg mode_crop_1280x720[] = {
 
 };
 
-static const struct imx662_reg mode_crop_640x480[] = {
+static const struct fr_sensor_reg mode_crop_640x480[] = {
 
 	{WINMODE,		0x04},
 	{ADDMODE,		0x00},
@@ -267,7 +264,7 @@ static const struct imx662_reg mode_crop_640x480[] = {
 
 };
 
-static const struct imx662_reg mode_h2v2_binning[] = {
+static const struct fr_sensor_reg mode_h2v2_binning[] = {
 
 	{WINMODE,		0x00},
 	{ADDMODE,		0x01},
@@ -276,7 +273,7 @@ static const struct imx662_reg mode_h2v2_binning[] = {
 
 };
 
-static const struct imx662_reg mode_enable_pattern_generator[] = {
+static const struct fr_sensor_reg mode_enable_pattern_generator[] = {
 
 	{BLKLEVEL_LOW,		0x00},
 	{TPG_EN_DUOUT,		0x01},
@@ -285,7 +282,7 @@ static const struct imx662_reg mode_enable_pattern_generator[] = {
 
 };
 
-static const struct imx662_reg mode_disable_pattern_generator[] = {
+static const struct fr_sensor_reg mode_disable_pattern_generator[] = {
 
 	{BLKLEVEL_LOW,		0x32},
 	{TPG_EN_DUOUT,		0x00},
@@ -7,22 +7,28 @@
 
 //#define DEBUG 1
 
-#include <asm/unaligned.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/gpio/consumer.h>
 #include <linux/i2c.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/workqueue.h>
 #include <media/v4l2-ctrls.h>
 #include <media/v4l2-device.h>
 #include <media/v4l2-event.h>
 #include <media/v4l2-fwnode.h>
 #include <media/v4l2-mediabus.h>
+#include <media/mipi-csi2.h>
 
 #include "fr_imx676_regs.h"
 #include "fr_max96792.h"
 #include "fr_max96793.h"
+#include "fr_sensor_core.h"
+#include "fr_stats.h"
+#include "fr_sync_group.h"
+#include "fr_trace.h"
 
 #define IMX676_K_FACTOR				1000LL
 #define IMX676_M_FACTOR				1000000LL
@@ -37,12 +43,16 @@
 #define IMX676_LINK_FREQ_720			(720000000/2)
 #define IMX676_LINK_FREQ_594			(594000000/2)
 
-#define IMX676_MODE_STANDBY			0x01
-#define IMX676_MODE_STREAMING			0x00
+#define IMX676_STANDBY_SETTLE_US		29000
+#define IMX676_FRAME_SYNC_EVENTS		4
 
 #define IMX676_MIN_SHR0_LENGTH			8
 #define IMX676_MIN_INTEGRATION_LINES		2
 
+#define IMX676_HMAX_MAX				0xFFFF
+#define IMX676_VMAX_MAX				0xFFFFF
+#define IMX676_VMAX_STEP			2
+
 #define IMX676_ANA_GAIN_MIN			0
 #define IMX676_ANA_GAIN_MAX			240
 #define IMX676_ANA_GAIN_STEP			1
@@ -71,15 +81,13 @@ enum pad_types {
 #define IMX676_PIXEL_ARRAY_WIDTH	3552U
 #define IMX676_PIXEL_ARRAY_HEIGHT	3556U
 
+#define IMX676_WINDOW_H_STEP		4U
+#define IMX676_WINDOW_V_STEP		2U
+
 #define V4L2_CID_FRAME_RATE		(V4L2_CID_USER_IMX_BASE + 1)
 #define V4L2_CID_OPERATION_MODE		(V4L2_CID_USER_IMX_BASE + 2)
 #define V4L2_CID_SYNC_MODE		(V4L2_CID_USER_IMX_BASE + 3)
 
-struct imx676_reg_list {
-	unsigned int num_of_regs;
-	const struct imx676_reg *regs;
-};
-
 struct imx676_mode {
 
 	unsigned int width;
@@ -89,8 +97,8 @@ struct imx676_mode {
 	unsigned int min_fps;
 	unsigned int hmax;
 	struct v4l2_rect crop;
-	struct imx676_reg_list reg_list;
-	struct imx676_reg_list reg_list_format;
+	struct fr_sensor_reg_list reg_list;
+	struct fr_sensor_reg_list reg_list_format;
 };
 
 static const s64 imx676_link_freq_menu[] = {
@@ -256,43 +264,36 @@ static const u32 codes[] = {
 };
 
 struct imx676 {
-	struct v4l2_subdev sd;
-	struct media_pad pad[NUM_PADS];
+	struct fr_sensor core;
 
-	unsigned int fmt_code;
+	struct media_pad pad[NUM_PADS];
 
-	struct gpio_desc *reset_gpio;
 	struct gpio_desc *xmaster;
 
 	struct v4l2_ctrl_handler ctrl_handler;
 	struct v4l2_ctrl *pixel_rate;
 	struct v4l2_ctrl *link_freq;
 	struct v4l2_ctrl *exposure;
-	struct v4l2_ctrl *framerate;
 	struct v4l2_ctrl *operation_mode;
 	struct v4l2_ctrl *sync_mode;
 	struct v4l2_ctrl *vflip;
 	struct v4l2_ctrl *hflip;
-	struct v4l2_ctrl *vblank;
-	struct v4l2_ctrl *hblank;
 	struct v4l2_ctrl *blklvl;
 
-	u64 line_time;
-	u32 frame_length;
-
-	const char *gmsl;
-	struct device *ser_dev;
-	struct device *dser_dev;
-	struct gmsl_link_ctx g_ctx;
-
 	const struct imx676_mode *mode;
-	struct mutex mutex;
-	bool streaming;
+	struct v4l2_rect crop;
+
+	struct dentry *debugfs;
 };
 
 static inline struct imx676 *to_imx676(struct v4l2_subdev *_sd)
 {
-	return container_of(_sd, struct imx676, sd);
+	return container_of(_sd, struct imx676, core.sd);
+}
+
+static inline struct imx676 *core_to_imx676(struct fr_sensor *core)
+{
+	return container_of(core, struct imx676, core);
 }
 
 static inline void get_mode_table(unsigned int code,
@@ -347,116 +348,11 @@ static const char * const imx676_sync_mode_menu[] = {
 
 };
 
-static int imx676_read_reg(struct imx676 *imx676, u16 reg, u32 len, u32 *val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
-	struct i2c_msg msgs[2];
-	u8 addr_buf[2] = { reg >> 8, reg & 0xff };
-	u8 data_buf[4] = { 0, };
-	int ret;
-
-	if (len > 4)
-		return -EINVAL;
-
-	msgs[0].addr = client->addr;
-	msgs[0].flags = 0;
-	msgs[0].len = ARRAY_SIZE(addr_buf);
-	msgs[0].buf = addr_buf;
-
-	msgs[1].addr = client->addr;
-	msgs[1].flags = I2C_M_RD;
-	msgs[1].len = len;
-	msgs[1].buf = &data_buf[4 - len];
-
-	ret = i2c_transfer(client->adapter, msgs, ARRAY_SIZE(msgs));
-	if (ret != ARRAY_SIZE(msgs))
-		return -EIO;
-
-	*val = get_unaligned_be32(data_buf);
-
-	return 0;
-}
-
-static int imx676_write_reg(struct imx676 *imx676, u16 reg, u32 len, u32 val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
-	u8 buf[6];
-
-	if (len > 4)
-		return -EINVAL;
-
-	put_unaligned_be16(reg, buf);
-	put_unaligned_le32(val, buf + 2);
-
-	if (i2c_master_send(client, buf, len + 2) != len + 2)
-		return -EIO;
-
-	return 0;
-}
-
-static int imx676_write_hold_reg(struct imx676 *imx676, u16 reg, u32 len, u32 val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
-	struct device *dev = &client->dev;
-	int ret;
-
-	ret = imx676_write_reg(imx676, REGHOLD, 1, 0x01);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n",
-								__func__);
-		return ret;
-	}
-
-	ret = imx676_write_reg(imx676, reg, len, val);
-	if (ret)
-		goto reghold_off;
-
-	ret = imx676_write_reg(imx676, REGHOLD, 1, 0x00);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n",
-								__func__);
-		return ret;
-	}
-
-	return 0;
-
-reghold_off:
-	ret = imx676_write_reg(imx676, REGHOLD, 1, 0x00);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n",
-								__func__);
-		return ret;
-	}
-	return ret;
-
-}
-
-static int imx676_write_table(struct imx676 *imx676,
-				 const struct imx676_reg *regs, u32 len)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
-	unsigned int i;
-	int ret;
-
-	for (i = 0; i < len; i++) {
-		ret = imx676_write_reg(imx676, regs[i].address, 1, regs[i].val);
-		if (ret) {
-			dev_err_ratelimited(&client->dev,
-					"Failed to write reg 0x%4.4x. error = %d\n",
-					regs[i].address, ret);
-
-			return ret;
-		}
-	}
-
-	return 0;
-}
-
 static u32 imx676_get_format_code(struct imx676 *imx676, u32 code)
 {
 	unsigned int i;
 
-	lockdep_assert_held(&imx676->mutex);
+	lockdep_assert_held(&imx676->core.mutex);
 
 	for (i = 0; i < ARRAY_SIZE(codes); i++)
 		if (codes[i] == code)
@@ -477,7 +373,7 @@ static int imx676_open(struct v4l2_subdev *sd, struct v4l2_subdev_fh *fh)
 		v4l2_subdev_get_try_format(sd, fh->state, METADATA_PAD);
 	struct v4l2_rect *try_crop;
 
-	mutex_lock(&imx676->mutex);
+	mutex_lock(&imx676->core.mutex);
 
 	try_fmt_img->width = modes_12bit[0].width;
 	try_fmt_img->height = modes_12bit[0].height;
@@ -496,7 +392,7 @@ static int imx676_open(struct v4l2_subdev *sd, struct v4l2_subdev_fh *fh)
 	try_crop->width = IMX676_PIXEL_ARRAY_WIDTH;
 	try_crop->height = IMX676_PIXEL_ARRAY_HEIGHT;
 
-	mutex_unlock(&imx676->mutex);
+	mutex_unlock(&imx676->core.mutex);
 
 	return 0;
 }
@@ -511,17 +407,23 @@ static bool imx676_is_binning_mode(struct imx676 *imx676)
 		return false;
 }
 
+static bool imx676_is_window_mode(const struct imx676_mode *mode)
+{
+	return mode->reg_list.regs == mode_crop_3552x2160 ||
+	       mode->reg_list.regs == mode_crop_1768x1080;
+}
+
 static int imx676_set_exposure(struct imx676 *imx676, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
 	struct device *dev = &client->dev;
 	const struct imx676_mode *mode = imx676->mode;
 	u64 exposure;
 	int ret;
 
-	exposure = imx676->vblank->val + mode->height - val;
+	exposure = imx676->core.vblank->val + mode->height - val;
 
-	ret = imx676_write_hold_reg(imx676, SHR0_LOW, 3, exposure);
+	ret = fr_sensor_write_hold_reg(&imx676->core, SHR0_LOW, 3, exposure);
 	if (ret) {
 		dev_err(dev, "%s failed to set exposure\n", __func__);
 		return ret;
@@ -535,7 +437,7 @@ static void imx676_adjust_exposure_range(struct imx676 *imx676)
 	const struct imx676_mode *mode = imx676->mode;
 	u64 exposure_max;
 
-	exposure_max = imx676->vblank->val + mode->height - IMX676_MIN_SHR0_LENGTH;
+	exposure_max = imx676->core.vblank->val + mode->height - IMX676_MIN_SHR0_LENGTH;
 
 	__v4l2_ctrl_modify_range(imx676->exposure, IMX676_MIN_INTEGRATION_LINES,
 				exposure_max, 1,
@@ -544,11 +446,12 @@ static void imx676_adjust_exposure_range(struct imx676 *imx676)
 
 static int imx676_set_frame_rate(struct imx676 *imx676, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
-	ret = imx676_write_hold_reg(imx676, VMAX_LOW, 3, imx676->frame_length);
+	ret = fr_sensor_write_hold_reg(&imx676->core, VMAX_LOW, 3,
+				imx676->core.frame_length);
 
 	if (ret) {
 		dev_err(dev, "%s failed to set frame rate\n", __func__);
@@ -559,52 +462,83 @@ static int imx676_set_frame_rate(struct imx676 *imx676, u64 val)
 
 }
 
-static void imx676_update_frame_rate(struct imx676 *imx676, u64 val)
+static int imx676_set_hmax_register(struct imx676 *imx676)
 {
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
+	struct device *dev = &client->dev;
+	int ret;
 
-	const struct imx676_mode *mode = imx676->mode;
-	u32 update_vblank;
+	ret = fr_sensor_write_hold_reg(&imx676->core, HMAX_LOW, 2,
+				imx676->core.hmax);
+	if (ret)
+		dev_err(dev, "%s failed to write HMAX register\n", __func__);
 
-	imx676->frame_length = (IMX676_M_FACTOR * IMX676_G_FACTOR) /
-						(val * imx676->line_time);
-	imx676->frame_length = (imx676->frame_length % 2) ?
-				imx676->frame_length + 1 : imx676->frame_length;
+	dev_dbg(dev, "%s: hmax: 0x%x\n", __func__, imx676->core.hmax);
 
-	update_vblank = imx676->frame_length - mode->height;
+	return ret;
 
-	__v4l2_ctrl_modify_range(imx676->vblank, update_vblank,
-				 update_vblank, 1, update_vblank);
+}
 
-	__v4l2_ctrl_s_ctrl(imx676->vblank, update_vblank);
+static u32 imx676_min_frame_length(struct imx676 *imx676)
+{
+	const struct imx676_mode *mode = imx676->mode;
+
+	if (imx676_is_binning_mode(imx676))
+		return mode->height * 2 + IMX676_MIN_FRAME_LENGTH_DELTA;
 
+	return mode->height + IMX676_MIN_FRAME_LENGTH_DELTA;
 }
 
-static int imx676_set_hmax_register(struct imx676 *imx676)
+static int imx676_set_window_position(struct imx676 *imx676)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
 	struct device *dev = &client->dev;
-	const struct imx676_mode *mode = imx676->mode;
 	int ret;
 
-	ret = imx676_write_hold_reg(imx676, HMAX_LOW, 2, mode->hmax);
+	ret = fr_sensor_write_reg(&imx676->core, REGHOLD, 1, 0x01);
+	if (ret) {
+		dev_err(dev, "%s failed to write reghold register\n",
+								__func__);
+		return ret;
+	}
+
+	ret = fr_sensor_write_reg(&imx676->core, PIX_HST_LOW, 2,
+				imx676->crop.left);
 	if (ret)
-		dev_err(dev, "%s failed to write HMAX register\n", __func__);
+		goto reghold_off;
 
-	dev_dbg(dev, "%s: hmax: 0x%x\n", __func__, mode->hmax);
+	ret = fr_sensor_write_reg(&imx676->core, PIX_VST_LOW, 2,
+				imx676->crop.top);
+	if (ret)
+		goto reghold_off;
 
-	return ret;
+	ret = fr_sensor_write_reg(&imx676->core, REGHOLD, 1, 0x00);
+	if (ret) {
+		dev_err(dev, "%s failed to write reghold register\n",
+								__func__);
+		return ret;
+	}
+
+	dev_dbg(dev, "%s: window start: (%d, %d)\n", __func__,
+				imx676->crop.left, imx676->crop.top);
+
+	return 0;
 
+reghold_off:
+	dev_err(dev, "%s failed to write window start\n", __func__);
+	fr_sensor_write_reg(&imx676->core, REGHOLD, 1, 0x00);
+	return ret;
 }
 
 static int imx676_set_data_rate(struct imx676 *imx676)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
 	switch (imx676->mode->linkfreq) {
 	case _IMX676_LINK_FREQ_1440:
-		ret = imx676_write_reg(imx676, DATARATE_SEL, 1, 0x03);
+		ret = fr_sensor_write_reg(&imx676->core, DATARATE_SEL, 1, 0x03);
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
 								__func__);
@@ -612,7 +546,7 @@ static int imx676_set_data_rate(struct imx676 *imx676)
 		}
 		break;
 	case _IMX676_LINK_FREQ_891:
-		ret = imx676_write_reg(imx676, DATARATE_SEL, 1, 0x05);
+		ret = fr_sensor_write_reg(&imx676->core, DATARATE_SEL, 1, 0x05);
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
 								__func__);
@@ -620,7 +554,7 @@ static int imx676_set_data_rate(struct imx676 *imx676)
 		}
 		break;
 	case _IMX676_LINK_FREQ_720:
-		ret = imx676_write_reg(imx676, DATARATE_SEL, 1, 0x06);
+		ret = fr_sensor_write_reg(&imx676->core, DATARATE_SEL, 1, 0x06);
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
 								__func__);
@@ -628,7 +562,7 @@ static int imx676_set_data_rate(struct imx676 *imx676)
 		}
 		break;
 	case _IMX676_LINK_FREQ_594:
-		ret = imx676_write_reg(imx676, DATARATE_SEL, 1, 0x07);
+		ret = fr_sensor_write_reg(&imx676->core, DATARATE_SEL, 1, 0x07);
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
 								__func__);
@@ -645,21 +579,24 @@ static int imx676_set_data_rate(struct imx676 *imx676)
 
 static int imx676_set_test_pattern(struct imx676 *imx676, u32 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
 	if (val) {
-		ret = imx676_write_table(imx676, mode_enable_pattern_generator,
+		ret = fr_sensor_write_table(&imx676->core,
+				mode_enable_pattern_generator,
 				ARRAY_SIZE(mode_enable_pattern_generator));
 		if (ret)
 			goto fail;
 
-		ret = imx676_write_reg(imx676, TPG_PATSEL_DUOUT, 1, val - 1);
+		ret = fr_sensor_write_reg(&imx676->core, TPG_PATSEL_DUOUT, 1,
+					val - 1);
 		if (ret)
 			goto fail;
 	} else {
-		ret = imx676_write_table(imx676, mode_disable_pattern_generator,
+		ret = fr_sensor_write_table(&imx676->core,
+				mode_disable_pattern_generator,
 				ARRAY_SIZE(mode_disable_pattern_generator));
 		if (ret)
 			goto fail;
@@ -675,7 +612,7 @@ fail:
 
 static void imx676_update_blklvl_range(struct imx676 *imx676)
 {
-	switch (imx676->fmt_code) {
+	switch (imx676->core.fmt_code) {
 	case MEDIA_BUS_FMT_SRGGB12_1X12:
 		__v4l2_ctrl_modify_range(imx676->blklvl, IMX676_BLACK_LEVEL_MIN,
 					IMX676_MAX_BLACK_LEVEL_12BPP,
@@ -696,17 +633,18 @@ static void imx676_update_blklvl_range(struct imx676 *imx676)
 
 static int imx676_set_blklvl(struct imx676 *imx676, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
 	struct device *dev = &client->dev;
 	u64 black_level_reg;
 	int ret;
 
-	if (imx676->fmt_code == MEDIA_BUS_FMT_SRGGB10_1X10)
+	if (imx676->core.fmt_code == MEDIA_BUS_FMT_SRGGB10_1X10)
 		black_level_reg = val;
 	else
 		black_level_reg = val >> 2;
 
-	ret = imx676_write_hold_reg(imx676, BLKLEVEL_LOW, 2, black_level_reg);
+	ret = fr_sensor_write_hold_reg(&imx676->core, BLKLEVEL_LOW, 2,
+				black_level_reg);
 
 	if (ret) {
 		dev_err(dev, "%s failed to adjust blklvl register\n",
@@ -727,7 +665,7 @@ static int imx676_set_operation_mode(struct imx676 *imx676, u32 val)
 
 static int imx676_set_sync_mode(struct imx676 *imx676, u32 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
 	struct device *dev = &client->dev;
 	int ret = 0;
 	u8 extmode;
@@ -737,7 +675,7 @@ static int imx676_set_sync_mode(struct imx676 *imx676, u32 val)
 	else
 		extmode = 0;
 
-	ret = imx676_write_reg(imx676, EXTMODE, 1, extmode);
+	ret = fr_sensor_write_reg(&imx676->core, EXTMODE, 1, extmode);
 	if (ret)
 		dev_err(dev, "%s: error setting sync mode\n", __func__);
 
@@ -746,7 +684,7 @@ static int imx676_set_sync_mode(struct imx676 *imx676, u32 val)
 
 static int imx676_configure_triggering_pins(struct imx676 *imx676)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
 	struct device *dev = &client->dev;
 	int ret = 0;
 	u8 xvs_xhs_drv = 0xF;
@@ -775,12 +713,35 @@ static int imx676_configure_triggering_pins(struct imx676 *imx676)
 		return -EINVAL;
 	}
 
-	ret = imx676_write_reg(imx676, XVS_XHS_DRV, 1, xvs_xhs_drv);
+	ret = fr_sensor_write_reg(&imx676->core, XVS_XHS_DRV, 1, xvs_xhs_drv);
 	if (ret) {
 		dev_err(dev, "%s: error setting Slave mode\n", __func__);
 		return ret;
 	}
 
+	/*
+	 * Forward XVS over the GMSL link in the direction it is driven:
+	 * from the sensor to the host in internal sync master mode, from the
+	 * host to the sensor in slave mode.
+	 */
+	if (fr_sensor_is_gmsl(&imx676->core)) {
+		if (xvs_xhs_drv == 0x0) {
+			ret = max96793_xvs_setup(imx676->core.ser_dev,
+							max96793_IN);
+			ret |= max96792_xvs_setup(imx676->core.dser_dev,
+							max96792_OUT);
+		} else if (imx676->operation_mode->val == SLAVE_MODE) {
+			ret = max96793_xvs_setup(imx676->core.ser_dev,
+							max96793_OUT);
+			ret |= max96792_xvs_setup(imx676->core.dser_dev,
+							max96792_IN);
+		}
+		if (ret) {
+			dev_err(dev, "%s: error forwarding XVS\n", __func__);
+			return ret;
+		}
+	}
+
 	dev_dbg(dev, "%s: XVS_XHS driver register: 0x%x\n", __func__, xvs_xhs_drv);
 
 	return 0;
@@ -790,24 +751,34 @@ static int imx676_set_ctrl(struct v4l2_ctrl *ctrl)
 {
 	struct imx676 *imx676 =
 		container_of(ctrl->handler, struct imx676, ctrl_handler);
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
 	int ret = 0;
 
 	switch (ctrl->id) {
 	case V4L2_CID_FRAME_RATE:
-		imx676_update_frame_rate(imx676, ctrl->val);
+		fr_sensor_update_frame_rate(&imx676->core, ctrl->val);
 		break;
 	case V4L2_CID_VBLANK:
 		imx676_adjust_exposure_range(imx676);
 		break;
 	}
 
-	if (pm_runtime_get_if_in_use(&client->dev) == 0)
+	/*
+	 * Controls are written whenever the sensor is powered, so that a
+	 * staged configuration stays valid. Otherwise they are applied on the
+	 * next staging or stream start.
+	 */
+	if (pm_runtime_get_if_active(&client->dev, true) <= 0) {
+		imx676->core.staged = false;
 		return 0;
+	}
+
+	WRITE_ONCE(imx676->core.i2c_class, FR_I2C_CONTROL);
 
 	switch (ctrl->id) {
 	case V4L2_CID_ANALOGUE_GAIN:
-		ret = imx676_write_hold_reg(imx676, GAIN0_LOW, 2, ctrl->val);
+		ret = fr_sensor_write_hold_reg(&imx676->core, GAIN0_LOW, 2,
+					ctrl->val);
 		break;
 	case V4L2_CID_EXPOSURE:
 		ret = imx676_set_exposure(imx676, ctrl->val);
@@ -816,10 +787,12 @@ static int imx676_set_ctrl(struct v4l2_ctrl *ctrl)
 		imx676_set_test_pattern(imx676, ctrl->val);
 		break;
 	case V4L2_CID_HFLIP:
-		ret = imx676_write_reg(imx676, HREVERSE, 1, ctrl->val);
+		ret = fr_sensor_write_reg(&imx676->core, HREVERSE, 1,
+					ctrl->val);
 		break;
 	case V4L2_CID_VFLIP:
-		ret = imx676_write_reg(imx676, VREVERSE, 1, ctrl->val);
+		ret = fr_sensor_write_reg(&imx676->core, VREVERSE, 1,
+					ctrl->val);
 		break;
 	case V4L2_CID_FRAME_RATE:
 		ret = imx676_set_frame_rate(imx676, ctrl->val);
@@ -829,13 +802,17 @@ static int imx676_set_ctrl(struct v4l2_ctrl *ctrl)
 		break;
 	case V4L2_CID_OPERATION_MODE:
 		ret = imx676_set_operation_mode(imx676, ctrl->val);
+		fr_sensor_invalidate_staging(&imx676->core);
 		break;
 	case V4L2_CID_SYNC_MODE:
 		ret = imx676_set_sync_mode(imx676, ctrl->val);
+		fr_sensor_invalidate_staging(&imx676->core);
 		break;
 	}
 
-	pm_runtime_put(&client->dev);
+	WRITE_ONCE(imx676->core.i2c_class, FR_I2C_OTHER);
+
+	pm_runtime_put_autosuspend(&client->dev);
 
 	return ret;
 }
@@ -944,11 +921,11 @@ static int imx676_get_pad_format(struct v4l2_subdev *sd,
 	if (fmt->pad >= NUM_PADS)
 		return -EINVAL;
 
-	mutex_lock(&imx676->mutex);
+	mutex_lock(&imx676->core.mutex);
 
 	if (fmt->which == V4L2_SUBDEV_FORMAT_TRY) {
 		struct v4l2_mbus_framefmt *try_fmt =
-			v4l2_subdev_get_try_format(&imx676->sd, sd_state,
+			v4l2_subdev_get_try_format(&imx676->core.sd, sd_state,
 							fmt->pad);
 		try_fmt->code = fmt->pad == IMAGE_PAD ?
 				imx676_get_format_code(imx676, try_fmt->code) :
@@ -960,19 +937,19 @@ static int imx676_get_pad_format(struct v4l2_subdev *sd,
 								fmt);
 			fmt->format.code =
 					imx676_get_format_code(imx676,
-								imx676->fmt_code);
+								imx676->core.fmt_code);
 		} else {
 			imx676_update_metadata_pad_format(fmt);
 		}
 	}
 
-	mutex_unlock(&imx676->mutex);
+	mutex_unlock(&imx676->core.mutex);
 	return 0;
 }
 
 static void imx676_set_limits(struct imx676 *imx676)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
 	struct device *dev = &client->dev;
 	const struct imx676_mode *mode = imx676->mode;
 	u64 vblank, max_framerate;
@@ -981,7 +958,7 @@ static void imx676_set_limits(struct imx676 *imx676)
 
 	vblank = IMX676_MIN_FRAME_LENGTH_DELTA;
 
-	__v4l2_ctrl_modify_range(imx676->vblank, vblank,
+	__v4l2_ctrl_modify_range(imx676->core.vblank, vblank,
 				 vblank, 1, vblank);
 	dev_dbg(dev, "%s: vblank: %lld\n", __func__, vblank);
 
@@ -989,7 +966,7 @@ static void imx676_set_limits(struct imx676 *imx676)
 				 mode->pixel_rate, 1, mode->pixel_rate);
 	dev_dbg(dev, "%s: pixel rate: %d\n", __func__, mode->pixel_rate);
 
-	if (!(strcmp(imx676->gmsl, "gmsl")))
+	if (fr_sensor_is_gmsl(&imx676->core))
 		__v4l2_ctrl_s_ctrl(imx676->link_freq, _GMSL_LINK_FREQ_1500);
 	else
 		__v4l2_ctrl_s_ctrl(imx676->link_freq, mode->linkfreq);
@@ -997,26 +974,28 @@ static void imx676_set_limits(struct imx676 *imx676)
 	dev_dbg(dev, "%s: linkfreq: %lld\n", __func__,
 					imx676_link_freq_menu[mode->linkfreq]);
 
-	imx676->line_time = (mode->hmax*IMX676_G_FACTOR) / (IMX676_XCLK_FREQ);
-	dev_dbg(dev, "%s: line time: %lld\n", __func__, imx676->line_time);
+	fr_sensor_set_hmax(&imx676->core, mode->hmax);
+	imx676->core.interval_fps = 0;
+	dev_dbg(dev, "%s: line time: %lld\n", __func__, imx676->core.line_time);
 
 	if (imx676_is_binning_mode(imx676))
-		imx676->frame_length = mode->height * 2 + vblank;
+		imx676->core.frame_length = mode->height * 2 + vblank;
 	else
-		imx676->frame_length = mode->height + vblank;
+		imx676->core.frame_length = mode->height + vblank;
 
-	dev_dbg(dev, "%s: frame length: %d\n", __func__, imx676->frame_length);
+	dev_dbg(dev, "%s: frame length: %d\n", __func__,
+						imx676->core.frame_length);
 
 	max_framerate = (IMX676_G_FACTOR * IMX676_M_FACTOR) /
-				(imx676->frame_length * imx676->line_time);
+			(imx676->core.frame_length * imx676->core.line_time);
 
-	__v4l2_ctrl_modify_range(imx676->framerate, mode->min_fps,
+	__v4l2_ctrl_modify_range(imx676->core.framerate, mode->min_fps,
 				 max_framerate, 1, max_framerate);
 	dev_dbg(dev, "%s: max framerate: %lld\n", __func__, max_framerate);
 
 	imx676_update_blklvl_range(imx676);
 
-	__v4l2_ctrl_s_ctrl(imx676->framerate, max_framerate);
+	__v4l2_ctrl_s_ctrl(imx676->core.framerate, max_framerate);
 }
 
 static int imx676_set_pad_format(struct v4l2_subdev *sd,
@@ -1030,7 +1009,7 @@ static int imx676_set_pad_format(struct v4l2_subdev *sd,
 	if (fmt->pad >= NUM_PADS)
 		return -EINVAL;
 
-	mutex_lock(&imx676->mutex);
+	mutex_lock(&imx676->core.mutex);
 
 	if (fmt->pad == IMAGE_PAD) {
 		const struct imx676_mode *mode_list;
@@ -1053,8 +1032,10 @@ static int imx676_set_pad_format(struct v4l2_subdev *sd,
 			*framefmt = fmt->format;
 		} else if (imx676->mode != mode) {
 			imx676->mode = mode;
-			imx676->fmt_code = fmt->format.code;
+			imx676->crop = mode->crop;
+			imx676->core.fmt_code = fmt->format.code;
 			imx676_set_limits(imx676);
+			fr_sensor_invalidate_staging(&imx676->core);
 		}
 	} else {
 		if (fmt->which == V4L2_SUBDEV_FORMAT_TRY) {
@@ -1066,7 +1047,7 @@ static int imx676_set_pad_format(struct v4l2_subdev *sd,
 		}
 	}
 
-	mutex_unlock(&imx676->mutex);
+	mutex_unlock(&imx676->core.mutex);
 
 	return 0;
 }
@@ -1078,9 +1059,9 @@ __imx676_get_pad_crop(struct imx676 *imx676,
 {
 	switch (which) {
 	case V4L2_SUBDEV_FORMAT_TRY:
-		return v4l2_subdev_get_try_crop(&imx676->sd, sd_state, pad);
+		return v4l2_subdev_get_try_crop(&imx676->core.sd, sd_state, pad);
 	case V4L2_SUBDEV_FORMAT_ACTIVE:
-		return &imx676->mode->crop;
+		return &imx676->crop;
 	}
 
 	return NULL;
@@ -1094,10 +1075,10 @@ static int imx676_get_selection(struct v4l2_subdev *sd,
 	case V4L2_SEL_TGT_CROP: {
 		struct imx676 *imx676 = to_imx676(sd);
 
-		mutex_lock(&imx676->mutex);
+		mutex_lock(&imx676->core.mutex);
 		sel->r = *__imx676_get_pad_crop(imx676, sd_state, sel->pad,
 						sel->which);
-		mutex_unlock(&imx676->mutex);
+		mutex_unlock(&imx676->core.mutex);
 
 		return 0;
 	}
@@ -1123,358 +1104,216 @@ static int imx676_get_selection(struct v4l2_subdev *sd,
 	return -EINVAL;
 }
 
-static int imx676_set_mode(struct imx676 *imx676)
+static int imx676_set_selection(struct v4l2_subdev *sd,
+				struct v4l2_subdev_state *sd_state,
+				struct v4l2_subdev_selection *sel)
 {
+	struct imx676 *imx676 = to_imx676(sd);
+	struct v4l2_rect *crop;
+	struct v4l2_rect prev;
+	int ret = 0;
 
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
-	struct device *dev = &client->dev;
-	const struct imx676_reg_list *reg_list;
-	int ret;
+	if (sel->target != V4L2_SEL_TGT_CROP || sel->pad != IMAGE_PAD)
+		return -EINVAL;
 
-	ret = imx676_write_table(imx676, mode_common_regs,
-					ARRAY_SIZE(mode_common_regs));
+	mutex_lock(&imx676->core.mutex);
 
-	if (ret) {
-		dev_err(dev, "%s failed to set common settings\n", __func__);
-		return ret;
+	if (sel->which == V4L2_SUBDEV_FORMAT_TRY)
+		crop = v4l2_subdev_get_try_crop(sd, sd_state, sel->pad);
+	else
+		crop = &imx676->crop;
+
+	/*
+	 * Only the window start can be changed, the window size is defined
+	 * by the selected mode. Sensor readout modes that do not use window
+	 * cropping keep their fixed position.
+	 */
+	if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE &&
+	    !imx676_is_window_mode(imx676->mode)) {
+		sel->r = *crop;
+		goto unlock;
 	}
 
-	reg_list = &imx676->mode->reg_list;
-	ret = imx676_write_table(imx676, reg_list->regs, reg_list->num_of_regs);
-	if (ret) {
-		dev_err(dev, "%s failed to set mode\n", __func__);
-		return ret;
+	prev = *crop;
+
+	crop->left = clamp_t(s32, sel->r.left, IMX676_PIXEL_ARRAY_LEFT,
+			     IMX676_PIXEL_ARRAY_WIDTH - crop->width);
+	crop->left = round_down(crop->left, IMX676_WINDOW_H_STEP);
+	crop->top = clamp_t(s32, sel->r.top, IMX676_PIXEL_ARRAY_TOP,
+			    IMX676_PIXEL_ARRAY_HEIGHT - crop->height);
+	crop->top = round_down(crop->top, IMX676_WINDOW_V_STEP);
+
+	/*
+	 * While streaming the new start position is written inside a
+	 * register hold group, so the sensor switches to it on the next
+	 * frame boundary without a stream restart.
+	 */
+	if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE && imx676->core.streaming &&
+	    (crop->left != prev.left || crop->top != prev.top)) {
+		ret = imx676_set_window_position(imx676);
+		if (ret)
+			*crop = prev;
+	} else if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE &&
+		   (crop->left != prev.left || crop->top != prev.top)) {
+		fr_sensor_invalidate_staging(&imx676->core);
 	}
 
-	reg_list = &imx676->mode->reg_list_format;
-	ret = imx676_write_table(imx676, reg_list->regs, reg_list->num_of_regs);
-	if (ret) {
-		dev_err(dev, "%s failed to set frame format\n", __func__);
-		return ret;
-	}
+	sel->r = *crop;
 
-	ret = imx676_set_hmax_register(imx676);
-	if (ret) {
-		dev_err(dev, "%s failed to write hmax register\n", __func__);
-		return ret;
-	}
+unlock:
+	mutex_unlock(&imx676->core.mutex);
 
-	ret = imx676_set_data_rate(imx676);
-	if (ret) {
-		dev_err(dev, "%s failed to set data rate\n", __func__);
-		return ret;
-	}
+	return ret;
+}
 
-	ret = imx676_configure_triggering_pins(imx676);
-	if (ret) {
-		dev_err(dev, "%s failed to configure triggering pins\n",
-								__func__);
-		return ret;
-	}
+/*
+ * Describe the CSI-2 stream seen by the receiver: the image on the data
+ * type of the active format and the virtual channel it arrives on.
+ */
+static int imx676_get_frame_desc(struct v4l2_subdev *sd, unsigned int pad,
+				 struct v4l2_mbus_frame_desc *fd)
+{
+	struct imx676 *imx676 = to_imx676(sd);
+	struct v4l2_mbus_frame_desc_entry *entry;
+	u8 vc = 0;
 
-	return ret;
+	if (pad >= NUM_PADS)
+		return -EINVAL;
+
+	if (fr_sensor_is_gmsl(&imx676->core))
+		vc = imx676->core.g_ctx.dst_vc;
+
+	memset(fd, 0, sizeof(*fd));
+	fd->type = V4L2_MBUS_FRAME_DESC_TYPE_CSI2;
+
+	mutex_lock(&imx676->core.mutex);
+
+	entry = &fd->entry[fd->num_entries++];
+	entry->stream = IMAGE_PAD;
+	entry->pixelcode = imx676->core.fmt_code;
+	entry->bus.csi2.vc = vc;
+	entry->bus.csi2.dt =
+		imx676->core.fmt_code == MEDIA_BUS_FMT_SRGGB10_1X10 ?
+		MIPI_CSI2_DT_RAW10 : MIPI_CSI2_DT_RAW12;
+
+	mutex_unlock(&imx676->core.mutex);
+
+	return 0;
 }
 
-static int imx676_start_streaming(struct imx676 *imx676)
+static int imx676_set_mode(struct fr_sensor *core)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
-	struct device *dev = &client->dev;
+	struct imx676 *imx676 = core_to_imx676(core);
+	struct device *dev = &core->client->dev;
+	const struct fr_sensor_reg_list *reg_list;
+	ktime_t start = ktime_get();
 	int ret;
 
-	if (!(strcmp(imx676->gmsl, "gmsl"))) {
-		ret = max96793_setup_streaming(imx676->ser_dev, imx676->fmt_code);
-		if (ret) {
-			dev_err(dev, "%s: Unable to setup streaming for serializer max96793\n",
-								__func__);
-			return ret;
-		}
-		ret = max96792_setup_streaming(imx676->dser_dev,
-							&client->dev);
-		if (ret) {
-			dev_err(dev, "%s: Unable to setup streaming for deserializer max96792\n",
-								__func__);
-			return ret;
-		}
-		ret = max96792_start_streaming(imx676->dser_dev, &client->dev);
+	/*
+	 * Common settings survive STREAMOFF/STREAMON, they only have to be
+	 * written once after the sensor has been powered up.
+	 */
+	if (!core->common_regs_written) {
+		ret = fr_sensor_write_table(core, mode_common_regs,
+					ARRAY_SIZE(mode_common_regs));
 		if (ret) {
-			dev_err(dev, "%s: Unable to start gmsl streaming\n",
+			dev_err(dev, "%s failed to set common settings\n",
 								__func__);
 			return ret;
 		}
-	}
 
-	ret = imx676_set_mode(imx676);
-	if (ret) {
-		dev_err(dev, "%s failed to set mode start stream\n", __func__);
-		return ret;
+		core->common_regs_written = true;
+		start = fr_latency_record(&core->latency,
+					  FR_STAGE_COMMON_REGS, start);
 	}
 
-	ret = __v4l2_ctrl_handler_setup(imx676->sd.ctrl_handler);
-	if (ret)
-		return ret;
-
-	ret = imx676_write_reg(imx676, STANDBY, 1, IMX676_MODE_STREAMING);
-
+	reg_list = &imx676->mode->reg_list;
+	ret = __fr_sensor_write_table(core, reg_list->regs,
+				   reg_list->num_of_regs, "mode");
 	if (ret) {
-		dev_err(dev, "%s failed to set STANDBY start stream\n",
-								__func__);
+		dev_err(dev, "%s failed to set mode\n", __func__);
 		return ret;
 	}
 
-	usleep_range(29000, 30000);
-
-	if (imx676->operation_mode->val == MASTER_MODE)
-		ret = imx676_write_reg(imx676, XMSTA, 1, 0x00);
-	else
-		ret = imx676_write_reg(imx676, XMSTA, 1, 0x01);
-
+	reg_list = &imx676->mode->reg_list_format;
+	ret = __fr_sensor_write_table(core, reg_list->regs,
+				   reg_list->num_of_regs, "format");
 	if (ret) {
-		dev_err(dev, "%s failed to set XMSTA start stream\n", __func__);
+		dev_err(dev, "%s failed to set frame format\n", __func__);
 		return ret;
 	}
 
-	return ret;
-}
-
-static void imx676_stop_streaming(struct imx676 *imx676)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
-	struct device *dev = &client->dev;
-	int ret;
-
-	if (!(strcmp(imx676->gmsl, "gmsl"))) {
-		max96793_bypassPCLK_dis(imx676->ser_dev);
-		max96792_stop_streaming(imx676->dser_dev, &client->dev);
-	}
-
-	ret = imx676_write_reg(imx676, XMSTA, 1, 0x01);
-	if (ret)
-		dev_err(dev, "%s failed to set XMSTA stop stream\n", __func__);
-
-	ret = imx676_write_reg(imx676, STANDBY, 1, IMX676_MODE_STANDBY);
-	if (ret)
-		dev_err(dev, "%s failed to set stream\n", __func__);
-
-	usleep_range(imx676->frame_length * imx676->line_time / IMX676_K_FACTOR,
-		imx676->frame_length * imx676->line_time / IMX676_K_FACTOR + 1000);
-
-}
-
-static int imx676_set_stream(struct v4l2_subdev *sd, int enable)
-{
-	struct imx676 *imx676 = to_imx676(sd);
-	struct i2c_client *client = v4l2_get_subdevdata(sd);
-	int ret = 0;
-
-	mutex_lock(&imx676->mutex);
-	if (imx676->streaming == enable) {
-		mutex_unlock(&imx676->mutex);
-		return 0;
-	}
-
-	if (enable) {
-		ret = pm_runtime_get_sync(&client->dev);
-		if (ret < 0) {
-			pm_runtime_put_noidle(&client->dev);
-			goto err_unlock;
-		}
-
-		ret = imx676_start_streaming(imx676);
+	if (imx676_is_window_mode(imx676->mode)) {
+		ret = imx676_set_window_position(imx676);
 		if (ret)
-			goto err_rpm_put;
-	} else {
-		imx676_stop_streaming(imx676);
-		pm_runtime_put(&client->dev);
-	}
-
-	imx676->streaming = enable;
-
-	__v4l2_ctrl_grab(imx676->vflip, enable);
-	__v4l2_ctrl_grab(imx676->hflip, enable);
-	__v4l2_ctrl_grab(imx676->operation_mode, enable);
-	__v4l2_ctrl_grab(imx676->sync_mode, enable);
-
-	mutex_unlock(&imx676->mutex);
-
-	return ret;
-
-err_rpm_put:
-	pm_runtime_put(&client->dev);
-err_unlock:
-	mutex_unlock(&imx676->mutex);
-
-	return ret;
-}
-
-static int imx676_gmsl_serdes_setup(struct imx676 *imx676)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
-	struct device *dev = &client->dev;
-	int ret = 0;
-	int des_err = 0;
-
-	if (!imx676 || !imx676->ser_dev || !imx676->dser_dev || !client)
-		return -EINVAL;
-
-	dev_dbg(dev, "enter %s function\n", __func__);
-
-	mutex_lock(&imx676->mutex);
-
-	ret = max96792_reset_control(imx676->dser_dev, &client->dev);
-
-	ret = max96792_gmsl3_setup(imx676->dser_dev);
-	if (ret) {
-		dev_err(dev, "deserializer gmsl setup failed\n");
-		goto error;
+			return ret;
 	}
 
-	ret = max96793_gmsl3_setup(imx676->ser_dev);
+	ret = imx676_set_hmax_register(imx676);
 	if (ret) {
-		dev_err(dev, "serializer gmsl setup failed\n");
-		goto error;
+		dev_err(dev, "%s failed to write hmax register\n", __func__);
+		return ret;
 	}
+	start = fr_latency_record(&core->latency, FR_STAGE_MODE_REGS,
+									start);
 
-	dev_dbg(dev, "%s: max96792_setup_link\n", __func__);
-	ret = max96792_setup_link(imx676->dser_dev, &client->dev);
+	ret = imx676_set_data_rate(imx676);
 	if (ret) {
-		dev_err(dev, "gmsl deserializer link config failed\n");
-		goto error;
+		dev_err(dev, "%s failed to set data rate\n", __func__);
+		return ret;
 	}
+	fr_latency_record(&core->latency, FR_STAGE_DATA_RATE, start);
 
-	dev_dbg(dev, "%s: max96793_setup_control\n", __func__);
-	ret = max96793_setup_control(imx676->ser_dev);
-
-	if (ret)
-		dev_err(dev, "gmsl serializer setup failed\n");
-
-	ret = max96793_gpio10_xtrig1_setup(imx676->ser_dev, "mipi");
+	ret = imx676_configure_triggering_pins(imx676);
 	if (ret) {
-		dev_err(dev, "gmsl serializer gpio10/xtrig1 pin config failed\n");
-		goto error;
+		dev_err(dev, "%s failed to configure triggering pins\n",
+								__func__);
+		return ret;
 	}
 
-	dev_dbg(dev, "%s: max96792_setup_control\n", __func__);
-	des_err = max96792_setup_control(imx676->dser_dev, &client->dev);
-	if (des_err)
-		dev_err(dev, "gmsl deserializer setup failed\n");
-
-error:
-	mutex_unlock(&imx676->mutex);
 	return ret;
 }
 
-static void imx676_gmsl_serdes_reset(struct imx676 *imx676)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
-
-	mutex_lock(&imx676->mutex);
-
-	max96793_reset_control(imx676->ser_dev);
-	max96792_reset_control(imx676->dser_dev, &client->dev);
-	max96792_power_off(imx676->dser_dev, &imx676->g_ctx);
-
-	mutex_unlock(&imx676->mutex);
-}
-
-static int imx676_power_on(struct device *dev)
-{
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx676 *imx676 = to_imx676(sd);
-
-	if (strcmp(imx676->gmsl, "gmsl")) {
-		gpiod_set_value_cansleep(imx676->reset_gpio, 1);
-		usleep_range(25000, 30000);
-	} else {
-		dev_info(dev, "%s: max96792_power_on\n", __func__);
-		max96792_power_on(imx676->dser_dev, &imx676->g_ctx);
-	}
-
-	return 0;
-}
-
-static int imx676_power_off(struct device *dev)
+static int imx676_communication_verify(struct imx676 *imx676)
 {
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx676 *imx676 = to_imx676(sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
+	struct device *dev = &client->dev;
 	int ret;
 
-	ret = imx676_write_reg(imx676, XVS_XHS_DRV, 1, 0xF);
+	ret = fr_sensor_identify(&imx676->core);
 	if (ret)
-		dev_err(dev, "%s: error setting XVS XHS to Hi-Z\n", __func__);
-
-	mutex_lock(&imx676->mutex);
-	if (strcmp(imx676->gmsl, "gmsl")) {
-		gpiod_set_value_cansleep(imx676->reset_gpio, 0);
-	} else {
-		dev_info(dev, "%s: max96792_power_off\n", __func__);
-		max96792_power_off(imx676->dser_dev, &imx676->g_ctx);
-	}
-	mutex_unlock(&imx676->mutex);
-
-	return 0;
-}
-
-static int __maybe_unused imx676_suspend(struct device *dev)
-{
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx676 *imx676 = to_imx676(sd);
+		return ret;
 
-	if (imx676->streaming)
-		imx676_stop_streaming(imx676);
+	dev_info(dev, "Detected imx676 sensor\n");
 
 	return 0;
 }
 
-static int __maybe_unused imx676_resume(struct device *dev)
+static int imx676_subscribe_event(struct v4l2_subdev *sd, struct v4l2_fh *fh,
+				  struct v4l2_event_subscription *sub)
 {
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
 	struct imx676 *imx676 = to_imx676(sd);
-	int ret;
-
-	if (imx676->streaming) {
-		ret = imx676_start_streaming(imx676);
-		if (ret)
-			goto error;
-	}
-
-	return 0;
 
-error:
-	imx676_stop_streaming(imx676);
-	imx676->streaming = 0;
-	return ret;
-}
-
-static int imx676_communication_verify(struct imx676 *imx676)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
-	struct device *dev = &client->dev;
-	int ret;
-	u32 val;
-
-	ret = imx676_read_reg(imx676, VMAX_LOW, 3, &val);
-
-	if (ret) {
-		dev_err(dev, "%s unable to communicate with sensor\n", __func__);
-		return ret;
+	switch (sub->type) {
+	case V4L2_EVENT_FRAME_SYNC:
+		if (imx676->core.xvs_irq <= 0)
+			return -EINVAL;
+		return v4l2_event_subscribe(fh, sub, IMX676_FRAME_SYNC_EVENTS,
+									NULL);
+	default:
+		return v4l2_ctrl_subdev_subscribe_event(sd, fh, sub);
 	}
-
-	dev_info(dev, "Detected imx676 sensor\n");
-
-	return 0;
 }
 
 static const struct v4l2_subdev_core_ops imx676_core_ops = {
-	.subscribe_event = v4l2_ctrl_subdev_subscribe_event,
+	.subscribe_event = imx676_subscribe_event,
 	.unsubscribe_event = v4l2_event_subdev_unsubscribe,
 };
 
 static const struct v4l2_subdev_video_ops imx676_video_ops = {
-	.s_stream = imx676_set_stream,
+	.s_stream = fr_sensor_s_stream,
+	.g_frame_interval = fr_sensor_g_frame_interval,
+	.s_frame_interval = fr_sensor_s_frame_interval,
 };
 
 static const struct v4l2_subdev_pad_ops imx676_pad_ops = {
@@ -1482,7 +1321,9 @@ static const struct v4l2_subdev_pad_ops imx676_pad_ops = {
 	.get_fmt = imx676_get_pad_format,
 	.set_fmt = imx676_set_pad_format,
 	.get_selection = imx676_get_selection,
+	.set_selection = imx676_set_selection,
 	.enum_frame_size = imx676_enum_frame_size,
+	.get_frame_desc = imx676_get_frame_desc,
 };
 
 static const struct v4l2_subdev_ops imx676_subdev_ops = {
@@ -1537,7 +1378,7 @@ static struct v4l2_ctrl_config imx676_ctrl_sync_mode[] = {
 static int imx676_init_controls(struct imx676 *imx676)
 {
 	struct v4l2_ctrl_handler *ctrl_hdlr;
-	struct i2c_client *client = v4l2_get_subdevdata(&imx676->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
 	struct device *dev = &client->dev;
 	struct v4l2_fwnode_device_properties props;
 	int ret;
@@ -1547,8 +1388,7 @@ static int imx676_init_controls(struct imx676 *imx676)
 	if (ret)
 		return ret;
 
-	mutex_init(&imx676->mutex);
-	ctrl_hdlr->lock = &imx676->mutex;
+	ctrl_hdlr->lock = &imx676->core.mutex;
 
 	imx676->pixel_rate = v4l2_ctrl_new_std(ctrl_hdlr, &imx676_ctrl_ops,
 						V4L2_CID_PIXEL_RATE, 0, 0, 1, 0);
@@ -1563,21 +1403,21 @@ static int imx676_init_controls(struct imx676 *imx676)
 	if (imx676->link_freq)
 		imx676->link_freq->flags |= V4L2_CTRL_FLAG_READ_ONLY;
 
-	imx676->vblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx676_ctrl_ops,
+	imx676->core.vblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx676_ctrl_ops,
 					V4L2_CID_VBLANK, 0, 0, 1, 0);
 
-	imx676->hblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx676_ctrl_ops,
+	imx676->core.hblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx676_ctrl_ops,
 					V4L2_CID_HBLANK, 0, 0, 1, 0);
 
-	if (imx676->hblank)
-		imx676->hblank->flags |= V4L2_CTRL_FLAG_READ_ONLY;
+	if (imx676->core.hblank)
+		imx676->core.hblank->flags |= V4L2_CTRL_FLAG_READ_ONLY;
 
 	imx676->exposure = v4l2_ctrl_new_std(ctrl_hdlr, &imx676_ctrl_ops,
 					V4L2_CID_EXPOSURE,
 					IMX676_MIN_INTEGRATION_LINES,
 					0xFF, 1, 0xFF);
 
-	imx676->framerate = v4l2_ctrl_new_custom(ctrl_hdlr,
+	imx676->core.framerate = v4l2_ctrl_new_custom(ctrl_hdlr,
 					imx676_ctrl_framerate, NULL);
 
 	imx676->operation_mode = v4l2_ctrl_new_custom(ctrl_hdlr,
@@ -1622,91 +1462,138 @@ static int imx676_init_controls(struct imx676 *imx676)
 	if (ret)
 		goto error;
 
-	imx676->sd.ctrl_handler = ctrl_hdlr;
+	imx676->core.grab_ctrls[0] = imx676->vflip;
+	imx676->core.grab_ctrls[1] = imx676->hflip;
+	imx676->core.grab_ctrls[2] = imx676->operation_mode;
+	imx676->core.grab_ctrls[3] = imx676->sync_mode;
+
+	imx676->core.sd.ctrl_handler = ctrl_hdlr;
 
-	mutex_lock(&imx676->mutex);
+	mutex_lock(&imx676->core.mutex);
 
 	imx676_set_limits(imx676);
 
-	mutex_unlock(&imx676->mutex);
+	mutex_unlock(&imx676->core.mutex);
 
 	return 0;
 
 error:
 	v4l2_ctrl_handler_free(ctrl_hdlr);
-	mutex_destroy(&imx676->mutex);
 
 	return ret;
 }
 
-static void imx676_free_controls(struct imx676 *imx676)
+/*
+ * Snapshot of the timing model the driver currently works with, one
+ * "key: value" pair per line. Times are derived from the line time, so
+ * userspace can plan exposure, trigger and CSI-2 bandwidth without
+ * repeating the driver's calculations.
+ */
+static int imx676_timing_show(struct seq_file *s, void *unused)
 {
-	v4l2_ctrl_handler_free(imx676->sd.ctrl_handler);
-	mutex_destroy(&imx676->mutex);
+	struct imx676 *imx676 = s->private;
+	const struct imx676_mode *mode;
+	u32 readout_lines;
+
+	mutex_lock(&imx676->core.mutex);
+
+	mode = imx676->mode;
+	readout_lines = imx676_min_frame_length(imx676) -
+					IMX676_MIN_FRAME_LENGTH_DELTA;
+
+	seq_printf(s, "mode: %ux%u\n", mode->width, mode->height);
+	seq_printf(s, "code: 0x%04x\n", imx676->core.fmt_code);
+	seq_printf(s, "hmax: %u\n", imx676->core.hmax);
+	seq_printf(s, "frame_length: %u\n", imx676->core.frame_length);
+	seq_printf(s, "line_time_ns: %llu\n", imx676->core.line_time);
+	seq_printf(s, "frame_time_us: %llu\n",
+		   imx676->core.frame_length * imx676->core.line_time /
+							IMX676_K_FACTOR);
+	seq_printf(s, "readout_lines: %u\n", readout_lines);
+	seq_printf(s, "readout_time_us: %llu\n",
+		   readout_lines * imx676->core.line_time / IMX676_K_FACTOR);
+	seq_printf(s, "min_shs_length: %d\n", IMX676_MIN_SHR0_LENGTH);
+	seq_printf(s, "min_frame_length_delta: %d\n",
+					IMX676_MIN_FRAME_LENGTH_DELTA);
+	seq_printf(s, "pixel_rate: %u\n", mode->pixel_rate);
+	seq_printf(s, "link_freq: %lld\n",
+				imx676_link_freq_menu[imx676->link_freq->val]);
+	seq_printf(s, "exposure_lines: %d\n", imx676->exposure->val);
+	seq_printf(s, "exposure_max_lines: %lld\n", imx676->exposure->maximum);
+
+	mutex_unlock(&imx676->core.mutex);
+
+	return 0;
 }
+DEFINE_SHOW_ATTRIBUTE(imx676_timing);
 
-static int imx676_check_hwcfg(struct device *dev, struct i2c_client *client)
+static void imx676_debugfs_init(struct imx676 *imx676)
 {
-	struct device_node *node = client->dev.of_node;
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx676 *imx676 = to_imx676(sd);
-	struct fwnode_handle *endpoint;
-	struct v4l2_fwnode_endpoint ep_cfg = {
-		.bus_type = V4L2_MBUS_CSI2_DPHY
-	};
-	const char *gmsl;
-	int ret = -EINVAL;
-
-	endpoint = fwnode_graph_get_next_endpoint(dev_fwnode(dev), NULL);
-	if (!endpoint) {
-		dev_err(dev, "endpoint node not found\n");
-		return -EINVAL;
-	}
+	struct i2c_client *client = v4l2_get_subdevdata(&imx676->core.sd);
+	char name[32];
 
-	if (v4l2_fwnode_endpoint_alloc_parse(endpoint, &ep_cfg)) {
-		dev_err(dev, "could not parse endpoint\n");
-		goto error_out;
-	}
+	snprintf(name, sizeof(name), "imx676-%s", dev_name(&client->dev));
 
-	if (ep_cfg.bus.mipi_csi2.num_data_lanes != 4) {
-		dev_err(dev, "only 4 data lanes are currently supported\n");
-		goto error_out;
-	}
+	imx676->debugfs = debugfs_create_dir(name, NULL);
+	debugfs_create_file("timing", 0444, imx676->debugfs, imx676,
+						&imx676_timing_fops);
+	fr_sensor_debugfs_create(&imx676->core, imx676->debugfs);
+}
 
-	if (!ep_cfg.nr_of_link_frequencies) {
-		dev_err(dev, "link-frequency property not found in DT\n");
-		goto error_out;
-	}
+static void imx676_free_controls(struct imx676 *imx676)
+{
+	v4l2_ctrl_handler_free(imx676->core.sd.ctrl_handler);
+}
 
-	if (ep_cfg.nr_of_link_frequencies != ARRAY_SIZE(imx676_link_freq_menu)) {
-		dev_err(dev, "Link frequency missing in dtree\n");
-		goto error_out;
-	}
+static bool imx676_is_master(struct fr_sensor *core)
+{
+	return core_to_imx676(core)->operation_mode->val == MASTER_MODE;
+}
 
-	for (int i = 0; i < ARRAY_SIZE(imx676_link_freq_menu); i++) {
-		if (ep_cfg.link_frequencies[i] != imx676_link_freq_menu[i]) {
-			dev_err(dev, "no supported link freq found\n");
-			goto error_out;
-		}
-	}
+static void imx676_frame_limits(struct fr_sensor *core,
+				struct fr_sensor_frame_limits *lim)
+{
+	struct imx676 *imx676 = core_to_imx676(core);
+	const struct imx676_mode *mode = imx676->mode;
 
-	ret = of_property_read_string(node, "gmsl", &gmsl);
-	if (ret) {
-		dev_warn(dev, "initializing mipi...\n");
-		imx676->gmsl = "mipi";
-	} else if (!strcmp(gmsl, "gmsl")) {
-		dev_warn(dev, "initializing GMSL...\n");
-		imx676->gmsl = "gmsl";
-	}
+	lim->width = mode->width;
+	lim->height = mode->height;
+	lim->pixel_rate = mode->pixel_rate;
+	lim->hmax_min = mode->hmax;
+	lim->vmax_min = imx676_min_frame_length(imx676);
+	lim->min_fps = mode->min_fps;
+}
 
-	ret = 0;
+/* XVS and XHS are left floating while the sensor is powered down */
+static void imx676_power_off(struct fr_sensor *core)
+{
+	if (fr_sensor_write_reg(core, XVS_XHS_DRV, 1, 0xF))
+		dev_err(&core->client->dev,
+			"%s: error setting XVS XHS to Hi-Z\n", __func__);
+}
 
-error_out:
-	v4l2_fwnode_endpoint_free(&ep_cfg);
-	fwnode_handle_put(endpoint);
+static const struct fr_sensor_ops imx676_sensor_ops = {
+	.set_mode = imx676_set_mode,
+	.is_master = imx676_is_master,
+	.frame_limits = imx676_frame_limits,
+	.power_off = imx676_power_off,
+};
 
-	return ret;
-}
+static const struct fr_sensor_desc imx676_desc = {
+	.reghold = REGHOLD,
+	.standby = STANDBY,
+	.xmsta = XMSTA,
+	.id_reg = VMAX_LOW,
+	.id_len = 3,
+	.xclk_freq = IMX676_XCLK_FREQ,
+	.hmax_max = IMX676_HMAX_MAX,
+	.vmax_max = IMX676_VMAX_MAX,
+	.vmax_step = IMX676_VMAX_STEP,
+	.settle_us = IMX676_STANDBY_SETTLE_US,
+	.link_freqs = imx676_link_freq_menu,
+	.num_link_freqs = ARRAY_SIZE(imx676_link_freq_menu),
+	.ops = &imx676_sensor_ops,
+};
 
 static const struct of_device_id imx676_dt_ids[] = {
 	{ .compatible = "framos,fr_imx676" },
@@ -1717,220 +1604,29 @@ static int imx676_probe(struct i2c_client *client)
 {
 	struct device *dev = &client->dev;
 	struct imx676 *imx676;
-	const struct of_device_id *match;
-	struct device_node *node = dev->of_node;
-	struct device_node *ser_node;
-	struct i2c_client *ser_i2c = NULL;
-	struct device_node *dser_node;
-	struct i2c_client *dser_i2c = NULL;
-	struct device_node *gmsl;
-	int value = 0xFFFF;
-	const char *str_value;
-	const char *str_value1[2];
-	int i;
 	int ret;
 
 	imx676 = devm_kzalloc(&client->dev, sizeof(*imx676), GFP_KERNEL);
 	if (!imx676)
 		return -ENOMEM;
 
-	v4l2_i2c_subdev_init(&imx676->sd, client, &imx676_subdev_ops);
-
-	match = of_match_device(imx676_dt_ids, dev);
-	if (!match)
-		return -ENODEV;
-
-	if (imx676_check_hwcfg(dev, client))
-		return -EINVAL;
-
-	if (strcmp(imx676->gmsl, "gmsl")) {
-		imx676->reset_gpio = devm_gpiod_get(dev, "reset", GPIOD_OUT_HIGH);
-		if (IS_ERR(imx676->reset_gpio)) {
-			dev_err(dev, "cannot get reset gpio\n");
-			return PTR_ERR(imx676->reset_gpio);
-		}
-	}
+	v4l2_i2c_subdev_init(&imx676->core.sd, client, &imx676_subdev_ops);
 
-	if (!(strcmp(imx676->gmsl, "gmsl"))) {
-		ret = of_property_read_u32(node, "reg", &imx676->g_ctx.sdev_reg);
-		if (ret < 0) {
-			dev_err(dev, "reg not found\n");
-			return ret;
-		}
-
-		ret = of_property_read_u32(node, "def-addr",
-							&imx676->g_ctx.sdev_def);
-		if (ret < 0) {
-			dev_err(dev, "def-addr not found\n");
-			return ret;
-		}
+	fr_sensor_init(&imx676->core, client, &imx676_desc);
 
-		ser_node = of_parse_phandle(node, "gmsl-ser-device", 0);
-		if (ser_node == NULL) {
-			dev_err(dev, "missing %s handle\n", "gmsl-ser-device");
-			return ret;
-		}
-
-		ret = of_property_read_u32(ser_node, "reg", &imx676->g_ctx.ser_reg);
-		if (ret < 0) {
-			dev_err(dev, "serializer reg not found\n");
-			return ret;
-		}
-
-		ser_i2c = of_find_i2c_device_by_node(ser_node);
-		of_node_put(ser_node);
-
-		if (ser_i2c == NULL) {
-			dev_err(dev, "missing serializer dev handle\n");
-			return ret;
-		}
-		if (ser_i2c->dev.driver == NULL) {
-			dev_err(dev, "missing serializer driver\n");
-			return ret;
-		}
-
-		imx676->ser_dev = &ser_i2c->dev;
-
-		dser_node = of_parse_phandle(node, "gmsl-dser-device", 0);
-		if (dser_node == NULL) {
-			dev_err(dev, "missing %s handle\n", "gmsl-dser-device");
-			return ret;
-		}
-
-		dser_i2c = of_find_i2c_device_by_node(dser_node);
-		of_node_put(dser_node);
-
-		if (dser_i2c == NULL) {
-			dev_err(dev, "missing deserializer dev handle\n");
-			return ret;
-		}
-		if (dser_i2c->dev.driver == NULL) {
-			dev_err(dev, "missing deserializer driver\n");
-			return ret;
-		}
-
-		imx676->dser_dev = &dser_i2c->dev;
-
-		gmsl = of_get_child_by_name(node, "gmsl-link");
-		if (gmsl == NULL) {
-			dev_err(dev, "missing gmsl-link device node\n");
-			ret = -EINVAL;
-			return ret;
-		}
-
-		ret = of_property_read_string(gmsl, "dst-csi-port", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No dst-csi-port found\n");
-			return ret;
-		}
-		imx676->g_ctx.dst_csi_port =
-		(!strcmp(str_value, "a")) ? GMSL_CSI_PORT_A : GMSL_CSI_PORT_B;
-
-		ret = of_property_read_string(gmsl, "src-csi-port", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No src-csi-port found\n");
-			return ret;
-		}
-		imx676->g_ctx.src_csi_port =
-		(!strcmp(str_value, "a")) ? GMSL_CSI_PORT_A : GMSL_CSI_PORT_B;
-
-		ret = of_property_read_string(gmsl, "csi-mode", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No csi-mode found\n");
-			return ret;
-		}
-
-		if (!strcmp(str_value, "1x4")) {
-			imx676->g_ctx.csi_mode = GMSL_CSI_1X4_MODE;
-		} else if (!strcmp(str_value, "2x4")) {
-			imx676->g_ctx.csi_mode = GMSL_CSI_2X4_MODE;
-		} else if (!strcmp(str_value, "2x2")) {
-			imx676->g_ctx.csi_mode = GMSL_CSI_2X2_MODE;
-		} else {
-			dev_err(dev, "invalid csi mode\n");
-			return ret;
-		}
-
-		ret = of_property_read_string(gmsl, "serdes-csi-link", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No serdes-csi-link found\n");
-			return ret;
-		}
-		imx676->g_ctx.serdes_csi_link =
-		(!strcmp(str_value, "a")) ? GMSL_SERDES_CSI_LINK_A : GMSL_SERDES_CSI_LINK_B;
-
-		ret = of_property_read_u32(gmsl, "st-vc", &value);
-		if (ret < 0) {
-			dev_err(dev, "No st-vc info\n");
-			return ret;
-		}
-
-		imx676->g_ctx.st_vc = value;
-
-		ret = of_property_read_u32(gmsl, "vc-id", &value);
-		if (ret < 0) {
-			dev_err(dev, "No vc-id info\n");
-			return ret;
-		}
-		imx676->g_ctx.dst_vc = value;
-
-		ret = of_property_read_u32(gmsl, "num-lanes", &value);
-		if (ret < 0) {
-			dev_err(dev, "No num-lanes info\n");
-			return ret;
-		}
-
-		imx676->g_ctx.num_csi_lanes = value;
-
-		imx676->g_ctx.num_streams =
-				of_property_count_strings(gmsl, "streams");
-		if (imx676->g_ctx.num_streams <= 0) {
-			dev_err(dev, "No streams found\n");
-			ret = -EINVAL;
-			return ret;
-		}
-
-		for (i = 0; i < imx676->g_ctx.num_streams; i++) {
-			of_property_read_string_index(gmsl, "streams", i, &str_value1[i]);
-			if (!str_value1[i]) {
-				dev_err(dev, "invalid stream info\n");
-				return ret;
-			}
-			if (!strcmp(str_value1[i], "raw12")) {
-				imx676->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_RAW_12;
-			} else if (!strcmp(str_value1[i], "embed")) {
-				imx676->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_EMBED;
-			} else if (!strcmp(str_value1[i], "ued-u1")) {
-				imx676->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_UED_U1;
-			} else {
-				dev_err(dev, "invalid stream data type\n");
-				return ret;
-			}
-		}
-
-		imx676->g_ctx.s_dev = dev;
-
-		ret = max96793_sdev_pair(imx676->ser_dev, &imx676->g_ctx);
-		if (ret) {
-			dev_err(dev, "gmsl ser pairing failed\n");
-			return ret;
-		}
-
-		ret = max96792_sdev_register(imx676->dser_dev, &imx676->g_ctx);
-		if (ret) {
-			dev_err(dev, "gmsl deserializer register failed\n");
-			return ret;
-		}
+	ret = fr_sensor_probe(&imx676->core);
+	if (ret)
+		return ret;
 
-		ret = imx676_gmsl_serdes_setup(imx676);
+	if (fr_sensor_is_gmsl(&imx676->core)) {
+		ret = fr_sensor_gmsl_serdes_setup(&imx676->core);
 		if (ret) {
 			dev_err(dev, "%s gmsl serdes setup failed\n", __func__);
 			return ret;
 		}
-
 	}
 
-	ret = imx676_power_on(dev);
+	ret = fr_sensor_runtime_resume(dev);
 	if (ret)
 		return ret;
 
@@ -1945,49 +1641,67 @@ static int imx676_probe(struct i2c_client *client)
 		return PTR_ERR(imx676->xmaster);
 	}
 
+	ret = fr_sensor_xvs_init(&imx676->core);
+	if (ret)
+		goto error_power_off;
+
 	imx676->mode = &modes_12bit[0];
-	imx676->fmt_code = MEDIA_BUS_FMT_SRGGB12_1X12;
+	imx676->crop = imx676->mode->crop;
+	imx676->core.fmt_code = MEDIA_BUS_FMT_SRGGB12_1X12;
 
-	pm_runtime_set_active(dev);
-	pm_runtime_enable(dev);
-	pm_runtime_idle(dev);
+	fr_sensor_pm_enable(&imx676->core);
 
 	ret = imx676_init_controls(imx676);
 	if (ret)
-		goto error_power_off;
+		goto error_pm_disable;
 
-	imx676->sd.internal_ops = &imx676_internal_ops;
-	imx676->sd.flags |= V4L2_SUBDEV_FL_HAS_DEVNODE |
+	imx676->core.sd.internal_ops = &imx676_internal_ops;
+	imx676->core.sd.flags |= V4L2_SUBDEV_FL_HAS_DEVNODE |
 				V4L2_SUBDEV_FL_HAS_EVENTS;
-	imx676->sd.entity.function = MEDIA_ENT_F_CAM_SENSOR;
+	imx676->core.sd.entity.function = MEDIA_ENT_F_CAM_SENSOR;
 
 	imx676->pad[IMAGE_PAD].flags = MEDIA_PAD_FL_SOURCE;
 	imx676->pad[METADATA_PAD].flags = MEDIA_PAD_FL_SOURCE;
 
-	ret = media_entity_pads_init(&imx676->sd.entity, NUM_PADS, imx676->pad);
+	ret = media_entity_pads_init(&imx676->core.sd.entity, NUM_PADS,
+				     imx676->pad);
 	if (ret) {
 		dev_err(dev, "failed to init entity pads: %d\n", ret);
 		goto error_handler_free;
 	}
 
-	ret = v4l2_async_register_subdev_sensor(&imx676->sd);
+	ret = fr_sensor_join_sync_group(&imx676->core);
+	if (ret)
+		goto error_media_entity;
+
+	ret = v4l2_async_register_subdev_sensor(&imx676->core.sd);
 	if (ret < 0) {
 		dev_err(dev, "failed to register sensor sub-device: %d\n", ret);
-		goto error_media_entity;
+		goto error_sync_leave;
 	}
 
+	imx676_debugfs_init(imx676);
+
 	return 0;
 
+error_sync_leave:
+	fr_sync_group_leave(&imx676->core.sync);
+
 error_media_entity:
-	media_entity_cleanup(&imx676->sd.entity);
+	media_entity_cleanup(&imx676->core.sd.entity);
 
 error_handler_free:
 	imx676_free_controls(imx676);
 
+error_pm_disable:
+	fr_sensor_pm_disable(&imx676->core);
+	mutex_destroy(&imx676->core.mutex);
+
+	return ret;
+
 error_power_off:
-	pm_runtime_disable(&client->dev);
-	pm_runtime_set_suspended(&client->dev);
-	imx676_power_off(&client->dev);
+	fr_sensor_runtime_suspend(&client->dev);
+	mutex_destroy(&imx676->core.mutex);
 
 	return ret;
 }
@@ -1997,35 +1711,39 @@ static void imx676_remove(struct i2c_client *client)
 	struct v4l2_subdev *sd = i2c_get_clientdata(client);
 	struct imx676 *imx676 = to_imx676(sd);
 
-	if (!(strcmp(imx676->gmsl, "gmsl"))) {
-		max96792_sdev_unregister(imx676->dser_dev, &client->dev);
-		imx676_gmsl_serdes_reset(imx676);
-	}
+	cancel_delayed_work_sync(&imx676->core.stage_work);
+
+	mutex_lock(&imx676->core.mutex);
+	fr_sensor_remove(&imx676->core);
+	mutex_unlock(&imx676->core.mutex);
 
+	debugfs_remove_recursive(imx676->debugfs);
 	v4l2_async_unregister_subdev(sd);
+	fr_sync_group_leave(&imx676->core.sync);
 	media_entity_cleanup(&sd->entity);
 	imx676_free_controls(imx676);
 
-	pm_runtime_disable(&client->dev);
-	if (!pm_runtime_status_suspended(&client->dev))
-		imx676_power_off(&client->dev);
-	pm_runtime_set_suspended(&client->dev);
+	fr_sensor_pm_disable(&imx676->core);
+	mutex_destroy(&imx676->core.mutex);
 }
 
 MODULE_DEVICE_TABLE(of, imx676_dt_ids);
 
-static const struct dev_pm_ops imx676_pm_ops = {
-	SET_SYSTEM_SLEEP_PM_OPS(imx676_suspend, imx676_resume)
-	SET_RUNTIME_PM_OPS(imx676_power_off, imx676_power_on, NULL)
+/* Lets the sensor be instantiated without device tree, from software nodes */
+static const struct i2c_device_id imx676_id[] = {
+	{ "fr_imx676" },
+	{ }
 };
+MODULE_DEVICE_TABLE(i2c, imx676_id);
 
 static struct i2c_driver imx676_i2c_driver = {
 	.driver = {
 		.name = "fr_imx676",
 		.of_match_table	= imx676_dt_ids,
-		.pm = &imx676_pm_ops,
+		.pm = &fr_sensor_pm_ops,
 	},
 	.probe = imx676_probe,
+	.id_table = imx676_id,
 	.remove = imx676_remove,
 };
 
@@ -5,6 +5,8 @@
  * fr_imx676_regs.h - imx676 sensor mode tables
  */
 
+#include "fr_sensor_core.h"
+
 #define STANDBY			0x3000
 #define REGHOLD			0x3001
 #define XMSTA			0x3002
@@ -69,17 +71,12 @@
 #define IMX676_CROP_1768x1080_HEIGHT	1080
 
 
-struct imx676_reg {
-	u16 address;
-	u8 val;
-};
-
 #define IMX676_MIN_FRAME_LENGTH_DELTA	72
 
 #define IMX676_TO_LOW_BYTE(x) (x & 0xFF)
 #define IMX676_TO_MID_BYTE(x) (x >> 8)
 
-static const struct imx676_reg mode_common_regs[] = {
+static const struct fr_sensor_reg mode_common_regs[] = {
 
 	{LANEMODE,		0x03},
 	{INCK_SEL,		0x01},
@@ -203,7 +200,7 @@ static const struct imx676_reg mode_common_regs[] = {
 
 };
 
-static const struct imx676_reg raw12_framefmt_regs[] = {
+static const struct fr_sensor_reg raw12_framefmt_regs[] = {
 
 	{ADBIT,			0x01},
 	{MDBIT,			0x01},
@@ -219,7 +216,7 @@ static const struct imx676_reg raw12_framefmt_regs[] = {
 
 };
 
-static const struct imx676_reg raw12_h2v2_framefmt_regs[] = {
+static const struct fr_sensor_reg raw12_h2v2_framefmt_regs[] = {
 
 	{ADBIT,			0x00},
 	{MDBIT,			0x01},
@@ -235,7 +232,7 @@ static const struct imx676_reg raw12_h2v2_framefmt_regs[] = {
 
 };
 
-static const struct imx676_reg raw10_framefmt_regs[] = {
+static const struct fr_sensor_reg raw10_framefmt_regs[] = {
 
 	{ADBIT,			0x00},
 	{MDBIT,			0x00},
@@ -251,7 +248,7 @@ static const struct imx676_reg raw10_framefmt_regs[] = {
 
 };
 
-static const struct imx676_reg mode_3552x3556[] = {
+static const struct fr_sensor_reg mode_3552x3556[] = {
 
 	{WINMODE,		0x00},
 	{ADDMODE,		0x00},
@@ -268,7 +265,7 @@ static const struct imx676_reg mode_3552x3556[] = {
 
 };
 
-static const struct imx676_reg mode_crop_3552x2160[] = {
+static const struct fr_sensor_reg mode_crop_3552x2160[] = {
 
 	{WINMODE,		0x04},
 	{ADDMODE,		0x00},
@@ -295,7 +292,7 @@ static const struct imx676_reg mode_crop_3552x2160[] = {
 
 };
 
-static const struct imx676_reg mode_h2v2_binning[] = {
+static const struct fr_sensor_reg mode_h2v2_binning[] = {
 
 	{WINMODE,		0x00},
 	{ADDMODE,		0x01},
@@ -312,7 +309,7 @@ static const struct imx676_reg mode_h2v2_binning[] = {
 
 };
 
-static const struct imx676_reg mode_crop_1768x1080[] = {
+static const struct fr_sensor_reg mode_crop_1768x1080[] = {
 
 	{WINMODE,		0x04},
 	{ADDMODE,		0x01},
@@ -339,7 +336,7 @@ static const struct imx676_reg mode_crop_1768x1080[] = {
 
 };
 
-static const struct imx676_reg mode_enable_pattern_generator[] = {
+static const struct fr_sensor_reg mode_enable_pattern_generator[] = {
 
 	{BLKLEVEL_LOW,		0x00},
 	{TPG_EN_DUOUT,		0x01},
@@ -348,7 +345,7 @@ static const struct imx676_reg mode_enable_pattern_generator[] = {
 
 };
 
-static const struct imx676_reg mode_disable_pattern_generator[] = {
+static const struct fr_sensor_reg mode_disable_pattern_generator[] = {
 
 	{BLKLEVEL_LOW,		0x32},
 	{TPG_EN_DUOUT,		0x00},
@@ -7,22 +7,28 @@
 
 //#define DEBUG 1
 
-#include <asm/unaligned.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/gpio/consumer.h>
 #include <linux/i2c.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/workqueue.h>
 #include <media/v4l2-ctrls.h>
 #include <media/v4l2-device.h>
 #include <media/v4l2-event.h>
 #include <media/v4l2-fwnode.h>
 #include <media/v4l2-mediabus.h>
+#include <media/mipi-csi2.h>
 
 #include "fr_imx678_regs.h"
 #include "fr_max96792.h"
 #include "fr_max96793.h"
+#include "fr_sensor_core.h"
+#include "fr_stats.h"
+#include "fr_sync_group.h"
+#include "fr_trace.h"
 
 #define IMX678_K_FACTOR				1000LL
 #define IMX678_M_FACTOR				1000000LL
@@ -36,12 +42,16 @@
 #define IMX678_LINK_FREQ_1188			(1188000000/2)
 #define IMX678_LINK_FREQ_891			(891000000/2)
 
-#define IMX678_MODE_STANDBY			0x01
-#define IMX678_MODE_STREAMING			0x00
+#define IMX678_STANDBY_SETTLE_US		29000
+#define IMX678_FRAME_SYNC_EVENTS		4
 
 #define IMX678_MIN_SHR0_LENGTH			3
 #define IMX678_MIN_INTEGRATION_LINES		1
 
+#define IMX678_HMAX_MAX				0xFFFF
+#define IMX678_VMAX_MAX				0xFFFFF
+#define IMX678_VMAX_STEP			2
+
 #define IMX678_ANA_GAIN_MIN			0
 #define IMX678_ANA_GAIN_MAX			240
 #define IMX678_ANA_GAIN_STEP			1
@@ -70,15 +80,13 @@ enum pad_types {
 #define IMX678_PIXEL_ARRAY_WIDTH	3856U
 #define IMX678_PIXEL_ARRAY_HEIGHT	2180U
 
+#define IMX678_WINDOW_H_STEP		4U
+#define IMX678_WINDOW_V_STEP		2U
+
 #define V4L2_CID_FRAME_RATE		(V4L2_CID_USER_IMX_BASE + 1)
 #define V4L2_CID_OPERATION_MODE		(V4L2_CID_USER_IMX_BASE + 2)
 #define V4L2_CID_SYNC_MODE		(V4L2_CID_USER_IMX_BASE + 3)
 
-struct imx678_reg_list {
-	unsigned int num_of_regs;
-	const struct imx678_reg *regs;
-};
-
 struct imx678_mode {
 
 	unsigned int width;
@@ -88,8 +96,8 @@ struct imx678_mode {
 	unsigned int min_fps;
 	unsigned int hmax;
 	struct v4l2_rect crop;
-	struct imx678_reg_list reg_list;
-	struct imx678_reg_list reg_list_format;
+	struct fr_sensor_reg_list reg_list;
+	struct fr_sensor_reg_list reg_list_format;
 };
 
 static const s64 imx678_link_freq_menu[] = {
@@ -276,43 +284,36 @@ static const u32 codes[] = {
 };
 
 struct imx678 {
-	struct v4l2_subdev sd;
-	struct media_pad pad[NUM_PADS];
+	struct fr_sensor core;
 
-	unsigned int fmt_code;
+	struct media_pad pad[NUM_PADS];
 
-	struct gpio_desc *reset_gpio;
 	struct gpio_desc *xmaster;
 
 	struct v4l2_ctrl_handler ctrl_handler;
 	struct v4l2_ctrl *pixel_rate;
 	struct v4l2_ctrl *link_freq;
 	struct v4l2_ctrl *exposure;
-	struct v4l2_ctrl *framerate;
 	struct v4l2_ctrl *operation_mode;
 	struct v4l2_ctrl *sync_mode;
 	struct v4l2_ctrl *vflip;
 	struct v4l2_ctrl *hflip;
-	struct v4l2_ctrl *vblank;
-	struct v4l2_ctrl *hblank;
 	struct v4l2_ctrl *blklvl;
 
-	u64 line_time;
-	u32 frame_length;
-
-	const char *gmsl;
-	struct device *ser_dev;
-	struct device *dser_dev;
-	struct gmsl_link_ctx g_ctx;
-
 	const struct imx678_mode *mode;
-	struct mutex mutex;
-	bool streaming;
+	struct v4l2_rect crop;
+
+	struct dentry *debugfs;
 };
 
 static inline struct imx678 *to_imx678(struct v4l2_subdev *_sd)
 {
-	return container_of(_sd, struct imx678, sd);
+	return container_of(_sd, struct imx678, core.sd);
+}
+
+static inline struct imx678 *core_to_imx678(struct fr_sensor *core)
+{
+	return container_of(core, struct imx678, core);
 }
 
 static inline void get_mode_table(unsigned int code,
@@ -367,116 +368,11 @@ static const char * const imx678_sync_mode_menu[] = {
 
 };
 
-static int imx678_read_reg(struct imx678 *imx678, u16 reg, u32 len, u32 *val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
-	struct i2c_msg msgs[2];
-	u8 addr_buf[2] = { reg >> 8, reg & 0xff };
-	u8 data_buf[4] = { 0, };
-	int ret;
-
-	if (len > 4)
-		return -EINVAL;
-
-	msgs[0].addr = client->addr;
-	msgs[0].flags = 0;
-	msgs[0].len = ARRAY_SIZE(addr_buf);
-	msgs[0].buf = addr_buf;
-
-	msgs[1].addr = client->addr;
-	msgs[1].flags = I2C_M_RD;
-	msgs[1].len = len;
-	msgs[1].buf = &data_buf[4 - len];
-
-	ret = i2c_transfer(client->adapter, msgs, ARRAY_SIZE(msgs));
-	if (ret != ARRAY_SIZE(msgs))
-		return -EIO;
-
-	*val = get_unaligned_be32(data_buf);
-
-	return 0;
-}
-
-static int imx678_write_reg(struct imx678 *imx678, u16 reg, u32 len, u32 val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
-	u8 buf[6];
-
-	if (len > 4)
-		return -EINVAL;
-
-	put_unaligned_be16(reg, buf);
-	put_unaligned_le32(val, buf + 2);
-
-	if (i2c_master_send(client, buf, len + 2) != len + 2)
-		return -EIO;
-
-	return 0;
-}
-
-static int imx678_write_hold_reg(struct imx678 *imx678, u16 reg, u32 len, u32 val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
-	struct device *dev = &client->dev;
-	int ret;
-
-	ret = imx678_write_reg(imx678, REGHOLD, 1, 0x01);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n",
-								__func__);
-		return ret;
-	}
-
-	ret = imx678_write_reg(imx678, reg, len, val);
-	if (ret)
-		goto reghold_off;
-
-	ret = imx678_write_reg(imx678, REGHOLD, 1, 0x00);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n",
-								__func__);
-		return ret;
-	}
-
-	return 0;
-
-reghold_off:
-	ret = imx678_write_reg(imx678, REGHOLD, 1, 0x00);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n",
-								__func__);
-		return ret;
-	}
-	return ret;
-
-}
-
-static int imx678_write_table(struct imx678 *imx678,
-				 const struct imx678_reg *regs, u32 len)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
-	unsigned int i;
-	int ret;
-
-	for (i = 0; i < len; i++) {
-		ret = imx678_write_reg(imx678, regs[i].address, 1, regs[i].val);
-		if (ret) {
-			dev_err_ratelimited(&client->dev,
-					"Failed to write reg 0x%4.4x. error = %d\n",
-					regs[i].address, ret);
-
-			return ret;
-		}
-	}
-
-	return 0;
-}
-
 static u32 imx678_get_format_code(struct imx678 *imx678, u32 code)
 {
 	unsigned int i;
 
-	lockdep_assert_held(&imx678->mutex);
+	lockdep_assert_held(&imx678->core.mutex);
 
 	for (i = 0; i < ARRAY_SIZE(codes); i++)
 		if (codes[i] == code)
@@ -497,7 +393,7 @@ static int imx678_open(struct v4l2_subdev *sd, struct v4l2_subdev_fh *fh)
 		v4l2_subdev_get_try_format(sd, fh->state, METADATA_PAD);
 	struct v4l2_rect *try_crop;
 
-	mutex_lock(&imx678->mutex);
+	mutex_lock(&imx678->core.mutex);
 
 	try_fmt_img->width = modes_12bit[0].width;
 	try_fmt_img->height = modes_12bit[0].height;
@@ -516,7 +412,7 @@ static int imx678_open(struct v4l2_subdev *sd, struct v4l2_subdev_fh *fh)
 	try_crop->width = IMX678_PIXEL_ARRAY_WIDTH;
 	try_crop->height = IMX678_PIXEL_ARRAY_HEIGHT;
 
-	mutex_unlock(&imx678->mutex);
+	mutex_unlock(&imx678->core.mutex);
 
 	return 0;
 }
@@ -531,17 +427,23 @@ static bool imx678_is_binning_mode(struct imx678 *imx678)
 		return false;
 }
 
+static bool imx678_is_window_mode(const struct imx678_mode *mode)
+{
+	return mode->reg_list.regs == mode_crop_2608x1964 ||
+	       mode->reg_list.regs == mode_crop_1920x1080;
+}
+
 static int imx678_set_exposure(struct imx678 *imx678, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
 	struct device *dev = &client->dev;
 	const struct imx678_mode *mode = imx678->mode;
 	u64 exposure;
 	int ret;
 
-	exposure = imx678->vblank->val + mode->height - val;
+	exposure = imx678->core.vblank->val + mode->height - val;
 
-	ret = imx678_write_hold_reg(imx678, SHR0_LOW, 3, exposure);
+	ret = fr_sensor_write_hold_reg(&imx678->core, SHR0_LOW, 3, exposure);
 	if (ret) {
 		dev_err(dev, "%s failed to set exposure\n", __func__);
 		return ret;
@@ -555,7 +457,7 @@ static void imx678_adjust_exposure_range(struct imx678 *imx678)
 	const struct imx678_mode *mode = imx678->mode;
 	u64 exposure_max;
 
-	exposure_max = imx678->vblank->val + mode->height - IMX678_MIN_SHR0_LENGTH;
+	exposure_max = imx678->core.vblank->val + mode->height - IMX678_MIN_SHR0_LENGTH;
 
 	__v4l2_ctrl_modify_range(imx678->exposure, IMX678_MIN_INTEGRATION_LINES,
 				exposure_max, 1,
@@ -564,11 +466,12 @@ static void imx678_adjust_exposure_range(struct imx678 *imx678)
 
 static int imx678_set_frame_rate(struct imx678 *imx678, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
-	ret = imx678_write_hold_reg(imx678, VMAX_LOW, 3, imx678->frame_length);
+	ret = fr_sensor_write_hold_reg(&imx678->core, VMAX_LOW, 3,
+				imx678->core.frame_length);
 
 	if (ret) {
 		dev_err(dev, "%s failed to set frame rate\n", __func__);
@@ -579,52 +482,83 @@ static int imx678_set_frame_rate(struct imx678 *imx678, u64 val)
 
 }
 
-static void imx678_update_frame_rate(struct imx678 *imx678, u64 val)
+static int imx678_set_hmax_register(struct imx678 *imx678)
 {
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
+	struct device *dev = &client->dev;
+	int ret;
 
-	const struct imx678_mode *mode = imx678->mode;
-	u32 update_vblank;
+	ret = fr_sensor_write_hold_reg(&imx678->core, HMAX_LOW, 2,
+				imx678->core.hmax);
+	if (ret)
+		dev_err(dev, "%s failed to write HMAX register\n", __func__);
 
-	imx678->frame_length = (IMX678_M_FACTOR * IMX678_G_FACTOR) /
-						(val * imx678->line_time);
-	imx678->frame_length = (imx678->frame_length % 2) ?
-				imx678->frame_length + 1 : imx678->frame_length;
+	dev_dbg(dev, "%s: hmax: 0x%x\n", __func__, imx678->core.hmax);
 
-	update_vblank = imx678->frame_length - mode->height;
+	return ret;
 
-	__v4l2_ctrl_modify_range(imx678->vblank, update_vblank,
-				 update_vblank, 1, update_vblank);
+}
 
-	__v4l2_ctrl_s_ctrl(imx678->vblank, update_vblank);
+static u32 imx678_min_frame_length(struct imx678 *imx678)
+{
+	const struct imx678_mode *mode = imx678->mode;
+
+	if (imx678_is_binning_mode(imx678))
+		return mode->height * 2 + IMX678_MIN_FRAME_LENGTH_DELTA;
 
+	return mode->height + IMX678_MIN_FRAME_LENGTH_DELTA;
 }
 
-static int imx678_set_hmax_register(struct imx678 *imx678)
+static int imx678_set_window_position(struct imx678 *imx678)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
 	struct device *dev = &client->dev;
-	const struct imx678_mode *mode = imx678->mode;
 	int ret;
 
-	ret = imx678_write_hold_reg(imx678, HMAX_LOW, 2, mode->hmax);
+	ret = fr_sensor_write_reg(&imx678->core, REGHOLD, 1, 0x01);
+	if (ret) {
+		dev_err(dev, "%s failed to write reghold register\n",
+								__func__);
+		return ret;
+	}
+
+	ret = fr_sensor_write_reg(&imx678->core, PIX_HST_LOW, 2,
+				imx678->crop.left);
 	if (ret)
-		dev_err(dev, "%s failed to write HMAX register\n", __func__);
+		goto reghold_off;
 
-	dev_dbg(dev, "%s: hmax: 0x%x\n", __func__, mode->hmax);
+	ret = fr_sensor_write_reg(&imx678->core, PIX_VST_LOW, 2,
+				imx678->crop.top);
+	if (ret)
+		goto reghold_off;
 
-	return ret;
+	ret = fr_sensor_write_reg(&imx678->core, REGHOLD, 1, 0x00);
+	if (ret) {
+		dev_err(dev, "%s failed to write reghold register\n",
+								__func__);
+		return ret;
+	}
+
+	dev_dbg(dev, "%s: window start: (%d, %d)\n", __func__,
+				imx678->crop.left, imx678->crop.top);
+
+	return 0;
 
+reghold_off:
+	dev_err(dev, "%s failed to write window start\n", __func__);
+	fr_sensor_write_reg(&imx678->core, REGHOLD, 1, 0x00);
+	return ret;
 }
 
 static int imx678_set_data_rate(struct imx678 *imx678)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
 	switch (imx678->mode->linkfreq) {
 	case _IMX678_LINK_FREQ_1440:
-		ret = imx678_write_reg(imx678, DATARATE_SEL, 1, 0x03);
+		ret = fr_sensor_write_reg(&imx678->core, DATARATE_SEL, 1, 0x03);
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
 									__func__);
@@ -632,7 +566,7 @@ static int imx678_set_data_rate(struct imx678 *imx678)
 		}
 		break;
 	case _IMX678_LINK_FREQ_1188:
-		ret = imx678_write_reg(imx678, DATARATE_SEL, 1, 0x04);
+		ret = fr_sensor_write_reg(&imx678->core, DATARATE_SEL, 1, 0x04);
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
 									__func__);
@@ -640,7 +574,7 @@ static int imx678_set_data_rate(struct imx678 *imx678)
 		}
 		break;
 	case _IMX678_LINK_FREQ_891:
-		ret = imx678_write_reg(imx678, DATARATE_SEL, 1, 0x05);
+		ret = fr_sensor_write_reg(&imx678->core, DATARATE_SEL, 1, 0x05);
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
 									__func__);
@@ -657,21 +591,24 @@ static int imx678_set_data_rate(struct imx678 *imx678)
 
 static int imx678_set_test_pattern(struct imx678 *imx678, u32 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
 	if (val) {
-		ret = imx678_write_table(imx678, mode_enable_pattern_generator,
+		ret = fr_sensor_write_table(&imx678->core,
+				mode_enable_pattern_generator,
 				ARRAY_SIZE(mode_enable_pattern_generator));
 		if (ret)
 			goto fail;
 
-		ret = imx678_write_reg(imx678, TPG_PATSEL_DUOUT, 1, val - 1);
+		ret = fr_sensor_write_reg(&imx678->core, TPG_PATSEL_DUOUT, 1,
+					val - 1);
 		if (ret)
 			goto fail;
 	} else {
-		ret = imx678_write_table(imx678, mode_disable_pattern_generator,
+		ret = fr_sensor_write_table(&imx678->core,
+				mode_disable_pattern_generator,
 				ARRAY_SIZE(mode_disable_pattern_generator));
 		if (ret)
 			goto fail;
@@ -687,7 +624,7 @@ fail:
 
 static void imx678_update_blklvl_range(struct imx678 *imx678)
 {
-	switch (imx678->fmt_code) {
+	switch (imx678->core.fmt_code) {
 	case MEDIA_BUS_FMT_SRGGB12_1X12:
 		__v4l2_ctrl_modify_range(imx678->blklvl, IMX678_BLACK_LEVEL_MIN,
 					IMX678_MAX_BLACK_LEVEL_12BPP,
@@ -708,17 +645,18 @@ static void imx678_update_blklvl_range(struct imx678 *imx678)
 
 static int imx678_set_blklvl(struct imx678 *imx678, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
 	struct device *dev = &client->dev;
 	u64 black_level_reg;
 	int ret;
 
-	if (imx678->fmt_code == MEDIA_BUS_FMT_SRGGB10_1X10)
+	if (imx678->core.fmt_code == MEDIA_BUS_FMT_SRGGB10_1X10)
 		black_level_reg = val;
 	else
 		black_level_reg = val >> 2;
 
-	ret = imx678_write_hold_reg(imx678, BLKLEVEL_LOW, 2, black_level_reg);
+	ret = fr_sensor_write_hold_reg(&imx678->core, BLKLEVEL_LOW, 2,
+				black_level_reg);
 
 	if (ret) {
 		dev_err(dev, "%s failed to adjust blklvl register\n",
@@ -739,7 +677,7 @@ static int imx678_set_operation_mode(struct imx678 *imx678, u32 val)
 
 static int imx678_set_sync_mode(struct imx678 *imx678, u32 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
 	struct device *dev = &client->dev;
 	int ret = 0;
 	u8 extmode;
@@ -749,7 +687,7 @@ static int imx678_set_sync_mode(struct imx678 *imx678, u32 val)
 	else
 		extmode = 0;
 
-	ret = imx678_write_reg(imx678, EXTMODE, 1, extmode);
+	ret = fr_sensor_write_reg(&imx678->core, EXTMODE, 1, extmode);
 	if (ret)
 		dev_err(dev, "%s: error setting sync mode\n", __func__);
 
@@ -758,7 +696,7 @@ static int imx678_set_sync_mode(struct imx678 *imx678, u32 val)
 
 static int imx678_configure_triggering_pins(struct imx678 *imx678)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
 	struct device *dev = &client->dev;
 	int ret = 0;
 	u8 xvs_xhs_drv = 0xF;
@@ -787,12 +725,35 @@ static int imx678_configure_triggering_pins(struct imx678 *imx678)
 		return -EINVAL;
 	}
 
-	ret = imx678_write_reg(imx678, XVS_XHS_DRV, 1, xvs_xhs_drv);
+	ret = fr_sensor_write_reg(&imx678->core, XVS_XHS_DRV, 1, xvs_xhs_drv);
 	if (ret) {
 		dev_err(dev, "%s: error setting Slave mode\n", __func__);
 		return ret;
 	}
 
+	/*
+	 * Forward XVS over the GMSL link in the direction it is driven:
+	 * from the sensor to the host in internal sync master mode, from the
+	 * host to the sensor in slave mode.
+	 */
+	if (fr_sensor_is_gmsl(&imx678->core)) {
+		if (xvs_xhs_drv == 0x0) {
+			ret = max96793_xvs_setup(imx678->core.ser_dev,
+							max96793_IN);
+			ret |= max96792_xvs_setup(imx678->core.dser_dev,
+							max96792_OUT);
+		} else if (imx678->operation_mode->val == SLAVE_MODE) {
+			ret = max96793_xvs_setup(imx678->core.ser_dev,
+							max96793_OUT);
+			ret |= max96792_xvs_setup(imx678->core.dser_dev,
+							max96792_IN);
+		}
+		if (ret) {
+			dev_err(dev, "%s: error forwarding XVS\n", __func__);
+			return ret;
+		}
+	}
+
 	dev_dbg(dev, "%s: XVS_XHS driver register: 0x%x\n", __func__, xvs_xhs_drv);
 
 	return 0;
@@ -802,24 +763,34 @@ static int imx678_set_ctrl(struct v4l2_ctrl *ctrl)
 {
 	struct imx678 *imx678 =
 		container_of(ctrl->handler, struct imx678, ctrl_handler);
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
 	int ret = 0;
 
 	switch (ctrl->id) {
 	case V4L2_CID_FRAME_RATE:
-		imx678_update_frame_rate(imx678, ctrl->val);
+		fr_sensor_update_frame_rate(&imx678->core, ctrl->val);
 		break;
 	case V4L2_CID_VBLANK:
 		imx678_adjust_exposure_range(imx678);
 		break;
 	}
 
-	if (pm_runtime_get_if_in_use(&client->dev) == 0)
+	/*
+	 * Controls are written whenever the sensor is powered, so that a
+	 * staged configuration stays valid. Otherwise they are applied on the
+	 * next staging or stream start.
+	 */
+	if (pm_runtime_get_if_active(&client->dev, true) <= 0) {
+		imx678->core.staged = false;
 		return 0;
+	}
+
+	WRITE_ONCE(imx678->core.i2c_class, FR_I2C_CONTROL);
 
 	switch (ctrl->id) {
 	case V4L2_CID_ANALOGUE_GAIN:
-		ret = imx678_write_hold_reg(imx678, GAIN_LOW, 2, ctrl->val);
+		ret = fr_sensor_write_hold_reg(&imx678->core, GAIN_LOW, 2,
+					ctrl->val);
 		break;
 	case V4L2_CID_EXPOSURE:
 		ret = imx678_set_exposure(imx678, ctrl->val);
@@ -828,10 +799,12 @@ static int imx678_set_ctrl(struct v4l2_ctrl *ctrl)
 		imx678_set_test_pattern(imx678, ctrl->val);
 		break;
 	case V4L2_CID_HFLIP:
-		ret = imx678_write_reg(imx678, HREVERSE, 1, ctrl->val);
+		ret = fr_sensor_write_reg(&imx678->core, HREVERSE, 1,
+					ctrl->val);
 		break;
 	case V4L2_CID_VFLIP:
-		ret = imx678_write_reg(imx678, VREVERSE, 1, ctrl->val);
+		ret = fr_sensor_write_reg(&imx678->core, VREVERSE, 1,
+					ctrl->val);
 		break;
 	case V4L2_CID_FRAME_RATE:
 		ret = imx678_set_frame_rate(imx678, ctrl->val);
@@ -841,13 +814,17 @@ static int imx678_set_ctrl(struct v4l2_ctrl *ctrl)
 		break;
 	case V4L2_CID_OPERATION_MODE:
 		ret = imx678_set_operation_mode(imx678, ctrl->val);
+		fr_sensor_invalidate_staging(&imx678->core);
 		break;
 	case V4L2_CID_SYNC_MODE:
 		ret = imx678_set_sync_mode(imx678, ctrl->val);
+		fr_sensor_invalidate_staging(&imx678->core);
 		break;
 	}
 
-	pm_runtime_put(&client->dev);
+	WRITE_ONCE(imx678->core.i2c_class, FR_I2C_OTHER);
+
+	pm_runtime_put_autosuspend(&client->dev);
 
 	return ret;
 }
@@ -956,11 +933,11 @@ static int imx678_get_pad_format(struct v4l2_subdev *sd,
 	if (fmt->pad >= NUM_PADS)
 		return -EINVAL;
 
-	mutex_lock(&imx678->mutex);
+	mutex_lock(&imx678->core.mutex);
 
 	if (fmt->which == V4L2_SUBDEV_FORMAT_TRY) {
 		struct v4l2_mbus_framefmt *try_fmt =
-			v4l2_subdev_get_try_format(&imx678->sd, sd_state,
+			v4l2_subdev_get_try_format(&imx678->core.sd, sd_state,
 							fmt->pad);
 		try_fmt->code = fmt->pad == IMAGE_PAD ?
 				imx678_get_format_code(imx678, try_fmt->code) :
@@ -972,19 +949,19 @@ static int imx678_get_pad_format(struct v4l2_subdev *sd,
 								fmt);
 			fmt->format.code =
 					imx678_get_format_code(imx678,
-								imx678->fmt_code);
+								imx678->core.fmt_code);
 		} else {
 			imx678_update_metadata_pad_format(fmt);
 		}
 	}
 
-	mutex_unlock(&imx678->mutex);
+	mutex_unlock(&imx678->core.mutex);
 	return 0;
 }
 
 static void imx678_set_limits(struct imx678 *imx678)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
 	struct device *dev = &client->dev;
 	const struct imx678_mode *mode = imx678->mode;
 	u64 vblank, max_framerate;
@@ -993,7 +970,7 @@ static void imx678_set_limits(struct imx678 *imx678)
 
 	vblank = IMX678_MIN_FRAME_LENGTH_DELTA;
 
-	__v4l2_ctrl_modify_range(imx678->vblank, vblank,
+	__v4l2_ctrl_modify_range(imx678->core.vblank, vblank,
 				 vblank, 1, vblank);
 	dev_dbg(dev, "%s: vblank: %lld\n", __func__, vblank);
 
@@ -1001,7 +978,7 @@ static void imx678_set_limits(struct imx678 *imx678)
 				 mode->pixel_rate, 1, mode->pixel_rate);
 	dev_dbg(dev, "%s: pixel rate: %d\n", __func__, mode->pixel_rate);
 
-	if (!(strcmp(imx678->gmsl, "gmsl")))
+	if (fr_sensor_is_gmsl(&imx678->core))
 		__v4l2_ctrl_s_ctrl(imx678->link_freq, _GMSL_LINK_FREQ_1500);
 	else
 		__v4l2_ctrl_s_ctrl(imx678->link_freq, mode->linkfreq);
@@ -1009,26 +986,28 @@ static void imx678_set_limits(struct imx678 *imx678)
 	dev_dbg(dev, "%s: linkfreq: %lld\n", __func__,
 					imx678_link_freq_menu[mode->linkfreq]);
 
-	imx678->line_time = (mode->hmax*IMX678_G_FACTOR) / (IMX678_XCLK_FREQ);
-	dev_dbg(dev, "%s: line time: %lld\n", __func__, imx678->line_time);
+	fr_sensor_set_hmax(&imx678->core, mode->hmax);
+	imx678->core.interval_fps = 0;
+	dev_dbg(dev, "%s: line time: %lld\n", __func__, imx678->core.line_time);
 
 	if (imx678_is_binning_mode(imx678))
-		imx678->frame_length = mode->height * 2 + vblank;
+		imx678->core.frame_length = mode->height * 2 + vblank;
 	else
-		imx678->frame_length = mode->height + vblank;
+		imx678->core.frame_length = mode->height + vblank;
 
-	dev_dbg(dev, "%s: frame length: %d\n", __func__, imx678->frame_length);
+	dev_dbg(dev, "%s: frame length: %d\n", __func__,
+						imx678->core.frame_length);
 
 	max_framerate = (IMX678_G_FACTOR * IMX678_M_FACTOR) /
-				(imx678->frame_length * imx678->line_time);
+			(imx678->core.frame_length * imx678->core.line_time);
 
-	__v4l2_ctrl_modify_range(imx678->framerate, mode->min_fps,
+	__v4l2_ctrl_modify_range(imx678->core.framerate, mode->min_fps,
 				 max_framerate, 1, max_framerate);
 	dev_dbg(dev, "%s: max framerate: %lld\n", __func__, max_framerate);
 
 	imx678_update_blklvl_range(imx678);
 
-	__v4l2_ctrl_s_ctrl(imx678->framerate, max_framerate);
+	__v4l2_ctrl_s_ctrl(imx678->core.framerate, max_framerate);
 }
 
 static int imx678_set_pad_format(struct v4l2_subdev *sd,
@@ -1042,7 +1021,7 @@ static int imx678_set_pad_format(struct v4l2_subdev *sd,
 	if (fmt->pad >= NUM_PADS)
 		return -EINVAL;
 
-	mutex_lock(&imx678->mutex);
+	mutex_lock(&imx678->core.mutex);
 
 	if (fmt->pad == IMAGE_PAD) {
 		const struct imx678_mode *mode_list;
@@ -1065,8 +1044,10 @@ static int imx678_set_pad_format(struct v4l2_subdev *sd,
 			*framefmt = fmt->format;
 		} else if (imx678->mode != mode) {
 			imx678->mode = mode;
-			imx678->fmt_code = fmt->format.code;
+			imx678->crop = mode->crop;
+			imx678->core.fmt_code = fmt->format.code;
 			imx678_set_limits(imx678);
+			fr_sensor_invalidate_staging(&imx678->core);
 		}
 	} else {
 		if (fmt->which == V4L2_SUBDEV_FORMAT_TRY) {
@@ -1078,7 +1059,7 @@ static int imx678_set_pad_format(struct v4l2_subdev *sd,
 		}
 	}
 
-	mutex_unlock(&imx678->mutex);
+	mutex_unlock(&imx678->core.mutex);
 
 	return 0;
 }
@@ -1090,9 +1071,9 @@ __imx678_get_pad_crop(struct imx678 *imx678,
 {
 	switch (which) {
 	case V4L2_SUBDEV_FORMAT_TRY:
-		return v4l2_subdev_get_try_crop(&imx678->sd, sd_state, pad);
+		return v4l2_subdev_get_try_crop(&imx678->core.sd, sd_state, pad);
 	case V4L2_SUBDEV_FORMAT_ACTIVE:
-		return &imx678->mode->crop;
+		return &imx678->crop;
 	}
 
 	return NULL;
@@ -1106,10 +1087,10 @@ static int imx678_get_selection(struct v4l2_subdev *sd,
 	case V4L2_SEL_TGT_CROP: {
 		struct imx678 *imx678 = to_imx678(sd);
 
-		mutex_lock(&imx678->mutex);
+		mutex_lock(&imx678->core.mutex);
 		sel->r = *__imx678_get_pad_crop(imx678, sd_state, sel->pad,
 						sel->which);
-		mutex_unlock(&imx678->mutex);
+		mutex_unlock(&imx678->core.mutex);
 
 		return 0;
 	}
@@ -1135,359 +1116,216 @@ static int imx678_get_selection(struct v4l2_subdev *sd,
 	return -EINVAL;
 }
 
-static int imx678_set_mode(struct imx678 *imx678)
+static int imx678_set_selection(struct v4l2_subdev *sd,
+				struct v4l2_subdev_state *sd_state,
+				struct v4l2_subdev_selection *sel)
 {
+	struct imx678 *imx678 = to_imx678(sd);
+	struct v4l2_rect *crop;
+	struct v4l2_rect prev;
+	int ret = 0;
 
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
-	struct device *dev = &client->dev;
-	const struct imx678_reg_list *reg_list;
-	int ret;
-
-	ret = imx678_write_table(imx678, mode_common_regs,
-					ARRAY_SIZE(mode_common_regs));
-
-	if (ret) {
-		dev_err(dev, "%s failed to set common settings\n", __func__);
-		return ret;
-	}
+	if (sel->target != V4L2_SEL_TGT_CROP || sel->pad != IMAGE_PAD)
+		return -EINVAL;
 
-	reg_list = &imx678->mode->reg_list;
-	ret = imx678_write_table(imx678, reg_list->regs, reg_list->num_of_regs);
-	if (ret) {
-		dev_err(dev, "%s failed to set mode\n", __func__);
-		return ret;
-	}
+	mutex_lock(&imx678->core.mutex);
 
-	reg_list = &imx678->mode->reg_list_format;
-	ret = imx678_write_table(imx678, reg_list->regs, reg_list->num_of_regs);
-	if (ret) {
-		dev_err(dev, "%s failed to set frame format\n", __func__);
-		return ret;
+	if (sel->which == V4L2_SUBDEV_FORMAT_TRY)
+		crop = v4l2_subdev_get_try_crop(sd, sd_state, sel->pad);
+	else
+		crop = &imx678->crop;
+
+	/*
+	 * Only the window start can be changed, the window size is defined
+	 * by the selected mode. Sensor readout modes that do not use window
+	 * cropping keep their fixed position.
+	 */
+	if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE &&
+	    !imx678_is_window_mode(imx678->mode)) {
+		sel->r = *crop;
+		goto unlock;
 	}
 
-	ret = imx678_set_hmax_register(imx678);
-	if (ret) {
-		dev_err(dev, "%s failed to write hmax register\n", __func__);
-		return ret;
+	prev = *crop;
+
+	crop->left = clamp_t(s32, sel->r.left, IMX678_PIXEL_ARRAY_LEFT,
+			     IMX678_PIXEL_ARRAY_WIDTH - crop->width);
+	crop->left = round_down(crop->left, IMX678_WINDOW_H_STEP);
+	crop->top = clamp_t(s32, sel->r.top, IMX678_PIXEL_ARRAY_TOP,
+			    IMX678_PIXEL_ARRAY_HEIGHT - crop->height);
+	crop->top = round_down(crop->top, IMX678_WINDOW_V_STEP);
+
+	/*
+	 * While streaming the new start position is written inside a
+	 * register hold group, so the sensor switches to it on the next
+	 * frame boundary without a stream restart.
+	 */
+	if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE && imx678->core.streaming &&
+	    (crop->left != prev.left || crop->top != prev.top)) {
+		ret = imx678_set_window_position(imx678);
+		if (ret)
+			*crop = prev;
+	} else if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE &&
+		   (crop->left != prev.left || crop->top != prev.top)) {
+		fr_sensor_invalidate_staging(&imx678->core);
 	}
 
-	ret = imx678_set_data_rate(imx678);
-	if (ret) {
-		dev_err(dev, "%s failed to set data rate\n", __func__);
-		return ret;
-	}
+	sel->r = *crop;
 
-	ret = imx678_configure_triggering_pins(imx678);
-	if (ret) {
-		dev_err(dev, "%s failed to configure triggering pins\n",
-								__func__);
-		return ret;
-	}
+unlock:
+	mutex_unlock(&imx678->core.mutex);
 
 	return ret;
 }
 
-static int imx678_start_streaming(struct imx678 *imx678)
+/*
+ * Describe the CSI-2 stream seen by the receiver: the image on the data
+ * type of the active format and the virtual channel it arrives on.
+ */
+static int imx678_get_frame_desc(struct v4l2_subdev *sd, unsigned int pad,
+				 struct v4l2_mbus_frame_desc *fd)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
-	struct device *dev = &client->dev;
-	int ret;
-
-	if (!(strcmp(imx678->gmsl, "gmsl"))) {
-		ret = max96793_setup_streaming(imx678->ser_dev, imx678->fmt_code);
-		if (ret) {
-			dev_err(dev, "%s: Unable to setup streaming for serializer max96793\n",
-								__func__);
-			return ret;
-		}
-		ret = max96792_setup_streaming(imx678->dser_dev,
-							&client->dev);
-		if (ret) {
-			dev_err(dev, "%s: Unable to setup streaming for deserializer max96792\n",
-								__func__);
-			return ret;
-		}
-		ret = max96792_start_streaming(imx678->dser_dev, &client->dev);
-		if (ret) {
-			dev_err(dev, "%s: Unable to start gmsl streaming\n",
-								__func__);
-			return ret;
-		}
-	}
-
-	ret = imx678_set_mode(imx678);
-	if (ret) {
-		dev_err(dev, "%s failed to set mode start stream\n", __func__);
-		return ret;
-	}
+	struct imx678 *imx678 = to_imx678(sd);
+	struct v4l2_mbus_frame_desc_entry *entry;
+	u8 vc = 0;
 
-	ret = __v4l2_ctrl_handler_setup(imx678->sd.ctrl_handler);
-	if (ret)
-		return ret;
+	if (pad >= NUM_PADS)
+		return -EINVAL;
 
-	ret = imx678_write_reg(imx678, STANDBY, 1, IMX678_MODE_STREAMING);
+	if (fr_sensor_is_gmsl(&imx678->core))
+		vc = imx678->core.g_ctx.dst_vc;
 
-	if (ret) {
-		dev_err(dev, "%s failed to set STANDBY start stream\n",
-								__func__);
-		return ret;
-	}
+	memset(fd, 0, sizeof(*fd));
+	fd->type = V4L2_MBUS_FRAME_DESC_TYPE_CSI2;
 
-	usleep_range(29000, 30000);
+	mutex_lock(&imx678->core.mutex);
 
-	if (imx678->operation_mode->val == MASTER_MODE)
-		ret = imx678_write_reg(imx678, XMSTA, 1, 0x00);
-	else
-		ret = imx678_write_reg(imx678, XMSTA, 1, 0x01);
+	entry = &fd->entry[fd->num_entries++];
+	entry->stream = IMAGE_PAD;
+	entry->pixelcode = imx678->core.fmt_code;
+	entry->bus.csi2.vc = vc;
+	entry->bus.csi2.dt =
+		imx678->core.fmt_code == MEDIA_BUS_FMT_SRGGB10_1X10 ?
+		MIPI_CSI2_DT_RAW10 : MIPI_CSI2_DT_RAW12;
 
-	if (ret) {
-		dev_err(dev, "%s failed to set XMSTA start stream\n", __func__);
-		return ret;
-	}
+	mutex_unlock(&imx678->core.mutex);
 
-	return ret;
+	return 0;
 }
 
-static void imx678_stop_streaming(struct imx678 *imx678)
+static int imx678_set_mode(struct fr_sensor *core)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
-	struct device *dev = &client->dev;
+	struct imx678 *imx678 = core_to_imx678(core);
+	struct device *dev = &core->client->dev;
+	const struct fr_sensor_reg_list *reg_list;
+	ktime_t start = ktime_get();
 	int ret;
 
-	if (!(strcmp(imx678->gmsl, "gmsl"))) {
-		max96793_bypassPCLK_dis(imx678->ser_dev);
-		max96792_stop_streaming(imx678->dser_dev, &client->dev);
-	}
-
-	ret = imx678_write_reg(imx678, XMSTA, 1, 0x01);
-	if (ret)
-		dev_err(dev, "%s failed to set XMSTA stop stream\n", __func__);
-
-	ret = imx678_write_reg(imx678, STANDBY, 1, IMX678_MODE_STANDBY);
-	if (ret)
-		dev_err(dev, "%s failed to set stream\n", __func__);
-
-	usleep_range(imx678->frame_length * imx678->line_time / IMX678_K_FACTOR,
-		imx678->frame_length * imx678->line_time / IMX678_K_FACTOR + 1000);
-
-}
-
-static int imx678_set_stream(struct v4l2_subdev *sd, int enable)
-{
-	struct imx678 *imx678 = to_imx678(sd);
-	struct i2c_client *client = v4l2_get_subdevdata(sd);
-	int ret = 0;
-
-	mutex_lock(&imx678->mutex);
-	if (imx678->streaming == enable) {
-		mutex_unlock(&imx678->mutex);
-		return 0;
-	}
-
-	if (enable) {
-		ret = pm_runtime_get_sync(&client->dev);
-		if (ret < 0) {
-			pm_runtime_put_noidle(&client->dev);
-			goto err_unlock;
+	/*
+	 * Common settings survive STREAMOFF/STREAMON, they only have to be
+	 * written once after the sensor has been powered up.
+	 */
+	if (!core->common_regs_written) {
+		ret = fr_sensor_write_table(core, mode_common_regs,
+					ARRAY_SIZE(mode_common_regs));
+		if (ret) {
+			dev_err(dev, "%s failed to set common settings\n",
+								__func__);
+			return ret;
 		}
 
-		ret = imx678_start_streaming(imx678);
-		if (ret)
-			goto err_rpm_put;
-	} else {
-		imx678_stop_streaming(imx678);
-		pm_runtime_put(&client->dev);
+		core->common_regs_written = true;
+		start = fr_latency_record(&core->latency,
+					  FR_STAGE_COMMON_REGS, start);
 	}
 
-	imx678->streaming = enable;
-
-	__v4l2_ctrl_grab(imx678->vflip, enable);
-	__v4l2_ctrl_grab(imx678->hflip, enable);
-	__v4l2_ctrl_grab(imx678->operation_mode, enable);
-	__v4l2_ctrl_grab(imx678->sync_mode, enable);
-
-	mutex_unlock(&imx678->mutex);
-
-	return ret;
-
-err_rpm_put:
-	pm_runtime_put(&client->dev);
-err_unlock:
-	mutex_unlock(&imx678->mutex);
-
-	return ret;
-}
-
-static int imx678_gmsl_serdes_setup(struct imx678 *imx678)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
-	struct device *dev = &client->dev;
-	int ret = 0;
-	int des_err = 0;
-
-	if (!imx678 || !imx678->ser_dev || !imx678->dser_dev || !client)
-		return -EINVAL;
-
-	dev_dbg(dev, "enter %s function\n", __func__);
-
-	mutex_lock(&imx678->mutex);
-
-	ret = max96792_reset_control(imx678->dser_dev, &client->dev);
-
-	ret = max96792_gmsl3_setup(imx678->dser_dev);
+	reg_list = &imx678->mode->reg_list;
+	ret = __fr_sensor_write_table(core, reg_list->regs,
+				   reg_list->num_of_regs, "mode");
 	if (ret) {
-		dev_err(dev, "deserializer gmsl setup failed\n");
-		goto error;
+		dev_err(dev, "%s failed to set mode\n", __func__);
+		return ret;
 	}
 
-	ret = max96793_gmsl3_setup(imx678->ser_dev);
+	reg_list = &imx678->mode->reg_list_format;
+	ret = __fr_sensor_write_table(core, reg_list->regs,
+				   reg_list->num_of_regs, "format");
 	if (ret) {
-		dev_err(dev, "serializer gmsl setup failed\n");
-		goto error;
+		dev_err(dev, "%s failed to set frame format\n", __func__);
+		return ret;
 	}
 
-	dev_dbg(dev, "%s: max96792_setup_link\n", __func__);
+	if (imx678_is_window_mode(imx678->mode)) {
+		ret = imx678_set_window_position(imx678);
+		if (ret)
+			return ret;
+	}
 
-	ret = max96792_setup_link(imx678->dser_dev, &client->dev);
+	ret = imx678_set_hmax_register(imx678);
 	if (ret) {
-		dev_err(dev, "gmsl deserializer link config failed\n");
-		goto error;
+		dev_err(dev, "%s failed to write hmax register\n", __func__);
+		return ret;
 	}
+	start = fr_latency_record(&core->latency, FR_STAGE_MODE_REGS,
+									start);
 
-	dev_dbg(dev, "%s: max96793_setup_control\n", __func__);
-	ret = max96793_setup_control(imx678->ser_dev);
-
-	if (ret)
-		dev_err(dev, "gmsl serializer setup failed\n");
-
-	ret = max96793_gpio10_xtrig1_setup(imx678->ser_dev, "mipi");
+	ret = imx678_set_data_rate(imx678);
 	if (ret) {
-		dev_err(dev, "gmsl serializer gpio10/xtrig1 pin config failed\n");
-		goto error;
+		dev_err(dev, "%s failed to set data rate\n", __func__);
+		return ret;
 	}
+	fr_latency_record(&core->latency, FR_STAGE_DATA_RATE, start);
 
-	dev_dbg(dev, "%s: max96792_setup_control\n", __func__);
-	des_err = max96792_setup_control(imx678->dser_dev, &client->dev);
-	if (des_err)
-		dev_err(dev, "gmsl deserializer setup failed\n");
-
-error:
-	mutex_unlock(&imx678->mutex);
-	return ret;
-}
-
-static void imx678_gmsl_serdes_reset(struct imx678 *imx678)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
-
-	mutex_lock(&imx678->mutex);
-
-	max96793_reset_control(imx678->ser_dev);
-	max96792_reset_control(imx678->dser_dev, &client->dev);
-	max96792_power_off(imx678->dser_dev, &imx678->g_ctx);
-
-	mutex_unlock(&imx678->mutex);
-}
-
-static int imx678_power_on(struct device *dev)
-{
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx678 *imx678 = to_imx678(sd);
-
-	if (strcmp(imx678->gmsl, "gmsl")) {
-		gpiod_set_value_cansleep(imx678->reset_gpio, 1);
-		usleep_range(25000, 30000);
-	} else {
-		dev_info(dev, "%s: max96792_power_on\n", __func__);
-		max96792_power_on(imx678->dser_dev, &imx678->g_ctx);
+	ret = imx678_configure_triggering_pins(imx678);
+	if (ret) {
+		dev_err(dev, "%s failed to configure triggering pins\n",
+								__func__);
+		return ret;
 	}
 
-	return 0;
+	return ret;
 }
 
-static int imx678_power_off(struct device *dev)
+static int imx678_communication_verify(struct imx678 *imx678)
 {
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx678 *imx678 = to_imx678(sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
+	struct device *dev = &client->dev;
 	int ret;
 
-	ret = imx678_write_reg(imx678, XVS_XHS_DRV, 1, 0xF);
+	ret = fr_sensor_identify(&imx678->core);
 	if (ret)
-		dev_err(dev, "%s: error setting XVS XHS to Hi-Z\n", __func__);
-
-	mutex_lock(&imx678->mutex);
-	if (strcmp(imx678->gmsl, "gmsl")) {
-		gpiod_set_value_cansleep(imx678->reset_gpio, 0);
-	} else {
-		dev_info(dev, "%s: max96792_power_off\n", __func__);
-		max96792_power_off(imx678->dser_dev, &imx678->g_ctx);
-	}
-	mutex_unlock(&imx678->mutex);
-
-	return 0;
-}
-
-static int __maybe_unused imx678_suspend(struct device *dev)
-{
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx678 *imx678 = to_imx678(sd);
+		return ret;
 
-	if (imx678->streaming)
-		imx678_stop_streaming(imx678);
+	dev_info(dev, "Detected imx678 sensor\n");
 
 	return 0;
 }
 
-static int __maybe_unused imx678_resume(struct device *dev)
+static int imx678_subscribe_event(struct v4l2_subdev *sd, struct v4l2_fh *fh,
+				  struct v4l2_event_subscription *sub)
 {
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
 	struct imx678 *imx678 = to_imx678(sd);
-	int ret;
-
-	if (imx678->streaming) {
-		ret = imx678_start_streaming(imx678);
-		if (ret)
-			goto error;
-	}
 
-	return 0;
-
-error:
-	imx678_stop_streaming(imx678);
-	imx678->streaming = 0;
-	return ret;
-}
-
-static int imx678_communication_verify(struct imx678 *imx678)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
-	struct device *dev = &client->dev;
-	int ret;
-	u32 val;
-
-	ret = imx678_read_reg(imx678, VMAX_LOW, 3, &val);
-
-	if (ret) {
-		dev_err(dev, "%s unable to communicate with sensor\n", __func__);
-		return ret;
+	switch (sub->type) {
+	case V4L2_EVENT_FRAME_SYNC:
+		if (imx678->core.xvs_irq <= 0)
+			return -EINVAL;
+		return v4l2_event_subscribe(fh, sub, IMX678_FRAME_SYNC_EVENTS,
+									NULL);
+	default:
+		return v4l2_ctrl_subdev_subscribe_event(sd, fh, sub);
 	}
-
-	dev_info(dev, "Detected imx678 sensor\n");
-
-	return 0;
 }
 
 static const struct v4l2_subdev_core_ops imx678_core_ops = {
-	.subscribe_event = v4l2_ctrl_subdev_subscribe_event,
+	.subscribe_event = imx678_subscribe_event,
 	.unsubscribe_event = v4l2_event_subdev_unsubscribe,
 };
 
 static const struct v4l2_subdev_video_ops imx678_video_ops = {
-	.s_stream = imx678_set_stream,
+	.s_stream = fr_sensor_s_stream,
+	.g_frame_interval = fr_sensor_g_frame_interval,
+	.s_frame_interval = fr_sensor_s_frame_interval,
 };
 
 static const struct v4l2_subdev_pad_ops imx678_pad_ops = {
@@ -1495,7 +1333,9 @@ static const struct v4l2_subdev_pad_ops imx678_pad_ops = {
 	.get_fmt = imx678_get_pad_format,
 	.set_fmt = imx678_set_pad_format,
 	.get_selection = imx678_get_selection,
+	.set_selection = imx678_set_selection,
 	.enum_frame_size = imx678_enum_frame_size,
+	.get_frame_desc = imx678_get_frame_desc,
 };
 
 static const struct v4l2_subdev_ops imx678_subdev_ops = {
@@ -1550,7 +1390,7 @@ static struct v4l2_ctrl_config imx678_ctrl_sync_mode[] = {
 static int imx678_init_controls(struct imx678 *imx678)
 {
 	struct v4l2_ctrl_handler *ctrl_hdlr;
-	struct i2c_client *client = v4l2_get_subdevdata(&imx678->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
 	struct device *dev = &client->dev;
 	struct v4l2_fwnode_device_properties props;
 	int ret;
@@ -1560,8 +1400,7 @@ static int imx678_init_controls(struct imx678 *imx678)
 	if (ret)
 		return ret;
 
-	mutex_init(&imx678->mutex);
-	ctrl_hdlr->lock = &imx678->mutex;
+	ctrl_hdlr->lock = &imx678->core.mutex;
 
 	imx678->pixel_rate = v4l2_ctrl_new_std(ctrl_hdlr, &imx678_ctrl_ops,
 						V4L2_CID_PIXEL_RATE, 0, 0, 1, 0);
@@ -1576,21 +1415,21 @@ static int imx678_init_controls(struct imx678 *imx678)
 	if (imx678->link_freq)
 		imx678->link_freq->flags |= V4L2_CTRL_FLAG_READ_ONLY;
 
-	imx678->vblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx678_ctrl_ops,
+	imx678->core.vblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx678_ctrl_ops,
 					V4L2_CID_VBLANK, 0, 0, 1, 0);
 
-	imx678->hblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx678_ctrl_ops,
+	imx678->core.hblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx678_ctrl_ops,
 					V4L2_CID_HBLANK, 0, 0, 1, 0);
 
-	if (imx678->hblank)
-		imx678->hblank->flags |= V4L2_CTRL_FLAG_READ_ONLY;
+	if (imx678->core.hblank)
+		imx678->core.hblank->flags |= V4L2_CTRL_FLAG_READ_ONLY;
 
 	imx678->exposure = v4l2_ctrl_new_std(ctrl_hdlr, &imx678_ctrl_ops,
 					V4L2_CID_EXPOSURE,
 					IMX678_MIN_INTEGRATION_LINES,
 					0xFF, 1, 0xFF);
 
-	imx678->framerate = v4l2_ctrl_new_custom(ctrl_hdlr,
+	imx678->core.framerate = v4l2_ctrl_new_custom(ctrl_hdlr,
 					imx678_ctrl_framerate, NULL);
 
 	imx678->operation_mode = v4l2_ctrl_new_custom(ctrl_hdlr,
@@ -1635,91 +1474,138 @@ static int imx678_init_controls(struct imx678 *imx678)
 	if (ret)
 		goto error;
 
-	imx678->sd.ctrl_handler = ctrl_hdlr;
+	imx678->core.grab_ctrls[0] = imx678->vflip;
+	imx678->core.grab_ctrls[1] = imx678->hflip;
+	imx678->core.grab_ctrls[2] = imx678->operation_mode;
+	imx678->core.grab_ctrls[3] = imx678->sync_mode;
+
+	imx678->core.sd.ctrl_handler = ctrl_hdlr;
 
-	mutex_lock(&imx678->mutex);
+	mutex_lock(&imx678->core.mutex);
 
 	imx678_set_limits(imx678);
 
-	mutex_unlock(&imx678->mutex);
+	mutex_unlock(&imx678->core.mutex);
 
 	return 0;
 
 error:
 	v4l2_ctrl_handler_free(ctrl_hdlr);
-	mutex_destroy(&imx678->mutex);
 
 	return ret;
 }
 
-static void imx678_free_controls(struct imx678 *imx678)
+/*
+ * Snapshot of the timing model the driver currently works with, one
+ * "key: value" pair per line. Times are derived from the line time, so
+ * userspace can plan exposure, trigger and CSI-2 bandwidth without
+ * repeating the driver's calculations.
+ */
+static int imx678_timing_show(struct seq_file *s, void *unused)
 {
-	v4l2_ctrl_handler_free(imx678->sd.ctrl_handler);
-	mutex_destroy(&imx678->mutex);
+	struct imx678 *imx678 = s->private;
+	const struct imx678_mode *mode;
+	u32 readout_lines;
+
+	mutex_lock(&imx678->core.mutex);
+
+	mode = imx678->mode;
+	readout_lines = imx678_min_frame_length(imx678) -
+					IMX678_MIN_FRAME_LENGTH_DELTA;
+
+	seq_printf(s, "mode: %ux%u\n", mode->width, mode->height);
+	seq_printf(s, "code: 0x%04x\n", imx678->core.fmt_code);
+	seq_printf(s, "hmax: %u\n", imx678->core.hmax);
+	seq_printf(s, "frame_length: %u\n", imx678->core.frame_length);
+	seq_printf(s, "line_time_ns: %llu\n", imx678->core.line_time);
+	seq_printf(s, "frame_time_us: %llu\n",
+		   imx678->core.frame_length * imx678->core.line_time /
+							IMX678_K_FACTOR);
+	seq_printf(s, "readout_lines: %u\n", readout_lines);
+	seq_printf(s, "readout_time_us: %llu\n",
+		   readout_lines * imx678->core.line_time / IMX678_K_FACTOR);
+	seq_printf(s, "min_shs_length: %d\n", IMX678_MIN_SHR0_LENGTH);
+	seq_printf(s, "min_frame_length_delta: %d\n",
+					IMX678_MIN_FRAME_LENGTH_DELTA);
+	seq_printf(s, "pixel_rate: %u\n", mode->pixel_rate);
+	seq_printf(s, "link_freq: %lld\n",
+				imx678_link_freq_menu[imx678->link_freq->val]);
+	seq_printf(s, "exposure_lines: %d\n", imx678->exposure->val);
+	seq_printf(s, "exposure_max_lines: %lld\n", imx678->exposure->maximum);
+
+	mutex_unlock(&imx678->core.mutex);
+
+	return 0;
 }
+DEFINE_SHOW_ATTRIBUTE(imx678_timing);
 
-static int imx678_check_hwcfg(struct device *dev, struct i2c_client *client)
+static void imx678_debugfs_init(struct imx678 *imx678)
 {
-	struct device_node *node = client->dev.of_node;
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx678 *imx678 = to_imx678(sd);
-	struct fwnode_handle *endpoint;
-	struct v4l2_fwnode_endpoint ep_cfg = {
-		.bus_type = V4L2_MBUS_CSI2_DPHY
-	};
-	const char *gmsl;
-	int ret = -EINVAL;
-
-	endpoint = fwnode_graph_get_next_endpoint(dev_fwnode(dev), NULL);
-	if (!endpoint) {
-		dev_err(dev, "endpoint node not found\n");
-		return -EINVAL;
-	}
+	struct i2c_client *client = v4l2_get_subdevdata(&imx678->core.sd);
+	char name[32];
 
-	if (v4l2_fwnode_endpoint_alloc_parse(endpoint, &ep_cfg)) {
-		dev_err(dev, "could not parse endpoint\n");
-		goto error_out;
-	}
+	snprintf(name, sizeof(name), "imx678-%s", dev_name(&client->dev));
 
-	if (ep_cfg.bus.mipi_csi2.num_data_lanes != 4) {
-		dev_err(dev, "only 4 data lanes are currently supported\n");
-		goto error_out;
-	}
+	imx678->debugfs = debugfs_create_dir(name, NULL);
+	debugfs_create_file("timing", 0444, imx678->debugfs, imx678,
+						&imx678_timing_fops);
+	fr_sensor_debugfs_create(&imx678->core, imx678->debugfs);
+}
 
-	if (!ep_cfg.nr_of_link_frequencies) {
-		dev_err(dev, "link-frequency property not found in DT\n");
-		goto error_out;
-	}
+static void imx678_free_controls(struct imx678 *imx678)
+{
+	v4l2_ctrl_handler_free(imx678->core.sd.ctrl_handler);
+}
 
-	if (ep_cfg.nr_of_link_frequencies != ARRAY_SIZE(imx678_link_freq_menu)) {
-		dev_err(dev, "Link frequency missing in dtree\n");
-		goto error_out;
-	}
+static bool imx678_is_master(struct fr_sensor *core)
+{
+	return core_to_imx678(core)->operation_mode->val == MASTER_MODE;
+}
 
-	for (int i = 0; i < ARRAY_SIZE(imx678_link_freq_menu); i++) {
-		if (ep_cfg.link_frequencies[i] != imx678_link_freq_menu[i]) {
-			dev_err(dev, "no supported link freq found\n");
-			goto error_out;
-		}
-	}
+static void imx678_frame_limits(struct fr_sensor *core,
+				struct fr_sensor_frame_limits *lim)
+{
+	struct imx678 *imx678 = core_to_imx678(core);
+	const struct imx678_mode *mode = imx678->mode;
 
-	ret = of_property_read_string(node, "gmsl", &gmsl);
-	if (ret) {
-		dev_warn(dev, "initializing mipi...\n");
-		imx678->gmsl = "mipi";
-	} else if (!strcmp(gmsl, "gmsl")) {
-		dev_warn(dev, "initializing GMSL...\n");
-		imx678->gmsl = "gmsl";
-	}
+	lim->width = mode->width;
+	lim->height = mode->height;
+	lim->pixel_rate = mode->pixel_rate;
+	lim->hmax_min = mode->hmax;
+	lim->vmax_min = imx678_min_frame_length(imx678);
+	lim->min_fps = mode->min_fps;
+}
 
-	ret = 0;
+/* XVS and XHS are left floating while the sensor is powered down */
+static void imx678_power_off(struct fr_sensor *core)
+{
+	if (fr_sensor_write_reg(core, XVS_XHS_DRV, 1, 0xF))
+		dev_err(&core->client->dev,
+			"%s: error setting XVS XHS to Hi-Z\n", __func__);
+}
 
-error_out:
-	v4l2_fwnode_endpoint_free(&ep_cfg);
-	fwnode_handle_put(endpoint);
+static const struct fr_sensor_ops imx678_sensor_ops = {
+	.set_mode = imx678_set_mode,
+	.is_master = imx678_is_master,
+	.frame_limits = imx678_frame_limits,
+	.power_off = imx678_power_off,
+};
 
-	return ret;
-}
+static const struct fr_sensor_desc imx678_desc = {
+	.reghold = REGHOLD,
+	.standby = STANDBY,
+	.xmsta = XMSTA,
+	.id_reg = VMAX_LOW,
+	.id_len = 3,
+	.xclk_freq = IMX678_XCLK_FREQ,
+	.hmax_max = IMX678_HMAX_MAX,
+	.vmax_max = IMX678_VMAX_MAX,
+	.vmax_step = IMX678_VMAX_STEP,
+	.settle_us = IMX678_STANDBY_SETTLE_US,
+	.link_freqs = imx678_link_freq_menu,
+	.num_link_freqs = ARRAY_SIZE(imx678_link_freq_menu),
+	.ops = &imx678_sensor_ops,
+};
 
 static const struct of_device_id imx678_dt_ids[] = {
 	{ .compatible = "framos,fr_imx678" },
@@ -1730,220 +1616,29 @@ static int imx678_probe(struct i2c_client *client)
 {
 	struct device *dev = &client->dev;
 	struct imx678 *imx678;
-	const struct of_device_id *match;
-	struct device_node *node = dev->of_node;
-	struct device_node *ser_node;
-	struct i2c_client *ser_i2c = NULL;
-	struct device_node *dser_node;
-	struct i2c_client *dser_i2c = NULL;
-	struct device_node *gmsl;
-	int value = 0xFFFF;
-	const char *str_value;
-	const char *str_value1[2];
-	int i;
 	int ret;
 
 	imx678 = devm_kzalloc(&client->dev, sizeof(*imx678), GFP_KERNEL);
 	if (!imx678)
 		return -ENOMEM;
 
-	v4l2_i2c_subdev_init(&imx678->sd, client, &imx678_subdev_ops);
-
-	match = of_match_device(imx678_dt_ids, dev);
-	if (!match)
-		return -ENODEV;
-
-	if (imx678_check_hwcfg(dev, client))
-		return -EINVAL;
-
-	if (strcmp(imx678->gmsl, "gmsl")) {
-		imx678->reset_gpio = devm_gpiod_get(dev, "reset", GPIOD_OUT_HIGH);
-		if (IS_ERR(imx678->reset_gpio)) {
-			dev_err(dev, "cannot get reset gpio\n");
-			return PTR_ERR(imx678->reset_gpio);
-		}
-	}
-
-	if (!(strcmp(imx678->gmsl, "gmsl"))) {
-		ret = of_property_read_u32(node, "reg", &imx678->g_ctx.sdev_reg);
-		if (ret < 0) {
-			dev_err(dev, "reg not found\n");
-			return ret;
-		}
-
-		ret = of_property_read_u32(node, "def-addr",
-							&imx678->g_ctx.sdev_def);
-		if (ret < 0) {
-			dev_err(dev, "def-addr not found\n");
-			return ret;
-		}
-
-		ser_node = of_parse_phandle(node, "gmsl-ser-device", 0);
-		if (ser_node == NULL) {
-			dev_err(dev, "missing %s handle\n", "gmsl-ser-device");
-			return ret;
-		}
-
-		ret = of_property_read_u32(ser_node, "reg", &imx678->g_ctx.ser_reg);
-		if (ret < 0) {
-			dev_err(dev, "serializer reg not found\n");
-			return ret;
-		}
-
-		ser_i2c = of_find_i2c_device_by_node(ser_node);
-		of_node_put(ser_node);
-
-		if (ser_i2c == NULL) {
-			dev_err(dev, "missing serializer dev handle\n");
-			return ret;
-		}
-		if (ser_i2c->dev.driver == NULL) {
-			dev_err(dev, "missing serializer driver\n");
-			return ret;
-		}
-
-		imx678->ser_dev = &ser_i2c->dev;
-
-		dser_node = of_parse_phandle(node, "gmsl-dser-device", 0);
-		if (dser_node == NULL) {
-			dev_err(dev, "missing %s handle\n", "gmsl-dser-device");
-			return ret;
-		}
-
-		dser_i2c = of_find_i2c_device_by_node(dser_node);
-		of_node_put(dser_node);
-
-		if (dser_i2c == NULL) {
-			dev_err(dev, "missing deserializer dev handle\n");
-			return ret;
-		}
-		if (dser_i2c->dev.driver == NULL) {
-			dev_err(dev, "missing deserializer driver\n");
-			return ret;
-		}
-
-		imx678->dser_dev = &dser_i2c->dev;
-
-		gmsl = of_get_child_by_name(node, "gmsl-link");
-		if (gmsl == NULL) {
-			dev_err(dev, "missing gmsl-link device node\n");
-			ret = -EINVAL;
-			return ret;
-		}
-
-		ret = of_property_read_string(gmsl, "dst-csi-port", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No dst-csi-port found\n");
-			return ret;
-		}
-		imx678->g_ctx.dst_csi_port =
-		(!strcmp(str_value, "a")) ? GMSL_CSI_PORT_A : GMSL_CSI_PORT_B;
-
-		ret = of_property_read_string(gmsl, "src-csi-port", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No src-csi-port found\n");
-			return ret;
-		}
-		imx678->g_ctx.src_csi_port =
-		(!strcmp(str_value, "a")) ? GMSL_CSI_PORT_A : GMSL_CSI_PORT_B;
+	v4l2_i2c_subdev_init(&imx678->core.sd, client, &imx678_subdev_ops);
 
-		ret = of_property_read_string(gmsl, "csi-mode", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No csi-mode found\n");
-			return ret;
-		}
-
-		if (!strcmp(str_value, "1x4")) {
-			imx678->g_ctx.csi_mode = GMSL_CSI_1X4_MODE;
-		} else if (!strcmp(str_value, "2x4")) {
-			imx678->g_ctx.csi_mode = GMSL_CSI_2X4_MODE;
-		} else if (!strcmp(str_value, "2x2")) {
-			imx678->g_ctx.csi_mode = GMSL_CSI_2X2_MODE;
-		} else {
-			dev_err(dev, "invalid csi mode\n");
-			return ret;
-		}
-
-		ret = of_property_read_string(gmsl, "serdes-csi-link", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No serdes-csi-link found\n");
-			return ret;
-		}
-		imx678->g_ctx.serdes_csi_link =
-		(!strcmp(str_value, "a")) ? GMSL_SERDES_CSI_LINK_A : GMSL_SERDES_CSI_LINK_B;
-
-		ret = of_property_read_u32(gmsl, "st-vc", &value);
-		if (ret < 0) {
-			dev_err(dev, "No st-vc info\n");
-			return ret;
-		}
-
-		imx678->g_ctx.st_vc = value;
-
-		ret = of_property_read_u32(gmsl, "vc-id", &value);
-		if (ret < 0) {
-			dev_err(dev, "No vc-id info\n");
-			return ret;
-		}
-		imx678->g_ctx.dst_vc = value;
-
-		ret = of_property_read_u32(gmsl, "num-lanes", &value);
-		if (ret < 0) {
-			dev_err(dev, "No num-lanes info\n");
-			return ret;
-		}
-
-		imx678->g_ctx.num_csi_lanes = value;
-
-		imx678->g_ctx.num_streams =
-				of_property_count_strings(gmsl, "streams");
-		if (imx678->g_ctx.num_streams <= 0) {
-			dev_err(dev, "No streams found\n");
-			ret = -EINVAL;
-			return ret;
-		}
+	fr_sensor_init(&imx678->core, client, &imx678_desc);
 
-		for (i = 0; i < imx678->g_ctx.num_streams; i++) {
-			of_property_read_string_index(gmsl, "streams", i, &str_value1[i]);
-			if (!str_value1[i]) {
-				dev_err(dev, "invalid stream info\n");
-				return ret;
-			}
-			if (!strcmp(str_value1[i], "raw12")) {
-				imx678->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_RAW_12;
-			} else if (!strcmp(str_value1[i], "embed")) {
-				imx678->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_EMBED;
-			} else if (!strcmp(str_value1[i], "ued-u1")) {
-				imx678->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_UED_U1;
-			} else {
-				dev_err(dev, "invalid stream data type\n");
-				return ret;
-			}
-		}
-
-		imx678->g_ctx.s_dev = dev;
-
-		ret = max96793_sdev_pair(imx678->ser_dev, &imx678->g_ctx);
-		if (ret) {
-			dev_err(dev, "gmsl ser pairing failed\n");
-			return ret;
-		}
-
-		ret = max96792_sdev_register(imx678->dser_dev, &imx678->g_ctx);
-		if (ret) {
-			dev_err(dev, "gmsl deserializer register failed\n");
-			return ret;
-		}
+	ret = fr_sensor_probe(&imx678->core);
+	if (ret)
+		return ret;
 
-		ret = imx678_gmsl_serdes_setup(imx678);
+	if (fr_sensor_is_gmsl(&imx678->core)) {
+		ret = fr_sensor_gmsl_serdes_setup(&imx678->core);
 		if (ret) {
 			dev_err(dev, "%s gmsl serdes setup failed\n", __func__);
 			return ret;
 		}
-
 	}
 
-	ret = imx678_power_on(dev);
+	ret = fr_sensor_runtime_resume(dev);
 	if (ret)
 		return ret;
 
@@ -1958,49 +1653,67 @@ static int imx678_probe(struct i2c_client *client)
 		return PTR_ERR(imx678->xmaster);
 	}
 
+	ret = fr_sensor_xvs_init(&imx678->core);
+	if (ret)
+		goto error_power_off;
+
 	imx678->mode = &modes_12bit[0];
-	imx678->fmt_code = MEDIA_BUS_FMT_SRGGB12_1X12;
+	imx678->crop = imx678->mode->crop;
+	imx678->core.fmt_code = MEDIA_BUS_FMT_SRGGB12_1X12;
 
-	pm_runtime_set_active(dev);
-	pm_runtime_enable(dev);
-	pm_runtime_idle(dev);
+	fr_sensor_pm_enable(&imx678->core);
 
 	ret = imx678_init_controls(imx678);
 	if (ret)
-		goto error_power_off;
+		goto error_pm_disable;
 
-	imx678->sd.internal_ops = &imx678_internal_ops;
-	imx678->sd.flags |= V4L2_SUBDEV_FL_HAS_DEVNODE |
+	imx678->core.sd.internal_ops = &imx678_internal_ops;
+	imx678->core.sd.flags |= V4L2_SUBDEV_FL_HAS_DEVNODE |
 				V4L2_SUBDEV_FL_HAS_EVENTS;
-	imx678->sd.entity.function = MEDIA_ENT_F_CAM_SENSOR;
+	imx678->core.sd.entity.function = MEDIA_ENT_F_CAM_SENSOR;
 
 	imx678->pad[IMAGE_PAD].flags = MEDIA_PAD_FL_SOURCE;
 	imx678->pad[METADATA_PAD].flags = MEDIA_PAD_FL_SOURCE;
 
-	ret = media_entity_pads_init(&imx678->sd.entity, NUM_PADS, imx678->pad);
+	ret = media_entity_pads_init(&imx678->core.sd.entity, NUM_PADS,
+				     imx678->pad);
 	if (ret) {
 		dev_err(dev, "failed to init entity pads: %d\n", ret);
 		goto error_handler_free;
 	}
 
-	ret = v4l2_async_register_subdev_sensor(&imx678->sd);
+	ret = fr_sensor_join_sync_group(&imx678->core);
+	if (ret)
+		goto error_media_entity;
+
+	ret = v4l2_async_register_subdev_sensor(&imx678->core.sd);
 	if (ret < 0) {
 		dev_err(dev, "failed to register sensor sub-device: %d\n", ret);
-		goto error_media_entity;
+		goto error_sync_leave;
 	}
 
+	imx678_debugfs_init(imx678);
+
 	return 0;
 
+error_sync_leave:
+	fr_sync_group_leave(&imx678->core.sync);
+
 error_media_entity:
-	media_entity_cleanup(&imx678->sd.entity);
+	media_entity_cleanup(&imx678->core.sd.entity);
 
 error_handler_free:
 	imx678_free_controls(imx678);
 
+error_pm_disable:
+	fr_sensor_pm_disable(&imx678->core);
+	mutex_destroy(&imx678->core.mutex);
+
+	return ret;
+
 error_power_off:
-	pm_runtime_disable(&client->dev);
-	pm_runtime_set_suspended(&client->dev);
-	imx678_power_off(&client->dev);
+	fr_sensor_runtime_suspend(&client->dev);
+	mutex_destroy(&imx678->core.mutex);
 
 	return ret;
 }
@@ -2010,35 +1723,39 @@ static void imx678_remove(struct i2c_client *client)
 	struct v4l2_subdev *sd = i2c_get_clientdata(client);
 	struct imx678 *imx678 = to_imx678(sd);
 
-	if (!(strcmp(imx678->gmsl, "gmsl"))) {
-		max96792_sdev_unregister(imx678->dser_dev, &client->dev);
-		imx678_gmsl_serdes_reset(imx678);
-	}
+	cancel_delayed_work_sync(&imx678->core.stage_work);
+
+	mutex_lock(&imx678->core.mutex);
+	fr_sensor_remove(&imx678->core);
+	mutex_unlock(&imx678->core.mutex);
 
+	debugfs_remove_recursive(imx678->debugfs);
 	v4l2_async_unregister_subdev(sd);
+	fr_sync_group_leave(&imx678->core.sync);
 	media_entity_cleanup(&sd->entity);
 	imx678_free_controls(imx678);
 
-	pm_runtime_disable(&client->dev);
-	if (!pm_runtime_status_suspended(&client->dev))
-		imx678_power_off(&client->dev);
-	pm_runtime_set_suspended(&client->dev);
+	fr_sensor_pm_disable(&imx678->core);
+	mutex_destroy(&imx678->core.mutex);
 }
 
 MODULE_DEVICE_TABLE(of, imx678_dt_ids);
 
-static const struct dev_pm_ops imx678_pm_ops = {
-	SET_SYSTEM_SLEEP_PM_OPS(imx678_suspend, imx678_resume)
-	SET_RUNTIME_PM_OPS(imx678_power_off, imx678_power_on, NULL)
+/* Lets the sensor be instantiated without device tree, from software nodes */
+static const struct i2c_device_id imx678_id[] = {
+	{ "fr_imx678" },
+	{ }
 };
+MODULE_DEVICE_TABLE(i2c, imx678_id);
 
 static struct i2c_driver imx678_i2c_driver = {
 	.driver = {
 		.name = "fr_imx678",
 		.of_match_table	= imx678_dt_ids,
-		.pm = &imx678_pm_ops,
+		.pm = &fr_sensor_pm_ops,
 	},
 	.probe = imx678_probe,
+	.id_table = imx678_id,
 	.remove = imx678_remove,
 };
 
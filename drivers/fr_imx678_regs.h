@@ -5,6 +5,8 @@
  * fr_imx678_regs.h - imx678 sensor mode tables
  */
 
+#include "fr_sensor_core.h"
+
 #define STANDBY			0x3000
 #define REGHOLD			0x3001
 #define XMSTA			0x3002
@@ -69,17 +71,12 @@
 #define IMX678_MODE_BINNING_H2V2_HEIGHT	1090
 
 
-struct imx678_reg {
-	u16 address;
-	u8 val;
-};
-
 #define IMX678_MIN_FRAME_LENGTH_DELTA	70
 
 #define IMX678_TO_LOW_BYTE(x) (x & 0xFF)
 #define IMX678_TO_MID_BYTE(x) (x >> 8)
 
-static const struct imx678_reg mode_common_regs[] = {
+static const struct fr_sensor_reg mode_common_regs[] = {
 
 	{LANEMODE,		0x03},
 	{INCK_SEL,		0x01},
@@ -444,21 +441,21 @@ static const struct imx678_reg mode_common_regs[] = {
 
 };
 
-static const struct imx678_reg raw12_framefmt_regs[] = {
+static const struct fr_sensor_reg raw12_framefmt_regs[] = {
 
 	{ADBIT,			0x01},
 	{MDBIT,			0x01},
 
 };
 
-static const struct imx678_reg raw10_framefmt_regs[] = {
+static const struct fr_sensor_reg raw10_framefmt_regs[] = {
 
 	{ADBIT,			0x00},
 	{MDBIT,			0x00},
 
 };
 
-static const struct imx678_reg raw12_h2v2_framefmt_regs[] = {
+static const struct fr_sensor_reg raw12_h2v2_framefmt_regs[] = {
 
 	{ADBIT,			0x00},
 	{MDBIT,			0x01},
@@ -466,7 +463,7 @@ static const struct imx678_reg raw12_h2v2_framefmt_regs[] = {
 };
 
 
-static const struct imx678_reg mode_3856x2180[] = {
+static const struct fr_sensor_reg mode_3856x2180[] = {
 
 	{WINMODE,		0x00},
 	{ADDMODE,		0x00},
@@ -475,7 +472,7 @@ static const struct imx678_reg mode_3856x2180[] = {
 
 };
 
-static const struct imx678_reg mode_crop_2608x1964[] = {
+static const struct fr_sensor_reg mode_crop_2608x1964[] = {
 
 	{WINMODE,		0x04},
 	{ADDMODE,		0x00},
@@ -495,7 +492,7 @@ static const struct imx678_reg mode_crop_2608x1964[] = {
 };
 
 
-static const struct imx678_reg mode_crop_1920x1080[] = {
+static const struct fr_sensor_reg mode_crop_1920x1080[] = {
 
 	{WINMODE,		0x04},
 	{ADDMODE,		0x00},
@@ -514,7 +511,7 @@ static const struct imx678_reg mode_crop_1920x1080[] = {
 
 };
 
-static const struct imx678_reg mode_h2v2_binning[] = {
+static const struct fr_sensor_reg mode_h2v2_binning[] = {
 
 	{WINMODE,		0x00},
 	{ADDMODE,		0x01},
@@ -523,7 +520,7 @@ static const struct imx678_reg mode_h2v2_binning[] = {
 
 };
 
-static const struct imx678_reg mode_enable_pattern_generator[] = {
+static const struct fr_sensor_reg mode_enable_pattern_generator[] = {
 
 	{BLKLEVEL_LOW,		0x00},
 	{TPG_EN_DUOUT,		0x01},
@@ -532,7 +529,7 @@ static const struct imx678_reg mode_enable_pattern_generator[] = {
 
 };
 
-static const struct imx678_reg mode_disable_pattern_generator[] = {
+static const struct fr_sensor_reg mode_disable_pattern_generator[] = {
 
 	{BLKLEVEL_LOW,		0x32},
 	{TPG_EN_DUOUT,		0x00},
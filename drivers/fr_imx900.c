@@ -7,22 +7,29 @@
 
 //#define DEBUG 1
 
-#include <asm/unaligned.h>
+#include <linux/debugfs.h>
 #include <linux/delay.h>
 #include <linux/gpio/consumer.h>
 #include <linux/i2c.h>
+#include <linux/interrupt.h>
 #include <linux/module.h>
 #include <linux/of_device.h>
 #include <linux/pm_runtime.h>
+#include <linux/workqueue.h>
 #include <media/v4l2-ctrls.h>
 #include <media/v4l2-device.h>
 #include <media/v4l2-event.h>
 #include <media/v4l2-fwnode.h>
 #include <media/v4l2-mediabus.h>
+#include <media/mipi-csi2.h>
 
 #include "fr_imx900_regs.h"
 #include "fr_max96792.h"
 #include "fr_max96793.h"
+#include "fr_sensor_core.h"
+#include "fr_stats.h"
+#include "fr_sync_group.h"
+#include "fr_trace.h"
 
 #define IMX900_K_FACTOR				1000LL
 #define IMX900_M_FACTOR				1000000LL
@@ -36,11 +43,21 @@
 #define	IMX900_LINK_FREQ_1188			(1188000000/2)
 #define IMX900_LINK_FREQ_891			(891000000/2)
 
-#define IMX900_MODE_STANDBY			0x01
-#define IMX900_MODE_STREAMING			0x00
+#define IMX900_STANDBY_SETTLE_US		15000
+#define IMX900_FRAME_SYNC_EVENTS		4
+
+#define IMX900_TRIGGER_GPIO_ID			6
+#define IMX900_TRIGGER_TIMEOUT_US		10000
+#define IMX900_TRIGGER_PULSE_US			20
+#define IMX900_TRIGGER_BURST_MAX		255
+#define IMX900_STROBE_GPIO_ID			7
 
 #define IMX900_MIN_INTEGRATION_LINES		1
 
+#define IMX900_HMAX_MAX				0xFFFF
+#define IMX900_VMAX_MAX				0xFFFFF
+#define IMX900_VMAX_STEP			1
+
 #define IMX900_ANA_GAIN_MIN			0
 #define IMX900_ANA_GAIN_MAX			480
 #define IMX900_ANA_GAIN_STEP			1
@@ -71,14 +88,34 @@ enum pad_types {
 #define IMX900_PIXEL_ARRAY_WIDTH	2064U
 #define IMX900_PIXEL_ARRAY_HEIGHT	1552U
 
+#define IMX900_WINDOW_H_STEP		8U
+#define IMX900_WINDOW_V_STEP		4U
+
 #define V4L2_CID_FRAME_RATE		(V4L2_CID_USER_IMX_BASE + 1)
 #define V4L2_CID_OPERATION_MODE		(V4L2_CID_USER_IMX_BASE + 2)
 #define V4L2_CID_GLOBAL_SHUTTER_MODE	(V4L2_CID_USER_IMX_BASE + 3)
+#define V4L2_CID_TRIGGER_LATENCY	(V4L2_CID_USER_IMX_BASE + 4)
+#define V4L2_CID_SOFTWARE_TRIGGER	(V4L2_CID_USER_IMX_BASE + 5)
+#define V4L2_CID_TRIGGER_BURST		(V4L2_CID_USER_IMX_BASE + 6)
+#define V4L2_CID_TRIGGER_TIMESTAMP	(V4L2_CID_USER_IMX_BASE + 7)
+#define V4L2_CID_STROBE_OUTPUT		(V4L2_CID_USER_IMX_BASE + 8)
 
-struct imx900_reg_list {
+/*
+ * Timing and register set of one mode on one sensor variant. Everything
+ * that depends on the mode and on the color or mono variant of the sensor
+ * is looked up here once the mode is set, so the limits derived from it
+ * always agree with what is written to the sensor.
+ */
+struct imx900_timing {
 
-	unsigned int num_of_regs;
-	const struct imx900_reg *regs;
+	u32 hmax;
+	u32 pixel_rate;
+	u32 min_shs_length;
+	u32 min_frame_length_delta;
+	u8 linkfreq;
+	u8 vint_en;
+	struct fr_sensor_reg_list mode_regs;
+	struct fr_sensor_reg_list dep_regs;
 };
 
 struct imx900_mode {
@@ -89,8 +126,8 @@ struct imx900_mode {
 	unsigned int min_fps;
 	unsigned int type;
 	struct v4l2_rect crop;
-	struct imx900_reg_list reg_list;
-	struct imx900_reg_list reg_list_format;
+	struct fr_sensor_reg_list reg_list;
+	struct fr_sensor_reg_list reg_list_format;
 };
 
 static const s64 imx900_link_freq_menu[] = {
@@ -101,6 +138,104 @@ static const s64 imx900_link_freq_menu[] = {
 	[_IMX900_LINK_FREQ_891] = IMX900_LINK_FREQ_891,
 };
 
+#define IMX900_REGS(table)	{ ARRAY_SIZE(table), table, #table }
+
+#define IMX900_TIMING(_hmax, _rate, _shs, _delta, _freq, _vint, _mode, _dep) \
+	{								\
+		.hmax = _hmax,						\
+		.pixel_rate = _rate,					\
+		.min_shs_length = _shs,					\
+		.min_frame_length_delta = _delta,			\
+		.linkfreq = _IMX900_LINK_FREQ_##_freq,			\
+		.vint_en = _vint,					\
+		.mode_regs = IMX900_REGS(_mode),			\
+		.dep_regs = IMX900_REGS(_dep),				\
+	}
+
+#define IMX900_TIMING_ANY(...)						\
+	{								\
+		[IMX900_COLOR] = IMX900_TIMING(__VA_ARGS__),		\
+		[IMX900_MONO] = IMX900_TIMING(__VA_ARGS__),		\
+	}
+
+static const struct imx900_timing imx900_timings[][2] = {
+	[IMX900_MODE_2064x1552_12BPP] = IMX900_TIMING_ANY(0x262, 251232786,
+		51, 137, 1485, 0x1C, mode_allPixel_roi,
+		allpix_roi_sub10_1485MBPS_1x12_4lane),
+	[IMX900_MODE_2064x1552_10BPP] = IMX900_TIMING_ANY(0x1F3, 307118236,
+		62, 155, 891, 0x1C, mode_allPixel_roi,
+		allpix_roi_sub10_891MBPS_1x10_4lane),
+	[IMX900_MODE_2064x1552_8BPP] = IMX900_TIMING_ANY(0x19C, 371970874,
+		75, 175, 891, 0x1C, mode_allPixel_roi,
+		allpix_roi_sub10_891MBPS_1x8_4lane),
+	[IMX900_MODE_ROI_1920x1080_12BPP] = IMX900_TIMING_ANY(0x262, 233704918,
+		51, 137, 1485, 0x1C, mode_allPixel_roi,
+		allpix_roi_sub10_1485MBPS_1x12_4lane),
+	[IMX900_MODE_ROI_1920x1080_10BPP] = IMX900_TIMING_ANY(0x17A, 377142857,
+		82, 186, 1188, 0x1C, mode_allPixel_roi,
+		allpix_roi_sub10_1188MBPS_1x10_4lane),
+	[IMX900_MODE_ROI_1920x1080_8BPP] = IMX900_TIMING_ANY(0x19C, 346019417,
+		75, 175, 891, 0x1C, mode_allPixel_roi,
+		allpix_roi_sub10_891MBPS_1x8_4lane),
+	[IMX900_MODE_SUB2_1032x776_12BPP] = {
+		[IMX900_COLOR] = IMX900_TIMING(0x262, 125616393,
+			51, 115, 1485, 0x14, mode_subg2_color,
+			sub2_color_1485MBPS_1x12_4lane),
+		[IMX900_MONO] = IMX900_TIMING(0x131, 251232787,
+			102, 200, 1485, 0x18, mode_sub2_binning_mono,
+			sub2_binning_mono_1485MBPS_1x12_4lane),
+	},
+	[IMX900_MODE_SUB2_1032x776_10BPP] = {
+		[IMX900_COLOR] = IMX900_TIMING(0x16C, 210510989,
+			85, 169, 1485, 0x14, mode_subg2_color,
+			sub2_color_1485MBPS_1x10_4lane),
+		[IMX900_MONO] = IMX900_TIMING(0xD8, 354750000,
+			142, 264, 1188, 0x18, mode_sub2_binning_mono,
+			sub2_binning_mono_1188MBPS_1x10_4lane),
+	},
+	[IMX900_MODE_SUB2_1032x776_8BPP] = {
+		[IMX900_COLOR] = IMX900_TIMING(0x152, 226704142,
+			92, 181, 1485, 0x14, mode_subg2_color,
+			sub2_color_1485MBPS_1x8_4lane),
+		[IMX900_MONO] = IMX900_TIMING(0xF0, 319275000,
+			128, 242, 891, 0x18, mode_sub2_binning_mono,
+			sub2_binning_mono_891MBPS_1x8_4lane),
+	},
+	[IMX900_MODE_SUB10_2064x154_12BPP] = IMX900_TIMING_ANY(0x262, 251232786,
+		51, 115, 1485, 0x14, mode_sub10,
+		allpix_roi_sub10_1485MBPS_1x12_4lane),
+	[IMX900_MODE_SUB10_2064x154_10BPP] = IMX900_TIMING_ANY(0x1F3, 307118236,
+		62, 133, 891, 0x14, mode_sub10,
+		allpix_roi_sub10_891MBPS_1x10_4lane),
+	[IMX900_MODE_SUB10_2064x154_8BPP] = IMX900_TIMING_ANY(0x19C, 371970874,
+		75, 153, 891, 0x14, mode_sub10,
+		allpix_roi_sub10_891MBPS_1x8_4lane),
+	[IMX900_MODE_BIN_CROP_1024x720_12BPP] = {
+		[IMX900_COLOR] = IMX900_TIMING(0x262, 249285246,
+			51, 115, 1485, 0x18, mode_subg2_color,
+			sub2_color_1485MBPS_1x12_4lane),
+		[IMX900_MONO] = IMX900_TIMING(0x131, 249285246,
+			102, 200, 1485, 0x18, mode_sub2_binning_mono,
+			sub2_binning_mono_1485MBPS_1x12_4lane),
+	},
+	[IMX900_MODE_BIN_CROP_1024x720_10BPP] = {
+		[IMX900_COLOR] = IMX900_TIMING(0x16C, 352000000,
+			85, 169, 1188, 0x18, mode_subg2_color,
+			sub2_color_1485MBPS_1x10_4lane),
+		[IMX900_MONO] = IMX900_TIMING(0xD8, 352000000,
+			142, 264, 1188, 0x18, mode_sub2_binning_mono,
+			sub2_binning_mono_1188MBPS_1x10_4lane),
+	},
+	[IMX900_MODE_BIN_CROP_1024x720_8BPP] = {
+		[IMX900_COLOR] = IMX900_TIMING(0x152, 316800000,
+			92, 181, 891, 0x18, mode_subg2_color,
+			sub2_color_1485MBPS_1x8_4lane),
+		[IMX900_MONO] = IMX900_TIMING(0xF0, 316800000,
+			128, 242, 891, 0x18, mode_sub2_binning_mono,
+			sub2_binning_mono_891MBPS_1x8_4lane),
+	},
+};
+
 static const struct imx900_mode modes_12bit[] = {
 	{
 		/* All pixel mode */
@@ -449,49 +584,55 @@ static const u32 codes_mono[] = {
 };
 
 struct imx900 {
-	struct v4l2_subdev sd;
-	struct media_pad pad[NUM_PADS];
+	struct fr_sensor core;
 
-	unsigned int fmt_code;
+	struct media_pad pad[NUM_PADS];
 
-	struct gpio_desc *reset_gpio;
 	struct gpio_desc *xmaster;
 
+	struct gpio_desc *trigger_gpio;
+	bool gmsl_trigger;
+	u32 trigger_dser_gpio;
+	u32 trigger_gpio_id;
+	ktime_t trigger_timestamp;
+	struct v4l2_ctrl *trigger_burst;
+	struct delayed_work trigger_work;
+	unsigned long trigger_period;
+	unsigned int trigger_pending;
+
+	bool gmsl_strobe;
+	u32 strobe_ser_gpio;
+	u32 strobe_dser_gpio;
+	u32 strobe_gpio_id;
+
 	struct v4l2_ctrl_handler ctrl_handler;
 	struct v4l2_ctrl *pixel_rate;
 	struct v4l2_ctrl *link_freq;
 	struct v4l2_ctrl *exposure;
-	struct v4l2_ctrl *framerate;
 	struct v4l2_ctrl *operation_mode;
 	struct v4l2_ctrl *shutter_mode;
 	struct v4l2_ctrl *vflip;
 	struct v4l2_ctrl *hflip;
-	struct v4l2_ctrl *vblank;
-	struct v4l2_ctrl *hblank;
 	struct v4l2_ctrl *blklvl;
+	struct v4l2_ctrl *exposure_priority;
 
 	u8 chromacity;
-	u8 linkfreq;
-	u64 line_time;
-	u32 frame_length;
-	u32 min_frame_length_delta;
-	u32 min_shs_length;
-	u32 hmax;
-	u32 pixel_rate_calc;
+	const struct imx900_timing *timing;
 
-	const char *gmsl;
-	struct device *ser_dev;
-	struct device *dser_dev;
-	struct gmsl_link_ctx g_ctx;
+	struct dentry *debugfs;
 
 	const struct imx900_mode *mode;
-	struct mutex mutex;
-	bool streaming;
+	struct v4l2_rect crop;
 };
 
 static inline struct imx900 *to_imx900(struct v4l2_subdev *_sd)
 {
-	return container_of(_sd, struct imx900, sd);
+	return container_of(_sd, struct imx900, core.sd);
+}
+
+static inline struct imx900 *core_to_imx900(struct fr_sensor *core)
+{
+	return container_of(core, struct imx900, core);
 }
 
 static inline void get_mode_table(struct imx900 *imx900,
@@ -543,6 +684,15 @@ static inline void get_mode_table(struct imx900 *imx900,
 
 }
 
+static const char * const imx900_strobe_menu[] = {
+
+	[STROBE_DISABLED] = "Disabled",
+	[STROBE_GPO0] = "Exposure on GPO0",
+	[STROBE_GPO1] = "Exposure on GPO1",
+	[STROBE_GPO2] = "Exposure on GPO2",
+
+};
+
 static const char * const imx900_test_pattern_menu[] = {
 
 	[0] = "Disabled",
@@ -569,113 +719,11 @@ static const char * const imx900_global_shutter_menu[] = {
 
 };
 
-static int imx900_read_reg(struct imx900 *imx900, u16 reg, u32 len, u32 *val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
-	struct i2c_msg msgs[2];
-	u8 addr_buf[2] = { reg >> 8, reg & 0xff };
-	u8 data_buf[4] = { 0, };
-	int ret;
-
-	if (len > 4)
-		return -EINVAL;
-
-	msgs[0].addr = client->addr;
-	msgs[0].flags = 0;
-	msgs[0].len = ARRAY_SIZE(addr_buf);
-	msgs[0].buf = addr_buf;
-
-	msgs[1].addr = client->addr;
-	msgs[1].flags = I2C_M_RD;
-	msgs[1].len = len;
-	msgs[1].buf = &data_buf[4 - len];
-
-	ret = i2c_transfer(client->adapter, msgs, ARRAY_SIZE(msgs));
-	if (ret != ARRAY_SIZE(msgs))
-		return -EIO;
-
-	*val = get_unaligned_be32(data_buf);
-
-	return 0;
-}
-
-static int imx900_write_reg(struct imx900 *imx900, u16 reg, u32 len, u32 val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
-	u8 buf[6];
-
-	if (len > 4)
-		return -EINVAL;
-
-	put_unaligned_be16(reg, buf);
-	put_unaligned_le32(val, buf + 2);
-
-	if (i2c_master_send(client, buf, len + 2) != len + 2)
-		return -EIO;
-
-	return 0;
-}
-
-static int imx900_write_hold_reg(struct imx900 *imx900, u16 reg, u32 len, u32 val)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
-	struct device *dev = &client->dev;
-	int ret;
-
-	ret = imx900_write_reg(imx900, REGHOLD, 1, 0x01);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n", __func__);
-		return ret;
-	}
-
-	ret = imx900_write_reg(imx900, reg, len, val);
-	if (ret)
-		goto reghold_off;
-
-	ret = imx900_write_reg(imx900, REGHOLD, 1, 0x00);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n", __func__);
-		return ret;
-	}
-
-	return 0;
-
-reghold_off:
-	ret = imx900_write_reg(imx900, REGHOLD, 1, 0x00);
-	if (ret) {
-		dev_err(dev, "%s failed to write reghold register\n", __func__);
-		return ret;
-	}
-	return ret;
-
-}
-
-static int imx900_write_table(struct imx900 *imx900,
-				 const struct imx900_reg *regs, u32 len)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
-	unsigned int i;
-	int ret;
-
-	for (i = 0; i < len; i++) {
-		ret = imx900_write_reg(imx900, regs[i].address, 1, regs[i].val);
-		if (ret) {
-			dev_err_ratelimited(&client->dev,
-					"Failed to write reg 0x%4.4x. error = %d\n",
-					regs[i].address, ret);
-
-			return ret;
-		}
-	}
-
-	return 0;
-}
-
 static u32 imx900_get_format_code(struct imx900 *imx900, u32 code)
 {
 	unsigned int i;
 
-	lockdep_assert_held(&imx900->mutex);
+	lockdep_assert_held(&imx900->core.mutex);
 
 	if (imx900->chromacity == IMX900_COLOR) {
 		for (i = 0; i < ARRAY_SIZE(codes); i++)
@@ -708,7 +756,7 @@ static int imx900_open(struct v4l2_subdev *sd, struct v4l2_subdev_fh *fh)
 		v4l2_subdev_get_try_format(sd, fh->state, METADATA_PAD);
 	struct v4l2_rect *try_crop;
 
-	mutex_lock(&imx900->mutex);
+	mutex_lock(&imx900->core.mutex);
 
 	try_fmt_img->width = modes_12bit[0].width;
 	try_fmt_img->height = modes_12bit[0].height;
@@ -732,34 +780,35 @@ static int imx900_open(struct v4l2_subdev *sd, struct v4l2_subdev_fh *fh)
 	try_crop->width = IMX900_PIXEL_ARRAY_WIDTH;
 	try_crop->height = IMX900_PIXEL_ARRAY_HEIGHT;
 
-	mutex_unlock(&imx900->mutex);
+	mutex_unlock(&imx900->core.mutex);
 
 	return 0;
 }
 
 static int imx900_chromacity_mode(struct imx900 *imx900)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 	u32 chromacity;
 
-	ret = imx900_write_reg(imx900, STANDBY, 1, 0x00);
+	ret = fr_sensor_write_reg(&imx900->core, STANDBY, 1, 0x00);
 	if (ret) {
 		dev_err(dev, "%s: error canceling standby mode\n", __func__);
 		return ret;
 	}
 
-	usleep_range(15000, 20000);
+	usleep_range(IMX900_STANDBY_SETTLE_US,
+			IMX900_STANDBY_SETTLE_US + 1000);
 
-	ret = imx900_read_reg(imx900, CHROMACITY, 1, &chromacity);
+	ret = fr_sensor_read_reg(&imx900->core, CHROMACITY, 1, &chromacity);
 	if (ret) {
 		dev_err(dev, "%s: error reading chromacity information register\n",
 									__func__);
 		return ret;
 	}
 
-	ret = imx900_write_reg(imx900, STANDBY, 1, 0x01);
+	ret = fr_sensor_write_reg(&imx900->core, STANDBY, 1, 0x01);
 	if (ret) {
 		dev_err(dev, "%s: error setting standby mode\n", __func__);
 		return ret;
@@ -774,311 +823,269 @@ static int imx900_chromacity_mode(struct imx900 *imx900)
 	return ret;
 }
 
-static int imx900_set_exposure(struct imx900 *imx900, u64 val)
+static bool imx900_is_window_mode(const struct imx900_mode *mode)
+{
+	switch (mode->type) {
+	case IMX900_MODE_ROI_1920x1080_12BPP:
+	case IMX900_MODE_ROI_1920x1080_10BPP:
+	case IMX900_MODE_ROI_1920x1080_8BPP:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static bool imx900_exposure_priority(struct imx900 *imx900)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	return imx900->exposure_priority && imx900->exposure_priority->val;
+}
+
+/*
+ * VMAX and SHS are written in one register hold group, so the sensor
+ * switches both on the same frame.
+ */
+static int imx900_write_vmax_shs(struct imx900 *imx900, u32 vmax, u32 shs)
+{
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
-	const struct imx900_mode *mode = imx900->mode;
-	u64 exposure;
 	int ret;
 
-	exposure = imx900->vblank->val + mode->height - val;
-
-	ret = imx900_write_hold_reg(imx900, SHS_LOW, 3, exposure);
+	ret = fr_sensor_write_reg(&imx900->core, REGHOLD, 1, 0x01);
 	if (ret) {
-		dev_err(dev, "%s failed to set exposure\n", __func__);
+		dev_err(dev, "%s failed to write reghold register\n", __func__);
 		return ret;
 	}
 
+	ret = fr_sensor_write_reg(&imx900->core, VMAX_LOW, 3, vmax);
+	if (ret)
+		goto reghold_off;
+
+	ret = fr_sensor_write_reg(&imx900->core, SHS_LOW, 3, shs);
+	if (ret)
+		goto reghold_off;
+
+	imx900->core.vmax = vmax;
+
+reghold_off:
+	if (fr_sensor_write_reg(&imx900->core, REGHOLD, 1, 0x00)) {
+		dev_err(dev, "%s failed to write reghold register\n", __func__);
+		ret = -EIO;
+	}
+
 	return ret;
 }
 
-static void imx900_adjust_min_shs_length(struct imx900 *imx900)
+/*
+ * In exposure priority mode the frame is stretched beyond the length set
+ * by the frame rate whenever the exposure does not fit into it, and goes
+ * back to it once the exposure is short enough again.
+ *
+ * VBLANK keeps reporting the frame length selected by the frame rate, as
+ * it bounds the exposure range and the default exposure, and changing it
+ * from here would clamp the exposure being set. The length the sensor
+ * actually runs with is imx900->core.vmax, shown as "vmax" in debugfs.
+ */
+static int imx900_set_exposure_priority(struct imx900 *imx900, u32 exposure)
+{
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
+	struct device *dev = &client->dev;
+	u32 vmax;
+	int ret;
+
+	vmax = max(imx900->core.frame_length,
+		   exposure + imx900->timing->min_shs_length);
+	vmax = min_t(u32, vmax, IMX900_VMAX_MAX);
+
+	ret = imx900_write_vmax_shs(imx900, vmax, vmax - exposure);
+	if (ret)
+		return ret;
+
+	dev_dbg(dev, "%s: exposure %u lines, vmax %u\n", __func__,
+							exposure, vmax);
+
+	return 0;
+}
+
+static int imx900_set_exposure(struct imx900 *imx900, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
 	const struct imx900_mode *mode = imx900->mode;
+	u64 exposure;
+	int ret;
 
-	switch (mode->type) {
-	case IMX900_MODE_2064x1552_12BPP:
-	case IMX900_MODE_ROI_1920x1080_12BPP:
-	case IMX900_MODE_SUB10_2064x154_12BPP:
-		imx900->min_shs_length = 51;
-		break;
-	case IMX900_MODE_SUB2_1032x776_12BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_12BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->min_shs_length = 51;
-		else
-			imx900->min_shs_length = 102;
-		break;
-	case IMX900_MODE_2064x1552_10BPP:
-	case IMX900_MODE_SUB10_2064x154_10BPP:
-		imx900->min_shs_length = 62;
-		break;
-	case IMX900_MODE_ROI_1920x1080_10BPP:
-		imx900->min_shs_length = 82;
-		break;
-	case IMX900_MODE_SUB2_1032x776_10BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_10BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->min_shs_length = 85;
-		else
-			imx900->min_shs_length = 142;
-		break;
-	case IMX900_MODE_2064x1552_8BPP:
-	case IMX900_MODE_ROI_1920x1080_8BPP:
-	case IMX900_MODE_SUB10_2064x154_8BPP:
-		imx900->min_shs_length = 75;
-		break;
-	case IMX900_MODE_SUB2_1032x776_8BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_8BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->min_shs_length = 92;
-		else
-			imx900->min_shs_length = 128;
-		break;
+	if (imx900_exposure_priority(imx900))
+		return imx900_set_exposure_priority(imx900, val);
+
+	exposure = imx900->core.vblank->val + mode->height - val;
+
+	/* Exposure priority was turned off with the frame still stretched */
+	if (imx900->core.vmax != imx900->core.frame_length)
+		ret = imx900_write_vmax_shs(imx900, imx900->core.frame_length,
+					    exposure);
+	else
+		ret = fr_sensor_write_hold_reg(&imx900->core, SHS_LOW, 3,
+					       exposure);
+	if (ret) {
+		dev_err(dev, "%s failed to set exposure\n", __func__);
+		return ret;
 	}
 
-	dev_dbg(dev, "%s: adjusted min_shs_length: %d\n", __func__,
-							imx900->min_shs_length);
+	return ret;
 }
 
 static void imx900_adjust_exposure_range(struct imx900 *imx900)
 {
 	const struct imx900_mode *mode = imx900->mode;
 	u64 exposure_max;
+	u64 exposure_def;
+	u64 frame_length_max;
+
+	exposure_def = imx900->core.vblank->val + mode->height -
+					imx900->timing->min_shs_length;
+	exposure_max = exposure_def;
 
-	imx900_adjust_min_shs_length(imx900);
-	exposure_max = imx900->vblank->val + mode->height - imx900->min_shs_length;
+	/* The frame may grow up to the length of the slowest frame rate */
+	if (imx900_exposure_priority(imx900)) {
+		frame_length_max = (IMX900_M_FACTOR * IMX900_G_FACTOR) /
+					(mode->min_fps * imx900->core.line_time);
+		frame_length_max = min_t(u64, frame_length_max,
+							IMX900_VMAX_MAX);
+		exposure_max = max(exposure_def,
+				frame_length_max - imx900->timing->min_shs_length);
+	}
 
 	__v4l2_ctrl_modify_range(imx900->exposure, IMX900_MIN_INTEGRATION_LINES,
 				exposure_max, 1,
-				exposure_max);
+				exposure_def);
 }
 
 static int imx900_set_frame_rate(struct imx900 *imx900, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
-	ret = imx900_write_hold_reg(imx900, VMAX_LOW, 3, imx900->frame_length);
+	if (imx900_exposure_priority(imx900))
+		return imx900_set_exposure_priority(imx900,
+						imx900->exposure->val);
+
+	ret = fr_sensor_write_hold_reg(&imx900->core, VMAX_LOW, 3,
+				imx900->core.frame_length);
 
 	if (ret) {
 		dev_err(dev, "%s failed to set frame rate\n", __func__);
 		return ret;
 	}
 
+	imx900->core.vmax = imx900->core.frame_length;
+
 	return ret;
 
 }
 
-static void imx900_update_frame_rate(struct imx900 *imx900, u64 val)
+static int imx900_set_hmax_register(struct imx900 *imx900)
 {
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
+	struct device *dev = &client->dev;
+	int ret;
 
-	const struct imx900_mode *mode = imx900->mode;
-	u32 update_vblank;
-
-	imx900->frame_length = (IMX900_M_FACTOR * IMX900_G_FACTOR) /
-						(val * imx900->line_time);
-
-	update_vblank = imx900->frame_length - mode->height;
+	ret = fr_sensor_write_hold_reg(&imx900->core, HMAX_LOW, 2,
+				imx900->core.hmax);
+	if (ret)
+		dev_err(dev, "%s failed to write HMAX register\n", __func__);
 
-	__v4l2_ctrl_modify_range(imx900->vblank, update_vblank,
-				 update_vblank, 1, update_vblank);
+	dev_dbg(dev, "%s: hmax: 0x%x\n", __func__, imx900->core.hmax);
 
-	__v4l2_ctrl_s_ctrl(imx900->vblank, update_vblank);
+	return ret;
 
 }
 
-static void imx900_adjust_hmax_register(struct imx900 *imx900)
+static u32 imx900_min_frame_length(struct imx900 *imx900)
 {
-	const struct imx900_mode *mode = imx900->mode;
-
-	switch (mode->type) {
-	case IMX900_MODE_2064x1552_12BPP:
-	case IMX900_MODE_ROI_1920x1080_12BPP:
-	case IMX900_MODE_SUB10_2064x154_12BPP:
-		imx900->hmax = 0x262;
-		break;
-	case IMX900_MODE_SUB2_1032x776_12BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_12BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->hmax = 0x262;
-		else
-			imx900->hmax = 0x131;
-		break;
-	case IMX900_MODE_2064x1552_10BPP:
-	case IMX900_MODE_SUB10_2064x154_10BPP:
-		imx900->hmax = 0x1F3;
-		break;
-	case IMX900_MODE_ROI_1920x1080_10BPP:
-		imx900->hmax = 0x17A;
-		break;
-	case IMX900_MODE_SUB2_1032x776_10BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_10BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->hmax = 0x16C;
-		else
-			imx900->hmax = 0xD8;
-		break;
-	case IMX900_MODE_2064x1552_8BPP:
-	case IMX900_MODE_ROI_1920x1080_8BPP:
-	case IMX900_MODE_SUB10_2064x154_8BPP:
-		imx900->hmax = 0x19C;
-		break;
-	case IMX900_MODE_SUB2_1032x776_8BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_8BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->hmax = 0x152;
-		else
-			imx900->hmax = 0xF0;
-		break;
-	}
+	return imx900->mode->height + imx900->timing->min_frame_length_delta;
 }
 
-static void imx900_adjust_pixel_rate(struct imx900 *imx900)
+static void imx900_select_timing(struct imx900 *imx900)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
-	const struct imx900_mode *mode = imx900->mode;
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
+	const struct imx900_timing *timing;
 
-	switch (mode->type) {
-	case IMX900_MODE_2064x1552_12BPP:
-	case IMX900_MODE_SUB10_2064x154_12BPP:
-		imx900->pixel_rate_calc = 251232786;
-		break;
-	case IMX900_MODE_ROI_1920x1080_12BPP:
-		imx900->pixel_rate_calc = 233704918;
-		break;
-	case IMX900_MODE_SUB2_1032x776_12BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->pixel_rate_calc = 125616393;
-		else
-			imx900->pixel_rate_calc = 251232787;
-		break;
-	case IMX900_MODE_BIN_CROP_1024x720_12BPP:
-		imx900->pixel_rate_calc = 249285246;
-		break;
-	case IMX900_MODE_2064x1552_10BPP:
-	case IMX900_MODE_SUB10_2064x154_10BPP:
-		imx900->pixel_rate_calc = 307118236;
-		break;
-	case IMX900_MODE_ROI_1920x1080_10BPP:
-		imx900->pixel_rate_calc = 377142857;
-		break;
-	case IMX900_MODE_SUB2_1032x776_10BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->pixel_rate_calc = 210510989;
-		else
-			imx900->pixel_rate_calc = 354750000;
-		break;
-	case IMX900_MODE_BIN_CROP_1024x720_10BPP:
-		imx900->pixel_rate_calc = 352000000;
-		break;
-	case IMX900_MODE_2064x1552_8BPP:
-	case IMX900_MODE_SUB10_2064x154_8BPP:
-		imx900->pixel_rate_calc = 371970874;
-		break;
-	case IMX900_MODE_ROI_1920x1080_8BPP:
-		imx900->pixel_rate_calc = 346019417;
-		break;
-	case IMX900_MODE_SUB2_1032x776_8BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->pixel_rate_calc = 226704142;
-		else
-			imx900->pixel_rate_calc = 319275000;
-		break;
-	case IMX900_MODE_BIN_CROP_1024x720_8BPP:
-		imx900->pixel_rate_calc = 316800000;
-		break;
-	}
+	timing = &imx900_timings[imx900->mode->type][imx900->chromacity];
+	imx900->timing = timing;
+	fr_sensor_set_hmax(&imx900->core, timing->hmax);
 
-	__v4l2_ctrl_modify_range(imx900->pixel_rate,
-				 imx900->pixel_rate_calc,
-				 imx900->pixel_rate_calc,
-				 1, imx900->pixel_rate_calc);
+	__v4l2_ctrl_modify_range(imx900->pixel_rate, timing->pixel_rate,
+				 timing->pixel_rate, 1, timing->pixel_rate);
+	dev_dbg(dev, "%s: pixel rate: %d\n", __func__, timing->pixel_rate);
 
-	dev_dbg(dev, "%s: pixel rate: %d\n", __func__, imx900->pixel_rate_calc);
+	__v4l2_ctrl_modify_range(imx900->core.vblank,
+				 timing->min_frame_length_delta,
+				 timing->min_frame_length_delta,
+				 1, timing->min_frame_length_delta);
+	dev_dbg(dev, "%s: vblank: %d\n", __func__,
+					timing->min_frame_length_delta);
+
+	if (fr_sensor_is_gmsl(&imx900->core))
+		__v4l2_ctrl_s_ctrl(imx900->link_freq, _GMSL_LINK_FREQ_1500);
+	else
+		__v4l2_ctrl_s_ctrl(imx900->link_freq, timing->linkfreq);
 
+	dev_dbg(dev, "%s: linkfreq: %lld\n", __func__,
+				imx900_link_freq_menu[timing->linkfreq]);
 }
 
-static int imx900_set_hmax_register(struct imx900 *imx900)
+static int imx900_set_window_position(struct imx900 *imx900)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
-	ret = imx900_write_hold_reg(imx900, HMAX_LOW, 2, imx900->hmax);
-	if (ret)
-		dev_err(dev, "%s failed to write HMAX register\n", __func__);
-
-	dev_dbg(dev, "%s: hmax: 0x%x\n", __func__, imx900->hmax);
-
-	return ret;
-
-}
+	ret = fr_sensor_write_reg(&imx900->core, REGHOLD, 1, 0x01);
+	if (ret) {
+		dev_err(dev, "%s failed to write reghold register\n",
+								__func__);
+		return ret;
+	}
 
-static void imx900_adjust_link_frequency(struct imx900 *imx900)
-{
+	ret = fr_sensor_write_reg(&imx900->core, FID0_ROIPH1_LOW, 2,
+				imx900->crop.left);
+	if (ret)
+		goto reghold_off;
 
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
-	struct device *dev = &client->dev;
+	ret = fr_sensor_write_reg(&imx900->core, FID0_ROIPV1_LOW, 2,
+				imx900->crop.top);
+	if (ret)
+		goto reghold_off;
 
-	switch (imx900->mode->type) {
-	case IMX900_MODE_2064x1552_12BPP:
-	case IMX900_MODE_ROI_1920x1080_12BPP:
-	case IMX900_MODE_SUB2_1032x776_12BPP:
-	case IMX900_MODE_SUB10_2064x154_12BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_12BPP:
-		imx900->linkfreq = _IMX900_LINK_FREQ_1485;
-		break;
-	case IMX900_MODE_ROI_1920x1080_10BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_10BPP:
-		imx900->linkfreq = _IMX900_LINK_FREQ_1188;
-		break;
-	case IMX900_MODE_SUB2_1032x776_10BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->linkfreq = _IMX900_LINK_FREQ_1485;
-		else
-			imx900->linkfreq = _IMX900_LINK_FREQ_1188;
-		break;
-	case IMX900_MODE_2064x1552_10BPP:
-	case IMX900_MODE_SUB10_2064x154_10BPP:
-	case IMX900_MODE_2064x1552_8BPP:
-	case IMX900_MODE_ROI_1920x1080_8BPP:
-	case IMX900_MODE_SUB10_2064x154_8BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_8BPP:
-		imx900->linkfreq = _IMX900_LINK_FREQ_891;
-		break;
-	case IMX900_MODE_SUB2_1032x776_8BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->linkfreq = _IMX900_LINK_FREQ_1485;
-		else
-			imx900->linkfreq = _IMX900_LINK_FREQ_891;
-		break;
+	ret = fr_sensor_write_reg(&imx900->core, REGHOLD, 1, 0x00);
+	if (ret) {
+		dev_err(dev, "%s failed to write reghold register\n",
+								__func__);
+		return ret;
 	}
 
-	if (!(strcmp(imx900->gmsl, "gmsl")))
-		__v4l2_ctrl_s_ctrl(imx900->link_freq, _GMSL_LINK_FREQ_1500);
-	else
-		__v4l2_ctrl_s_ctrl(imx900->link_freq, imx900->linkfreq);
+	dev_dbg(dev, "%s: window start: (%d, %d)\n", __func__,
+				imx900->crop.left, imx900->crop.top);
 
-	dev_dbg(dev, "%s: linkfreq: %lld\n", __func__,
-					imx900_link_freq_menu[imx900->linkfreq]);
+	return 0;
 
+reghold_off:
+	dev_err(dev, "%s failed to write window start\n", __func__);
+	fr_sensor_write_reg(&imx900->core, REGHOLD, 1, 0x00);
+	return ret;
 }
 
 static int imx900_set_data_rate(struct imx900 *imx900)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
-	switch (imx900->linkfreq) {
+	switch (imx900->timing->linkfreq) {
 	case _IMX900_LINK_FREQ_1485:
-		ret = imx900_write_table(imx900, imx900_1485_mbps,
+		ret = fr_sensor_write_table(&imx900->core, imx900_1485_mbps,
 				ARRAY_SIZE(imx900_1485_mbps));
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
@@ -1087,7 +1094,7 @@ static int imx900_set_data_rate(struct imx900 *imx900)
 		}
 		break;
 	case _IMX900_LINK_FREQ_1188:
-		ret = imx900_write_table(imx900, imx900_1188_mbps,
+		ret = fr_sensor_write_table(&imx900->core, imx900_1188_mbps,
 				ARRAY_SIZE(imx900_1188_mbps));
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
@@ -1096,7 +1103,7 @@ static int imx900_set_data_rate(struct imx900 *imx900)
 		}
 		break;
 	case _IMX900_LINK_FREQ_891:
-		ret = imx900_write_table(imx900, imx900_891_mbps,
+		ret = fr_sensor_write_table(&imx900->core, imx900_891_mbps,
 				ARRAY_SIZE(imx900_891_mbps));
 		if (ret) {
 			dev_err(dev, "%s failed to write datarate reg.\n",
@@ -1112,109 +1119,15 @@ static int imx900_set_data_rate(struct imx900 *imx900)
 	return ret;
 }
 
-static void imx900_adjust_min_frame_length_delta(struct imx900 *imx900)
+static int imx900_set_mode_additional(struct imx900 *imx900)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
-	const struct imx900_mode *mode = imx900->mode;
-
-	switch (mode->type) {
-	case IMX900_MODE_2064x1552_12BPP:
-	case IMX900_MODE_ROI_1920x1080_12BPP:
-		imx900->min_frame_length_delta = 137;
-		break;
-	case IMX900_MODE_SUB2_1032x776_12BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_12BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->min_frame_length_delta = 115;
-		else
-			imx900->min_frame_length_delta = 200;
-		break;
-	case IMX900_MODE_SUB10_2064x154_12BPP:
-		imx900->min_frame_length_delta = 115;
-		break;
-	case IMX900_MODE_2064x1552_10BPP:
-		imx900->min_frame_length_delta = 155;
-		break;
-	case IMX900_MODE_ROI_1920x1080_10BPP:
-		imx900->min_frame_length_delta = 186;
-		break;
-	case IMX900_MODE_SUB2_1032x776_10BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_10BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->min_frame_length_delta = 169;
-		else
-			imx900->min_frame_length_delta = 264;
-		break;
-	case IMX900_MODE_SUB10_2064x154_10BPP:
-		imx900->min_frame_length_delta = 133;
-		break;
-	case IMX900_MODE_2064x1552_8BPP:
-	case IMX900_MODE_ROI_1920x1080_8BPP:
-		imx900->min_frame_length_delta = 175;
-		break;
-	case IMX900_MODE_SUB2_1032x776_8BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_8BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			imx900->min_frame_length_delta = 181;
-		else
-			imx900->min_frame_length_delta = 242;
-		break;
-	case IMX900_MODE_SUB10_2064x154_8BPP:
-		imx900->min_frame_length_delta = 153;
-		break;
-	}
-
-	dev_dbg(dev, "%s: adjusted min_frame_length_delta: %d\n", __func__,
-						imx900->min_frame_length_delta);
-
-	__v4l2_ctrl_modify_range(imx900->vblank,
-				 imx900->min_frame_length_delta,
-				 imx900->min_frame_length_delta,
-				 1, imx900->min_frame_length_delta);
-
-	dev_dbg(dev, "%s: vblank: %d\n", __func__, imx900->min_frame_length_delta);
-
-}
-
-static int imx900_set_mode_additional(struct imx900 *imx900)
-{
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
-	struct device *dev = &client->dev;
-	const struct imx900_mode *mode = imx900->mode;
-	int ret;
-
-	switch (mode->type) {
-	case IMX900_MODE_2064x1552_12BPP:
-	case IMX900_MODE_2064x1552_10BPP:
-	case IMX900_MODE_2064x1552_8BPP:
-	case IMX900_MODE_ROI_1920x1080_12BPP:
-	case IMX900_MODE_ROI_1920x1080_10BPP:
-	case IMX900_MODE_ROI_1920x1080_8BPP:
-		ret = imx900_write_table(imx900, mode_allPixel_roi,
-			ARRAY_SIZE(mode_allPixel_roi));
-		break;
-	case IMX900_MODE_SUB2_1032x776_12BPP:
-	case IMX900_MODE_SUB2_1032x776_10BPP:
-	case IMX900_MODE_SUB2_1032x776_8BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_12BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_10BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_8BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			ret = imx900_write_table(imx900, mode_subg2_color,
-				ARRAY_SIZE(mode_subg2_color));
-		else
-			ret = imx900_write_table(imx900, mode_sub2_binning_mono,
-				ARRAY_SIZE(mode_sub2_binning_mono));
-		break;
-	case IMX900_MODE_SUB10_2064x154_12BPP:
-	case IMX900_MODE_SUB10_2064x154_10BPP:
-	case IMX900_MODE_SUB10_2064x154_8BPP:
-		ret = imx900_write_table(imx900, mode_sub10,
-			ARRAY_SIZE(mode_sub10));
-		break;
-	}
+	const struct fr_sensor_reg_list *reg_list = &imx900->timing->mode_regs;
+	int ret;
 
+	ret = __fr_sensor_write_table(&imx900->core, reg_list->regs,
+				   reg_list->num_of_regs, reg_list->name);
 	if (ret) {
 		dev_err(dev, "%s error setting mode additional table\n",
 								__func__);
@@ -1226,62 +1139,13 @@ static int imx900_set_mode_additional(struct imx900 *imx900)
 
 static int imx900_set_dep_registers(struct imx900 *imx900)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
-	const struct imx900_mode *mode = imx900->mode;
+	const struct fr_sensor_reg_list *reg_list = &imx900->timing->dep_regs;
 	int ret;
 
-	switch (mode->type) {
-	case IMX900_MODE_2064x1552_12BPP:
-	case IMX900_MODE_ROI_1920x1080_12BPP:
-	case IMX900_MODE_SUB10_2064x154_12BPP:
-		ret = imx900_write_table(imx900, allpix_roi_sub10_1485MBPS_1x12_4lane,
-			ARRAY_SIZE(allpix_roi_sub10_1485MBPS_1x12_4lane));
-		break;
-	case IMX900_MODE_SUB2_1032x776_12BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_12BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			ret = imx900_write_table(imx900, sub2_color_1485MBPS_1x12_4lane,
-				ARRAY_SIZE(sub2_color_1485MBPS_1x12_4lane));
-		else
-			ret = imx900_write_table(imx900, sub2_binning_mono_1485MBPS_1x12_4lane,
-				ARRAY_SIZE(sub2_binning_mono_1485MBPS_1x12_4lane));
-		break;
-	case IMX900_MODE_2064x1552_10BPP:
-	case IMX900_MODE_SUB10_2064x154_10BPP:
-		ret = imx900_write_table(imx900, allpix_roi_sub10_891MBPS_1x10_4lane,
-			ARRAY_SIZE(allpix_roi_sub10_891MBPS_1x10_4lane));
-		break;
-	case IMX900_MODE_ROI_1920x1080_10BPP:
-		ret = imx900_write_table(imx900, allpix_roi_sub10_1188MBPS_1x10_4lane,
-			ARRAY_SIZE(allpix_roi_sub10_1188MBPS_1x10_4lane));
-		break;
-	case IMX900_MODE_SUB2_1032x776_10BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_10BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			ret = imx900_write_table(imx900, sub2_color_1485MBPS_1x10_4lane,
-				ARRAY_SIZE(sub2_color_1485MBPS_1x10_4lane));
-		else
-			ret = imx900_write_table(imx900, sub2_binning_mono_1188MBPS_1x10_4lane,
-				ARRAY_SIZE(sub2_binning_mono_1188MBPS_1x10_4lane));
-		break;
-	case IMX900_MODE_2064x1552_8BPP:
-	case IMX900_MODE_ROI_1920x1080_8BPP:
-	case IMX900_MODE_SUB10_2064x154_8BPP:
-		ret = imx900_write_table(imx900, allpix_roi_sub10_891MBPS_1x8_4lane,
-			ARRAY_SIZE(allpix_roi_sub10_891MBPS_1x8_4lane));
-		break;
-	case IMX900_MODE_SUB2_1032x776_8BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_8BPP:
-		if (imx900->chromacity == IMX900_COLOR)
-			ret = imx900_write_table(imx900, sub2_color_1485MBPS_1x8_4lane,
-				ARRAY_SIZE(sub2_color_1485MBPS_1x8_4lane));
-		else
-			ret = imx900_write_table(imx900, sub2_binning_mono_891MBPS_1x8_4lane,
-				ARRAY_SIZE(sub2_binning_mono_891MBPS_1x8_4lane));
-		break;
-	}
-
+	ret = __fr_sensor_write_table(&imx900->core, reg_list->regs,
+				   reg_list->num_of_regs, reg_list->name);
 	if (ret) {
 		dev_err(dev, "%s error setting dep register table\n", __func__);
 		return ret;
@@ -1292,29 +1156,32 @@ static int imx900_set_dep_registers(struct imx900 *imx900)
 
 static int imx900_set_test_pattern(struct imx900 *imx900, u32 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
 	if (val) {
-		ret = imx900_write_reg(imx900, 0x3550, 1, 0x07);
+		ret = fr_sensor_write_reg(&imx900->core, 0x3550, 1, 0x07);
 		if (ret)
 			goto fail;
 		if (val == 4) {
-			ret = imx900_write_reg(imx900, 0x3551, 1, 0x0A);
+			ret = fr_sensor_write_reg(&imx900->core, 0x3551, 1,
+						0x0A);
 			if (ret)
 				goto fail;
 		} else if (val == 5) {
-			ret = imx900_write_reg(imx900, 0x3551, 1, 0x0B);
+			ret = fr_sensor_write_reg(&imx900->core, 0x3551, 1,
+						0x0B);
 			if (ret)
 				goto fail;
 		} else {
-			ret = imx900_write_reg(imx900, 0x3551, 1, (u8)(val));
+			ret = fr_sensor_write_reg(&imx900->core, 0x3551, 1,
+						(u8)(val));
 			if (ret)
 				goto fail;
 		}
 	} else {
-		ret = imx900_write_reg(imx900, 0x3550, 1, 0x06);
+		ret = fr_sensor_write_reg(&imx900->core, 0x3550, 1, 0x06);
 		if (ret)
 			goto fail;
 	}
@@ -1329,7 +1196,7 @@ fail:
 
 static void imx900_update_blklvl_range(struct imx900 *imx900)
 {
-	switch (imx900->fmt_code) {
+	switch (imx900->core.fmt_code) {
 	case MEDIA_BUS_FMT_SRGGB12_1X12:
 	case MEDIA_BUS_FMT_SGBRG12_1X12:
 	case MEDIA_BUS_FMT_Y12_1X12:
@@ -1363,11 +1230,11 @@ static void imx900_update_blklvl_range(struct imx900 *imx900)
 
 static int imx900_set_blklvl(struct imx900 *imx900, u64 val)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 
-	ret = imx900_write_hold_reg(imx900, BLKLEVEL_LOW, 2, val);
+	ret = fr_sensor_write_hold_reg(&imx900->core, BLKLEVEL_LOW, 2, val);
 
 	if (ret) {
 		dev_err(dev, "%s failed to adjust blklvl register\n",
@@ -1379,6 +1246,40 @@ static int imx900_set_blklvl(struct imx900 *imx900, u64 val)
 	return ret;
 }
 
+/* Route the exposure active signal to the selected GPO pin */
+static int imx900_set_strobe(struct imx900 *imx900, u32 val)
+{
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
+	struct device *dev = &client->dev;
+	u8 gpo01 = GPO_EXPSSEL_OFF;
+	u8 gpo2 = GPO_EXPSSEL_OFF;
+	int ret;
+
+	switch (val) {
+	case STROBE_GPO0:
+		gpo01 = GPO_EXPSSEL_EXPOSURE;
+		break;
+	case STROBE_GPO1:
+		gpo01 = GPO_EXPSSEL_EXPOSURE << 4;
+		break;
+	case STROBE_GPO2:
+		gpo2 = GPO_EXPSSEL_EXPOSURE;
+		break;
+	}
+
+	ret = fr_sensor_write_reg(&imx900->core, GPO0EXPSSEL_GPO1EXPSSEL, 1,
+				gpo01);
+	ret |= fr_sensor_write_reg(&imx900->core, GPO2EXPSSEL, 1, gpo2);
+	if (ret) {
+		dev_err(dev, "%s: error setting strobe output\n", __func__);
+		return ret;
+	}
+
+	dev_dbg(dev, "%s: strobe output: %u\n", __func__, val);
+
+	return 0;
+}
+
 static int imx900_set_operation_mode(struct imx900 *imx900, u32 val)
 {
 	gpiod_set_raw_value_cansleep(imx900->xmaster, val);
@@ -1388,17 +1289,18 @@ static int imx900_set_operation_mode(struct imx900 *imx900, u32 val)
 
 static int imx900_set_pixel_format(struct imx900 *imx900)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
 	u8 adbit_monosel;
 
-	switch (imx900->fmt_code) {
+	switch (imx900->core.fmt_code) {
 	case MEDIA_BUS_FMT_SRGGB8_1X8:
 	case MEDIA_BUS_FMT_SGBRG8_1X8:
 	case MEDIA_BUS_FMT_Y8_1X8:
 		adbit_monosel = (imx900->chromacity == IMX900_COLOR) ? 0x21 : 0x25;
-		ret = imx900_write_reg(imx900, ADBIT_MONOSEL, 1, adbit_monosel);
+		ret = fr_sensor_write_reg(&imx900->core, ADBIT_MONOSEL, 1,
+					adbit_monosel);
 		if (ret) {
 			dev_err(dev, "%s: error setting chromacity pixel format\n",
 									__func__);
@@ -1409,7 +1311,8 @@ static int imx900_set_pixel_format(struct imx900 *imx900)
 	case MEDIA_BUS_FMT_SGBRG10_1X10:
 	case MEDIA_BUS_FMT_Y10_1X10:
 		adbit_monosel = (imx900->chromacity == IMX900_COLOR) ? 0x01 : 0x05;
-		ret = imx900_write_reg(imx900, ADBIT_MONOSEL, 1, adbit_monosel);
+		ret = fr_sensor_write_reg(&imx900->core, ADBIT_MONOSEL, 1,
+					adbit_monosel);
 		if (ret) {
 			dev_err(dev, "%s: error setting chromacity pixel format\n",
 									__func__);
@@ -1420,7 +1323,8 @@ static int imx900_set_pixel_format(struct imx900 *imx900)
 	case MEDIA_BUS_FMT_SGBRG12_1X12:
 	case MEDIA_BUS_FMT_Y12_1X12:
 		adbit_monosel = (imx900->chromacity == IMX900_COLOR) ? 0x11 : 0x15;
-		ret = imx900_write_reg(imx900, ADBIT_MONOSEL, 1, adbit_monosel);
+		ret = fr_sensor_write_reg(&imx900->core, ADBIT_MONOSEL, 1,
+					adbit_monosel);
 		if (ret) {
 			dev_err(dev, "%s: error setting chromacity pixel format\n",
 									__func__);
@@ -1440,9 +1344,8 @@ static int imx900_set_pixel_format(struct imx900 *imx900)
 
 static int imx900_set_shutter_mode(struct imx900 *imx900)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
-	const struct imx900_mode *mode = imx900->mode;
 	int ret = 0;
 	u8 trigen = 0;
 	u8 vint_en = 0;
@@ -1487,36 +1390,10 @@ static int imx900_set_shutter_mode(struct imx900 *imx900)
 		return -EINVAL;
 	}
 
-	switch (mode->type) {
-	case IMX900_MODE_2064x1552_12BPP:
-	case IMX900_MODE_2064x1552_10BPP:
-	case IMX900_MODE_2064x1552_8BPP:
-		vint_en |= 0x1C;
-		break;
-	case IMX900_MODE_ROI_1920x1080_12BPP:
-	case IMX900_MODE_ROI_1920x1080_10BPP:
-	case IMX900_MODE_ROI_1920x1080_8BPP:
-		vint_en |= 0x1C;
-		break;
-	case IMX900_MODE_SUB2_1032x776_12BPP:
-	case IMX900_MODE_SUB2_1032x776_10BPP:
-	case IMX900_MODE_SUB2_1032x776_8BPP:
-		vint_en |= (imx900->chromacity == IMX900_COLOR) ? 0x14 : 0x18;
-		break;
-	case IMX900_MODE_SUB10_2064x154_12BPP:
-	case IMX900_MODE_SUB10_2064x154_10BPP:
-	case IMX900_MODE_SUB10_2064x154_8BPP:
-		vint_en |= 0x14;
-		break;
-	case IMX900_MODE_BIN_CROP_1024x720_12BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_10BPP:
-	case IMX900_MODE_BIN_CROP_1024x720_8BPP:
-		vint_en |= 0x18;
-		break;
-	}
+	vint_en |= imx900->timing->vint_en;
 
-	ret = imx900_write_reg(imx900, TRIGMODE, 1, trigen);
-	ret |= imx900_write_reg(imx900, VINT_EN, 1, vint_en);
+	ret = fr_sensor_write_reg(&imx900->core, TRIGMODE, 1, trigen);
+	ret |= fr_sensor_write_reg(&imx900->core, VINT_EN, 1, vint_en);
 	if (ret) {
 		dev_err(dev, "%s: error setting Shutter mode\n", __func__);
 		return ret;
@@ -1525,28 +1402,185 @@ static int imx900_set_shutter_mode(struct imx900 *imx900)
 	return 0;
 }
 
+/*
+ * Pulse the trigger line once and record when it was asserted. A trigger
+ * GPIO that does not sleep is toggled with interrupts off to keep the
+ * pulse start and width free of jitter. Without a trigger GPIO, a GMSL
+ * sensor whose trigger is not forwarded from the deserializer is
+ * triggered by driving its serializer pin over I2C.
+ */
+static int imx900_trigger_pulse(struct imx900 *imx900)
+{
+	unsigned long flags;
+	int ret;
+
+	if (imx900->trigger_gpio &&
+	    !gpiod_cansleep(imx900->trigger_gpio)) {
+		local_irq_save(flags);
+		gpiod_set_value(imx900->trigger_gpio, 1);
+		WRITE_ONCE(imx900->trigger_timestamp, ktime_get());
+		udelay(IMX900_TRIGGER_PULSE_US);
+		gpiod_set_value(imx900->trigger_gpio, 0);
+		local_irq_restore(flags);
+		return 0;
+	}
+
+	if (imx900->trigger_gpio) {
+		gpiod_set_value_cansleep(imx900->trigger_gpio, 1);
+		WRITE_ONCE(imx900->trigger_timestamp, ktime_get());
+		usleep_range(IMX900_TRIGGER_PULSE_US,
+				IMX900_TRIGGER_PULSE_US + 10);
+		gpiod_set_value_cansleep(imx900->trigger_gpio, 0);
+		return 0;
+	}
+
+	ret = max96793_xtrig_set(imx900->core.ser_dev, true);
+	if (ret)
+		return ret;
+	WRITE_ONCE(imx900->trigger_timestamp, ktime_get());
+	usleep_range(IMX900_TRIGGER_PULSE_US, IMX900_TRIGGER_PULSE_US + 10);
+
+	return max96793_xtrig_set(imx900->core.ser_dev, false);
+}
+
+/*
+ * Remaining pulses of a burst, one per frame time. The work does not take
+ * the driver lock. It is only ever cancelled synchronously, so the burst
+ * state is not touched by anyone else while it runs. The trigger timestamp
+ * is read under the lock by the controls and is therefore only accessed
+ * with READ_ONCE()/WRITE_ONCE().
+ */
+static void imx900_trigger_work(struct work_struct *work)
+{
+	struct imx900 *imx900 = container_of(to_delayed_work(work),
+						struct imx900, trigger_work);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
+	struct device *dev = &client->dev;
+
+	if (imx900_trigger_pulse(imx900)) {
+		dev_err(dev, "%s: failed to pulse trigger\n", __func__);
+		return;
+	}
+
+	if (--imx900->trigger_pending)
+		schedule_delayed_work(&imx900->trigger_work,
+				      imx900->trigger_period);
+	else
+		dev_dbg(dev, "%s: burst done, last trigger at %lld ns\n",
+			__func__,
+			ktime_to_ns(READ_ONCE(imx900->trigger_timestamp)));
+}
+
+/*
+ * Fire the first trigger of a burst right away and leave the rest, one per
+ * frame time, to the trigger work. A new trigger restarts the burst.
+ */
+static int imx900_software_trigger(struct imx900 *imx900)
+{
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
+	struct device *dev = &client->dev;
+	u64 frame_time = fr_sensor_frame_lines(&imx900->core) *
+			 imx900->core.line_time / IMX900_K_FACTOR;
+	int ret;
+
+	cancel_delayed_work_sync(&imx900->trigger_work);
+
+	ret = imx900_trigger_pulse(imx900);
+	if (ret) {
+		dev_err(dev, "%s: failed to pulse trigger\n", __func__);
+		return ret;
+	}
+
+	dev_dbg(dev, "%s: %d trigger(s), first at %lld ns\n", __func__,
+			imx900->trigger_burst->val,
+			ktime_to_ns(READ_ONCE(imx900->trigger_timestamp)));
+
+	imx900->trigger_pending = imx900->trigger_burst->val - 1;
+	if (imx900->trigger_pending) {
+		imx900->trigger_period = usecs_to_jiffies(frame_time);
+		schedule_delayed_work(&imx900->trigger_work,
+				      imx900->trigger_period);
+	}
+
+	return 0;
+}
+
+/*
+ * Time from the last trigger pulse to the frame start that followed it,
+ * taken from the XVS interrupt, or -1 while that frame has not started.
+ */
+static s32 imx900_trigger_latency(struct imx900 *imx900)
+{
+	ktime_t trigger = READ_ONCE(imx900->trigger_timestamp);
+	s64 latency;
+
+	if (!ktime_to_ns(trigger))
+		return -1;
+
+	latency = ktime_us_delta(READ_ONCE(imx900->core.xvs_timestamp),
+								trigger);
+	if (latency < 0)
+		return -1;
+
+	return min_t(s64, latency, S32_MAX);
+}
+
+static int imx900_get_volatile_ctrl(struct v4l2_ctrl *ctrl)
+{
+	struct imx900 *imx900 =
+		container_of(ctrl->handler, struct imx900, ctrl_handler);
+
+	switch (ctrl->id) {
+	case V4L2_CID_TRIGGER_TIMESTAMP:
+		*ctrl->p_new.p_s64 =
+			ktime_to_ns(READ_ONCE(imx900->trigger_timestamp));
+		break;
+	case V4L2_CID_TRIGGER_LATENCY:
+		*ctrl->p_new.p_s32 = imx900_trigger_latency(imx900);
+		break;
+	}
+
+	return 0;
+}
+
 static int imx900_set_ctrl(struct v4l2_ctrl *ctrl)
 {
 	struct imx900 *imx900 =
 		container_of(ctrl->handler, struct imx900, ctrl_handler);
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	int ret = 0;
 
 	switch (ctrl->id) {
 	case V4L2_CID_FRAME_RATE:
-		imx900_update_frame_rate(imx900, ctrl->val);
+		fr_sensor_update_frame_rate(&imx900->core, ctrl->val);
 		break;
 	case V4L2_CID_VBLANK:
+	case V4L2_CID_EXPOSURE_AUTO_PRIORITY:
 		imx900_adjust_exposure_range(imx900);
 		break;
+	case V4L2_CID_SOFTWARE_TRIGGER:
+		if (!imx900->core.streaming ||
+		    imx900->shutter_mode->val == NORMAL_MODE)
+			return -EBUSY;
+		break;
 	}
 
-	if (pm_runtime_get_if_in_use(&client->dev) == 0)
+	/*
+	 * Controls are written whenever the sensor is powered, so that a
+	 * staged configuration stays valid. Otherwise they are applied on the
+	 * next staging or stream start.
+	 */
+	if (pm_runtime_get_if_active(&client->dev, true) <= 0) {
+		imx900->core.staged = false;
 		return 0;
+	}
+
+	WRITE_ONCE(imx900->core.i2c_class, FR_I2C_CONTROL);
 
 	switch (ctrl->id) {
 	case V4L2_CID_ANALOGUE_GAIN:
-		ret = imx900_write_hold_reg(imx900, GAIN_LOW, 2, ctrl->val);
+		ret = fr_sensor_write_hold_reg(&imx900->core, GAIN_LOW, 2,
+					ctrl->val);
 		break;
 	case V4L2_CID_EXPOSURE:
 		ret = imx900_set_exposure(imx900, ctrl->val);
@@ -1562,15 +1596,31 @@ static int imx900_set_ctrl(struct v4l2_ctrl *ctrl)
 		break;
 	case V4L2_CID_OPERATION_MODE:
 		ret = imx900_set_operation_mode(imx900, ctrl->val);
+		fr_sensor_invalidate_staging(&imx900->core);
+		break;
+	case V4L2_CID_GLOBAL_SHUTTER_MODE:
+		fr_sensor_invalidate_staging(&imx900->core);
+		break;
+	case V4L2_CID_SOFTWARE_TRIGGER:
+		ret = imx900_software_trigger(imx900);
+		break;
+	case V4L2_CID_STROBE_OUTPUT:
+		ret = imx900_set_strobe(imx900, ctrl->val);
+		break;
+	case V4L2_CID_EXPOSURE_AUTO_PRIORITY:
+		ret = imx900_set_exposure(imx900, imx900->exposure->val);
 		break;
 	}
 
-	pm_runtime_put(&client->dev);
+	WRITE_ONCE(imx900->core.i2c_class, FR_I2C_OTHER);
+
+	pm_runtime_put_autosuspend(&client->dev);
 
 	return ret;
 }
 
 static const struct v4l2_ctrl_ops imx900_ctrl_ops = {
+	.g_volatile_ctrl = imx900_get_volatile_ctrl,
 	.s_ctrl = imx900_set_ctrl,
 };
 
@@ -1682,11 +1732,11 @@ static int imx900_get_pad_format(struct v4l2_subdev *sd,
 	if (fmt->pad >= NUM_PADS)
 		return -EINVAL;
 
-	mutex_lock(&imx900->mutex);
+	mutex_lock(&imx900->core.mutex);
 
 	if (fmt->which == V4L2_SUBDEV_FORMAT_TRY) {
 		struct v4l2_mbus_framefmt *try_fmt =
-			v4l2_subdev_get_try_format(&imx900->sd, sd_state,
+			v4l2_subdev_get_try_format(&imx900->core.sd, sd_state,
 							fmt->pad);
 		try_fmt->code = fmt->pad == IMAGE_PAD ?
 				imx900_get_format_code(imx900, try_fmt->code) :
@@ -1697,49 +1747,45 @@ static int imx900_get_pad_format(struct v4l2_subdev *sd,
 			imx900_update_image_pad_format(imx900, imx900->mode,
 								fmt);
 			fmt->format.code = imx900_get_format_code(imx900,
-								imx900->fmt_code);
+								imx900->core.fmt_code);
 		} else {
 			imx900_update_metadata_pad_format(fmt);
 		}
 	}
 
-	mutex_unlock(&imx900->mutex);
+	mutex_unlock(&imx900->core.mutex);
 	return 0;
 }
 
 static void imx900_set_limits(struct imx900 *imx900)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
 	const struct imx900_mode *mode = imx900->mode;
 	u64 max_framerate;
 
 	dev_dbg(dev, "%s: mode: %dx%d\n", __func__, mode->width, mode->height);
 
-	imx900_adjust_hmax_register(imx900);
-
-	imx900_adjust_min_frame_length_delta(imx900);
-
-	imx900_adjust_pixel_rate(imx900);
-
-	imx900_adjust_link_frequency(imx900);
+	imx900_select_timing(imx900);
+	imx900->core.interval_fps = 0;
 
-	imx900->line_time = (imx900->hmax*IMX900_G_FACTOR) / (IMX900_XCLK_FREQ);
-	dev_dbg(dev, "%s: line time: %lld\n", __func__, imx900->line_time);
+	dev_dbg(dev, "%s: line time: %lld\n", __func__, imx900->core.line_time);
 
-	imx900->frame_length = mode->height + imx900->min_frame_length_delta;
-	dev_dbg(dev, "%s: frame length: %d\n", __func__, imx900->frame_length);
+	imx900->core.frame_length = mode->height +
+				imx900->timing->min_frame_length_delta;
+	dev_dbg(dev, "%s: frame length: %d\n", __func__,
+						imx900->core.frame_length);
 
 	max_framerate = (IMX900_G_FACTOR * IMX900_M_FACTOR) /
-				(imx900->frame_length * imx900->line_time);
+			(imx900->core.frame_length * imx900->core.line_time);
 
-	__v4l2_ctrl_modify_range(imx900->framerate, mode->min_fps,
+	__v4l2_ctrl_modify_range(imx900->core.framerate, mode->min_fps,
 				 max_framerate, 1, max_framerate);
 	dev_dbg(dev, "%s: max framerate: %lld\n", __func__, max_framerate);
 
 	imx900_update_blklvl_range(imx900);
 
-	__v4l2_ctrl_s_ctrl(imx900->framerate, max_framerate);
+	__v4l2_ctrl_s_ctrl(imx900->core.framerate, max_framerate);
 }
 
 static int imx900_set_pad_format(struct v4l2_subdev *sd,
@@ -1753,7 +1799,7 @@ static int imx900_set_pad_format(struct v4l2_subdev *sd,
 	if (fmt->pad >= NUM_PADS)
 		return -EINVAL;
 
-	mutex_lock(&imx900->mutex);
+	mutex_lock(&imx900->core.mutex);
 
 	if (fmt->pad == IMAGE_PAD) {
 		const struct imx900_mode *mode_list;
@@ -1776,8 +1822,10 @@ static int imx900_set_pad_format(struct v4l2_subdev *sd,
 			*framefmt = fmt->format;
 		} else if (imx900->mode != mode) {
 			imx900->mode = mode;
-			imx900->fmt_code = fmt->format.code;
+			imx900->crop = mode->crop;
+			imx900->core.fmt_code = fmt->format.code;
 			imx900_set_limits(imx900);
+			fr_sensor_invalidate_staging(&imx900->core);
 		}
 	} else {
 		if (fmt->which == V4L2_SUBDEV_FORMAT_TRY) {
@@ -1789,7 +1837,7 @@ static int imx900_set_pad_format(struct v4l2_subdev *sd,
 		}
 	}
 
-	mutex_unlock(&imx900->mutex);
+	mutex_unlock(&imx900->core.mutex);
 
 	return 0;
 }
@@ -1801,9 +1849,9 @@ __imx900_get_pad_crop(struct imx900 *imx900,
 {
 	switch (which) {
 	case V4L2_SUBDEV_FORMAT_TRY:
-		return v4l2_subdev_get_try_crop(&imx900->sd, sd_state, pad);
+		return v4l2_subdev_get_try_crop(&imx900->core.sd, sd_state, pad);
 	case V4L2_SUBDEV_FORMAT_ACTIVE:
-		return &imx900->mode->crop;
+		return &imx900->crop;
 	}
 
 	return NULL;
@@ -1817,10 +1865,10 @@ static int imx900_get_selection(struct v4l2_subdev *sd,
 	case V4L2_SEL_TGT_CROP: {
 		struct imx900 *imx900 = to_imx900(sd);
 
-		mutex_lock(&imx900->mutex);
+		mutex_lock(&imx900->core.mutex);
 		sel->r = *__imx900_get_pad_crop(imx900, sd_state, sel->pad,
 						sel->which);
-		mutex_unlock(&imx900->mutex);
+		mutex_unlock(&imx900->core.mutex);
 
 		return 0;
 	}
@@ -1846,41 +1894,194 @@ static int imx900_get_selection(struct v4l2_subdev *sd,
 	return -EINVAL;
 }
 
-static int imx900_set_mode(struct imx900 *imx900)
+static int imx900_set_selection(struct v4l2_subdev *sd,
+				struct v4l2_subdev_state *sd_state,
+				struct v4l2_subdev_selection *sel)
+{
+	struct imx900 *imx900 = to_imx900(sd);
+	struct v4l2_rect *crop;
+	struct v4l2_rect prev;
+	int ret = 0;
+
+	if (sel->target != V4L2_SEL_TGT_CROP || sel->pad != IMAGE_PAD)
+		return -EINVAL;
+
+	mutex_lock(&imx900->core.mutex);
+
+	if (sel->which == V4L2_SUBDEV_FORMAT_TRY)
+		crop = v4l2_subdev_get_try_crop(sd, sd_state, sel->pad);
+	else
+		crop = &imx900->crop;
+
+	/*
+	 * Only the window start can be changed, the window size is defined
+	 * by the selected mode. Sensor readout modes that do not use window
+	 * cropping keep their fixed position.
+	 */
+	if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE &&
+	    !imx900_is_window_mode(imx900->mode)) {
+		sel->r = *crop;
+		goto unlock;
+	}
+
+	prev = *crop;
+
+	crop->left = clamp_t(s32, sel->r.left, IMX900_PIXEL_ARRAY_LEFT,
+			     IMX900_PIXEL_ARRAY_WIDTH - crop->width);
+	crop->left = round_down(crop->left, IMX900_WINDOW_H_STEP);
+	crop->top = clamp_t(s32, sel->r.top, IMX900_PIXEL_ARRAY_TOP,
+			    IMX900_PIXEL_ARRAY_HEIGHT - crop->height);
+	crop->top = round_down(crop->top, IMX900_WINDOW_V_STEP);
+
+	/*
+	 * While streaming the new start position is written inside a
+	 * register hold group, so the sensor switches to it on the next
+	 * frame boundary without a stream restart.
+	 */
+	if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE && imx900->core.streaming &&
+	    (crop->left != prev.left || crop->top != prev.top)) {
+		ret = imx900_set_window_position(imx900);
+		if (ret)
+			*crop = prev;
+	} else if (sel->which == V4L2_SUBDEV_FORMAT_ACTIVE &&
+		   (crop->left != prev.left || crop->top != prev.top)) {
+		fr_sensor_invalidate_staging(&imx900->core);
+	}
+
+	sel->r = *crop;
+
+unlock:
+	mutex_unlock(&imx900->core.mutex);
+
+	return ret;
+}
+
+/*
+ * Describe the CSI-2 stream seen by the receiver: the image on the data
+ * type of the active format and the virtual channel it arrives on.
+ */
+static int imx900_get_frame_desc(struct v4l2_subdev *sd, unsigned int pad,
+				 struct v4l2_mbus_frame_desc *fd)
 {
+	struct imx900 *imx900 = to_imx900(sd);
+	struct v4l2_mbus_frame_desc_entry *entry;
+	u8 vc = 0;
+
+	if (pad >= NUM_PADS)
+		return -EINVAL;
+
+	if (fr_sensor_is_gmsl(&imx900->core))
+		vc = imx900->core.g_ctx.dst_vc;
+
+	memset(fd, 0, sizeof(*fd));
+	fd->type = V4L2_MBUS_FRAME_DESC_TYPE_CSI2;
+
+	mutex_lock(&imx900->core.mutex);
+
+	entry = &fd->entry[fd->num_entries++];
+	entry->stream = IMAGE_PAD;
+	entry->pixelcode = imx900->core.fmt_code;
+	entry->bus.csi2.vc = vc;
+	switch (imx900->core.fmt_code) {
+	case MEDIA_BUS_FMT_SRGGB8_1X8:
+	case MEDIA_BUS_FMT_SGBRG8_1X8:
+	case MEDIA_BUS_FMT_Y8_1X8:
+		entry->bus.csi2.dt = MIPI_CSI2_DT_RAW8;
+		break;
+	case MEDIA_BUS_FMT_SRGGB10_1X10:
+	case MEDIA_BUS_FMT_SGBRG10_1X10:
+	case MEDIA_BUS_FMT_Y10_1X10:
+		entry->bus.csi2.dt = MIPI_CSI2_DT_RAW10;
+		break;
+	default:
+		entry->bus.csi2.dt = MIPI_CSI2_DT_RAW12;
+		break;
+	}
+
+	mutex_unlock(&imx900->core.mutex);
+
+	return 0;
+}
 
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+/*
+ * Forward XVS over the GMSL link in the direction it is driven: from the
+ * sensor to the host in master mode, from the host to the sensor in slave
+ * mode.
+ */
+static int imx900_gmsl_xvs_setup(struct imx900 *imx900)
+{
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
-	const struct imx900_reg_list *reg_list;
+	bool master = imx900->operation_mode->val == MASTER_MODE;
 	int ret;
 
-	ret = imx900_write_table(imx900, mode_common_regs,
-					ARRAY_SIZE(mode_common_regs));
-
+	ret = max96793_xvs_setup(imx900->core.ser_dev,
+				master ? max96793_IN : max96793_OUT);
+	ret |= max96792_xvs_setup(imx900->core.dser_dev,
+				master ? max96792_OUT : max96792_IN);
 	if (ret) {
-		dev_err(dev, "%s failed to set common settings\n", __func__);
+		dev_err(dev, "%s: error forwarding XVS\n", __func__);
 		return ret;
 	}
 
+	return 0;
+}
+
+static int imx900_set_mode(struct fr_sensor *core)
+{
+	struct imx900 *imx900 = core_to_imx900(core);
+	struct device *dev = &core->client->dev;
+	const struct fr_sensor_reg_list *reg_list;
+	ktime_t start = ktime_get();
+	int ret;
+
+	/*
+	 * Common settings survive STREAMOFF/STREAMON, they only have to be
+	 * written once after the sensor has been powered up.
+	 */
+	if (!core->common_regs_written) {
+		ret = fr_sensor_write_table(core, mode_common_regs,
+					ARRAY_SIZE(mode_common_regs));
+		if (ret) {
+			dev_err(dev, "%s failed to set common settings\n",
+								__func__);
+			return ret;
+		}
+
+		core->common_regs_written = true;
+		start = fr_latency_record(&core->latency,
+					  FR_STAGE_COMMON_REGS, start);
+	}
+
 	reg_list = &imx900->mode->reg_list;
-	ret = imx900_write_table(imx900, reg_list->regs, reg_list->num_of_regs);
+	ret = __fr_sensor_write_table(core, reg_list->regs,
+				   reg_list->num_of_regs, "mode");
 	if (ret) {
 		dev_err(dev, "%s failed to set mode\n", __func__);
 		return ret;
 	}
 
 	reg_list = &imx900->mode->reg_list_format;
-	ret = imx900_write_table(imx900, reg_list->regs, reg_list->num_of_regs);
+	ret = __fr_sensor_write_table(core, reg_list->regs,
+				   reg_list->num_of_regs, "format");
 	if (ret) {
 		dev_err(dev, "%s failed to set frame format\n", __func__);
 		return ret;
 	}
 
+	if (imx900_is_window_mode(imx900->mode)) {
+		ret = imx900_set_window_position(imx900);
+		if (ret)
+			return ret;
+	}
+
 	ret = imx900_set_hmax_register(imx900);
 	if (ret) {
 		dev_err(dev, "%s failed to write hmax register\n", __func__);
 		return ret;
 	}
+	start = fr_latency_record(&core->latency, FR_STAGE_MODE_REGS,
+									start);
 
 	ret = imx900_set_data_rate(imx900);
 	if (ret) {
@@ -1901,6 +2102,7 @@ static int imx900_set_mode(struct imx900 *imx900)
 								__func__);
 		return ret;
 	}
+	fr_latency_record(&core->latency, FR_STAGE_DATA_RATE, start);
 
 	ret = imx900_set_pixel_format(imx900);
 	if (ret) {
@@ -1915,290 +2117,195 @@ static int imx900_set_mode(struct imx900 *imx900)
 		return ret;
 	}
 
+	if (fr_sensor_is_gmsl(core)) {
+		ret = imx900_gmsl_xvs_setup(imx900);
+		if (ret)
+			return ret;
+	}
+
 	return ret;
 }
 
-static int imx900_start_streaming(struct imx900 *imx900)
+static int imx900_gmsl_parse(struct fr_sensor *core, struct device_node *gmsl)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
-	struct device *dev = &client->dev;
+	struct imx900 *imx900 = core_to_imx900(core);
+	struct device *dev = &core->client->dev;
+	u32 value;
 	int ret;
 
-	if (!(strcmp(imx900->gmsl, "gmsl"))) {
-		ret = max96793_setup_streaming(imx900->ser_dev, imx900->fmt_code);
-		if (ret) {
-			dev_err(dev, "%s: Unable to setup streaming for serializer max96793\n",
-								__func__);
-			return ret;
-		}
-		ret = max96792_setup_streaming(imx900->dser_dev,
-							&client->dev);
-		if (ret) {
-			dev_err(dev, "%s: Unable to setup streaming for deserializer max96792\n",
-								__func__);
-			return ret;
-		}
-		ret = max96792_start_streaming(imx900->dser_dev, &client->dev);
-		if (ret) {
-			dev_err(dev, "%s: Unable to start gmsl streaming\n",
-								__func__);
-			return ret;
-		}
-	}
+	if (!of_property_read_u32(gmsl, "trigger-dser-gpio", &value)) {
+		imx900->trigger_dser_gpio = value;
+		imx900->gmsl_trigger = true;
 
-	ret = imx900_set_mode(imx900);
-	if (ret) {
-		dev_err(dev, "%s failed to set mode start stream\n", __func__);
-		return ret;
+		if (of_property_read_u32(gmsl, "trigger-gpio-id", &value))
+			value = IMX900_TRIGGER_GPIO_ID;
+		imx900->trigger_gpio_id = value;
 	}
 
-	ret = __v4l2_ctrl_handler_setup(imx900->sd.ctrl_handler);
-	if (ret)
-		return ret;
+	if (!of_property_read_u32(gmsl, "strobe-ser-gpio", &value)) {
+		imx900->strobe_ser_gpio = value;
 
-	ret = imx900_write_reg(imx900, STANDBY, 1, IMX900_MODE_STREAMING);
+		ret = of_property_read_u32(gmsl, "strobe-dser-gpio", &value);
+		if (ret < 0) {
+			dev_err(dev, "No strobe-dser-gpio info\n");
+			return ret;
+		}
+		imx900->strobe_dser_gpio = value;
+		imx900->gmsl_strobe = true;
 
-	if (ret) {
-		dev_err(dev, "%s failed to set STANDBY start stream\n", __func__);
-		return ret;
+		if (of_property_read_u32(gmsl, "strobe-gpio-id", &value))
+			value = IMX900_STROBE_GPIO_ID;
+		imx900->strobe_gpio_id = value;
 	}
 
-	usleep_range(15000, 20000);
+	return 0;
+}
 
-	if (imx900->operation_mode->val == MASTER_MODE)
-		ret = imx900_write_reg(imx900, XMSTA, 1, 0x00);
-	else
-		ret = imx900_write_reg(imx900, XMSTA, 1, 0x01);
+static int imx900_gmsl_ser_setup(struct fr_sensor *core)
+{
+	struct imx900 *imx900 = core_to_imx900(core);
 
-	if (ret) {
-		dev_err(dev, "%s failed to set XMSTA start stream\n", __func__);
-		return ret;
-	}
+	if (imx900->gmsl_trigger)
+		return max96793_xtrig_setup(core->ser_dev,
+					imx900->trigger_gpio_id);
 
-	return ret;
+	return max96793_gpio10_xtrig1_setup(core->ser_dev, "mipi");
 }
 
-static void imx900_stop_streaming(struct imx900 *imx900)
+static int imx900_gmsl_dser_setup(struct fr_sensor *core)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
-	struct device *dev = &client->dev;
+	struct imx900 *imx900 = core_to_imx900(core);
+	struct device *dev = &core->client->dev;
 	int ret;
 
-	if (!(strcmp(imx900->gmsl, "gmsl"))) {
-		max96793_bypassPCLK_dis(imx900->ser_dev);
-		max96792_stop_streaming(imx900->dser_dev, &client->dev);
+	if (imx900->gmsl_trigger) {
+		ret = max96792_trigger_setup(core->dser_dev,
+					imx900->trigger_dser_gpio,
+					imx900->trigger_gpio_id);
+		if (ret) {
+			dev_err(dev, "gmsl deserializer trigger pin config failed\n");
+			return ret;
+		}
 	}
 
-	ret = imx900_write_reg(imx900, XMSTA, 1, 0x01);
-	if (ret)
-		dev_err(dev, "%s failed to set XMSTA stop stream\n", __func__);
+	if (imx900->gmsl_strobe) {
+		ret = max96793_gpio_tx_setup(core->ser_dev,
+					imx900->strobe_ser_gpio,
+					imx900->strobe_gpio_id);
+		ret |= max96792_gpio_rx_setup(core->dser_dev,
+					imx900->strobe_dser_gpio,
+					imx900->strobe_gpio_id);
+		if (ret) {
+			dev_err(dev, "gmsl strobe pin config failed\n");
+			return ret;
+		}
+	}
 
-	ret = imx900_write_reg(imx900, STANDBY, 1, IMX900_MODE_STANDBY);
-	if (ret)
-		dev_err(dev, "%s failed to set stream\n", __func__);
+	return 0;
+}
 
-	usleep_range(imx900->frame_length * imx900->line_time / IMX900_K_FACTOR,
-		imx900->frame_length * imx900->line_time / IMX900_K_FACTOR + 1000);
-
-}
-
-static int imx900_set_stream(struct v4l2_subdev *sd, int enable)
+static bool imx900_is_master(struct fr_sensor *core)
 {
-	struct imx900 *imx900 = to_imx900(sd);
-	struct i2c_client *client = v4l2_get_subdevdata(sd);
-	int ret = 0;
-
-	mutex_lock(&imx900->mutex);
-	if (imx900->streaming == enable) {
-		mutex_unlock(&imx900->mutex);
-		return 0;
-	}
-
-	if (enable) {
-		ret = pm_runtime_get_sync(&client->dev);
-		if (ret < 0) {
-			pm_runtime_put_noidle(&client->dev);
-			goto err_unlock;
-		}
-
-		ret = imx900_start_streaming(imx900);
-		if (ret)
-			goto err_rpm_put;
-	} else {
-		imx900_stop_streaming(imx900);
-		pm_runtime_put(&client->dev);
-	}
-
-	imx900->streaming = enable;
-
-	__v4l2_ctrl_grab(imx900->vflip, enable);
-	__v4l2_ctrl_grab(imx900->hflip, enable);
-	__v4l2_ctrl_grab(imx900->operation_mode, enable);
-	__v4l2_ctrl_grab(imx900->shutter_mode, enable);
-
-	mutex_unlock(&imx900->mutex);
-
-	return ret;
-
-err_rpm_put:
-	pm_runtime_put(&client->dev);
-err_unlock:
-	mutex_unlock(&imx900->mutex);
-
-	return ret;
+	return core_to_imx900(core)->operation_mode->val == MASTER_MODE;
 }
 
-static int imx900_gmsl_serdes_setup(struct imx900 *imx900)
+static void imx900_frame_limits(struct fr_sensor *core,
+				struct fr_sensor_frame_limits *lim)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
-	struct device *dev = &client->dev;
-	int ret = 0;
-	int des_err = 0;
-
-	if (!imx900 || !imx900->ser_dev || !imx900->dser_dev || !client)
-		return -EINVAL;
-
-	dev_dbg(dev, "enter %s function\n", __func__);
-
-	mutex_lock(&imx900->mutex);
-
-	ret = max96792_reset_control(imx900->dser_dev, &client->dev);
-
-	ret = max96792_gmsl3_setup(imx900->dser_dev);
-	if (ret) {
-		dev_err(dev, "deserializer gmsl setup failed\n");
-		goto error;
-	}
-
-	ret = max96793_gmsl3_setup(imx900->ser_dev);
-	if (ret) {
-		dev_err(dev, "serializer gmsl setup failed\n");
-		goto error;
-	}
-
-	dev_dbg(dev, "%s: max96792_setup_link\n", __func__);
-	ret = max96792_setup_link(imx900->dser_dev, &client->dev);
-	if (ret) {
-		dev_err(dev, "gmsl deserializer link config failed\n");
-		goto error;
-	}
-
-	dev_dbg(dev, "%s: max96793_setup_control\n", __func__);
-	ret = max96793_setup_control(imx900->ser_dev);
-
-	if (ret)
-		dev_err(dev, "gmsl serializer setup failed\n");
-
-	ret = max96793_gpio10_xtrig1_setup(imx900->ser_dev, "mipi");
-	if (ret) {
-		dev_err(dev, "gmsl serializer gpio10/xtrig1 pin config failed\n");
-		goto error;
-	}
-
-	dev_dbg(dev, "%s: max96792_setup_control\n", __func__);
-	des_err = max96792_setup_control(imx900->dser_dev, &client->dev);
-	if (des_err)
-		dev_err(dev, "gmsl deserializer setup failed\n");
-
-error:
-	mutex_unlock(&imx900->mutex);
-	return ret;
+	struct imx900 *imx900 = core_to_imx900(core);
+
+	lim->width = imx900->mode->width;
+	lim->height = imx900->mode->height;
+	lim->pixel_rate = imx900->timing->pixel_rate;
+	lim->hmax_min = imx900->timing->hmax;
+	lim->vmax_min = imx900_min_frame_length(imx900);
+	lim->min_fps = imx900->mode->min_fps;
 }
 
-static void imx900_gmsl_serdes_reset(struct imx900 *imx900)
+/* No trigger of a burst may hit the sensor once it is back in standby */
+static void imx900_stream_stop(struct fr_sensor *core)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
-
-	mutex_lock(&imx900->mutex);
-
-	max96793_reset_control(imx900->ser_dev);
-	max96792_reset_control(imx900->dser_dev, &client->dev);
-	max96792_power_off(imx900->dser_dev, &imx900->g_ctx);
-
-	mutex_unlock(&imx900->mutex);
+	cancel_delayed_work_sync(&core_to_imx900(core)->trigger_work);
 }
 
-static int imx900_power_on(struct device *dev)
-{
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx900 *imx900 = to_imx900(sd);
-
-	if (strcmp(imx900->gmsl, "gmsl")) {
-		gpiod_set_value_cansleep(imx900->reset_gpio, 1);
-		usleep_range(25000, 30000);
-	} else {
-		dev_info(dev, "%s: max96792_power_on\n", __func__);
-		max96792_power_on(imx900->dser_dev, &imx900->g_ctx);
-	}
-
-	return 0;
-}
+static const struct fr_sensor_ops imx900_sensor_ops = {
+	.gmsl_parse = imx900_gmsl_parse,
+	.gmsl_ser_setup = imx900_gmsl_ser_setup,
+	.gmsl_dser_setup = imx900_gmsl_dser_setup,
+	.set_mode = imx900_set_mode,
+	.is_master = imx900_is_master,
+	.frame_limits = imx900_frame_limits,
+	.stream_stop = imx900_stream_stop,
+};
 
-static int imx900_power_off(struct device *dev)
+/*
+ * Check that a pulse on the trigger GPIO shows up on the serializer pin
+ * driving XTRIG. The level is polled over I2C, so the time it takes is
+ * dominated by the bus and says nothing about the propagation delay of
+ * the forwarded GPIO itself. It is only logged as an upper bound.
+ */
+static void imx900_check_trigger_path(struct imx900 *imx900)
 {
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx900 *imx900 = to_imx900(sd);
-
-	mutex_lock(&imx900->mutex);
-	if (strcmp(imx900->gmsl, "gmsl")) {
-		gpiod_set_value_cansleep(imx900->reset_gpio, 0);
-	} else {
-		dev_info(dev, "%s: max96792_power_off\n", __func__);
-		max96792_power_off(imx900->dser_dev, &imx900->g_ctx);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
+	struct device *dev = &client->dev;
+	ktime_t start;
+	int idle, level;
+	s64 delay;
+
+	idle = max96793_xtrig_level(imx900->core.ser_dev);
+	if (idle < 0)
+		return;
+
+	start = ktime_get();
+	gpiod_set_value_cansleep(imx900->trigger_gpio, 1);
+	do {
+		level = max96793_xtrig_level(imx900->core.ser_dev);
+		delay = ktime_us_delta(ktime_get(), start);
+	} while (level == idle && delay < IMX900_TRIGGER_TIMEOUT_US);
+	gpiod_set_value_cansleep(imx900->trigger_gpio, 0);
+
+	if (level < 0 || level == idle) {
+		dev_warn(dev, "%s: trigger does not reach the sensor\n",
+								__func__);
+		return;
 	}
-	mutex_unlock(&imx900->mutex);
-
-	return 0;
-}
-
-static int __maybe_unused imx900_suspend(struct device *dev)
-{
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx900 *imx900 = to_imx900(sd);
-
-	if (imx900->streaming)
-		imx900_stop_streaming(imx900);
 
-	return 0;
+	dev_dbg(dev, "%s: trigger seen at the serializer within %lld us\n",
+							__func__, delay);
 }
 
-static int __maybe_unused imx900_resume(struct device *dev)
+/*
+ * The optional trigger GPIO is the host side of the trigger line, either
+ * wired to XTRIG directly or, on GMSL, to the deserializer pin forwarded
+ * to the sensor. Its active level is taken from the DT GPIO flags.
+ */
+static int imx900_trigger_init(struct imx900 *imx900)
 {
-	struct i2c_client *client = to_i2c_client(dev);
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx900 *imx900 = to_imx900(sd);
-	int ret;
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
+	struct device *dev = &client->dev;
 
-	if (imx900->streaming) {
-		ret = imx900_start_streaming(imx900);
-		if (ret)
-			goto error;
+	imx900->trigger_gpio = devm_gpiod_get_optional(dev, "trigger",
+							GPIOD_OUT_LOW);
+	if (IS_ERR(imx900->trigger_gpio)) {
+		dev_err(dev, "cannot get trigger gpio\n");
+		return PTR_ERR(imx900->trigger_gpio);
 	}
 
-	return 0;
+	if (imx900->trigger_gpio && imx900->gmsl_trigger)
+		imx900_check_trigger_path(imx900);
 
-error:
-	imx900_stop_streaming(imx900);
-	imx900->streaming = 0;
-	return ret;
+	return 0;
 }
 
 static int imx900_communication_verify(struct imx900 *imx900)
 {
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
 	int ret;
-	u32 val;
 
-	ret = imx900_read_reg(imx900, VMAX_LOW, 3, &val);
-
-	if (ret) {
-		dev_err(dev, "%s unable to communicate with sensor\n", __func__);
+	ret = fr_sensor_identify(&imx900->core);
+	if (ret)
 		return ret;
-	}
 
 	ret = imx900_chromacity_mode(imx900);
 	if (ret) {
@@ -2215,13 +2322,31 @@ static int imx900_communication_verify(struct imx900 *imx900)
 	return 0;
 }
 
+static int imx900_subscribe_event(struct v4l2_subdev *sd, struct v4l2_fh *fh,
+				  struct v4l2_event_subscription *sub)
+{
+	struct imx900 *imx900 = to_imx900(sd);
+
+	switch (sub->type) {
+	case V4L2_EVENT_FRAME_SYNC:
+		if (imx900->core.xvs_irq <= 0)
+			return -EINVAL;
+		return v4l2_event_subscribe(fh, sub, IMX900_FRAME_SYNC_EVENTS,
+									NULL);
+	default:
+		return v4l2_ctrl_subdev_subscribe_event(sd, fh, sub);
+	}
+}
+
 static const struct v4l2_subdev_core_ops imx900_core_ops = {
-	.subscribe_event = v4l2_ctrl_subdev_subscribe_event,
+	.subscribe_event = imx900_subscribe_event,
 	.unsubscribe_event = v4l2_event_subdev_unsubscribe,
 };
 
 static const struct v4l2_subdev_video_ops imx900_video_ops = {
-	.s_stream = imx900_set_stream,
+	.s_stream = fr_sensor_s_stream,
+	.g_frame_interval = fr_sensor_g_frame_interval,
+	.s_frame_interval = fr_sensor_s_frame_interval,
 };
 
 static const struct v4l2_subdev_pad_ops imx900_pad_ops = {
@@ -2229,7 +2354,9 @@ static const struct v4l2_subdev_pad_ops imx900_pad_ops = {
 	.get_fmt = imx900_get_pad_format,
 	.set_fmt = imx900_set_pad_format,
 	.get_selection = imx900_get_selection,
+	.set_selection = imx900_set_selection,
 	.enum_frame_size = imx900_enum_frame_size,
+	.get_frame_desc = imx900_get_frame_desc,
 };
 
 static const struct v4l2_subdev_ops imx900_subdev_ops = {
@@ -2281,10 +2408,73 @@ static struct v4l2_ctrl_config imx900_ctrl_global_shutter_mode[] = {
 	},
 };
 
+static struct v4l2_ctrl_config imx900_ctrl_software_trigger[] = {
+	{
+		.ops = &imx900_ctrl_ops,
+		.id = V4L2_CID_SOFTWARE_TRIGGER,
+		.name = "Software trigger",
+		.type = V4L2_CTRL_TYPE_BUTTON,
+		.flags = V4L2_CTRL_FLAG_EXECUTE_ON_WRITE,
+	},
+};
+
+static struct v4l2_ctrl_config imx900_ctrl_trigger_burst[] = {
+	{
+		.ops = &imx900_ctrl_ops,
+		.id = V4L2_CID_TRIGGER_BURST,
+		.name = "Trigger burst count",
+		.type = V4L2_CTRL_TYPE_INTEGER,
+		.min = 1,
+		.max = IMX900_TRIGGER_BURST_MAX,
+		.def = 1,
+		.step = 1,
+	},
+};
+
+static struct v4l2_ctrl_config imx900_ctrl_trigger_timestamp[] = {
+	{
+		.ops = &imx900_ctrl_ops,
+		.id = V4L2_CID_TRIGGER_TIMESTAMP,
+		.name = "Trigger timestamp ns",
+		.type = V4L2_CTRL_TYPE_INTEGER64,
+		.flags = V4L2_CTRL_FLAG_READ_ONLY | V4L2_CTRL_FLAG_VOLATILE,
+		.min = 0,
+		.max = S64_MAX,
+		.step = 1,
+	},
+};
+
+static struct v4l2_ctrl_config imx900_ctrl_trigger_latency[] = {
+	{
+		.ops = &imx900_ctrl_ops,
+		.id = V4L2_CID_TRIGGER_LATENCY,
+		.name = "Trigger latency us",
+		.type = V4L2_CTRL_TYPE_INTEGER,
+		.flags = V4L2_CTRL_FLAG_READ_ONLY | V4L2_CTRL_FLAG_VOLATILE,
+		.min = -1,
+		.max = S32_MAX,
+		.def = -1,
+		.step = 1,
+	},
+};
+
+static struct v4l2_ctrl_config imx900_ctrl_strobe_output[] = {
+	{
+		.ops = &imx900_ctrl_ops,
+		.id = V4L2_CID_STROBE_OUTPUT,
+		.name = "Strobe output",
+		.type = V4L2_CTRL_TYPE_MENU,
+		.min = STROBE_DISABLED,
+		.def = STROBE_DISABLED,
+		.max = STROBE_GPO2,
+		.qmenu = imx900_strobe_menu,
+	},
+};
+
 static int imx900_init_controls(struct imx900 *imx900)
 {
 	struct v4l2_ctrl_handler *ctrl_hdlr;
-	struct i2c_client *client = v4l2_get_subdevdata(&imx900->sd);
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
 	struct device *dev = &client->dev;
 	struct v4l2_fwnode_device_properties props;
 	int ret;
@@ -2294,8 +2484,7 @@ static int imx900_init_controls(struct imx900 *imx900)
 	if (ret)
 		return ret;
 
-	mutex_init(&imx900->mutex);
-	ctrl_hdlr->lock = &imx900->mutex;
+	ctrl_hdlr->lock = &imx900->core.mutex;
 
 	imx900->pixel_rate = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
 						V4L2_CID_PIXEL_RATE, 0, 0, 1, 0);
@@ -2310,21 +2499,26 @@ static int imx900_init_controls(struct imx900 *imx900)
 	if (imx900->link_freq)
 		imx900->link_freq->flags |= V4L2_CTRL_FLAG_READ_ONLY;
 
-	imx900->vblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
+	imx900->core.vblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
 					V4L2_CID_VBLANK, 0, 0, 1, 0);
 
-	imx900->hblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
+	imx900->core.hblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
 					V4L2_CID_HBLANK, 0, 0, 1, 0);
 
-	if (imx900->hblank)
-		imx900->hblank->flags |= V4L2_CTRL_FLAG_READ_ONLY;
+	if (imx900->core.hblank)
+		imx900->core.hblank->flags |= V4L2_CTRL_FLAG_READ_ONLY;
 
 	imx900->exposure = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
 					V4L2_CID_EXPOSURE,
 					IMX900_MIN_INTEGRATION_LINES,
 					0xFF, 1, 0xFF);
 
-	imx900->framerate = v4l2_ctrl_new_custom(ctrl_hdlr,
+	imx900->exposure_priority = v4l2_ctrl_new_std(ctrl_hdlr,
+					&imx900_ctrl_ops,
+					V4L2_CID_EXPOSURE_AUTO_PRIORITY,
+					0, 1, 1, 0);
+
+	imx900->core.framerate = v4l2_ctrl_new_custom(ctrl_hdlr,
 					imx900_ctrl_framerate, NULL);
 
 	imx900->operation_mode = v4l2_ctrl_new_custom(ctrl_hdlr,
@@ -2333,6 +2527,21 @@ static int imx900_init_controls(struct imx900 *imx900)
 	imx900->shutter_mode = v4l2_ctrl_new_custom(ctrl_hdlr,
 					imx900_ctrl_global_shutter_mode, NULL);
 
+	v4l2_ctrl_new_custom(ctrl_hdlr, imx900_ctrl_strobe_output, NULL);
+
+	if (imx900->trigger_gpio ||
+	    (fr_sensor_is_gmsl(&imx900->core) && !imx900->gmsl_trigger)) {
+		v4l2_ctrl_new_custom(ctrl_hdlr, imx900_ctrl_software_trigger,
+									NULL);
+		imx900->trigger_burst = v4l2_ctrl_new_custom(ctrl_hdlr,
+					imx900_ctrl_trigger_burst, NULL);
+		v4l2_ctrl_new_custom(ctrl_hdlr, imx900_ctrl_trigger_timestamp,
+									NULL);
+		if (imx900->core.xvs_irq > 0)
+			v4l2_ctrl_new_custom(ctrl_hdlr,
+					imx900_ctrl_trigger_latency, NULL);
+	}
+
 	imx900->blklvl = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
 					V4L2_CID_BLACK_LEVEL,
 					IMX900_BLACK_LEVEL_MIN, 0xFF,
@@ -2372,92 +2581,112 @@ static int imx900_init_controls(struct imx900 *imx900)
 	if (ret)
 		goto error;
 
-	imx900->sd.ctrl_handler = ctrl_hdlr;
+	imx900->core.grab_ctrls[0] = imx900->vflip;
+	imx900->core.grab_ctrls[1] = imx900->hflip;
+	imx900->core.grab_ctrls[2] = imx900->operation_mode;
+	imx900->core.grab_ctrls[3] = imx900->shutter_mode;
+
+	imx900->core.sd.ctrl_handler = ctrl_hdlr;
 
-	mutex_lock(&imx900->mutex);
+	mutex_lock(&imx900->core.mutex);
 
 	imx900_set_limits(imx900);
 
-	mutex_unlock(&imx900->mutex);
+	mutex_unlock(&imx900->core.mutex);
 
 	return 0;
 
 error:
 	v4l2_ctrl_handler_free(ctrl_hdlr);
-	mutex_destroy(&imx900->mutex);
 
 	return ret;
 }
 
-static void imx900_free_controls(struct imx900 *imx900)
+/*
+ * Timing model in use, one "key: value" pair per line, followed by the
+ * timing table entry it was derived from.
+ */
+static int imx900_timing_show(struct seq_file *s, void *unused)
 {
-	v4l2_ctrl_handler_free(imx900->sd.ctrl_handler);
-	mutex_destroy(&imx900->mutex);
+	struct imx900 *imx900 = s->private;
+	const struct imx900_timing *timing;
+	u32 frame_lines;
+
+	mutex_lock(&imx900->core.mutex);
+
+	timing = imx900->timing;
+	frame_lines = fr_sensor_frame_lines(&imx900->core);
+
+	seq_printf(s, "mode: %ux%u (type %u)\n", imx900->mode->width,
+				imx900->mode->height, imx900->mode->type);
+	seq_printf(s, "code: 0x%04x\n", imx900->core.fmt_code);
+	seq_printf(s, "chromacity: %s\n",
+			imx900->chromacity == IMX900_COLOR ? "color" : "mono");
+	seq_printf(s, "hmax: %u\n", imx900->core.hmax);
+	seq_printf(s, "frame_length: %u\n", imx900->core.frame_length);
+	seq_printf(s, "vmax: %u\n", frame_lines);
+	seq_printf(s, "line_time_ns: %llu\n", imx900->core.line_time);
+	seq_printf(s, "frame_time_us: %llu\n",
+		   frame_lines * imx900->core.line_time / IMX900_K_FACTOR);
+	seq_printf(s, "readout_lines: %u\n", imx900->mode->height);
+	seq_printf(s, "readout_time_us: %llu\n",
+		   imx900->mode->height * imx900->core.line_time /
+							IMX900_K_FACTOR);
+	seq_printf(s, "min_hmax: %u\n", timing->hmax);
+	seq_printf(s, "min_shs_length: %u\n", timing->min_shs_length);
+	seq_printf(s, "min_frame_length_delta: %u\n",
+					timing->min_frame_length_delta);
+	seq_printf(s, "pixel_rate: %u\n", timing->pixel_rate);
+	seq_printf(s, "link_freq: %lld\n",
+			imx900_link_freq_menu[imx900->link_freq->val]);
+	seq_printf(s, "exposure_lines: %d\n", imx900->exposure->val);
+	seq_printf(s, "exposure_max_lines: %lld\n", imx900->exposure->maximum);
+	seq_printf(s, "vint_en: 0x%x\n", timing->vint_en);
+	seq_printf(s, "mode_regs: %s (%u)\n", timing->mode_regs.name,
+					timing->mode_regs.num_of_regs);
+	seq_printf(s, "dep_regs: %s (%u)\n", timing->dep_regs.name,
+					timing->dep_regs.num_of_regs);
+
+	mutex_unlock(&imx900->core.mutex);
+
+	return 0;
 }
+DEFINE_SHOW_ATTRIBUTE(imx900_timing);
 
-static int imx900_check_hwcfg(struct device *dev, struct i2c_client *client)
+static void imx900_debugfs_init(struct imx900 *imx900)
 {
-	struct device_node *node = client->dev.of_node;
-	struct v4l2_subdev *sd = i2c_get_clientdata(client);
-	struct imx900 *imx900 = to_imx900(sd);
-	struct fwnode_handle *endpoint;
-	struct v4l2_fwnode_endpoint ep_cfg = {
-		.bus_type = V4L2_MBUS_CSI2_DPHY
-	};
-	const char *gmsl;
-	int ret = -EINVAL;
-
-	endpoint = fwnode_graph_get_next_endpoint(dev_fwnode(dev), NULL);
-	if (!endpoint) {
-		dev_err(dev, "endpoint node not found\n");
-		return -EINVAL;
-	}
-
-	if (v4l2_fwnode_endpoint_alloc_parse(endpoint, &ep_cfg)) {
-		dev_err(dev, "could not parse endpoint\n");
-		goto error_out;
-	}
-
-	if (ep_cfg.bus.mipi_csi2.num_data_lanes != 4) {
-		dev_err(dev, "only 4 data lanes are currently supported\n");
-		goto error_out;
-	}
-
-	if (!ep_cfg.nr_of_link_frequencies) {
-		dev_err(dev, "link-frequency property not found in DT\n");
-		goto error_out;
-	}
-
-	if (ep_cfg.nr_of_link_frequencies != ARRAY_SIZE(imx900_link_freq_menu)) {
-		dev_err(dev, "Link frequency missing in dtree\n");
-		goto error_out;
-	}
+	struct i2c_client *client = v4l2_get_subdevdata(&imx900->core.sd);
+	char name[32];
 
-	for (int i = 0; i < ARRAY_SIZE(imx900_link_freq_menu); i++) {
-		if (ep_cfg.link_frequencies[i] != imx900_link_freq_menu[i]) {
-			dev_err(dev, "no supported link freq found\n");
-			goto error_out;
-		}
-	}
+	snprintf(name, sizeof(name), "imx900-%s", dev_name(&client->dev));
 
-	ret = of_property_read_string(node, "gmsl", &gmsl);
-	if (ret) {
-		dev_warn(dev, "initializing mipi...\n");
-		imx900->gmsl = "mipi";
-	} else if (!strcmp(gmsl, "gmsl")) {
-		dev_warn(dev, "initializing GMSL...\n");
-		imx900->gmsl = "gmsl";
-	}
-
-	ret = 0;
-
-error_out:
-	v4l2_fwnode_endpoint_free(&ep_cfg);
-	fwnode_handle_put(endpoint);
+	imx900->debugfs = debugfs_create_dir(name, NULL);
+	debugfs_create_file("timing", 0444, imx900->debugfs, imx900,
+						&imx900_timing_fops);
+	fr_sensor_debugfs_create(&imx900->core, imx900->debugfs);
+}
 
-	return ret;
+static void imx900_free_controls(struct imx900 *imx900)
+{
+	v4l2_ctrl_handler_free(imx900->core.sd.ctrl_handler);
 }
 
+static const struct fr_sensor_desc imx900_desc = {
+	.reghold = REGHOLD,
+	.standby = STANDBY,
+	.xmsta = XMSTA,
+	.id_reg = VMAX_LOW,
+	.id_len = 3,
+	.xclk_freq = IMX900_XCLK_FREQ,
+	.hmax_max = IMX900_HMAX_MAX,
+	.vmax_max = IMX900_VMAX_MAX,
+	.vmax_step = IMX900_VMAX_STEP,
+	.settle_us = IMX900_STANDBY_SETTLE_US,
+	.link_freqs = imx900_link_freq_menu,
+	.num_link_freqs = ARRAY_SIZE(imx900_link_freq_menu),
+	.ops = &imx900_sensor_ops,
+};
+
 static const struct of_device_id imx900_dt_ids[] = {
 	{ .compatible = "framos,fr_imx900" },
 	{	}
@@ -2467,220 +2696,29 @@ static int imx900_probe(struct i2c_client *client)
 {
 	struct device *dev = &client->dev;
 	struct imx900 *imx900;
-	const struct of_device_id *match;
-	struct device_node *node = dev->of_node;
-	struct device_node *ser_node;
-	struct i2c_client *ser_i2c = NULL;
-	struct device_node *dser_node;
-	struct i2c_client *dser_i2c = NULL;
-	struct device_node *gmsl;
-	int value = 0xFFFF;
-	const char *str_value;
-	const char *str_value1[2];
-	int i;
 	int ret;
 
 	imx900 = devm_kzalloc(&client->dev, sizeof(*imx900), GFP_KERNEL);
 	if (!imx900)
 		return -ENOMEM;
 
-	v4l2_i2c_subdev_init(&imx900->sd, client, &imx900_subdev_ops);
-
-	match = of_match_device(imx900_dt_ids, dev);
-	if (!match)
-		return -ENODEV;
+	v4l2_i2c_subdev_init(&imx900->core.sd, client, &imx900_subdev_ops);
 
-	if (imx900_check_hwcfg(dev, client))
-		return -EINVAL;
-
-	if (strcmp(imx900->gmsl, "gmsl")) {
-		imx900->reset_gpio = devm_gpiod_get(dev, "reset", GPIOD_OUT_HIGH);
-		if (IS_ERR(imx900->reset_gpio)) {
-			dev_err(dev, "cannot get reset gpio\n");
-			return PTR_ERR(imx900->reset_gpio);
-		}
-	}
-
-	if (!(strcmp(imx900->gmsl, "gmsl"))) {
-		ret = of_property_read_u32(node, "reg", &imx900->g_ctx.sdev_reg);
-		if (ret < 0) {
-			dev_err(dev, "reg not found\n");
-			return ret;
-		}
-
-		ret = of_property_read_u32(node, "def-addr", &imx900->g_ctx.sdev_def);
-		if (ret < 0) {
-			dev_err(dev, "def-addr not found\n");
-			return ret;
-		}
-
-		ser_node = of_parse_phandle(node, "gmsl-ser-device", 0);
-		if (ser_node == NULL) {
-			dev_err(dev, "missing %s handle\n", "gmsl-ser-device");
-			return ret;
-		}
-
-		ret = of_property_read_u32(ser_node, "reg", &imx900->g_ctx.ser_reg);
-		if (ret < 0) {
-			dev_err(dev, "serializer reg not found\n");
-			return ret;
-		}
-
-		ser_i2c = of_find_i2c_device_by_node(ser_node);
-		of_node_put(ser_node);
-
-		if (ser_i2c == NULL) {
-			dev_err(dev, "missing serializer dev handle\n");
-			return ret;
-		}
-		if (ser_i2c->dev.driver == NULL) {
-			dev_err(dev, "missing serializer driver\n");
-			return ret;
-		}
-
-		imx900->ser_dev = &ser_i2c->dev;
-
-		dser_node = of_parse_phandle(node, "gmsl-dser-device", 0);
-		if (dser_node == NULL) {
-			dev_err(dev, "missing %s handle\n", "gmsl-dser-device");
-			return ret;
-		}
-
-		dser_i2c = of_find_i2c_device_by_node(dser_node);
-		of_node_put(dser_node);
-
-		if (dser_i2c == NULL) {
-			dev_err(dev, "missing deserializer dev handle\n");
-			return ret;
-		}
-		if (dser_i2c->dev.driver == NULL) {
-			dev_err(dev, "missing deserializer driver\n");
-			return ret;
-		}
-
-		imx900->dser_dev = &dser_i2c->dev;
-
-		gmsl = of_get_child_by_name(node, "gmsl-link");
-		if (gmsl == NULL) {
-			dev_err(dev, "missing gmsl-link device node\n");
-			ret = -EINVAL;
-			return ret;
-		}
+	fr_sensor_init(&imx900->core, client, &imx900_desc);
 
-		ret = of_property_read_string(gmsl, "dst-csi-port", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No dst-csi-port found\n");
-			return ret;
-		}
-		imx900->g_ctx.dst_csi_port =
-		(!strcmp(str_value, "a")) ? GMSL_CSI_PORT_A : GMSL_CSI_PORT_B;
-
-		ret = of_property_read_string(gmsl, "src-csi-port", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No src-csi-port found\n");
-			return ret;
-		}
-		imx900->g_ctx.src_csi_port =
-		(!strcmp(str_value, "a")) ? GMSL_CSI_PORT_A : GMSL_CSI_PORT_B;
-
-		ret = of_property_read_string(gmsl, "csi-mode", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No csi-mode found\n");
-			return ret;
-		}
-
-		if (!strcmp(str_value, "1x4")) {
-			imx900->g_ctx.csi_mode = GMSL_CSI_1X4_MODE;
-		} else if (!strcmp(str_value, "2x4")) {
-			imx900->g_ctx.csi_mode = GMSL_CSI_2X4_MODE;
-		} else if (!strcmp(str_value, "2x2")) {
-			imx900->g_ctx.csi_mode = GMSL_CSI_2X2_MODE;
-		} else {
-			dev_err(dev, "invalid csi mode\n");
-			return ret;
-		}
-
-		ret = of_property_read_string(gmsl, "serdes-csi-link", &str_value);
-		if (ret < 0) {
-			dev_err(dev, "No serdes-csi-link found\n");
-			return ret;
-		}
-		imx900->g_ctx.serdes_csi_link =
-		(!strcmp(str_value, "a")) ? GMSL_SERDES_CSI_LINK_A : GMSL_SERDES_CSI_LINK_B;
-
-		ret = of_property_read_u32(gmsl, "st-vc", &value);
-		if (ret < 0) {
-			dev_err(dev, "No st-vc info\n");
-			return ret;
-		}
-
-		imx900->g_ctx.st_vc = value;
-
-		ret = of_property_read_u32(gmsl, "vc-id", &value);
-		if (ret < 0) {
-			dev_err(dev, "No vc-id info\n");
-			return ret;
-		}
-		imx900->g_ctx.dst_vc = value;
-
-		ret = of_property_read_u32(gmsl, "num-lanes", &value);
-		if (ret < 0) {
-			dev_err(dev, "No num-lanes info\n");
-			return ret;
-		}
-
-		imx900->g_ctx.num_csi_lanes = value;
-
-		imx900->g_ctx.num_streams =
-				of_property_count_strings(gmsl, "streams");
-		if (imx900->g_ctx.num_streams <= 0) {
-			dev_err(dev, "No streams found\n");
-			ret = -EINVAL;
-			return ret;
-		}
-
-		for (i = 0; i < imx900->g_ctx.num_streams; i++) {
-			of_property_read_string_index(gmsl, "streams",
-							i, &str_value1[i]);
-			if (!str_value1[i]) {
-				dev_err(dev, "invalid stream info\n");
-				return ret;
-			}
-			if (!strcmp(str_value1[i], "raw12")) {
-				imx900->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_RAW_12;
-			} else if (!strcmp(str_value1[i], "embed")) {
-				imx900->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_EMBED;
-			} else if (!strcmp(str_value1[i], "ued-u1")) {
-				imx900->g_ctx.streams[i].st_data_type = GMSL_CSI_DT_UED_U1;
-			} else {
-				dev_err(dev, "invalid stream data type\n");
-				return ret;
-			}
-		}
-
-		imx900->g_ctx.s_dev = dev;
-
-		ret = max96793_sdev_pair(imx900->ser_dev, &imx900->g_ctx);
-		if (ret) {
-			dev_err(dev, "gmsl ser pairing failed\n");
-			return ret;
-		}
-
-		ret = max96792_sdev_register(imx900->dser_dev, &imx900->g_ctx);
-		if (ret) {
-			dev_err(dev, "gmsl deserializer register failed\n");
-			return ret;
-		}
+	ret = fr_sensor_probe(&imx900->core);
+	if (ret)
+		return ret;
 
-		ret = imx900_gmsl_serdes_setup(imx900);
+	if (fr_sensor_is_gmsl(&imx900->core)) {
+		ret = fr_sensor_gmsl_serdes_setup(&imx900->core);
 		if (ret) {
 			dev_err(dev, "%s gmsl serdes setup failed\n", __func__);
 			return ret;
 		}
-
 	}
 
-	ret = imx900_power_on(dev);
+	ret = fr_sensor_runtime_resume(dev);
 	if (ret)
 		return ret;
 
@@ -2694,52 +2732,76 @@ static int imx900_probe(struct i2c_client *client)
 		return PTR_ERR(imx900->xmaster);
 	}
 
+	ret = fr_sensor_xvs_init(&imx900->core);
+	if (ret)
+		goto error_power_off;
+
+	ret = imx900_trigger_init(imx900);
+	if (ret)
+		goto error_power_off;
+
+	INIT_DELAYED_WORK(&imx900->trigger_work, imx900_trigger_work);
+
 	imx900->mode = &modes_12bit[0];
+	imx900->crop = imx900->mode->crop;
 	if (imx900->chromacity == IMX900_COLOR)
-		imx900->fmt_code = MEDIA_BUS_FMT_SRGGB12_1X12;
+		imx900->core.fmt_code = MEDIA_BUS_FMT_SRGGB12_1X12;
 	else
-		imx900->fmt_code = MEDIA_BUS_FMT_Y12_1X12;
+		imx900->core.fmt_code = MEDIA_BUS_FMT_Y12_1X12;
 
-	pm_runtime_set_active(dev);
-	pm_runtime_enable(dev);
-	pm_runtime_idle(dev);
+	fr_sensor_pm_enable(&imx900->core);
 
 	ret = imx900_init_controls(imx900);
 	if (ret)
-		goto error_power_off;
+		goto error_pm_disable;
 
-	imx900->sd.internal_ops = &imx900_internal_ops;
-	imx900->sd.flags |= V4L2_SUBDEV_FL_HAS_DEVNODE |
+	imx900->core.sd.internal_ops = &imx900_internal_ops;
+	imx900->core.sd.flags |= V4L2_SUBDEV_FL_HAS_DEVNODE |
 				V4L2_SUBDEV_FL_HAS_EVENTS;
-	imx900->sd.entity.function = MEDIA_ENT_F_CAM_SENSOR;
+	imx900->core.sd.entity.function = MEDIA_ENT_F_CAM_SENSOR;
 
 	imx900->pad[IMAGE_PAD].flags = MEDIA_PAD_FL_SOURCE;
 	imx900->pad[METADATA_PAD].flags = MEDIA_PAD_FL_SOURCE;
 
-	ret = media_entity_pads_init(&imx900->sd.entity, NUM_PADS, imx900->pad);
+	ret = media_entity_pads_init(&imx900->core.sd.entity, NUM_PADS,
+				     imx900->pad);
 	if (ret) {
 		dev_err(dev, "failed to init entity pads: %d\n", ret);
 		goto error_handler_free;
 	}
 
-	ret = v4l2_async_register_subdev_sensor(&imx900->sd);
+	ret = fr_sensor_join_sync_group(&imx900->core);
+	if (ret)
+		goto error_media_entity;
+
+	ret = v4l2_async_register_subdev_sensor(&imx900->core.sd);
 	if (ret < 0) {
 		dev_err(dev, "failed to register sensor sub-device: %d\n", ret);
-		goto error_media_entity;
+		goto error_sync_leave;
 	}
 
+	imx900_debugfs_init(imx900);
+
 	return 0;
 
+error_sync_leave:
+	fr_sync_group_leave(&imx900->core.sync);
+
 error_media_entity:
-	media_entity_cleanup(&imx900->sd.entity);
+	media_entity_cleanup(&imx900->core.sd.entity);
 
 error_handler_free:
 	imx900_free_controls(imx900);
 
+error_pm_disable:
+	fr_sensor_pm_disable(&imx900->core);
+	mutex_destroy(&imx900->core.mutex);
+
+	return ret;
+
 error_power_off:
-	pm_runtime_disable(&client->dev);
-	pm_runtime_set_suspended(&client->dev);
-	imx900_power_off(&client->dev);
+	fr_sensor_runtime_suspend(&client->dev);
+	mutex_destroy(&imx900->core.mutex);
 
 	return ret;
 }
@@ -2749,35 +2811,40 @@ static void imx900_remove(struct i2c_client *client)
 	struct v4l2_subdev *sd = i2c_get_clientdata(client);
 	struct imx900 *imx900 = to_imx900(sd);
 
-	if (!(strcmp(imx900->gmsl, "gmsl"))) {
-		max96792_sdev_unregister(imx900->dser_dev, &client->dev);
-		imx900_gmsl_serdes_reset(imx900);
-	}
+	cancel_delayed_work_sync(&imx900->core.stage_work);
+	cancel_delayed_work_sync(&imx900->trigger_work);
 
+	mutex_lock(&imx900->core.mutex);
+	fr_sensor_remove(&imx900->core);
+	mutex_unlock(&imx900->core.mutex);
+
+	debugfs_remove_recursive(imx900->debugfs);
 	v4l2_async_unregister_subdev(sd);
+	fr_sync_group_leave(&imx900->core.sync);
 	media_entity_cleanup(&sd->entity);
 	imx900_free_controls(imx900);
 
-	pm_runtime_disable(&client->dev);
-	if (!pm_runtime_status_suspended(&client->dev))
-		imx900_power_off(&client->dev);
-	pm_runtime_set_suspended(&client->dev);
+	fr_sensor_pm_disable(&imx900->core);
+	mutex_destroy(&imx900->core.mutex);
 }
 
 MODULE_DEVICE_TABLE(of, imx900_dt_ids);
 
-static const struct dev_pm_ops imx900_pm_ops = {
-	SET_SYSTEM_SLEEP_PM_OPS(imx900_suspend, imx900_resume)
-	SET_RUNTIME_PM_OPS(imx900_power_off, imx900_power_on, NULL)
+/* Lets the sensor be instantiated without device tree, from software nodes */
+static const struct i2c_device_id imx900_id[] = {
+	{ "fr_imx900" },
+	{ }
 };
+MODULE_DEVICE_TABLE(i2c, imx900_id);
 
 static struct i2c_driver imx900_i2c_driver = {
 	.driver = {
 		.name = "fr_imx900",
 		.of_match_table	= imx900_dt_ids,
-		.pm = &imx900_pm_ops,
+		.pm = &fr_sensor_pm_ops,
 	},
 	.probe = imx900_probe,
+	.id_table = imx900_id,
 	.remove = imx900_remove,
 };
 
@@ -2786,3 +2853,7 @@ module_i2c_driver(imx900_i2c_driver);
 MODULE_AUTHOR("FRAMOS GmbH");
 MODULE_DESCRIPTION("Sony IMX900 sensor driver");
 MODULE_LICENSE("GPL v2");
+
+#if IS_ENABLED(CONFIG_VIDEO_FR_IMX900_KUNIT_TEST)
+#include "fr_imx900_kunit.c"
+#endif
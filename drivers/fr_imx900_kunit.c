@@ -0,0 +1,410 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_imx900_kunit.c - KUnit tests of the IMX900 timing math
+ *
+ * Included from fr_imx900.c when CONFIG_VIDEO_FR_IMX900_KUNIT_TEST is set,
+ * so that the static helpers can be tested as they are. Every mode of
+ * modes_12bit, modes_10bit and modes_8bit is checked on the color and the
+ * mono sensor variant. The sensor is never accessed: runtime PM of the test
+ * device stays disabled, so the control handlers only update the limits.
+ *
+ * Run with:
+ *   ./tools/testing/kunit/kunit.py run --kunitconfig=<path to drivers>
+ */
+
+#include <kunit/test.h>
+
+#define IMX900_KUNIT_FPS_SCALE		(IMX900_M_FACTOR * IMX900_G_FACTOR)
+
+struct imx900_kunit_table {
+	const struct imx900_mode *modes;
+	unsigned int num_modes;
+	u32 codes[2];
+};
+
+static const struct imx900_kunit_table imx900_kunit_tables[] = {
+	{
+		.modes = modes_12bit,
+		.num_modes = ARRAY_SIZE(modes_12bit),
+		.codes = {
+			[IMX900_COLOR] = MEDIA_BUS_FMT_SRGGB12_1X12,
+			[IMX900_MONO] = MEDIA_BUS_FMT_Y12_1X12,
+		},
+	},
+	{
+		.modes = modes_10bit,
+		.num_modes = ARRAY_SIZE(modes_10bit),
+		.codes = {
+			[IMX900_COLOR] = MEDIA_BUS_FMT_SRGGB10_1X10,
+			[IMX900_MONO] = MEDIA_BUS_FMT_Y10_1X10,
+		},
+	},
+	{
+		.modes = modes_8bit,
+		.num_modes = ARRAY_SIZE(modes_8bit),
+		.codes = {
+			[IMX900_COLOR] = MEDIA_BUS_FMT_SRGGB8_1X8,
+			[IMX900_MONO] = MEDIA_BUS_FMT_Y8_1X8,
+		},
+	},
+};
+
+#define imx900_kunit_for_each_mode(table, mode, chroma)			\
+	for (table = imx900_kunit_tables;					\
+	     table < imx900_kunit_tables + ARRAY_SIZE(imx900_kunit_tables);	\
+	     table++)								\
+		for (mode = table->modes;					\
+		     mode < table->modes + table->num_modes; mode++)		\
+			for (chroma = IMX900_COLOR; chroma <= IMX900_MONO;	\
+			     chroma++)
+
+static void imx900_kunit_release(struct device *dev)
+{
+}
+
+static int imx900_kunit_init(struct kunit *test)
+{
+	struct v4l2_ctrl_handler *ctrl_hdlr;
+	struct i2c_client *client;
+	struct imx900 *imx900;
+
+	client = kunit_kzalloc(test, sizeof(*client), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, client);
+
+	imx900 = kunit_kzalloc(test, sizeof(*imx900), GFP_KERNEL);
+	KUNIT_ASSERT_NOT_NULL(test, imx900);
+
+	/* Runtime PM starts disabled, so no control is written to the sensor */
+	device_initialize(&client->dev);
+	client->dev.release = imx900_kunit_release;
+	dev_set_name(&client->dev, "imx900-kunit");
+
+	v4l2_set_subdevdata(&imx900->core.sd, client);
+	fr_sensor_init(&imx900->core, client, &imx900_desc);
+
+	ctrl_hdlr = &imx900->ctrl_handler;
+	v4l2_ctrl_handler_init(ctrl_hdlr, 8);
+	ctrl_hdlr->lock = &imx900->core.mutex;
+
+	imx900->pixel_rate = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
+						V4L2_CID_PIXEL_RATE, 0, 0, 1, 0);
+	imx900->link_freq =
+		v4l2_ctrl_new_int_menu(ctrl_hdlr, &imx900_ctrl_ops,
+					V4L2_CID_LINK_FREQ,
+					ARRAY_SIZE(imx900_link_freq_menu) - 1, 0,
+					imx900_link_freq_menu);
+	imx900->core.vblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
+					V4L2_CID_VBLANK, 0, 0, 1, 0);
+	imx900->core.hblank = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
+					V4L2_CID_HBLANK, 0, 0, 1, 0);
+	imx900->exposure = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
+					V4L2_CID_EXPOSURE,
+					IMX900_MIN_INTEGRATION_LINES,
+					0xFF, 1, 0xFF);
+	imx900->exposure_priority = v4l2_ctrl_new_std(ctrl_hdlr,
+					&imx900_ctrl_ops,
+					V4L2_CID_EXPOSURE_AUTO_PRIORITY,
+					0, 1, 1, 0);
+	imx900->core.framerate = v4l2_ctrl_new_custom(ctrl_hdlr,
+					imx900_ctrl_framerate, NULL);
+	imx900->blklvl = v4l2_ctrl_new_std(ctrl_hdlr, &imx900_ctrl_ops,
+					V4L2_CID_BLACK_LEVEL,
+					IMX900_BLACK_LEVEL_MIN, 0xFF,
+					IMX900_BLACK_LEVEL_STEP, 0xFF);
+
+	if (ctrl_hdlr->error) {
+		int ret = ctrl_hdlr->error;
+
+		v4l2_ctrl_handler_free(ctrl_hdlr);
+		mutex_destroy(&imx900->core.mutex);
+		put_device(&client->dev);
+		KUNIT_FAIL(test, "control init failed (%d)", ret);
+		return ret;
+	}
+
+	test->priv = imx900;
+
+	return 0;
+}
+
+static void imx900_kunit_exit(struct kunit *test)
+{
+	struct imx900 *imx900 = test->priv;
+	struct i2c_client *client;
+
+	if (!imx900)
+		return;
+
+	client = v4l2_get_subdevdata(&imx900->core.sd);
+
+	v4l2_ctrl_handler_free(&imx900->ctrl_handler);
+	mutex_destroy(&imx900->core.mutex);
+	put_device(&client->dev);
+}
+
+/* Same path as a format change, called with the mutex held */
+static void imx900_kunit_set_mode(struct imx900 *imx900,
+				  const struct imx900_kunit_table *table,
+				  const struct imx900_mode *mode, u8 chroma)
+{
+	imx900->mode = mode;
+	imx900->crop = mode->crop;
+	imx900->core.fmt_code = table->codes[chroma];
+	imx900->chromacity = chroma;
+	imx900_set_limits(imx900);
+}
+
+#define IMX900_KUNIT_MODE_FMT		"%ux%u type %u %s"
+#define IMX900_KUNIT_MODE_ARGS(mode, chroma)				\
+	(mode)->width, (mode)->height, (mode)->type,			\
+	(chroma) == IMX900_COLOR ? "color" : "mono"
+
+/* The frame length must be the longest one that still meets the frame rate */
+static void imx900_kunit_check_frame_length(struct kunit *test,
+					    struct imx900 *imx900, u64 fps,
+					    const struct imx900_mode *mode,
+					    u8 chroma)
+{
+	u64 frame_time = (u64)imx900->core.frame_length * imx900->core.line_time;
+	u64 requested = div64_u64(IMX900_KUNIT_FPS_SCALE, fps);
+
+	KUNIT_EXPECT_LE_MSG(test, frame_time, requested,
+			    IMX900_KUNIT_MODE_FMT " at %llu ufps",
+			    IMX900_KUNIT_MODE_ARGS(mode, chroma), fps);
+	KUNIT_EXPECT_GT_MSG(test, frame_time + imx900->core.line_time, requested,
+			    IMX900_KUNIT_MODE_FMT " at %llu ufps",
+			    IMX900_KUNIT_MODE_ARGS(mode, chroma), fps);
+
+	KUNIT_EXPECT_GE_MSG(test, imx900->core.frame_length,
+			    imx900_min_frame_length(imx900),
+			    IMX900_KUNIT_MODE_FMT " at %llu ufps",
+			    IMX900_KUNIT_MODE_ARGS(mode, chroma), fps);
+	KUNIT_EXPECT_LE_MSG(test, imx900->core.frame_length, IMX900_VMAX_MAX,
+			    IMX900_KUNIT_MODE_FMT " at %llu ufps",
+			    IMX900_KUNIT_MODE_ARGS(mode, chroma), fps);
+	KUNIT_EXPECT_EQ_MSG(test, imx900->core.vblank->val,
+			    imx900->core.frame_length - mode->height,
+			    IMX900_KUNIT_MODE_FMT " at %llu ufps",
+			    IMX900_KUNIT_MODE_ARGS(mode, chroma), fps);
+}
+
+static void imx900_kunit_limits(struct kunit *test)
+{
+	struct imx900 *imx900 = test->priv;
+	const struct imx900_kunit_table *table;
+	const struct imx900_mode *mode;
+	u8 chroma;
+
+	mutex_lock(&imx900->core.mutex);
+
+	imx900_kunit_for_each_mode(table, mode, chroma) {
+		imx900_kunit_set_mode(imx900, table, mode, chroma);
+
+		KUNIT_EXPECT_PTR_EQ(test, imx900->timing,
+				    &imx900_timings[mode->type][chroma]);
+		KUNIT_EXPECT_GT_MSG(test, imx900->core.line_time, 0ULL,
+				    IMX900_KUNIT_MODE_FMT,
+				    IMX900_KUNIT_MODE_ARGS(mode, chroma));
+		KUNIT_EXPECT_EQ_MSG(test, *imx900->pixel_rate->p_cur.p_s64,
+				    (s64)imx900->timing->pixel_rate,
+				    IMX900_KUNIT_MODE_FMT,
+				    IMX900_KUNIT_MODE_ARGS(mode, chroma));
+		KUNIT_EXPECT_GT_MSG(test, imx900_min_frame_length(imx900),
+				    imx900->timing->min_shs_length +
+				    IMX900_MIN_INTEGRATION_LINES,
+				    IMX900_KUNIT_MODE_FMT,
+				    IMX900_KUNIT_MODE_ARGS(mode, chroma));
+
+		/* Non-empty frame rate range, starting at the fastest rate */
+		KUNIT_EXPECT_GT_MSG(test, imx900->core.framerate->maximum, 0LL,
+				    IMX900_KUNIT_MODE_FMT,
+				    IMX900_KUNIT_MODE_ARGS(mode, chroma));
+		KUNIT_EXPECT_LE_MSG(test, imx900->core.framerate->minimum,
+				    imx900->core.framerate->maximum,
+				    IMX900_KUNIT_MODE_FMT,
+				    IMX900_KUNIT_MODE_ARGS(mode, chroma));
+		KUNIT_EXPECT_EQ_MSG(test, imx900->core.framerate->val,
+				    imx900->core.framerate->maximum,
+				    IMX900_KUNIT_MODE_FMT,
+				    IMX900_KUNIT_MODE_ARGS(mode, chroma));
+
+		imx900_kunit_check_frame_length(test, imx900,
+					imx900->core.framerate->val, mode, chroma);
+	}
+
+	mutex_unlock(&imx900->core.mutex);
+}
+
+static void imx900_kunit_frame_rate(struct kunit *test)
+{
+	struct imx900 *imx900 = test->priv;
+	const struct imx900_kunit_table *table;
+	const struct imx900_mode *mode;
+	u64 rates[4];
+	unsigned int i;
+	u8 chroma;
+
+	mutex_lock(&imx900->core.mutex);
+
+	imx900_kunit_for_each_mode(table, mode, chroma) {
+		imx900_kunit_set_mode(imx900, table, mode, chroma);
+
+		rates[0] = imx900->core.framerate->minimum;
+		rates[1] = imx900->core.framerate->maximum;
+		rates[2] = (rates[0] + rates[1]) / 2;
+		rates[3] = clamp_t(u64, 30 * IMX900_M_FACTOR, rates[0],
+								rates[1]);
+
+		for (i = 0; i < ARRAY_SIZE(rates); i++) {
+			/* Move away first, so that every rate is applied */
+			__v4l2_ctrl_s_ctrl(imx900->core.framerate,
+					   i ? rates[0] : rates[1]);
+			__v4l2_ctrl_s_ctrl(imx900->core.framerate, rates[i]);
+
+			KUNIT_EXPECT_EQ(test, (u64)imx900->core.framerate->val,
+								rates[i]);
+			imx900_kunit_check_frame_length(test, imx900, rates[i],
+								mode, chroma);
+		}
+	}
+
+	mutex_unlock(&imx900->core.mutex);
+}
+
+static void imx900_kunit_check_exposure(struct kunit *test,
+					struct imx900 *imx900,
+					const struct imx900_mode *mode,
+					u8 chroma)
+{
+	KUNIT_EXPECT_GT_MSG(test, imx900->exposure->maximum,
+			    imx900->exposure->minimum,
+			    IMX900_KUNIT_MODE_FMT " at vblank %d",
+			    IMX900_KUNIT_MODE_ARGS(mode, chroma),
+			    imx900->core.vblank->val);
+	KUNIT_EXPECT_LE_MSG(test, imx900->exposure->default_value,
+			    imx900->exposure->maximum,
+			    IMX900_KUNIT_MODE_FMT " at vblank %d",
+			    IMX900_KUNIT_MODE_ARGS(mode, chroma),
+			    imx900->core.vblank->val);
+	KUNIT_EXPECT_LT_MSG(test, imx900->exposure->maximum,
+			    (s64)IMX900_VMAX_MAX,
+			    IMX900_KUNIT_MODE_FMT " at vblank %d",
+			    IMX900_KUNIT_MODE_ARGS(mode, chroma),
+			    imx900->core.vblank->val);
+}
+
+static void imx900_kunit_exposure_range(struct kunit *test)
+{
+	struct imx900 *imx900 = test->priv;
+	const struct imx900_kunit_table *table;
+	const struct imx900_mode *mode;
+	s64 exposure_def;
+	u8 chroma;
+
+	mutex_lock(&imx900->core.mutex);
+
+	imx900_kunit_for_each_mode(table, mode, chroma) {
+		__v4l2_ctrl_s_ctrl(imx900->exposure_priority, 0);
+		imx900_kunit_set_mode(imx900, table, mode, chroma);
+		imx900_adjust_exposure_range(imx900);
+
+		/* Fastest frame rate: the shortest frame still fits exposure */
+		imx900_kunit_check_exposure(test, imx900, mode, chroma);
+		KUNIT_EXPECT_EQ_MSG(test, imx900->exposure->maximum,
+				    (s64)imx900->core.frame_length -
+				    imx900->timing->min_shs_length,
+				    IMX900_KUNIT_MODE_FMT,
+				    IMX900_KUNIT_MODE_ARGS(mode, chroma));
+
+		/* Slowest frame rate */
+		__v4l2_ctrl_s_ctrl(imx900->core.framerate,
+				   imx900->core.framerate->minimum);
+		imx900_adjust_exposure_range(imx900);
+		imx900_kunit_check_exposure(test, imx900, mode, chroma);
+		exposure_def = imx900->exposure->default_value;
+
+		/* Exposure priority may only extend the range */
+		__v4l2_ctrl_s_ctrl(imx900->core.framerate,
+				   imx900->core.framerate->maximum);
+		__v4l2_ctrl_s_ctrl(imx900->exposure_priority, 1);
+		imx900_adjust_exposure_range(imx900);
+		imx900_kunit_check_exposure(test, imx900, mode, chroma);
+		KUNIT_EXPECT_GE_MSG(test, imx900->exposure->maximum,
+				    exposure_def,
+				    IMX900_KUNIT_MODE_FMT,
+				    IMX900_KUNIT_MODE_ARGS(mode, chroma));
+	}
+
+	__v4l2_ctrl_s_ctrl(imx900->exposure_priority, 0);
+
+	mutex_unlock(&imx900->core.mutex);
+}
+
+static void imx900_kunit_frame_interval(struct kunit *test)
+{
+	static const struct v4l2_fract intervals[] = {
+		{ 1, 30 }, { 1001, 30000 }, { 1, 25 }, { 1, 10 },
+	};
+	struct imx900 *imx900 = test->priv;
+	const struct imx900_kunit_table *table;
+	const struct imx900_mode *mode;
+	u64 fps, frame, target;
+	unsigned int i;
+	u32 hmax, vmax;
+	u8 chroma;
+
+	mutex_lock(&imx900->core.mutex);
+
+	imx900_kunit_for_each_mode(table, mode, chroma) {
+		imx900_kunit_set_mode(imx900, table, mode, chroma);
+
+		for (i = 0; i < ARRAY_SIZE(intervals); i++) {
+			fps = div_u64((u64)intervals[i].denominator *
+				      IMX900_M_FACTOR, intervals[i].numerator);
+			if (fps < imx900->core.framerate->minimum ||
+			    fps > imx900->core.framerate->maximum)
+				continue;
+
+			fr_sensor_find_frame_timing(&imx900->core,
+						    &intervals[i], &hmax, &vmax);
+
+			KUNIT_EXPECT_GE(test, hmax, imx900->timing->hmax);
+			KUNIT_EXPECT_LE(test, hmax, IMX900_HMAX_MAX);
+			KUNIT_EXPECT_GE(test, vmax,
+					imx900_min_frame_length(imx900));
+			KUNIT_EXPECT_LE(test, vmax, IMX900_VMAX_MAX);
+
+			/* Within one line of the requested interval */
+			frame = (u64)hmax * vmax * intervals[i].denominator;
+			target = (u64)IMX900_XCLK_FREQ * intervals[i].numerator;
+			KUNIT_EXPECT_LE_MSG(test,
+				frame > target ? frame - target : target - frame,
+				(u64)hmax * intervals[i].denominator,
+				IMX900_KUNIT_MODE_FMT " at %u/%u s",
+				IMX900_KUNIT_MODE_ARGS(mode, chroma),
+				intervals[i].numerator,
+				intervals[i].denominator);
+		}
+	}
+
+	mutex_unlock(&imx900->core.mutex);
+}
+
+static struct kunit_case imx900_kunit_cases[] = {
+	KUNIT_CASE(imx900_kunit_limits),
+	KUNIT_CASE(imx900_kunit_frame_rate),
+	KUNIT_CASE(imx900_kunit_exposure_range),
+	KUNIT_CASE(imx900_kunit_frame_interval),
+	{}
+};
+
+static struct kunit_suite imx900_kunit_suite = {
+	.name = "fr_imx900_timing",
+	.init = imx900_kunit_init,
+	.exit = imx900_kunit_exit,
+	.test_cases = imx900_kunit_cases,
+};
+
+kunit_test_suite(imx900_kunit_suite);
@@ -5,6 +5,8 @@
  * fr_imx900_regs.h - imx900 sensor mode tables
  */
 
+#include "fr_sensor_core.h"
+
 #define STANDBY			0x3000
 #define XMSTA			0x3010
 
@@ -63,6 +65,9 @@
 #define GPO0EXPSSEL_GPO1EXPSSEL	0x3436
 #define GPO2EXPSSEL		0x3437
 
+#define GPO_EXPSSEL_OFF		0x0
+#define GPO_EXPSSEL_EXPOSURE	0x1
+
 #define SYNCSEL			0x343C
 
 #define GAIN_RTS		0x3502
@@ -157,15 +162,10 @@
 #define IMX900_BINNING_CROP_MODE_HEIGHT		720
 
 
-struct imx900_reg {
-	u16 address;
-	u8 val;
-};
-
 #define IMX900_TO_LOW_BYTE(x) (x & 0xFF)
 #define IMX900_TO_MID_BYTE(x) (x >> 8)
 
-static const struct imx900_reg mode_common_regs[] = {
+static const struct fr_sensor_reg mode_common_regs[] = {
 
 	/* 37.125MHz */
 	{INCKSEL_ST0,		0x1E},
@@ -331,8 +331,6 @@ static const struct imx900_reg mode_common_regs[] = {
 	{0x5338,		0x48},
 	{0x533A,		0x52},
 
-	{0x54D6,		0x00},
-
 	{0x5545,		0xA7},
 	{0x5546,		0x14},
 	{0x5547,		0x14},
@@ -380,7 +378,6 @@ static const struct imx900_reg mode_common_regs[] = {
 	{0x590E,		0xC4},
 	{0x590F,		0x09},
 	{0x5939,		0x08},
-	{0x59AC,		0x00},
 	{0x59C1,		0x00},
 	{0x59D4,		0x00},
 
@@ -388,7 +385,6 @@ static const struct imx900_reg mode_common_regs[] = {
 	{0x5B81,		0x36},
 	{0x5BB5,		0x09},
 	{0x5BC9,		0x11},
-	{0x5BCC,		0x00},
 	{0x5BD8,		0x00},
 	{0x5BD9,		0x00},
 	{0x5BDC,		0x1D},
@@ -553,7 +549,7 @@ static const struct imx900_reg mode_common_regs[] = {
 
 };
 
-static const struct imx900_reg raw12_framefmt_regs[] = {
+static const struct fr_sensor_reg raw12_framefmt_regs[] = {
 
 	{ODBIT,		0x01},
 
@@ -562,7 +558,7 @@ static const struct imx900_reg raw12_framefmt_regs[] = {
 
 };
 
-static const struct imx900_reg raw10_framefmt_regs[] = {
+static const struct fr_sensor_reg raw10_framefmt_regs[] = {
 
 	{ODBIT,		0x00},
 
@@ -571,7 +567,7 @@ static const struct imx900_reg raw10_framefmt_regs[] = {
 
 };
 
-static const struct imx900_reg raw8_framefmt_regs[] = {
+static const struct fr_sensor_reg raw8_framefmt_regs[] = {
 
 	{ODBIT,		0x02},
 
@@ -581,7 +577,7 @@ static const struct imx900_reg raw8_framefmt_regs[] = {
 };
 
 /* All-pixel mode */
-static const struct imx900_reg mode_2064x1552[] = {
+static const struct fr_sensor_reg mode_2064x1552[] = {
 
 	{HVMODE,	0x00},
 
@@ -595,7 +591,7 @@ static const struct imx900_reg mode_2064x1552[] = {
 };
 
 /* ROI mode */
-static const struct imx900_reg mode_1920x1080[] = {
+static const struct fr_sensor_reg mode_1920x1080[] = {
 
 	{HVMODE,	0x00},
 
@@ -620,7 +616,7 @@ static const struct imx900_reg mode_1920x1080[] = {
 };
 
 /* Subsampling 1/2 mode */
-static const struct imx900_reg mode_1032x776[] = {
+static const struct fr_sensor_reg mode_1032x776[] = {
 
 	{HVMODE,	0x08},
 
@@ -634,7 +630,7 @@ static const struct imx900_reg mode_1032x776[] = {
 };
 
 /* Subsampling 1/10 mode */
-static const struct imx900_reg mode_2064x154[] = {
+static const struct fr_sensor_reg mode_2064x154[] = {
 
 	{HVMODE,	0x18},
 
@@ -648,7 +644,7 @@ static const struct imx900_reg mode_2064x154[] = {
 };
 
 /* Binning-crop mode */
-static const struct imx900_reg mode_1024x720[] = {
+static const struct fr_sensor_reg mode_1024x720[] = {
 
 	{HVMODE,	0x10},
 
@@ -672,7 +668,7 @@ static const struct imx900_reg mode_1024x720[] = {
 
 };
 
-static const struct imx900_reg imx900_1485_mbps[] = {
+static const struct fr_sensor_reg imx900_1485_mbps[] = {
 
 	{SCAL_INIT_EN,		0x00},
 	{THS_PREPARE_LOW,	0x5F},
@@ -700,7 +696,7 @@ static const struct imx900_reg imx900_1485_mbps[] = {
 
 };
 
-static const struct imx900_reg imx900_1188_mbps[] = {
+static const struct fr_sensor_reg imx900_1188_mbps[] = {
 
 	{SCAL_INIT_EN,		0x00},
 	{THS_PREPARE_LOW,	0x4F},
@@ -728,7 +724,7 @@ static const struct imx900_reg imx900_1188_mbps[] = {
 
 };
 
-static const struct imx900_reg imx900_891_mbps[] = {
+static const struct fr_sensor_reg imx900_891_mbps[] = {
 
 	{SCAL_INIT_EN,		0x00},
 	{THS_PREPARE_LOW,	0x3F},
@@ -757,7 +753,7 @@ static const struct imx900_reg imx900_891_mbps[] = {
 };
 
 /* all pixel and roi mode common for color and mono */
-static const struct imx900_reg mode_allPixel_roi[] = {
+static const struct fr_sensor_reg mode_allPixel_roi[] = {
 
 	{LLBLANK_LOW,	0x0F},
 	{LLBLANK_HIGH,	0x00},
@@ -768,7 +764,7 @@ static const struct imx900_reg mode_allPixel_roi[] = {
 
 };
 
-static const struct imx900_reg mode_subg2_color[] = {
+static const struct fr_sensor_reg mode_subg2_color[] = {
 
 	{LLBLANK_LOW,	0x0B},
 	{LLBLANK_HIGH,	0x00},
@@ -780,7 +776,7 @@ static const struct imx900_reg mode_subg2_color[] = {
 };
 
 /* 1/2 subsampling for mono and binning for mono settings are common */
-static const struct imx900_reg mode_sub2_binning_mono[] = {
+static const struct fr_sensor_reg mode_sub2_binning_mono[] = {
 
 	{LLBLANK_LOW,	0x0D},
 	{LLBLANK_HIGH,	0x00},
@@ -792,7 +788,7 @@ static const struct imx900_reg mode_sub2_binning_mono[] = {
 };
 
 /* 1/10 subsampling settings common for color and mono */
-static const struct imx900_reg mode_sub10[] = {
+static const struct fr_sensor_reg mode_sub10[] = {
 
 	{LLBLANK_LOW,	0x0B},
 	{LLBLANK_HIGH,	0x00},
@@ -803,7 +799,7 @@ static const struct imx900_reg mode_sub10[] = {
 
 };
 
-static const struct imx900_reg allpix_roi_sub10_1485MBPS_1x12_4lane[] = {
+static const struct fr_sensor_reg allpix_roi_sub10_1485MBPS_1x12_4lane[] = {
 
 	{GMRWT,		0x11},
 	{GMTWT,		0x27},
@@ -816,7 +812,7 @@ static const struct imx900_reg allpix_roi_sub10_1485MBPS_1x12_4lane[] = {
 
 };
 
-static const struct imx900_reg allpix_roi_sub10_1188MBPS_1x10_4lane[] = {
+static const struct fr_sensor_reg allpix_roi_sub10_1188MBPS_1x10_4lane[] = {
 
 	{GMRWT,		0x1B},
 	{GMTWT,		0x3E},
@@ -829,7 +825,7 @@ static const struct imx900_reg allpix_roi_sub10_1188MBPS_1x10_4lane[] = {
 
 };
 
-static const struct imx900_reg allpix_roi_sub10_891MBPS_1x10_4lane[] = {
+static const struct fr_sensor_reg allpix_roi_sub10_891MBPS_1x10_4lane[] = {
 
 	{GMRWT,		0x15},
 	{GMTWT,		0x2F},
@@ -842,7 +838,7 @@ static const struct imx900_reg allpix_roi_sub10_891MBPS_1x10_4lane[] = {
 
 };
 
-static const struct imx900_reg allpix_roi_sub10_891MBPS_1x8_4lane[] = {
+static const struct fr_sensor_reg allpix_roi_sub10_891MBPS_1x8_4lane[] = {
 
 	{GMRWT,		0x19},
 	{GMTWT,		0x39},
@@ -855,7 +851,7 @@ static const struct imx900_reg allpix_roi_sub10_891MBPS_1x8_4lane[] = {
 
 };
 
-static const struct imx900_reg sub2_color_1485MBPS_1x12_4lane[] = {
+static const struct fr_sensor_reg sub2_color_1485MBPS_1x12_4lane[] = {
 
 	{GMRWT,		0x11},
 	{GMTWT,		0x27},
@@ -868,7 +864,7 @@ static const struct imx900_reg sub2_color_1485MBPS_1x12_4lane[] = {
 
 };
 
-static const struct imx900_reg sub2_color_1485MBPS_1x10_4lane[] = {
+static const struct fr_sensor_reg sub2_color_1485MBPS_1x10_4lane[] = {
 
 	{GMRWT,		0x1C},
 	{GMTWT,		0x40},
@@ -881,7 +877,7 @@ static const struct imx900_reg sub2_color_1485MBPS_1x10_4lane[] = {
 
 };
 
-static const struct imx900_reg sub2_color_1485MBPS_1x8_4lane[] = {
+static const struct fr_sensor_reg sub2_color_1485MBPS_1x8_4lane[] = {
 
 	{GMRWT,		0x1E},
 	{GMTWT,		0x45},
@@ -894,7 +890,7 @@ static const struct imx900_reg sub2_color_1485MBPS_1x8_4lane[] = {
 
 };
 
-static const struct imx900_reg sub2_binning_mono_1485MBPS_1x12_4lane[] = {
+static const struct fr_sensor_reg sub2_binning_mono_1485MBPS_1x12_4lane[] = {
 
 	{GMRWT,		0x22},
 	{GMTWT,		0x4E},
@@ -907,7 +903,7 @@ static const struct imx900_reg sub2_binning_mono_1485MBPS_1x12_4lane[] = {
 
 };
 
-static const struct imx900_reg sub2_binning_mono_1188MBPS_1x10_4lane[] = {
+static const struct fr_sensor_reg sub2_binning_mono_1188MBPS_1x10_4lane[] = {
 
 	{GMRWT,		0x30},
 	{GMTWT,		0x6C},
@@ -920,7 +916,7 @@ static const struct imx900_reg sub2_binning_mono_1188MBPS_1x10_4lane[] = {
 
 };
 
-static const struct imx900_reg sub2_binning_mono_891MBPS_1x8_4lane[] = {
+static const struct fr_sensor_reg sub2_binning_mono_891MBPS_1x8_4lane[] = {
 
 	{GMRWT,		0x2C},
 	{GMTWT,		0x62},
@@ -969,6 +965,13 @@ enum {
 	FAST_TRIGGER_MODE,
 } sync_mode;
 
+enum {
+	STROBE_DISABLED,
+	STROBE_GPO0,
+	STROBE_GPO1,
+	STROBE_GPO2,
+};
+
 enum {
 	IMX900_COLOR,
 	IMX900_MONO,
@@ -15,10 +15,12 @@
 #include <linux/of.h>
 #include <linux/of_device.h>
 #include <linux/of_gpio.h>
+#include <linux/property.h>
 #include <linux/regmap.h>
 #include <linux/version.h>
 
 #include "fr_max96792.h"
+#include "fr_trace.h"
 
 #define MAX96792_DST_CSI_MODE_ADDR	0x330
 #define MAX96792_LANE_MAP1_ADDR		0x333
@@ -79,6 +81,11 @@
 #define GPIO_OUT_DIS			0x01
 #define GPIO_TX_EN			(0x01 << 1)
 #define GPIO_RX_EN			(0x01 << 2)
+#define GPIO_ID_MASK			0x1F
+
+#define MAX96792_GPIO_A(n)		(0x2B0 + 3 * (n))
+#define MAX96792_GPIO_B(n)		(0x2B1 + 3 * (n))
+#define MAX96792_GPIO_C(n)		(0x2B2 + 3 * (n))
 
 #define VIDEO_PIPE_EN			0x160
 #define VIDEO_PIPE_SEL			0x161
@@ -122,11 +129,14 @@ static int max96792_write_reg(struct device *dev,
 	u16 addr, u8 val)
 {
 	struct max96792 *priv;
+	u64 start;
 	int err;
 
 	priv = dev_get_drvdata(dev);
 
+	start = ktime_get_ns();
 	err = regmap_write(priv->regmap, addr, val);
+	trace_fr_reg_write(dev, addr, 1, val, ktime_get_ns() - start, err);
 	if (err)
 		dev_err(dev,
 		"%s:i2c write failed, 0x%x = %x\n",
@@ -202,6 +212,8 @@ int max96792_power_on(struct device *dev, struct gmsl_link_ctx *g_ctx)
 	struct max96792 *priv = dev_get_drvdata(dev);
 	int err = 0;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	dev_dbg(dev, "enter %s function\n", __func__);
 	mutex_lock(&priv->lock);
 	dev_dbg(dev, "%s: pw_ref = %d\n", __func__, priv->pw_ref);
@@ -239,6 +251,8 @@ void max96792_power_off(struct device *dev, struct gmsl_link_ctx *g_ctx)
 {
 	struct max96792 *priv = dev_get_drvdata(dev);
 
+	trace_fr_serdes_step(dev, __func__);
+
 	mutex_lock(&priv->lock);
 	priv->pw_ref--;
 
@@ -286,6 +300,8 @@ int max96792_setup_link(struct device *dev, struct device *s_dev)
 	int err = 0;
 	int i;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	err = max96792_get_sdev_idx(dev, s_dev, &i);
 	if (err)
 		return err;
@@ -313,6 +329,8 @@ int max96792_gmsl3_setup(struct device *dev)
 	struct max96792 *priv = dev_get_drvdata(dev);
 	int err = 0;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	dev_dbg(dev, "enter %s function\n", __func__);
 	mutex_lock(&priv->lock);
 
@@ -362,6 +380,8 @@ int max96792_set_deser_clock(struct device *dev, int data_rate)
 {
 	int err = 0;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	dev_dbg(dev, "enter %s function\n", __func__);
 
 	err = max96792_write_reg(dev, 0x1D00, 0xF4);
@@ -382,6 +402,8 @@ int max96792_setup_control(struct device *dev, struct device *s_dev)
 	int err = 0;
 	int i;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	err = max96792_get_sdev_idx(dev, s_dev, &i);
 	if (err)
 		return err;
@@ -496,6 +518,8 @@ int max96792_xvs_setup(struct device *dev, bool direction)
 	struct max96792 *priv = dev_get_drvdata(dev);
 	int err = 0;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	mutex_lock(&priv->lock);
 
 	if (direction == max96792_OUT) {
@@ -518,10 +542,60 @@ int max96792_xvs_setup(struct device *dev, bool direction)
 }
 EXPORT_SYMBOL(max96792_xvs_setup);
 
+/*
+ * Forward the level of a deserializer MFP pin, driven by the host trigger
+ * source, over the link with the given GMSL GPIO ID.
+ */
+int max96792_trigger_setup(struct device *dev, u8 gpio, u8 gpio_id)
+{
+	struct max96792 *priv = dev_get_drvdata(dev);
+	int err;
+
+	trace_fr_serdes_step(dev, __func__);
+
+	mutex_lock(&priv->lock);
+
+	err = max96792_write_reg(dev, MAX96792_GPIO_A(gpio),
+				0x80 | GPIO_OUT_DIS | GPIO_TX_EN);
+	err |= max96792_write_reg(dev, MAX96792_GPIO_B(gpio),
+				0x60 | (gpio_id & GPIO_ID_MASK));
+	if (err)
+		dev_err(dev, "%s: max96792 trigger forwarding ERR\n", __func__);
+
+	mutex_unlock(&priv->lock);
+	return err;
+}
+EXPORT_SYMBOL(max96792_trigger_setup);
+
+/* Output the GPIO received over the link with the given ID on an MFP pin */
+int max96792_gpio_rx_setup(struct device *dev, u8 gpio, u8 gpio_id)
+{
+	struct max96792 *priv = dev_get_drvdata(dev);
+	int err;
+
+	trace_fr_serdes_step(dev, __func__);
+
+	mutex_lock(&priv->lock);
+
+	err = max96792_write_reg(dev, MAX96792_GPIO_A(gpio),
+				0x80 | GPIO_RX_EN);
+	err |= max96792_write_reg(dev, MAX96792_GPIO_C(gpio),
+				0x60 | (gpio_id & GPIO_ID_MASK));
+	if (err)
+		dev_err(dev, "%s: max96792 gpio %u forwarding ERR\n",
+							__func__, gpio);
+
+	mutex_unlock(&priv->lock);
+	return err;
+}
+EXPORT_SYMBOL(max96792_gpio_rx_setup);
+
 int max96792_reset_control(struct device *dev, struct device *s_dev)
 {
 	struct max96792 *priv = dev_get_drvdata(dev);
 
+	trace_fr_serdes_step(dev, __func__);
+
 	mutex_lock(&priv->lock);
 	dev_dbg(dev, "%s: sdev_ref is equal to %u\n", __func__,
 		priv->sdev_ref);
@@ -667,6 +741,8 @@ int max96792_start_streaming(struct device *dev, struct device *s_dev)
 	int err = 0;
 	int i = 0;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	err = max96792_get_sdev_idx(dev, s_dev, &i);
 	if (err)
 		return err;
@@ -697,6 +773,8 @@ int max96792_stop_streaming(struct device *dev, struct device *s_dev)
 	int err = 0;
 	int i = 0;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	err = max96792_get_sdev_idx(dev, s_dev, &i);
 	if (err)
 		return err;
@@ -718,6 +796,8 @@ int max96792_setup_streaming(struct device *dev, struct device *s_dev)
 	int i = 0;
 	u16 lane_ctrl_addr;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	err = max96792_get_sdev_idx(dev, s_dev, &i);
 	if (err)
 		return err;
@@ -783,19 +863,9 @@ static int max96792_parse_dt(struct max96792 *priv,
 	struct device_node *node = client->dev.of_node;
 	int err = 0;
 	const char *str_value;
-	int value;
-	const struct of_device_id *match;
-
-	if (!node)
-		return -EINVAL;
+	u32 value;
 
-	match = of_match_device(max96792_of_match, &client->dev);
-	if (!match) {
-		dev_err(&client->dev, "Failed to find matching dt id\n");
-		return -EFAULT;
-	}
-
-	err = of_property_read_string(node, "csi-mode", &str_value);
+	err = device_property_read_string(&client->dev, "csi-mode", &str_value);
 	if (err < 0) {
 		dev_err(&client->dev, "csi-mode property not found\n");
 		return err;
@@ -814,18 +884,21 @@ static int max96792_parse_dt(struct max96792 *priv,
 		return -EINVAL;
 	}
 
-	err = of_property_read_u32(node, "max-src", &value);
+	err = device_property_read_u32(&client->dev, "max-src", &value);
 	if (err < 0) {
 		dev_err(&client->dev, "No max-src info\n");
 		return err;
 	}
 	priv->max_src = value;
 
-	priv->reset_gpio = of_get_named_gpio(node, "reset-gpios", 0);
+	/* The reset line is only described in device tree */
+	if (node) {
+		priv->reset_gpio = of_get_named_gpio(node, "reset-gpios", 0);
 
-	if (priv->reset_gpio < 0) {
-		dev_err(&client->dev, "reset_gpio not found %d\n", err);
-		return err;
+		if (priv->reset_gpio < 0) {
+			dev_err(&client->dev, "reset_gpio not found %d\n", err);
+			return err;
+		}
 	}
 
 	if (of_get_property(node, "vdd_cam_1v2-supply", NULL)) {
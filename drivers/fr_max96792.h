@@ -34,6 +34,10 @@ int max96792_gmsl3_setup(struct device *dev);
 
 int max96792_xvs_setup(struct device *dev, bool direction);
 
+int max96792_trigger_setup(struct device *dev, u8 gpio, u8 gpio_id);
+
+int max96792_gpio_rx_setup(struct device *dev, u8 gpio, u8 gpio_id);
+
 int max96792_set_deser_clock(struct device *dev, int data_rate);
 
 enum {
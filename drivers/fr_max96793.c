@@ -15,6 +15,7 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/platform_device.h>
+#include <linux/property.h>
 #include <linux/regmap.h>
 #include <linux/regulator/consumer.h>
 #include <linux/v4l2-mediabus.h>
@@ -25,6 +26,7 @@
 #include <media/v4l2-ctrls.h>
 
 #include "fr_max96793.h"
+#include "fr_trace.h"
 
 #define MAX96793_MIPI_RX0_ADDR		0x330
 #define MAX96793_MIPI_RX1_ADDR		0x331
@@ -134,6 +136,9 @@
 #define GPIO_OUT_DIS			0x01
 #define GPIO_TX_EN			(0x01 << 1)
 #define GPIO_RX_EN			(0x01 << 2)
+#define GPIO_IN				(0x01 << 3)
+#define GPIO_OUT			(0x01 << 4)
+#define GPIO_ID_MASK			0x1F
 
 struct max96793_client_ctx {
 	struct gmsl_link_ctx *g_ctx;
@@ -161,15 +166,18 @@ struct map_ctx {
 static int max96793_write_reg(struct device *dev, u16 addr, u8 val)
 {
 	struct max96793 *priv = dev_get_drvdata(dev);
+	u64 start;
 	int err;
 	int num_retry = 0;
 
+	start = ktime_get_ns();
 	for (num_retry = 0; num_retry < MAX96793_MAX_RETRIES; num_retry++) {
 		err = regmap_write(priv->regmap, addr, val);
 		if (err >= 0)
 			break;
 		usleep_range(1000, 1100);
 	}
+	trace_fr_reg_write(dev, addr, 1, val, ktime_get_ns() - start, err);
 
 	if (err < 0) {
 		dev_err(dev, "Write reg error: reg=%x, val=%x, error= %d after %d retries\n",
@@ -188,11 +196,33 @@ static int max96793_write_reg(struct device *dev, u16 addr, u8 val)
 	return err;
 }
 
+static int max96793_read_reg(struct device *dev, u16 addr, u8 *val)
+{
+	struct max96793 *priv = dev_get_drvdata(dev);
+	unsigned int reg_val = 0;
+	u64 start;
+	int err;
+
+	start = ktime_get_ns();
+	err = regmap_read(priv->regmap, addr, &reg_val);
+	trace_fr_reg_read(dev, addr, 1, reg_val, ktime_get_ns() - start, err);
+	if (err) {
+		dev_err(dev, "Read reg error: reg=%x, error= %d\n", addr, err);
+		return err;
+	}
+
+	*val = reg_val & 0xFF;
+
+	return 0;
+}
+
 int max96793_gmsl3_setup(struct device *dev)
 {
 	struct max96793 *priv = dev_get_drvdata(dev);
 	int err = 0;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	mutex_lock(&priv->lock);
 	dev_dbg(dev, "enter %s function\n", __func__);
 	max96793_write_reg(dev, 0x577, 0x7F);
@@ -227,6 +257,8 @@ int max96793_setup_streaming(struct device *dev, u32 code)
 	struct gmsl_link_ctx *g_ctx;
 	u32 i;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	dev_dbg(dev, "%s: ++\n", __func__);
 
 	priv->g_client.st_done = false;
@@ -303,6 +335,8 @@ int max96793_bypassPCLK_dis(struct device *dev)
 {
 	int err;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	err = max96793_write_reg(dev, 0x110, 0x28);
 
 	return err;
@@ -315,6 +349,8 @@ int max96793_setup_control(struct device *dev)
 	int err = 0;
 	struct gmsl_link_ctx *g_ctx;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	mutex_lock(&priv->lock);
 
 	if (!priv->g_client.g_ctx) {
@@ -373,6 +409,8 @@ int max96793_xvs_setup(struct device *dev, bool direction)
 	struct max96793 *priv = dev_get_drvdata(dev);
 	int err = 0;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	mutex_lock(&priv->lock);
 
 	if (direction == max96793_OUT) {
@@ -399,6 +437,8 @@ int max96793_gpio10_xtrig1_setup(struct device *dev, char *image_sensor_type)
 {
 	int err = 0;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	if ((image_sensor_type[0] == 's' && image_sensor_type[1] == 'l' && image_sensor_type[2] == 'v' && image_sensor_type[3] == 's') ||
 	(image_sensor_type[0] == 'l' && image_sensor_type[1] == 'v' && image_sensor_type[2] == 'd' && image_sensor_type[3] == 's')) {
 		err = max96793_write_reg(dev, MAX96793_GPIO6_A, 0x81);
@@ -418,11 +458,94 @@ int max96793_gpio10_xtrig1_setup(struct device *dev, char *image_sensor_type)
 }
 EXPORT_SYMBOL(max96793_gpio10_xtrig1_setup);
 
+/*
+ * Drive the sensor trigger input (MFP6) from the GPIO forwarded by the
+ * deserializer with the given GMSL GPIO ID.
+ */
+int max96793_xtrig_setup(struct device *dev, u8 gpio_id)
+{
+	struct max96793 *priv = dev_get_drvdata(dev);
+	int err;
+
+	trace_fr_serdes_step(dev, __func__);
+
+	mutex_lock(&priv->lock);
+
+	err = max96793_write_reg(dev, MAX96793_GPIO6_A, 0x80 | GPIO_RX_EN);
+	err |= max96793_write_reg(dev, MAX96793_GPIO6_C,
+					0x40 | (gpio_id & GPIO_ID_MASK));
+	if (err)
+		dev_err(dev, "%s: ERROR: xtrig forwarding config failed!\n",
+								__func__);
+
+	mutex_unlock(&priv->lock);
+	return err;
+}
+EXPORT_SYMBOL(max96793_xtrig_setup);
+
+/* Current level of the sensor trigger input as seen by the serializer */
+int max96793_xtrig_level(struct device *dev)
+{
+	struct max96793 *priv = dev_get_drvdata(dev);
+	int err;
+	u8 val;
+
+	mutex_lock(&priv->lock);
+	err = max96793_read_reg(dev, MAX96793_GPIO6_A, &val);
+	mutex_unlock(&priv->lock);
+
+	if (err)
+		return err;
+
+	return !!(val & GPIO_IN);
+}
+EXPORT_SYMBOL(max96793_xtrig_level);
+
+/* Drive the sensor trigger input (MFP6) directly from the serializer */
+int max96793_xtrig_set(struct device *dev, bool level)
+{
+	struct max96793 *priv = dev_get_drvdata(dev);
+	int err;
+
+	mutex_lock(&priv->lock);
+	err = max96793_write_reg(dev, MAX96793_GPIO6_A,
+				0x80 | (level ? GPIO_OUT : 0));
+	mutex_unlock(&priv->lock);
+
+	return err;
+}
+EXPORT_SYMBOL(max96793_xtrig_set);
+
+/* Transmit the level of a serializer MFP pin with the given GMSL GPIO ID */
+int max96793_gpio_tx_setup(struct device *dev, u8 gpio, u8 gpio_id)
+{
+	struct max96793 *priv = dev_get_drvdata(dev);
+	int err;
+
+	trace_fr_serdes_step(dev, __func__);
+
+	mutex_lock(&priv->lock);
+
+	err = max96793_write_reg(dev, MAX96793_GPIO0_A + 3 * gpio,
+					0x80 | GPIO_TX_EN);
+	err |= max96793_write_reg(dev, MAX96793_GPIO0_B + 3 * gpio,
+					gpio_id & GPIO_ID_MASK);
+	if (err)
+		dev_err(dev, "%s: max96793 gpio %u forwarding ERR\n",
+							__func__, gpio);
+
+	mutex_unlock(&priv->lock);
+	return err;
+}
+EXPORT_SYMBOL(max96793_gpio_tx_setup);
+
 int max96793_reset_control(struct device *dev)
 {
 	struct max96793 *priv = dev_get_drvdata(dev);
 	int err = 0;
 
+	trace_fr_serdes_step(dev, __func__);
+
 	mutex_lock(&priv->lock);
 	if (!priv->g_client.g_ctx) {
 		dev_err(dev, "%s: no sdev client found\n", __func__);
@@ -516,7 +639,6 @@ static int max96793_probe(struct i2c_client *client)
 {
 	struct max96793 *priv;
 	int err = 0;
-	struct device_node *node = client->dev.of_node;
 
 	dev_info(&client->dev, "[max96793]: probing GMSL Serializer\n");
 
@@ -531,13 +653,14 @@ static int max96793_probe(struct i2c_client *client)
 	}
 
 	mutex_init(&priv->lock);
-	if (of_get_property(node, "is-prim-ser", NULL)) {
+	if (device_property_read_bool(&client->dev, "is-prim-ser")) {
 		if (prim_priv__) {
 			dev_err(&client->dev,
 				"prim-ser already exists\n");
 		}
 
-		err = of_property_read_u32(node, "reg", &priv->def_addr);
+		err = device_property_read_u32(&client->dev, "reg",
+							&priv->def_addr);
 		if (err < 0) {
 			dev_err(&client->dev, "reg not found\n");
 			return -EINVAL;
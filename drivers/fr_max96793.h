@@ -46,6 +46,14 @@ int max96793_gmsl3_setup(struct device *dev);
 
 int max96793_gpio10_xtrig1_setup(struct device *dev, char *image_sensor_type);
 
+int max96793_xtrig_setup(struct device *dev, u8 gpio_id);
+
+int max96793_xtrig_level(struct device *dev);
+
+int max96793_xtrig_set(struct device *dev, bool level);
+
+int max96793_gpio_tx_setup(struct device *dev, u8 gpio, u8 gpio_id);
+
 int max96793_xvs_setup(struct device *dev, bool direction);
 
 int max96793_bypassPCLK_dis(struct device *dev);
@@ -0,0 +1,1384 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_sensor_core.c - common code of the FRAMOS IMX sensor drivers
+ *
+ * Register access, identification, device tree parsing, power sequencing
+ * and GMSL serializer/deserializer handling are the same for all FRAMOS
+ * IMX sensors and live here. So are the stream start and stop with the
+ * background staging of the configuration, XVS frame sync events, sync
+ * group membership, runtime PM and the frame interval search. The sensor
+ * drivers keep the mode tables and controls, and describe the rest with a
+ * struct fr_sensor_desc and its struct fr_sensor_ops.
+ */
+
+#include <asm/unaligned.h>
+#include <linux/delay.h>
+#include <linux/interrupt.h>
+#include <linux/module.h>
+#include <linux/of_device.h>
+#include <linux/pm_runtime.h>
+#include <linux/property.h>
+#include <linux/rational.h>
+#include <media/v4l2-event.h>
+#include <media/v4l2-fwnode.h>
+
+#include "fr_max96792.h"
+#include "fr_max96793.h"
+#include "fr_sensor_core.h"
+#include "fr_trace.h"
+
+#define FR_SENSOR_K_FACTOR			1000LL
+#define FR_SENSOR_M_FACTOR			1000000LL
+#define FR_SENSOR_G_FACTOR			1000000000LL
+
+#define FR_SENSOR_MODE_STANDBY			0x01
+#define FR_SENSOR_MODE_STREAMING		0x00
+
+#define FR_SENSOR_INTERVAL_MAX			0xFFFFFF
+#define FR_SENSOR_STAGE_DELAY_MS		10
+#define FR_SENSOR_AUTOSUSPEND_DELAY_MS		2000
+
+/* All sensors have the image on the first pad */
+#define FR_SENSOR_IMAGE_PAD			0
+
+static const char * const fr_sensor_stage_names[] = {
+	[FR_STAGE_SERDES_SETUP] = "serdes_setup",
+	[FR_STAGE_SERDES_START] = "serdes_start",
+	[FR_STAGE_COMMON_REGS] = "common_regs",
+	[FR_STAGE_MODE_REGS] = "mode_regs",
+	[FR_STAGE_DATA_RATE] = "data_rate",
+	[FR_STAGE_CONTROLS] = "controls",
+	[FR_STAGE_STANDBY] = "standby",
+	[FR_STAGE_XMSTA] = "xmsta",
+	[FR_STAGE_START] = "start_total",
+	[FR_STAGE_STOP] = "stop_total",
+};
+
+static void fr_sensor_stage_work(struct work_struct *work);
+static int fr_sensor_sync_release(struct fr_sync_member *member);
+
+void fr_sensor_init(struct fr_sensor *core, struct i2c_client *client,
+		    const struct fr_sensor_desc *desc)
+{
+	core->client = client;
+	core->desc = desc;
+	core->gmsl = "mipi";
+
+	mutex_init(&core->mutex);
+	INIT_DELAYED_WORK(&core->stage_work, fr_sensor_stage_work);
+	init_completion(&core->xvs_event);
+
+	core->sync.dev = &client->dev;
+	core->sync.release = fr_sensor_sync_release;
+
+	fr_latency_init(&core->latency, fr_sensor_stage_names,
+			core->latency_stages, FR_NUM_STAGES);
+	fr_i2c_stats_init(&core->i2c_stats);
+	WRITE_ONCE(core->i2c_class, FR_I2C_OTHER);
+}
+EXPORT_SYMBOL(fr_sensor_init);
+
+int fr_sensor_read_reg(struct fr_sensor *core, u16 reg, u32 len, u32 *val)
+{
+	struct i2c_client *client = core->client;
+	struct i2c_msg msgs[2];
+	u8 addr_buf[2] = { reg >> 8, reg & 0xff };
+	u8 data_buf[4] = { 0, };
+	u64 start, duration;
+	int ret;
+
+	if (len > 4)
+		return -EINVAL;
+
+	msgs[0].addr = client->addr;
+	msgs[0].flags = 0;
+	msgs[0].len = ARRAY_SIZE(addr_buf);
+	msgs[0].buf = addr_buf;
+
+	msgs[1].addr = client->addr;
+	msgs[1].flags = I2C_M_RD;
+	msgs[1].len = len;
+	msgs[1].buf = &data_buf[4 - len];
+
+	start = ktime_get_ns();
+	ret = i2c_transfer(client->adapter, msgs, ARRAY_SIZE(msgs));
+	ret = (ret == ARRAY_SIZE(msgs)) ? 0 : -EIO;
+	duration = ktime_get_ns() - start;
+
+	trace_fr_reg_read(&client->dev, reg, len, get_unaligned_be32(data_buf),
+							duration, ret);
+	fr_i2c_stats_record(&core->i2c_stats, READ_ONCE(core->i2c_class),
+				ARRAY_SIZE(addr_buf) + len, 0, duration, ret);
+	if (ret)
+		return ret;
+
+	*val = get_unaligned_be32(data_buf);
+
+	return 0;
+}
+EXPORT_SYMBOL(fr_sensor_read_reg);
+
+int fr_sensor_write_reg(struct fr_sensor *core, u16 reg, u32 len, u32 val)
+{
+	struct i2c_client *client = core->client;
+	u16 reghold = core->desc->reghold;
+	u8 buf[6];
+	u64 start, duration;
+	int ret;
+
+	if (len > 4)
+		return -EINVAL;
+
+	put_unaligned_be16(reg, buf);
+	put_unaligned_le32(val, buf + 2);
+
+	start = ktime_get_ns();
+	ret = i2c_master_send(client, buf, len + 2);
+	ret = (ret == len + 2) ? 0 : -EIO;
+	duration = ktime_get_ns() - start;
+
+	trace_fr_reg_write(&client->dev, reg, len, val, duration, ret);
+	fr_i2c_stats_record(&core->i2c_stats,
+			    reg == reghold ? FR_I2C_HOLD :
+						     READ_ONCE(core->i2c_class),
+			    len + 2, 0, duration, ret);
+	if (ret)
+		return ret;
+
+	if (reg == reghold) {
+		if (val)
+			trace_fr_hold_begin(&client->dev);
+		else
+			trace_fr_hold_commit(&client->dev);
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(fr_sensor_write_reg);
+
+int fr_sensor_write_hold_reg(struct fr_sensor *core, u16 reg, u32 len, u32 val)
+{
+	struct device *dev = &core->client->dev;
+	u16 reghold = core->desc->reghold;
+	int ret, err;
+
+	ret = fr_sensor_write_reg(core, reghold, 1, 0x01);
+	if (ret) {
+		dev_err(dev, "%s failed to write reghold register\n",
+								__func__);
+		return ret;
+	}
+
+	/* The hold is released even if the write itself failed */
+	ret = fr_sensor_write_reg(core, reg, len, val);
+
+	err = fr_sensor_write_reg(core, reghold, 1, 0x00);
+	if (err) {
+		dev_err(dev, "%s failed to write reghold register\n",
+								__func__);
+		return err;
+	}
+
+	return ret;
+}
+EXPORT_SYMBOL(fr_sensor_write_hold_reg);
+
+int __fr_sensor_write_table(struct fr_sensor *core,
+			    const struct fr_sensor_reg *regs, u32 len,
+			    const char *name)
+{
+	struct i2c_client *client = core->client;
+	enum fr_i2c_class i2c_class = READ_ONCE(core->i2c_class);
+	unsigned int i;
+	int ret = 0;
+
+	trace_fr_table_start(&client->dev, name, len, 0);
+
+	WRITE_ONCE(core->i2c_class, FR_I2C_TABLE);
+
+	for (i = 0; i < len; i++) {
+		ret = fr_sensor_write_reg(core, regs[i].address, 1, regs[i].val);
+		if (ret) {
+			dev_err_ratelimited(&client->dev,
+					"Failed to write reg 0x%4.4x. error = %d\n",
+					regs[i].address, ret);
+			break;
+		}
+	}
+
+	WRITE_ONCE(core->i2c_class, i2c_class);
+
+	trace_fr_table_end(&client->dev, name, i, ret);
+
+	return ret;
+}
+EXPORT_SYMBOL(__fr_sensor_write_table);
+
+int fr_sensor_identify(struct fr_sensor *core)
+{
+	struct device *dev = &core->client->dev;
+	int ret;
+	u32 val;
+
+	WRITE_ONCE(core->i2c_class, FR_I2C_IDENTIFY);
+	ret = fr_sensor_read_reg(core, core->desc->id_reg, core->desc->id_len,
+									&val);
+	WRITE_ONCE(core->i2c_class, FR_I2C_OTHER);
+
+	if (ret) {
+		dev_err(dev, "%s unable to communicate with sensor\n", __func__);
+		return ret;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(fr_sensor_identify);
+
+static int fr_sensor_check_hwcfg(struct fr_sensor *core)
+{
+	struct device *dev = &core->client->dev;
+	const struct fr_sensor_desc *desc = core->desc;
+	struct fwnode_handle *endpoint;
+	struct v4l2_fwnode_endpoint ep_cfg = {
+		.bus_type = V4L2_MBUS_CSI2_DPHY
+	};
+	const char *gmsl;
+	unsigned int i;
+	int ret = -EINVAL;
+
+	endpoint = fwnode_graph_get_next_endpoint(dev_fwnode(dev), NULL);
+	if (!endpoint) {
+		dev_err(dev, "endpoint node not found\n");
+		return -EINVAL;
+	}
+
+	if (v4l2_fwnode_endpoint_alloc_parse(endpoint, &ep_cfg)) {
+		dev_err(dev, "could not parse endpoint\n");
+		goto error_out;
+	}
+
+	if (ep_cfg.bus.mipi_csi2.num_data_lanes != 4) {
+		dev_err(dev, "only 4 data lanes are currently supported\n");
+		goto error_out;
+	}
+
+	if (!ep_cfg.nr_of_link_frequencies) {
+		dev_err(dev, "link-frequency property not found in DT\n");
+		goto error_out;
+	}
+
+	if (ep_cfg.nr_of_link_frequencies != desc->num_link_freqs) {
+		dev_err(dev, "Link frequency missing in dtree\n");
+		goto error_out;
+	}
+
+	for (i = 0; i < desc->num_link_freqs; i++) {
+		if (ep_cfg.link_frequencies[i] != desc->link_freqs[i]) {
+			dev_err(dev, "no supported link freq found\n");
+			goto error_out;
+		}
+	}
+
+	if (!device_property_read_string(dev, "gmsl", &gmsl) &&
+	    !strcmp(gmsl, "gmsl")) {
+		dev_warn(dev, "initializing GMSL...\n");
+		core->gmsl = "gmsl";
+	} else {
+		dev_warn(dev, "initializing mipi...\n");
+		core->gmsl = "mipi";
+	}
+
+	ret = 0;
+
+error_out:
+	v4l2_fwnode_endpoint_free(&ep_cfg);
+	fwnode_handle_put(endpoint);
+
+	return ret;
+}
+
+static struct device *fr_sensor_get_serdes(struct device *dev,
+					   struct device_node *node,
+					   const char *prop, u32 *reg)
+{
+	struct device_node *serdes_node;
+	struct i2c_client *serdes_i2c;
+	int ret;
+
+	serdes_node = of_parse_phandle(node, prop, 0);
+	if (!serdes_node) {
+		dev_err(dev, "missing %s handle\n", prop);
+		return ERR_PTR(-EINVAL);
+	}
+
+	if (reg) {
+		ret = of_property_read_u32(serdes_node, "reg", reg);
+		if (ret < 0) {
+			dev_err(dev, "%s reg not found\n", prop);
+			of_node_put(serdes_node);
+			return ERR_PTR(ret);
+		}
+	}
+
+	serdes_i2c = of_find_i2c_device_by_node(serdes_node);
+	of_node_put(serdes_node);
+
+	if (!serdes_i2c) {
+		dev_err(dev, "missing %s dev handle\n", prop);
+		return ERR_PTR(-EINVAL);
+	}
+	if (!serdes_i2c->dev.driver) {
+		dev_err(dev, "missing %s driver\n", prop);
+		return ERR_PTR(-EINVAL);
+	}
+
+	return &serdes_i2c->dev;
+}
+
+static int fr_sensor_gmsl_parse(struct fr_sensor *core,
+				struct device_node *gmsl)
+{
+	struct device *dev = &core->client->dev;
+	struct gmsl_link_ctx *g_ctx = &core->g_ctx;
+	const char *str_value;
+	u32 value;
+	int i;
+	int ret;
+
+	ret = of_property_read_string(gmsl, "dst-csi-port", &str_value);
+	if (ret < 0) {
+		dev_err(dev, "No dst-csi-port found\n");
+		return ret;
+	}
+	g_ctx->dst_csi_port =
+	(!strcmp(str_value, "a")) ? GMSL_CSI_PORT_A : GMSL_CSI_PORT_B;
+
+	ret = of_property_read_string(gmsl, "src-csi-port", &str_value);
+	if (ret < 0) {
+		dev_err(dev, "No src-csi-port found\n");
+		return ret;
+	}
+	g_ctx->src_csi_port =
+	(!strcmp(str_value, "a")) ? GMSL_CSI_PORT_A : GMSL_CSI_PORT_B;
+
+	ret = of_property_read_string(gmsl, "csi-mode", &str_value);
+	if (ret < 0) {
+		dev_err(dev, "No csi-mode found\n");
+		return ret;
+	}
+
+	if (!strcmp(str_value, "1x4")) {
+		g_ctx->csi_mode = GMSL_CSI_1X4_MODE;
+	} else if (!strcmp(str_value, "2x4")) {
+		g_ctx->csi_mode = GMSL_CSI_2X4_MODE;
+	} else if (!strcmp(str_value, "2x2")) {
+		g_ctx->csi_mode = GMSL_CSI_2X2_MODE;
+	} else {
+		dev_err(dev, "invalid csi mode\n");
+		return -EINVAL;
+	}
+
+	ret = of_property_read_string(gmsl, "serdes-csi-link", &str_value);
+	if (ret < 0) {
+		dev_err(dev, "No serdes-csi-link found\n");
+		return ret;
+	}
+	g_ctx->serdes_csi_link =
+	(!strcmp(str_value, "a")) ? GMSL_SERDES_CSI_LINK_A : GMSL_SERDES_CSI_LINK_B;
+
+	ret = of_property_read_u32(gmsl, "st-vc", &value);
+	if (ret < 0) {
+		dev_err(dev, "No st-vc info\n");
+		return ret;
+	}
+	g_ctx->st_vc = value;
+
+	ret = of_property_read_u32(gmsl, "vc-id", &value);
+	if (ret < 0) {
+		dev_err(dev, "No vc-id info\n");
+		return ret;
+	}
+	g_ctx->dst_vc = value;
+
+	ret = of_property_read_u32(gmsl, "num-lanes", &value);
+	if (ret < 0) {
+		dev_err(dev, "No num-lanes info\n");
+		return ret;
+	}
+	g_ctx->num_csi_lanes = value;
+
+	ret = of_property_count_strings(gmsl, "streams");
+	if (ret <= 0 || ret > GMSL_DEV_MAX_NUM_DATA_STREAMS) {
+		dev_err(dev, "No streams found\n");
+		return -EINVAL;
+	}
+	g_ctx->num_streams = ret;
+
+	for (i = 0; i < g_ctx->num_streams; i++) {
+		ret = of_property_read_string_index(gmsl, "streams", i,
+								&str_value);
+		if (ret < 0) {
+			dev_err(dev, "invalid stream info\n");
+			return ret;
+		}
+		if (!strcmp(str_value, "raw12")) {
+			g_ctx->streams[i].st_data_type = GMSL_CSI_DT_RAW_12;
+		} else if (!strcmp(str_value, "embed")) {
+			g_ctx->streams[i].st_data_type = GMSL_CSI_DT_EMBED;
+		} else if (!strcmp(str_value, "ued-u1")) {
+			g_ctx->streams[i].st_data_type = GMSL_CSI_DT_UED_U1;
+		} else {
+			dev_err(dev, "invalid stream data type\n");
+			return -EINVAL;
+		}
+	}
+
+	if (core->desc->ops && core->desc->ops->gmsl_parse)
+		return core->desc->ops->gmsl_parse(core, gmsl);
+
+	return 0;
+}
+
+static int fr_sensor_gmsl_init(struct fr_sensor *core)
+{
+	struct device *dev = &core->client->dev;
+	struct device_node *node = dev->of_node;
+	struct device_node *gmsl;
+	int ret;
+
+	ret = of_property_read_u32(node, "reg", &core->g_ctx.sdev_reg);
+	if (ret < 0) {
+		dev_err(dev, "reg not found\n");
+		return ret;
+	}
+
+	ret = of_property_read_u32(node, "def-addr", &core->g_ctx.sdev_def);
+	if (ret < 0) {
+		dev_err(dev, "def-addr not found\n");
+		return ret;
+	}
+
+	core->ser_dev = fr_sensor_get_serdes(dev, node, "gmsl-ser-device",
+							&core->g_ctx.ser_reg);
+	if (IS_ERR(core->ser_dev))
+		return PTR_ERR(core->ser_dev);
+
+	core->dser_dev = fr_sensor_get_serdes(dev, node, "gmsl-dser-device",
+								NULL);
+	if (IS_ERR(core->dser_dev))
+		return PTR_ERR(core->dser_dev);
+
+	gmsl = of_get_child_by_name(node, "gmsl-link");
+	if (!gmsl) {
+		dev_err(dev, "missing gmsl-link device node\n");
+		return -EINVAL;
+	}
+
+	ret = fr_sensor_gmsl_parse(core, gmsl);
+	of_node_put(gmsl);
+	if (ret)
+		return ret;
+
+	core->g_ctx.s_dev = dev;
+
+	ret = max96793_sdev_pair(core->ser_dev, &core->g_ctx);
+	if (ret) {
+		dev_err(dev, "gmsl ser pairing failed\n");
+		return ret;
+	}
+
+	ret = max96792_sdev_register(core->dser_dev, &core->g_ctx);
+	if (ret) {
+		dev_err(dev, "gmsl deserializer register failed\n");
+		return ret;
+	}
+
+	return 0;
+}
+
+/*
+ * Checks the endpoint against the sensor description and gets either the
+ * reset gpio of a directly connected sensor or the serializer and
+ * deserializer of a GMSL one. The serdes setup itself is done separately
+ * by fr_sensor_gmsl_serdes_setup().
+ */
+int fr_sensor_probe(struct fr_sensor *core)
+{
+	struct device *dev = &core->client->dev;
+
+	if (fr_sensor_check_hwcfg(core))
+		return -EINVAL;
+
+	if (fr_sensor_is_gmsl(core))
+		return fr_sensor_gmsl_init(core);
+
+	core->reset_gpio = devm_gpiod_get(dev, "reset", GPIOD_OUT_HIGH);
+	if (IS_ERR(core->reset_gpio)) {
+		dev_err(dev, "cannot get reset gpio\n");
+		return PTR_ERR(core->reset_gpio);
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(fr_sensor_probe);
+
+void fr_sensor_remove(struct fr_sensor *core)
+{
+	if (!fr_sensor_is_gmsl(core))
+		return;
+
+	max96792_sdev_unregister(core->dser_dev, &core->client->dev);
+	fr_sensor_gmsl_serdes_reset(core);
+}
+EXPORT_SYMBOL(fr_sensor_remove);
+
+void fr_sensor_power_on(struct fr_sensor *core)
+{
+	struct device *dev = &core->client->dev;
+
+	if (!fr_sensor_is_gmsl(core)) {
+		gpiod_set_value_cansleep(core->reset_gpio, 1);
+		usleep_range(25000, 30000);
+	} else {
+		dev_info(dev, "%s: max96792_power_on\n", __func__);
+		max96792_power_on(core->dser_dev, &core->g_ctx);
+	}
+
+	trace_fr_power(dev, true, 0);
+}
+EXPORT_SYMBOL(fr_sensor_power_on);
+
+void fr_sensor_power_off(struct fr_sensor *core)
+{
+	struct device *dev = &core->client->dev;
+
+	if (!fr_sensor_is_gmsl(core)) {
+		gpiod_set_value_cansleep(core->reset_gpio, 0);
+	} else {
+		dev_info(dev, "%s: max96792_power_off\n", __func__);
+		max96792_power_off(core->dser_dev, &core->g_ctx);
+	}
+
+	trace_fr_power(dev, false, 0);
+}
+EXPORT_SYMBOL(fr_sensor_power_off);
+
+static int __fr_sensor_gmsl_serdes_setup(struct fr_sensor *core)
+{
+	const struct fr_sensor_ops *ops = core->desc->ops;
+	struct device *dev = &core->client->dev;
+	int ret;
+
+	if (!core->ser_dev || !core->dser_dev)
+		return -EINVAL;
+
+	dev_dbg(dev, "enter %s function\n", __func__);
+
+	max96792_reset_control(core->dser_dev, dev);
+
+	ret = max96792_gmsl3_setup(core->dser_dev);
+	if (ret) {
+		dev_err(dev, "deserializer gmsl setup failed\n");
+		return ret;
+	}
+
+	ret = max96793_gmsl3_setup(core->ser_dev);
+	if (ret) {
+		dev_err(dev, "serializer gmsl setup failed\n");
+		return ret;
+	}
+
+	dev_dbg(dev, "%s: max96792_setup_link\n", __func__);
+	ret = max96792_setup_link(core->dser_dev, dev);
+	if (ret) {
+		dev_err(dev, "gmsl deserializer link config failed\n");
+		return ret;
+	}
+
+	dev_dbg(dev, "%s: max96793_setup_control\n", __func__);
+	ret = max96793_setup_control(core->ser_dev);
+	if (ret)
+		dev_err(dev, "gmsl serializer setup failed\n");
+
+	if (ops && ops->gmsl_ser_setup)
+		ret = ops->gmsl_ser_setup(core);
+	else
+		ret = max96793_gpio10_xtrig1_setup(core->ser_dev, "mipi");
+	if (ret) {
+		dev_err(dev, "gmsl serializer gpio10/xtrig1 pin config failed\n");
+		return ret;
+	}
+
+	dev_dbg(dev, "%s: max96792_setup_control\n", __func__);
+	if (max96792_setup_control(core->dser_dev, dev))
+		dev_err(dev, "gmsl deserializer setup failed\n");
+
+	if (ops && ops->gmsl_dser_setup)
+		return ops->gmsl_dser_setup(core);
+
+	return 0;
+}
+
+int fr_sensor_gmsl_serdes_setup(struct fr_sensor *core)
+{
+	ktime_t start = ktime_get();
+	int ret;
+
+	mutex_lock(&core->mutex);
+
+	ret = __fr_sensor_gmsl_serdes_setup(core);
+	if (!ret)
+		fr_latency_record(&core->latency, FR_STAGE_SERDES_SETUP, start);
+
+	mutex_unlock(&core->mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL(fr_sensor_gmsl_serdes_setup);
+
+void fr_sensor_gmsl_serdes_reset(struct fr_sensor *core)
+{
+	max96793_reset_control(core->ser_dev);
+	max96792_reset_control(core->dser_dev, &core->client->dev);
+	max96792_power_off(core->dser_dev, &core->g_ctx);
+}
+EXPORT_SYMBOL(fr_sensor_gmsl_serdes_reset);
+
+int fr_sensor_gmsl_start_streaming(struct fr_sensor *core, u32 fmt_code)
+{
+	struct device *dev = &core->client->dev;
+	int ret;
+
+	ret = max96793_setup_streaming(core->ser_dev, fmt_code);
+	if (ret) {
+		dev_err(dev, "%s: Unable to setup streaming for serializer max96793\n",
+								__func__);
+		return ret;
+	}
+	ret = max96792_setup_streaming(core->dser_dev, dev);
+	if (ret) {
+		dev_err(dev, "%s: Unable to setup streaming for deserializer max96792\n",
+								__func__);
+		return ret;
+	}
+	ret = max96792_start_streaming(core->dser_dev, dev);
+	if (ret) {
+		dev_err(dev, "%s: Unable to start gmsl streaming\n",
+								__func__);
+		return ret;
+	}
+
+	return 0;
+}
+EXPORT_SYMBOL(fr_sensor_gmsl_start_streaming);
+
+/*
+ * XVS marks the start of every frame. Besides timing the stream stop, it
+ * is reported to userspace as a FRAME_SYNC event carrying the number of
+ * the frame since stream start and the CLOCK_MONOTONIC time of the edge.
+ */
+static irqreturn_t fr_sensor_xvs_irq_handler(int irq, void *data)
+{
+	struct fr_sensor *core = data;
+	struct v4l2_event event = {
+		.type = V4L2_EVENT_FRAME_SYNC,
+	};
+
+	WRITE_ONCE(core->xvs_timestamp, ktime_get());
+	complete(&core->xvs_event);
+
+	if (!READ_ONCE(core->xvs_active))
+		return IRQ_HANDLED;
+
+	event.u.frame_sync.frame_sequence =
+				atomic_fetch_inc(&core->xvs_sequence);
+	v4l2_event_queue(core->sd.devnode, &event);
+
+	return IRQ_HANDLED;
+}
+
+int fr_sensor_xvs_init(struct fr_sensor *core)
+{
+	struct device *dev = &core->client->dev;
+	int ret;
+
+	core->xvs_gpio = devm_gpiod_get_optional(dev, "xvs", GPIOD_IN);
+	if (IS_ERR(core->xvs_gpio)) {
+		dev_err(dev, "cannot get xvs gpio\n");
+		return PTR_ERR(core->xvs_gpio);
+	}
+
+	if (!core->xvs_gpio)
+		return 0;
+
+	ret = gpiod_to_irq(core->xvs_gpio);
+	if (ret < 0) {
+		dev_err(dev, "%s: xvs gpio has no interrupt\n", __func__);
+		return ret;
+	}
+
+	core->xvs_irq = ret;
+
+	/* XVS is an active low pulse at the start of every frame */
+	ret = devm_request_irq(dev, core->xvs_irq, fr_sensor_xvs_irq_handler,
+				IRQF_TRIGGER_FALLING, dev_name(dev), core);
+	if (ret) {
+		dev_err(dev, "%s: failed to request xvs irq\n", __func__);
+		return ret;
+	}
+
+	dev_dbg(dev, "%s: xvs irq: %d\n", __func__, core->xvs_irq);
+
+	return 0;
+}
+EXPORT_SYMBOL(fr_sensor_xvs_init);
+
+/*
+ * Drop the configuration staged in the sensor and, unless streaming,
+ * program the new one in the background once format and controls settle.
+ */
+void fr_sensor_invalidate_staging(struct fr_sensor *core)
+{
+	core->staged = false;
+
+	if (!core->streaming)
+		mod_delayed_work(system_wq, &core->stage_work,
+				msecs_to_jiffies(FR_SENSOR_STAGE_DELAY_MS));
+}
+EXPORT_SYMBOL(fr_sensor_invalidate_staging);
+
+static void fr_sensor_stage_work(struct work_struct *work)
+{
+	struct fr_sensor *core = container_of(to_delayed_work(work),
+						struct fr_sensor, stage_work);
+	struct device *dev = &core->client->dev;
+	int ret;
+
+	/* Never power the sensor up only to stage a configuration */
+	if (pm_runtime_get_if_active(dev, true) <= 0)
+		return;
+
+	mutex_lock(&core->mutex);
+
+	if (core->streaming || core->staged)
+		goto unlock;
+
+	ret = core->desc->ops->set_mode(core);
+	if (!ret)
+		ret = __v4l2_ctrl_handler_setup(core->sd.ctrl_handler);
+
+	if (ret)
+		dev_err(dev, "%s failed to stage configuration\n", __func__);
+	else
+		core->staged = true;
+
+unlock:
+	mutex_unlock(&core->mutex);
+	pm_runtime_put_autosuspend(dev);
+}
+
+/*
+ * Last step of the stream start, called by the sync group. It may run on
+ * behalf of another sensor of the group, so it only touches XMSTA and the
+ * XVS event state and does not take the device mutex.
+ */
+static int fr_sensor_sync_release(struct fr_sync_member *member)
+{
+	struct fr_sensor *core = container_of(member, struct fr_sensor, sync);
+	struct device *dev = &core->client->dev;
+	ktime_t start = ktime_get();
+	int ret;
+
+	atomic_set(&core->xvs_sequence, 0);
+	WRITE_ONCE(core->xvs_active, true);
+
+	/* A slave left standby on arm and runs off the master's XVS */
+	if (!member->master)
+		return 0;
+
+	ret = fr_sensor_write_reg(core, core->desc->xmsta, 1, 0x00);
+	if (ret) {
+		WRITE_ONCE(core->xvs_active, false);
+		dev_err(dev, "%s failed to set XMSTA start stream\n", __func__);
+		return ret;
+	}
+	fr_latency_record(&core->latency, FR_STAGE_XMSTA, start);
+
+	return 0;
+}
+
+int fr_sensor_join_sync_group(struct fr_sensor *core)
+{
+	struct device *dev = &core->client->dev;
+	u32 sync_group;
+	int ret;
+
+	if (device_property_read_u32(dev, "sync-group", &sync_group))
+		return 0;
+
+	ret = fr_sync_group_join(&core->sync, sync_group);
+	if (ret)
+		dev_err(dev, "failed to join sync group: %d\n", ret);
+
+	return ret;
+}
+EXPORT_SYMBOL(fr_sensor_join_sync_group);
+
+void fr_sensor_debugfs_create(struct fr_sensor *core, struct dentry *parent)
+{
+	fr_latency_debugfs_create(&core->latency, "latency", parent);
+	fr_i2c_stats_debugfs_create(&core->i2c_stats, "i2c", parent);
+	fr_sync_group_debugfs_create(&core->sync, "sync_group", parent);
+}
+EXPORT_SYMBOL(fr_sensor_debugfs_create);
+
+static int fr_sensor_start_streaming(struct fr_sensor *core)
+{
+	const struct fr_sensor_desc *desc = core->desc;
+	struct device *dev = &core->client->dev;
+	bool gmsl = fr_sensor_is_gmsl(core);
+	bool master = desc->ops->is_master(core);
+	s64 mode_us = 0, ctrls_us = 0, serdes_us = 0, settle_us;
+	ktime_t begin = ktime_get();
+	ktime_t start, standby;
+	s64 remaining;
+	int ret;
+
+	/*
+	 * A slave sensor can start to output as soon as it leaves standby,
+	 * so the GMSL pipeline has to be up before that.
+	 */
+	if (gmsl && !master) {
+		start = ktime_get();
+		ret = fr_sensor_gmsl_start_streaming(core, core->fmt_code);
+		if (ret)
+			return ret;
+		serdes_us = ktime_us_delta(ktime_get(), start);
+		fr_latency_record(&core->latency, FR_STAGE_SERDES_START, start);
+	}
+
+	/*
+	 * The sensor still holds the configuration from the last staging
+	 * or stream session, only standby and master mode are left to change.
+	 */
+	if (!core->staged) {
+		start = ktime_get();
+		ret = desc->ops->set_mode(core);
+		if (ret) {
+			dev_err(dev, "%s failed to set mode start stream\n",
+								__func__);
+			return ret;
+		}
+		mode_us = ktime_us_delta(ktime_get(), start);
+
+		start = ktime_get();
+		ret = __v4l2_ctrl_handler_setup(core->sd.ctrl_handler);
+		if (ret)
+			return ret;
+		ctrls_us = ktime_us_delta(ktime_get(), start);
+		fr_latency_record(&core->latency, FR_STAGE_CONTROLS, start);
+
+		core->staged = true;
+	}
+
+	start = ktime_get();
+	ret = fr_sensor_write_reg(core, desc->standby, 1,
+				FR_SENSOR_MODE_STREAMING);
+	if (ret) {
+		dev_err(dev, "%s failed to set STANDBY start stream\n",
+								__func__);
+		return ret;
+	}
+	standby = ktime_get();
+
+	/*
+	 * A master sensor does not output anything before XMSTA is cleared,
+	 * so the GMSL pipeline is brought up while the sensor settles.
+	 */
+	if (gmsl && master) {
+		ret = fr_sensor_gmsl_start_streaming(core, core->fmt_code);
+		if (ret) {
+			fr_sensor_write_reg(core, desc->standby, 1,
+						FR_SENSOR_MODE_STANDBY);
+			return ret;
+		}
+		serdes_us = ktime_us_delta(ktime_get(), standby);
+		fr_latency_record(&core->latency, FR_STAGE_SERDES_START,
+								standby);
+	}
+
+	/* Only wait for whatever is left of the settle time */
+	remaining = desc->settle_us - ktime_us_delta(ktime_get(), standby);
+	if (remaining > 0)
+		usleep_range(remaining, remaining + 100);
+	settle_us = ktime_us_delta(ktime_get(), standby);
+	fr_latency_record(&core->latency, FR_STAGE_STANDBY, start);
+
+	/*
+	 * Sensors in a sync group are released together once all of them
+	 * got here, the others right away.
+	 */
+	ret = fr_sync_group_arm(&core->sync, master);
+	if (ret)
+		return ret;
+	fr_latency_record(&core->latency, FR_STAGE_START, begin);
+
+	dev_dbg(dev, "%s: mode %lld us, controls %lld us, serdes %lld us, settle %lld us\n",
+			__func__, mode_us, ctrls_us, serdes_us, settle_us);
+
+	return ret;
+}
+
+static void fr_sensor_wait_frame_end(struct fr_sensor *core)
+{
+	u64 frame_time = fr_sensor_frame_lines(core) * core->line_time /
+							FR_SENSOR_K_FACTOR;
+	s64 elapsed;
+
+	reinit_completion(&core->xvs_event);
+
+	/*
+	 * With XVS wired to an interrupt, the frame in flight ends one frame
+	 * time after the last vertical sync, or earlier if the sensor signals
+	 * a new one after the standby request. Without it, or if XVS did not
+	 * toggle during the last frame, wait for the whole frame time.
+	 */
+	if (core->xvs_irq > 0) {
+		elapsed = ktime_us_delta(ktime_get(),
+					READ_ONCE(core->xvs_timestamp));
+		if (elapsed >= 0 && elapsed < frame_time) {
+			wait_for_completion_timeout(&core->xvs_event,
+				usecs_to_jiffies(frame_time - elapsed + 1000));
+			return;
+		}
+	}
+
+	usleep_range(frame_time, frame_time + 1000);
+}
+
+static void fr_sensor_stop_streaming(struct fr_sensor *core)
+{
+	const struct fr_sensor_desc *desc = core->desc;
+	struct device *dev = &core->client->dev;
+	ktime_t start = ktime_get();
+	int ret;
+
+	if (desc->ops->stream_stop)
+		desc->ops->stream_stop(core);
+
+	fr_sync_group_disarm(&core->sync);
+	WRITE_ONCE(core->xvs_active, false);
+
+	if (fr_sensor_is_gmsl(core)) {
+		max96793_bypassPCLK_dis(core->ser_dev);
+		max96792_stop_streaming(core->dser_dev, dev);
+	}
+
+	ret = fr_sensor_write_reg(core, desc->xmsta, 1, 0x01);
+	if (ret)
+		dev_err(dev, "%s failed to set XMSTA stop stream\n", __func__);
+
+	ret = fr_sensor_write_reg(core, desc->standby, 1,
+				FR_SENSOR_MODE_STANDBY);
+	if (ret)
+		dev_err(dev, "%s failed to set stream\n", __func__);
+
+	fr_sensor_wait_frame_end(core);
+	fr_latency_record(&core->latency, FR_STAGE_STOP, start);
+}
+
+static void fr_sensor_grab_ctrls(struct fr_sensor *core, bool grab)
+{
+	unsigned int i;
+
+	for (i = 0; i < FR_SENSOR_MAX_GRAB_CTRLS; i++)
+		if (core->grab_ctrls[i])
+			__v4l2_ctrl_grab(core->grab_ctrls[i], grab);
+}
+
+int fr_sensor_s_stream(struct v4l2_subdev *sd, int enable)
+{
+	struct fr_sensor *core = to_fr_sensor(sd);
+	struct device *dev = &core->client->dev;
+	int ret = 0;
+
+	trace_fr_stream_enter(dev, enable, 0);
+
+	/*
+	 * Resume before taking the lock, the runtime PM callbacks take it
+	 * as well and a suspend in flight would never finish otherwise.
+	 */
+	if (enable) {
+		ret = pm_runtime_resume_and_get(dev);
+		if (ret < 0) {
+			trace_fr_stream_exit(dev, enable, ret);
+			return ret;
+		}
+	}
+
+	mutex_lock(&core->mutex);
+	if (core->streaming == enable) {
+		mutex_unlock(&core->mutex);
+		if (enable)
+			pm_runtime_put_autosuspend(dev);
+		trace_fr_stream_exit(dev, enable, 0);
+		return 0;
+	}
+
+	if (enable) {
+		ret = fr_sensor_start_streaming(core);
+		if (ret)
+			goto err_rpm_put;
+	} else {
+		fr_sensor_stop_streaming(core);
+		pm_runtime_mark_last_busy(dev);
+		pm_runtime_put_autosuspend(dev);
+	}
+
+	core->streaming = enable;
+	fr_sensor_grab_ctrls(core, enable);
+
+	mutex_unlock(&core->mutex);
+
+	trace_fr_stream_exit(dev, enable, ret);
+
+	return ret;
+
+err_rpm_put:
+	mutex_unlock(&core->mutex);
+	pm_runtime_put_autosuspend(dev);
+
+	trace_fr_stream_exit(dev, enable, ret);
+
+	return ret;
+}
+EXPORT_SYMBOL(fr_sensor_s_stream);
+
+/*
+ * The reported pixel rate makes the nominal HMAX of a mode span exactly its
+ * width, anything a longer line adds shows up as horizontal blanking.
+ */
+static void fr_sensor_update_hblank(struct fr_sensor *core,
+				    const struct fr_sensor_frame_limits *lim)
+{
+	u64 line_length;
+	u32 hblank = 0;
+
+	line_length = ((u64)core->hmax * lim->pixel_rate) /
+						core->desc->xclk_freq;
+	if (line_length > lim->width)
+		hblank = line_length - lim->width;
+
+	__v4l2_ctrl_modify_range(core->hblank, hblank, hblank, 1, hblank);
+}
+
+/* Set the line length, together with the line time and HBLANK */
+void fr_sensor_set_hmax(struct fr_sensor *core, u32 hmax)
+{
+	struct fr_sensor_frame_limits lim;
+
+	core->desc->ops->frame_limits(core, &lim);
+
+	core->hmax = hmax;
+	core->line_time = (hmax * FR_SENSOR_G_FACTOR) / core->desc->xclk_freq;
+
+	fr_sensor_update_hblank(core, &lim);
+}
+EXPORT_SYMBOL(fr_sensor_set_hmax);
+
+/*
+ * Frame length for a frame rate in micro frames per second, reported
+ * through VBLANK. Unless it is the rate set by s_frame_interval, whose
+ * frame length is kept exactly.
+ */
+void fr_sensor_update_frame_rate(struct fr_sensor *core, u64 fps)
+{
+	struct fr_sensor_frame_limits lim;
+	u32 update_vblank;
+
+	/* Frame length was set exactly by s_frame_interval */
+	if (core->interval_fps && fps == core->interval_fps)
+		return;
+
+	core->desc->ops->frame_limits(core, &lim);
+
+	core->interval_fps = 0;
+
+	core->frame_length = (FR_SENSOR_M_FACTOR * FR_SENSOR_G_FACTOR) /
+						(fps * core->line_time);
+	core->frame_length = roundup(core->frame_length,
+				     core->desc->vmax_step);
+
+	update_vblank = core->frame_length - lim.height;
+
+	__v4l2_ctrl_modify_range(core->vblank, update_vblank,
+				 update_vblank, 1, update_vblank);
+
+	__v4l2_ctrl_s_ctrl(core->vblank, update_vblank);
+}
+EXPORT_SYMBOL(fr_sensor_update_frame_rate);
+
+/*
+ * Search the HMAX and VMAX whose frame time comes closest to the requested
+ * interval, preferring the shortest line that gets there. VMAX is kept to
+ * multiples of the sensor's VMAX step and to the range between the
+ * shortest frame and the one of the slowest frame rate of the mode.
+ */
+void fr_sensor_find_frame_timing(struct fr_sensor *core,
+				 const struct v4l2_fract *interval,
+				 u32 *hmax, u32 *vmax)
+{
+	const struct fr_sensor_desc *desc = core->desc;
+	struct fr_sensor_frame_limits lim;
+	u64 target = (u64)desc->xclk_freq * interval->numerator;
+	u64 best_err = U64_MAX;
+	u64 period, err, v;
+	u32 h, v_max;
+
+	desc->ops->frame_limits(core, &lim);
+
+	*hmax = lim.hmax_min;
+	*vmax = lim.vmax_min;
+
+	for (h = lim.hmax_min; h <= desc->hmax_max; h++) {
+		period = (u64)h * interval->denominator;
+
+		/* Longer lines only move further away from the request */
+		if (period * lim.vmax_min > target &&
+		    period * lim.vmax_min - target >= best_err)
+			break;
+
+		v_max = min_t(u64, desc->vmax_max,
+			      (desc->xclk_freq * FR_SENSOR_M_FACTOR) /
+			      ((u64)h * lim.min_fps));
+		v_max = rounddown(v_max, desc->vmax_step);
+		if (v_max < lim.vmax_min)
+			break;
+
+		v = (target + period * desc->vmax_step / 2) /
+			(period * desc->vmax_step) * desc->vmax_step;
+		v = clamp_t(u64, v, lim.vmax_min, v_max);
+
+		err = period * v > target ? period * v - target :
+					    target - period * v;
+		if (err < best_err) {
+			best_err = err;
+			*hmax = h;
+			*vmax = v;
+		}
+
+		if (!err)
+			break;
+	}
+}
+EXPORT_SYMBOL(fr_sensor_find_frame_timing);
+
+int fr_sensor_g_frame_interval(struct v4l2_subdev *sd,
+			       struct v4l2_subdev_frame_interval *fi)
+{
+	struct fr_sensor *core = to_fr_sensor(sd);
+	unsigned long num, den;
+
+	if (fi->pad != FR_SENSOR_IMAGE_PAD)
+		return -EINVAL;
+
+	mutex_lock(&core->mutex);
+
+	rational_best_approximation((u64)core->hmax *
+				    fr_sensor_frame_lines(core),
+				    core->desc->xclk_freq, U32_MAX, U32_MAX,
+				    &num, &den);
+
+	mutex_unlock(&core->mutex);
+
+	fi->interval.numerator = num;
+	fi->interval.denominator = den;
+
+	return 0;
+}
+EXPORT_SYMBOL(fr_sensor_g_frame_interval);
+
+int fr_sensor_s_frame_interval(struct v4l2_subdev *sd,
+			       struct v4l2_subdev_frame_interval *fi)
+{
+	struct fr_sensor *core = to_fr_sensor(sd);
+	struct device *dev = &core->client->dev;
+	struct fr_sensor_frame_limits lim;
+	struct v4l2_fract interval;
+	unsigned long num, den;
+	u64 max_framerate;
+	u32 hmax, vmax, update_vblank;
+	int ret = 0;
+
+	if (fi->pad != FR_SENSOR_IMAGE_PAD)
+		return -EINVAL;
+
+	if (!fi->interval.numerator || !fi->interval.denominator)
+		return -EINVAL;
+
+	mutex_lock(&core->mutex);
+
+	/* HMAX can not be changed while streaming */
+	if (core->streaming) {
+		ret = -EBUSY;
+		goto unlock;
+	}
+
+	rational_best_approximation(fi->interval.numerator,
+				    fi->interval.denominator,
+				    FR_SENSOR_INTERVAL_MAX,
+				    FR_SENSOR_INTERVAL_MAX, &num, &den);
+	interval.numerator = num;
+	interval.denominator = den;
+
+	fr_sensor_find_frame_timing(core, &interval, &hmax, &vmax);
+
+	fr_sensor_set_hmax(core, hmax);
+	core->frame_length = vmax;
+	core->interval_fps = (core->desc->xclk_freq * FR_SENSOR_M_FACTOR) /
+							((u64)hmax * vmax);
+
+	dev_dbg(dev, "%s: %u/%u s: hmax 0x%x, vmax %u\n", __func__,
+			interval.numerator, interval.denominator, hmax, vmax);
+
+	core->desc->ops->frame_limits(core, &lim);
+
+	update_vblank = core->frame_length - lim.height;
+	__v4l2_ctrl_modify_range(core->vblank, update_vblank,
+				 update_vblank, 1, update_vblank);
+	__v4l2_ctrl_s_ctrl(core->vblank, update_vblank);
+
+	max_framerate = (FR_SENSOR_G_FACTOR * FR_SENSOR_M_FACTOR) /
+			(lim.vmax_min * core->line_time);
+	max_framerate = max_t(u64, max_framerate, core->interval_fps);
+
+	__v4l2_ctrl_modify_range(core->framerate, lim.min_fps,
+				 max_framerate, 1, max_framerate);
+	__v4l2_ctrl_s_ctrl(core->framerate, core->interval_fps);
+
+	/* HMAX changed, reprogram the sensor while it is still in standby */
+	fr_sensor_invalidate_staging(core);
+
+	rational_best_approximation((u64)hmax * vmax, core->desc->xclk_freq,
+				    U32_MAX, U32_MAX, &num, &den);
+	fi->interval.numerator = num;
+	fi->interval.denominator = den;
+
+unlock:
+	mutex_unlock(&core->mutex);
+
+	return ret;
+}
+EXPORT_SYMBOL(fr_sensor_s_frame_interval);
+
+static struct fr_sensor *dev_to_fr_sensor(struct device *dev)
+{
+	return to_fr_sensor(i2c_get_clientdata(to_i2c_client(dev)));
+}
+
+int fr_sensor_runtime_resume(struct device *dev)
+{
+	struct fr_sensor *core = dev_to_fr_sensor(dev);
+
+	core->common_regs_written = false;
+	core->staged = false;
+
+	fr_sensor_power_on(core);
+
+	return 0;
+}
+EXPORT_SYMBOL(fr_sensor_runtime_resume);
+
+int fr_sensor_runtime_suspend(struct device *dev)
+{
+	struct fr_sensor *core = dev_to_fr_sensor(dev);
+
+	if (core->desc->ops->power_off)
+		core->desc->ops->power_off(core);
+
+	mutex_lock(&core->mutex);
+	core->common_regs_written = false;
+	core->staged = false;
+	fr_sensor_power_off(core);
+	mutex_unlock(&core->mutex);
+
+	return 0;
+}
+EXPORT_SYMBOL(fr_sensor_runtime_suspend);
+
+static int __maybe_unused fr_sensor_suspend(struct device *dev)
+{
+	struct fr_sensor *core = dev_to_fr_sensor(dev);
+
+	mutex_lock(&core->mutex);
+	if (core->streaming)
+		fr_sensor_stop_streaming(core);
+	mutex_unlock(&core->mutex);
+
+	return 0;
+}
+
+static int __maybe_unused fr_sensor_resume(struct device *dev)
+{
+	struct fr_sensor *core = dev_to_fr_sensor(dev);
+	int ret = 0;
+
+	mutex_lock(&core->mutex);
+	if (core->streaming) {
+		ret = fr_sensor_start_streaming(core);
+		if (ret) {
+			fr_sensor_stop_streaming(core);
+			core->streaming = false;
+		}
+	}
+	mutex_unlock(&core->mutex);
+
+	return ret;
+}
+
+const struct dev_pm_ops fr_sensor_pm_ops = {
+	SET_SYSTEM_SLEEP_PM_OPS(fr_sensor_suspend, fr_sensor_resume)
+	SET_RUNTIME_PM_OPS(fr_sensor_runtime_suspend, fr_sensor_runtime_resume,
+			   NULL)
+};
+EXPORT_SYMBOL(fr_sensor_pm_ops);
+
+/*
+ * Hand the powered sensor over to runtime PM. It is kept powered for a
+ * while after streaming stops, so that quick stop/start cycles skip the
+ * power sequencing and reprogramming.
+ */
+void fr_sensor_pm_enable(struct fr_sensor *core)
+{
+	struct device *dev = &core->client->dev;
+	u32 autosuspend_delay;
+
+	if (device_property_read_u32(dev, "autosuspend-delay-ms",
+					&autosuspend_delay))
+		autosuspend_delay = FR_SENSOR_AUTOSUSPEND_DELAY_MS;
+
+	pm_runtime_set_active(dev);
+	pm_runtime_set_autosuspend_delay(dev, autosuspend_delay);
+	pm_runtime_use_autosuspend(dev);
+	pm_runtime_enable(dev);
+	pm_runtime_idle(dev);
+}
+EXPORT_SYMBOL(fr_sensor_pm_enable);
+
+void fr_sensor_pm_disable(struct fr_sensor *core)
+{
+	struct device *dev = &core->client->dev;
+
+	pm_runtime_disable(dev);
+	pm_runtime_dont_use_autosuspend(dev);
+	if (!pm_runtime_status_suspended(dev))
+		fr_sensor_runtime_suspend(dev);
+	pm_runtime_set_suspended(dev);
+}
+EXPORT_SYMBOL(fr_sensor_pm_disable);
+
+MODULE_DESCRIPTION("Common code of the FRAMOS IMX sensor drivers");
+MODULE_AUTHOR("FRAMOS GmbH");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,254 @@
+/* SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_sensor_core.h - common code of the FRAMOS IMX sensor drivers header
+ */
+
+#ifndef __FR_SENSOR_CORE_H__
+#define __FR_SENSOR_CORE_H__
+
+#include <linux/atomic.h>
+#include <linux/completion.h>
+#include <linux/device.h>
+#include <linux/gpio/consumer.h>
+#include <linux/i2c.h>
+#include <linux/ktime.h>
+#include <linux/mutex.h>
+#include <linux/of.h>
+#include <linux/pm.h>
+#include <linux/types.h>
+#include <linux/workqueue.h>
+#include <media/v4l2-ctrls.h>
+#include <media/v4l2-subdev.h>
+
+#include "fr_stats.h"
+#include "fr_sync_group.h"
+#include "gmsl-link.h"
+
+/* Stages of the stream start and stop, timed in debugfs "latency" */
+enum fr_sensor_stage {
+	FR_STAGE_SERDES_SETUP,
+	FR_STAGE_SERDES_START,
+	FR_STAGE_COMMON_REGS,
+	FR_STAGE_MODE_REGS,
+	FR_STAGE_DATA_RATE,
+	FR_STAGE_CONTROLS,
+	FR_STAGE_STANDBY,
+	FR_STAGE_XMSTA,
+	FR_STAGE_START,
+	FR_STAGE_STOP,
+	FR_NUM_STAGES,
+};
+
+/* Controls that can not change while streaming */
+#define FR_SENSOR_MAX_GRAB_CTRLS	4
+
+struct fr_sensor_reg {
+	u16 address;
+	u8 val;
+};
+
+struct fr_sensor_reg_list {
+	unsigned int num_of_regs;
+	const struct fr_sensor_reg *regs;
+	const char *name;
+};
+
+struct fr_sensor;
+
+/*
+ * Timing limits of the current mode. The reported pixel rate makes a line
+ * of hmax_min INCK periods span exactly the width, vmax_min is the shortest
+ * frame in lines.
+ */
+struct fr_sensor_frame_limits {
+	u32 width;
+	u32 height;
+	u32 pixel_rate;
+	u32 hmax_min;
+	u32 vmax_min;
+	u32 min_fps;
+};
+
+/*
+ * Sensor specific parts of the GMSL bring-up, all optional. gmsl_parse()
+ * reads additional properties of the "gmsl-link" node at probe.
+ * gmsl_ser_setup() configures the serializer trigger input and replaces
+ * the default gpio10/xtrig1 setup, gmsl_dser_setup() runs last and sets
+ * up any further pins forwarded over the link.
+ *
+ * The rest is called with the core mutex held. set_mode() programs the
+ * current mode into the sensor in standby, the controls are applied by
+ * the core afterwards. is_master() tells whether the sensor drives XVS
+ * and XHS itself, frame_limits() describes the current mode. The optional
+ * stream_stop() runs first on every stream stop.
+ *
+ * power_off() is optional and runs without the lock, right before runtime
+ * PM powers the sensor down.
+ */
+struct fr_sensor_ops {
+	int (*gmsl_parse)(struct fr_sensor *core, struct device_node *gmsl);
+	int (*gmsl_ser_setup)(struct fr_sensor *core);
+	int (*gmsl_dser_setup)(struct fr_sensor *core);
+
+	int (*set_mode)(struct fr_sensor *core);
+	bool (*is_master)(struct fr_sensor *core);
+	void (*frame_limits)(struct fr_sensor *core,
+			     struct fr_sensor_frame_limits *lim);
+	void (*stream_stop)(struct fr_sensor *core);
+
+	void (*power_off)(struct fr_sensor *core);
+};
+
+/*
+ * Constant description of a sensor model. The identification register is
+ * read at probe to check that the sensor answers, link_freqs must match
+ * the link-frequencies of the device tree endpoint one to one. HMAX is
+ * counted in periods of xclk_freq, VMAX in lines and in steps of
+ * vmax_step. The sensor needs settle_us after leaving standby before
+ * XMSTA starts it.
+ */
+struct fr_sensor_desc {
+	u16 reghold;
+	u16 standby;
+	u16 xmsta;
+	u16 id_reg;
+	u32 id_len;
+	u32 xclk_freq;
+	u32 hmax_max;
+	u32 vmax_max;
+	u32 vmax_step;
+	u32 settle_us;
+	const s64 *link_freqs;
+	unsigned int num_link_freqs;
+	const struct fr_sensor_ops *ops;
+};
+
+/*
+ * State shared by all FRAMOS sensor drivers, embedded in the driver's
+ * private data. mutex also protects the driver's own state and is the lock
+ * of its control handler. Register access and the GMSL helpers expect the
+ * caller to hold it, the stream, staging and PM code below takes it itself.
+ * The one exception is the release of a sync group, which writes to a
+ * sensor on behalf of another member, so i2c_class is only accessed with
+ * READ_ONCE()/WRITE_ONCE().
+ *
+ * hmax and frame_length are the line and frame length set by the frame
+ * rate, line_time is the line length in ns. vmax is the frame length the
+ * sensor runs with when the driver stretches the frame beyond that, and
+ * interval_fps is the frame rate, in micro frames per second, set exactly
+ * by the last s_frame_interval, 0 otherwise.
+ */
+struct fr_sensor {
+	struct v4l2_subdev sd;
+	struct i2c_client *client;
+	const struct fr_sensor_desc *desc;
+	struct mutex mutex;
+	u32 fmt_code;
+
+	u32 hmax;
+	u32 frame_length;
+	u32 vmax;
+	u64 line_time;
+	u32 interval_fps;
+
+	struct v4l2_ctrl *framerate;
+	struct v4l2_ctrl *vblank;
+	struct v4l2_ctrl *hblank;
+	struct v4l2_ctrl *grab_ctrls[FR_SENSOR_MAX_GRAB_CTRLS];
+
+	bool streaming;
+	bool common_regs_written;
+	bool staged;
+	struct delayed_work stage_work;
+
+	struct gpio_desc *xvs_gpio;
+	int xvs_irq;
+	ktime_t xvs_timestamp;
+	struct completion xvs_event;
+	bool xvs_active;
+	atomic_t xvs_sequence;
+
+	struct fr_sync_member sync;
+
+	struct fr_latency_stage latency_stages[FR_NUM_STAGES];
+	struct fr_latency latency;
+
+	struct fr_i2c_stats i2c_stats;
+	enum fr_i2c_class i2c_class;
+
+	struct gpio_desc *reset_gpio;
+
+	const char *gmsl;
+	struct device *ser_dev;
+	struct device *dser_dev;
+	struct gmsl_link_ctx g_ctx;
+};
+
+static inline bool fr_sensor_is_gmsl(const struct fr_sensor *core)
+{
+	return !strcmp(core->gmsl, "gmsl");
+}
+
+static inline struct fr_sensor *to_fr_sensor(struct v4l2_subdev *sd)
+{
+	return container_of(sd, struct fr_sensor, sd);
+}
+
+/* Frame length in lines the sensor currently runs with */
+static inline u32 fr_sensor_frame_lines(const struct fr_sensor *core)
+{
+	return max(core->frame_length, core->vmax);
+}
+
+void fr_sensor_init(struct fr_sensor *core, struct i2c_client *client,
+		    const struct fr_sensor_desc *desc);
+
+int fr_sensor_read_reg(struct fr_sensor *core, u16 reg, u32 len, u32 *val);
+int fr_sensor_write_reg(struct fr_sensor *core, u16 reg, u32 len, u32 val);
+int fr_sensor_write_hold_reg(struct fr_sensor *core, u16 reg, u32 len,
+			     u32 val);
+int __fr_sensor_write_table(struct fr_sensor *core,
+			    const struct fr_sensor_reg *regs, u32 len,
+			    const char *name);
+
+/* Register tables show up in traces under the name they are passed by */
+#define fr_sensor_write_table(core, regs, len) \
+	__fr_sensor_write_table(core, regs, len, #regs)
+
+int fr_sensor_identify(struct fr_sensor *core);
+int fr_sensor_probe(struct fr_sensor *core);
+void fr_sensor_remove(struct fr_sensor *core);
+
+void fr_sensor_power_on(struct fr_sensor *core);
+void fr_sensor_power_off(struct fr_sensor *core);
+
+int fr_sensor_gmsl_serdes_setup(struct fr_sensor *core);
+void fr_sensor_gmsl_serdes_reset(struct fr_sensor *core);
+int fr_sensor_gmsl_start_streaming(struct fr_sensor *core, u32 fmt_code);
+
+int fr_sensor_xvs_init(struct fr_sensor *core);
+void fr_sensor_invalidate_staging(struct fr_sensor *core);
+int fr_sensor_join_sync_group(struct fr_sensor *core);
+void fr_sensor_debugfs_create(struct fr_sensor *core, struct dentry *parent);
+
+void fr_sensor_set_hmax(struct fr_sensor *core, u32 hmax);
+void fr_sensor_update_frame_rate(struct fr_sensor *core, u64 fps);
+void fr_sensor_find_frame_timing(struct fr_sensor *core,
+				 const struct v4l2_fract *interval,
+				 u32 *hmax, u32 *vmax);
+
+int fr_sensor_s_stream(struct v4l2_subdev *sd, int enable);
+int fr_sensor_g_frame_interval(struct v4l2_subdev *sd,
+			       struct v4l2_subdev_frame_interval *fi);
+int fr_sensor_s_frame_interval(struct v4l2_subdev *sd,
+			       struct v4l2_subdev_frame_interval *fi);
+
+int fr_sensor_runtime_resume(struct device *dev);
+int fr_sensor_runtime_suspend(struct device *dev);
+void fr_sensor_pm_enable(struct fr_sensor *core);
+void fr_sensor_pm_disable(struct fr_sensor *core);
+extern const struct dev_pm_ops fr_sensor_pm_ops;
+
+#endif /* __FR_SENSOR_CORE_H__ */
@@ -0,0 +1,833 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_sensor_emu.c - emulated FRAMOS IMX sensors for hardware-free testing
+ *
+ * Registers a virtual I2C adapter with one emulated sensor per entry of the
+ * "sensors" module parameter, and instantiates the real fr_imx* drivers on
+ * it from software nodes describing a 4-lane MIPI CSI-2 connection. Each
+ * sensor has a 64k register file that the driver programs as usual:
+ *
+ *  - writes while REGHOLD is set are buffered and applied when it clears,
+ *  - STANDBY and XMSTA are tracked to tell whether the sensor streams,
+ *  - the IMX900 CHROMACITY register reports the "chromacity" parameter,
+ *  - the reset line is provided by an emulated GPIO chip, and a sensor in
+ *    reset does not acknowledge its address and loses its registers.
+ *
+ * Every transfer takes "latency_us" plus the time the bytes need on a bus
+ * clocked at "bus_khz", so that driver changes can be benchmarked with
+ * realistic register traffic costs.
+ *
+ * The emulator also acts as a minimal bridge: it binds the sensor
+ * sub-devices, creates their device nodes for format negotiation and
+ * provides a debugfs "stream" file per sensor to start and stop streaming,
+ * next to a "state" file reporting the emulated sensor state and traffic.
+ */
+
+#include <linux/bitmap.h>
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/gpio/driver.h>
+#include <linux/gpio/machine.h>
+#include <linux/i2c.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/platform_device.h>
+#include <linux/property.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <media/v4l2-async.h>
+#include <media/v4l2-device.h>
+#include <media/v4l2-fwnode.h>
+#include <media/v4l2-subdev.h>
+
+#define FR_EMU_MAX_SENSORS		4
+#define FR_EMU_NUM_REGS			0x10000
+#define FR_EMU_GPIOS_PER_SENSOR		2
+#define FR_EMU_GPIO_RESET		0
+#define FR_EMU_GPIO_XMASTER		1
+#define FR_EMU_MAX_LINK_FREQS		5
+
+#define FR_EMU_STANDBY			0x3000
+
+static char *sensors = "imx678";
+module_param(sensors, charp, 0444);
+MODULE_PARM_DESC(sensors, "Comma separated list of emulated sensors (imx662, imx676, imx678, imx900)");
+
+static unsigned int latency_us;
+module_param(latency_us, uint, 0644);
+MODULE_PARM_DESC(latency_us, "Fixed latency of every I2C transfer in microseconds");
+
+static unsigned int bus_khz = 400;
+module_param(bus_khz, uint, 0644);
+MODULE_PARM_DESC(bus_khz, "Emulated I2C bus clock in kHz, 0 for infinitely fast");
+
+static unsigned int chromacity;
+module_param(chromacity, uint, 0444);
+MODULE_PARM_DESC(chromacity, "Chromacity reported by an IMX900 (0 color, 1 mono)");
+
+struct fr_emu_model {
+	const char *name;
+	const char *type;
+	u16 addr;
+	u16 reghold;
+	u16 xmsta;
+	u16 chromacity;
+	u64 link_freqs[FR_EMU_MAX_LINK_FREQS];
+	unsigned int num_link_freqs;
+};
+
+/* Link frequencies are listed in the order the drivers expect them in DT */
+static const struct fr_emu_model fr_emu_models[] = {
+	{
+		.name = "imx662",
+		.type = "fr_imx662",
+		.addr = 0x1a,
+		.reghold = 0x3001,
+		.xmsta = 0x3002,
+		.link_freqs = { 750000000, 360000000, 297000000 },
+		.num_link_freqs = 3,
+	},
+	{
+		.name = "imx676",
+		.type = "fr_imx676",
+		.addr = 0x1a,
+		.reghold = 0x3001,
+		.xmsta = 0x3002,
+		.link_freqs = { 750000000, 720000000, 445500000, 360000000,
+				297000000 },
+		.num_link_freqs = 5,
+	},
+	{
+		.name = "imx678",
+		.type = "fr_imx678",
+		.addr = 0x1a,
+		.reghold = 0x3001,
+		.xmsta = 0x3002,
+		.link_freqs = { 750000000, 720000000, 594000000, 445500000 },
+		.num_link_freqs = 4,
+	},
+	{
+		.name = "imx900",
+		.type = "fr_imx900",
+		.addr = 0x1a,
+		.reghold = 0x30f8,
+		.xmsta = 0x3010,
+		.chromacity = 0x3817,
+		.link_freqs = { 750000000, 742500000, 594000000, 445500000 },
+		.num_link_freqs = 4,
+	},
+};
+
+static const u32 fr_emu_data_lanes[] = { 1, 2, 3, 4 };
+
+struct fr_emu;
+
+struct fr_emu_sensor {
+	struct fr_emu *emu;
+	const struct fr_emu_model *model;
+	unsigned int index;
+	u16 addr;
+
+	char node_name[24];
+	char dev_name[16];
+	struct property_entry ep_props[4];
+	struct property_entry port_props[2];
+	struct software_node nodes[3];
+	const struct software_node *group[4];
+	struct gpiod_lookup_table *gpios;
+
+	struct i2c_client *client;
+	struct v4l2_subdev *sd;
+	struct dentry *debugfs;
+
+	bool reset_released;
+	bool xmaster;
+	bool hold;
+	u16 ptr;
+
+	u64 reads;
+	u64 writes;
+	u64 bytes;
+	u64 nacks;
+	u64 commits;
+	u64 stream_starts;
+
+	u8 regs[FR_EMU_NUM_REGS];
+	u8 shadow[FR_EMU_NUM_REGS];
+	DECLARE_BITMAP(pending, FR_EMU_NUM_REGS);
+};
+
+struct fr_emu {
+	struct platform_device *pdev;
+	struct i2c_adapter adap;
+	struct gpio_chip gc;
+	struct v4l2_device v4l2_dev;
+	struct v4l2_async_notifier notifier;
+	struct dentry *debugfs;
+
+	/* Serializes bus transfers and GPIO changes */
+	struct mutex lock;
+
+	unsigned int num_sensors;
+	struct fr_emu_sensor *sensors[FR_EMU_MAX_SENSORS];
+};
+
+static struct fr_emu *fr_emu;
+
+static const struct fr_emu_model *fr_emu_find_model(const char *name)
+{
+	unsigned int i;
+
+	for (i = 0; i < ARRAY_SIZE(fr_emu_models); i++)
+		if (!strcmp(fr_emu_models[i].name, name))
+			return &fr_emu_models[i];
+
+	return NULL;
+}
+
+static struct fr_emu_sensor *fr_emu_find_sensor(struct fr_emu *emu, u16 addr)
+{
+	unsigned int i;
+
+	for (i = 0; i < emu->num_sensors; i++)
+		if (emu->sensors[i]->addr == addr)
+			return emu->sensors[i];
+
+	return NULL;
+}
+
+/* Register state after power-up: standby, slave start held off */
+static void fr_emu_sensor_reset(struct fr_emu_sensor *sensor)
+{
+	const struct fr_emu_model *model = sensor->model;
+
+	memset(sensor->regs, 0, sizeof(sensor->regs));
+	bitmap_zero(sensor->pending, FR_EMU_NUM_REGS);
+
+	sensor->regs[FR_EMU_STANDBY] = 0x01;
+	sensor->regs[model->xmsta] = 0x01;
+	if (model->chromacity)
+		sensor->regs[model->chromacity] = chromacity ? 0x80 : 0x00;
+
+	sensor->hold = false;
+	sensor->ptr = 0;
+}
+
+static bool fr_emu_sensor_streaming(struct fr_emu_sensor *sensor)
+{
+	if (sensor->regs[FR_EMU_STANDBY] & 0x01)
+		return false;
+
+	/* A master, XMASTER pulled low, only starts once XMSTA is cleared */
+	return sensor->xmaster || !(sensor->regs[sensor->model->xmsta] & 0x01);
+}
+
+static void fr_emu_sensor_write(struct fr_emu_sensor *sensor, u16 addr, u8 val)
+{
+	const struct fr_emu_model *model = sensor->model;
+	bool streaming = fr_emu_sensor_streaming(sensor);
+	unsigned int i;
+
+	if (addr == model->reghold) {
+		sensor->regs[addr] = val;
+		sensor->hold = val & 0x01;
+		if (sensor->hold)
+			return;
+
+		for_each_set_bit(i, sensor->pending, FR_EMU_NUM_REGS)
+			sensor->regs[i] = sensor->shadow[i];
+		bitmap_zero(sensor->pending, FR_EMU_NUM_REGS);
+		sensor->commits++;
+		return;
+	}
+
+	/* Standby and master start take effect immediately */
+	if (sensor->hold && addr != FR_EMU_STANDBY && addr != model->xmsta) {
+		sensor->shadow[addr] = val;
+		set_bit(addr, sensor->pending);
+		return;
+	}
+
+	/* Status registers are read-only */
+	if (model->chromacity && addr == model->chromacity)
+		return;
+
+	sensor->regs[addr] = val;
+
+	if (!streaming && fr_emu_sensor_streaming(sensor))
+		sensor->stream_starts++;
+}
+
+static void fr_emu_delay(unsigned int bytes)
+{
+	u64 ns = (u64)latency_us * NSEC_PER_USEC;
+
+	/* Address byte plus the payload, 9 clocks each */
+	if (bus_khz)
+		ns += div_u64((u64)(bytes + 1) * 9 * NSEC_PER_MSEC, bus_khz);
+
+	if (ns >= NSEC_PER_USEC)
+		fsleep(div_u64(ns, NSEC_PER_USEC));
+}
+
+static int fr_emu_xfer_msg(struct fr_emu_sensor *sensor, struct i2c_msg *msg)
+{
+	unsigned int i;
+
+	if (msg->flags & I2C_M_RD) {
+		for (i = 0; i < msg->len; i++)
+			msg->buf[i] = sensor->regs[sensor->ptr++];
+		sensor->reads++;
+		return 0;
+	}
+
+	if (msg->len < 2)
+		return -EIO;
+
+	sensor->ptr = (msg->buf[0] << 8) | msg->buf[1];
+	for (i = 2; i < msg->len; i++)
+		fr_emu_sensor_write(sensor, sensor->ptr++, msg->buf[i]);
+
+	if (msg->len > 2)
+		sensor->writes++;
+
+	return 0;
+}
+
+static int fr_emu_master_xfer(struct i2c_adapter *adap, struct i2c_msg *msgs,
+			      int num)
+{
+	struct fr_emu *emu = i2c_get_adapdata(adap);
+	struct fr_emu_sensor *sensor;
+	unsigned int bytes = 0;
+	int ret = num;
+	int i;
+
+	mutex_lock(&emu->lock);
+
+	for (i = 0; i < num; i++) {
+		sensor = fr_emu_find_sensor(emu, msgs[i].addr);
+		if (!sensor || !sensor->reset_released) {
+			if (sensor)
+				sensor->nacks++;
+			ret = -ENXIO;
+			break;
+		}
+
+		if (fr_emu_xfer_msg(sensor, &msgs[i])) {
+			ret = -EIO;
+			break;
+		}
+
+		bytes += msgs[i].len;
+		sensor->bytes += msgs[i].len;
+	}
+
+	mutex_unlock(&emu->lock);
+
+	fr_emu_delay(bytes);
+
+	return ret;
+}
+
+static u32 fr_emu_functionality(struct i2c_adapter *adap)
+{
+	return I2C_FUNC_I2C;
+}
+
+static const struct i2c_algorithm fr_emu_algo = {
+	.master_xfer = fr_emu_master_xfer,
+	.functionality = fr_emu_functionality,
+};
+
+static int fr_emu_gpio_get(struct gpio_chip *gc, unsigned int offset)
+{
+	struct fr_emu *emu = gpiochip_get_data(gc);
+	struct fr_emu_sensor *sensor;
+
+	sensor = emu->sensors[offset / FR_EMU_GPIOS_PER_SENSOR];
+
+	if (offset % FR_EMU_GPIOS_PER_SENSOR == FR_EMU_GPIO_RESET)
+		return sensor->reset_released;
+
+	return sensor->xmaster;
+}
+
+static void fr_emu_gpio_set(struct gpio_chip *gc, unsigned int offset,
+			    int value)
+{
+	struct fr_emu *emu = gpiochip_get_data(gc);
+	struct fr_emu_sensor *sensor;
+
+	sensor = emu->sensors[offset / FR_EMU_GPIOS_PER_SENSOR];
+
+	mutex_lock(&emu->lock);
+
+	if (offset % FR_EMU_GPIOS_PER_SENSOR == FR_EMU_GPIO_RESET) {
+		if (value && !sensor->reset_released)
+			fr_emu_sensor_reset(sensor);
+		sensor->reset_released = value;
+	} else {
+		sensor->xmaster = value;
+	}
+
+	mutex_unlock(&emu->lock);
+}
+
+static int fr_emu_gpio_direction_output(struct gpio_chip *gc,
+					unsigned int offset, int value)
+{
+	fr_emu_gpio_set(gc, offset, value);
+
+	return 0;
+}
+
+static int fr_emu_gpio_get_direction(struct gpio_chip *gc, unsigned int offset)
+{
+	return GPIO_LINE_DIRECTION_OUT;
+}
+
+static int fr_emu_state_show(struct seq_file *s, void *unused)
+{
+	struct fr_emu_sensor *sensor = s->private;
+	struct fr_emu *emu = sensor->emu;
+
+	mutex_lock(&emu->lock);
+
+	seq_printf(s, "model: %s\n", sensor->model->name);
+	seq_printf(s, "address: 0x%02x\n", sensor->addr);
+	seq_printf(s, "reset: %s\n", sensor->reset_released ? "released" :
+								"asserted");
+	seq_printf(s, "master: %d\n", !sensor->xmaster);
+	seq_printf(s, "standby: %d\n", sensor->regs[FR_EMU_STANDBY] & 0x01);
+	seq_printf(s, "xmsta: %d\n",
+			sensor->regs[sensor->model->xmsta] & 0x01);
+	seq_printf(s, "hold: %d\n", sensor->hold);
+	seq_printf(s, "pending: %u\n",
+			bitmap_weight(sensor->pending, FR_EMU_NUM_REGS));
+	seq_printf(s, "streaming: %d\n", fr_emu_sensor_streaming(sensor));
+	seq_printf(s, "stream_starts: %llu\n", sensor->stream_starts);
+	seq_printf(s, "reads: %llu\n", sensor->reads);
+	seq_printf(s, "writes: %llu\n", sensor->writes);
+	seq_printf(s, "bytes: %llu\n", sensor->bytes);
+	seq_printf(s, "nacks: %llu\n", sensor->nacks);
+	seq_printf(s, "hold_commits: %llu\n", sensor->commits);
+
+	mutex_unlock(&emu->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(fr_emu_state);
+
+static ssize_t fr_emu_stream_write(struct file *file, const char __user *buf,
+				   size_t count, loff_t *ppos)
+{
+	struct fr_emu_sensor *sensor = file->private_data;
+	bool enable;
+	int ret;
+
+	ret = kstrtobool_from_user(buf, count, &enable);
+	if (ret)
+		return ret;
+
+	if (!sensor->sd)
+		return -ENODEV;
+
+	ret = v4l2_subdev_call(sensor->sd, video, s_stream, enable);
+	if (ret)
+		return ret;
+
+	return count;
+}
+
+static const struct file_operations fr_emu_stream_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.write = fr_emu_stream_write,
+	.llseek = noop_llseek,
+};
+
+static int fr_emu_notify_bound(struct v4l2_async_notifier *notifier,
+			       struct v4l2_subdev *sd,
+			       struct v4l2_async_connection *asc)
+{
+	struct fr_emu *emu = container_of(notifier, struct fr_emu, notifier);
+	unsigned int i;
+
+	for (i = 0; i < emu->num_sensors; i++) {
+		if (sd->fwnode != software_node_fwnode(&emu->sensors[i]->nodes[0]))
+			continue;
+
+		emu->sensors[i]->sd = sd;
+		dev_info(&emu->pdev->dev, "%s: bound %s\n", __func__, sd->name);
+		return 0;
+	}
+
+	return -ENODEV;
+}
+
+static void fr_emu_notify_unbind(struct v4l2_async_notifier *notifier,
+				 struct v4l2_subdev *sd,
+				 struct v4l2_async_connection *asc)
+{
+	struct fr_emu *emu = container_of(notifier, struct fr_emu, notifier);
+	unsigned int i;
+
+	for (i = 0; i < emu->num_sensors; i++)
+		if (emu->sensors[i]->sd == sd)
+			emu->sensors[i]->sd = NULL;
+}
+
+static int fr_emu_notify_complete(struct v4l2_async_notifier *notifier)
+{
+	struct fr_emu *emu = container_of(notifier, struct fr_emu, notifier);
+
+	return v4l2_device_register_subdev_nodes(&emu->v4l2_dev);
+}
+
+static const struct v4l2_async_notifier_operations fr_emu_notify_ops = {
+	.bound = fr_emu_notify_bound,
+	.unbind = fr_emu_notify_unbind,
+	.complete = fr_emu_notify_complete,
+};
+
+static int fr_emu_sensor_nodes_register(struct fr_emu_sensor *sensor)
+{
+	const struct fr_emu_model *model = sensor->model;
+
+	snprintf(sensor->node_name, sizeof(sensor->node_name), "%s-emu.%u",
+					model->name, sensor->index);
+
+	sensor->port_props[0] = PROPERTY_ENTRY_U32("reg", 0);
+
+	sensor->ep_props[0] = PROPERTY_ENTRY_U32("bus-type",
+					V4L2_FWNODE_BUS_TYPE_CSI2_DPHY);
+	sensor->ep_props[1] = PROPERTY_ENTRY_U32_ARRAY("data-lanes",
+					fr_emu_data_lanes);
+	sensor->ep_props[2] = PROPERTY_ENTRY_U64_ARRAY_LEN("link-frequencies",
+					model->link_freqs, model->num_link_freqs);
+
+	sensor->nodes[0] = (struct software_node) {
+		.name = sensor->node_name,
+	};
+	sensor->nodes[1] = (struct software_node) {
+		.name = "port@0",
+		.parent = &sensor->nodes[0],
+		.properties = sensor->port_props,
+	};
+	sensor->nodes[2] = (struct software_node) {
+		.name = "endpoint@0",
+		.parent = &sensor->nodes[1],
+		.properties = sensor->ep_props,
+	};
+
+	sensor->group[0] = &sensor->nodes[0];
+	sensor->group[1] = &sensor->nodes[1];
+	sensor->group[2] = &sensor->nodes[2];
+
+	return software_node_register_node_group(sensor->group);
+}
+
+static int fr_emu_sensor_gpios_register(struct fr_emu_sensor *sensor)
+{
+	struct fr_emu *emu = sensor->emu;
+	unsigned int base = sensor->index * FR_EMU_GPIOS_PER_SENSOR;
+
+	sensor->gpios = kzalloc(struct_size(sensor->gpios, table, 3),
+							GFP_KERNEL);
+	if (!sensor->gpios)
+		return -ENOMEM;
+
+	snprintf(sensor->dev_name, sizeof(sensor->dev_name), "%d-%04x",
+					i2c_adapter_id(&emu->adap), sensor->addr);
+
+	sensor->gpios->dev_id = sensor->dev_name;
+	sensor->gpios->table[0] =
+		GPIO_LOOKUP(emu->gc.label, base + FR_EMU_GPIO_RESET, "reset",
+							GPIO_ACTIVE_HIGH);
+	sensor->gpios->table[1] =
+		GPIO_LOOKUP(emu->gc.label, base + FR_EMU_GPIO_XMASTER,
+						"xmaster", GPIO_ACTIVE_HIGH);
+
+	gpiod_add_lookup_table(sensor->gpios);
+
+	return 0;
+}
+
+static int fr_emu_sensor_add(struct fr_emu *emu, const char *name)
+{
+	const struct fr_emu_model *model;
+	struct fr_emu_sensor *sensor;
+	struct v4l2_async_connection *asc;
+	unsigned int index = emu->num_sensors;
+	int ret;
+
+	model = fr_emu_find_model(name);
+	if (!model) {
+		dev_err(&emu->pdev->dev, "%s: unknown sensor %s\n", __func__,
+									name);
+		return -EINVAL;
+	}
+
+	if (index >= FR_EMU_MAX_SENSORS) {
+		dev_err(&emu->pdev->dev, "%s: too many sensors\n", __func__);
+		return -EINVAL;
+	}
+
+	sensor = kvzalloc(sizeof(*sensor), GFP_KERNEL);
+	if (!sensor)
+		return -ENOMEM;
+
+	sensor->emu = emu;
+	sensor->model = model;
+	sensor->index = index;
+	sensor->addr = model->addr + index;
+	fr_emu_sensor_reset(sensor);
+
+	emu->sensors[index] = sensor;
+	emu->num_sensors++;
+
+	ret = fr_emu_sensor_nodes_register(sensor);
+	if (ret) {
+		dev_err(&emu->pdev->dev, "%s: failed to register software nodes\n",
+								__func__);
+		goto error_free;
+	}
+
+	asc = v4l2_async_nf_add_fwnode(&emu->notifier,
+				software_node_fwnode(&sensor->nodes[0]),
+				struct v4l2_async_connection);
+	if (IS_ERR(asc)) {
+		ret = PTR_ERR(asc);
+		goto error_nodes;
+	}
+
+	ret = fr_emu_sensor_gpios_register(sensor);
+	if (ret)
+		goto error_nodes;
+
+	sensor->debugfs = debugfs_create_dir(sensor->node_name, emu->debugfs);
+	debugfs_create_file("state", 0444, sensor->debugfs, sensor,
+						&fr_emu_state_fops);
+	debugfs_create_file("stream", 0200, sensor->debugfs, sensor,
+						&fr_emu_stream_fops);
+
+	return 0;
+
+error_nodes:
+	software_node_unregister_node_group(sensor->group);
+error_free:
+	emu->sensors[index] = NULL;
+	emu->num_sensors--;
+	kvfree(sensor);
+
+	return ret;
+}
+
+static void fr_emu_sensor_remove(struct fr_emu_sensor *sensor)
+{
+	i2c_unregister_device(sensor->client);
+	gpiod_remove_lookup_table(sensor->gpios);
+	kfree(sensor->gpios);
+	software_node_unregister_node_group(sensor->group);
+	kvfree(sensor);
+}
+
+/*
+ * The clients are only created once every sensor has its GPIO lookup, its
+ * software nodes and its async connection, so that a driver probing right
+ * away finds all of them.
+ */
+static int fr_emu_instantiate(struct fr_emu *emu)
+{
+	struct fr_emu_sensor *sensor;
+	struct i2c_board_info info;
+	unsigned int i;
+
+	for (i = 0; i < emu->num_sensors; i++) {
+		sensor = emu->sensors[i];
+
+		memset(&info, 0, sizeof(info));
+		strscpy(info.type, sensor->model->type, sizeof(info.type));
+		info.addr = sensor->addr;
+		info.swnode = &sensor->nodes[0];
+
+		sensor->client = i2c_new_client_device(&emu->adap, &info);
+		if (IS_ERR(sensor->client)) {
+			dev_err(&emu->pdev->dev, "%s: failed to add %s\n",
+					__func__, sensor->node_name);
+			return PTR_ERR(sensor->client);
+		}
+	}
+
+	return 0;
+}
+
+static int fr_emu_setup(struct fr_emu *emu)
+{
+	struct device *dev = &emu->pdev->dev;
+	char *list, *cur, *name;
+	int ret;
+
+	emu->gc.label = "fr-sensor-emu";
+	emu->adap.owner = THIS_MODULE;
+	emu->adap.algo = &fr_emu_algo;
+	emu->adap.dev.parent = dev;
+	strscpy(emu->adap.name, "fr-sensor-emu", sizeof(emu->adap.name));
+	i2c_set_adapdata(&emu->adap, emu);
+
+	ret = i2c_add_adapter(&emu->adap);
+	if (ret) {
+		dev_err(dev, "%s: failed to add i2c adapter\n", __func__);
+		return ret;
+	}
+
+	ret = v4l2_device_register(dev, &emu->v4l2_dev);
+	if (ret)
+		goto error_adapter;
+
+	v4l2_async_nf_init(&emu->notifier, &emu->v4l2_dev);
+	emu->notifier.ops = &fr_emu_notify_ops;
+
+	emu->debugfs = debugfs_create_dir("fr_sensor_emu", NULL);
+
+	list = kstrdup(sensors, GFP_KERNEL);
+	if (!list) {
+		ret = -ENOMEM;
+		goto error_sensors;
+	}
+
+	cur = list;
+	while ((name = strsep(&cur, ",")) != NULL) {
+		name = strim(name);
+		if (!*name)
+			continue;
+
+		ret = fr_emu_sensor_add(emu, name);
+		if (ret)
+			break;
+	}
+
+	kfree(list);
+
+	if (ret)
+		goto error_sensors;
+
+	emu->gc.parent = dev;
+	emu->gc.owner = THIS_MODULE;
+	emu->gc.base = -1;
+	emu->gc.ngpio = emu->num_sensors * FR_EMU_GPIOS_PER_SENSOR;
+	emu->gc.can_sleep = true;
+	emu->gc.get = fr_emu_gpio_get;
+	emu->gc.set = fr_emu_gpio_set;
+	emu->gc.direction_output = fr_emu_gpio_direction_output;
+	emu->gc.get_direction = fr_emu_gpio_get_direction;
+
+	ret = gpiochip_add_data(&emu->gc, emu);
+	if (ret) {
+		dev_err(dev, "%s: failed to add gpio chip\n", __func__);
+		goto error_sensors;
+	}
+
+	ret = v4l2_async_nf_register(&emu->notifier);
+	if (ret) {
+		dev_err(dev, "%s: failed to register notifier\n", __func__);
+		goto error_gpiochip;
+	}
+
+	ret = fr_emu_instantiate(emu);
+	if (ret)
+		goto error_notifier;
+
+	return 0;
+
+error_notifier:
+	v4l2_async_nf_unregister(&emu->notifier);
+error_gpiochip:
+	gpiochip_remove(&emu->gc);
+error_sensors:
+	while (emu->num_sensors)
+		fr_emu_sensor_remove(emu->sensors[--emu->num_sensors]);
+	debugfs_remove_recursive(emu->debugfs);
+	v4l2_async_nf_cleanup(&emu->notifier);
+	v4l2_device_unregister(&emu->v4l2_dev);
+error_adapter:
+	i2c_del_adapter(&emu->adap);
+
+	return ret;
+}
+
+static void fr_emu_teardown(struct fr_emu *emu)
+{
+	unsigned int i;
+
+	for (i = 0; i < emu->num_sensors; i++) {
+		i2c_unregister_device(emu->sensors[i]->client);
+		emu->sensors[i]->client = NULL;
+	}
+
+	v4l2_async_nf_unregister(&emu->notifier);
+	gpiochip_remove(&emu->gc);
+
+	while (emu->num_sensors)
+		fr_emu_sensor_remove(emu->sensors[--emu->num_sensors]);
+
+	debugfs_remove_recursive(emu->debugfs);
+	v4l2_async_nf_cleanup(&emu->notifier);
+	v4l2_device_unregister(&emu->v4l2_dev);
+	i2c_del_adapter(&emu->adap);
+}
+
+static int __init fr_emu_init(void)
+{
+	struct fr_emu *emu;
+	int ret;
+
+	emu = kzalloc(sizeof(*emu), GFP_KERNEL);
+	if (!emu)
+		return -ENOMEM;
+
+	mutex_init(&emu->lock);
+
+	emu->pdev = platform_device_register_simple("fr-sensor-emu",
+						PLATFORM_DEVID_NONE, NULL, 0);
+	if (IS_ERR(emu->pdev)) {
+		ret = PTR_ERR(emu->pdev);
+		goto error_free;
+	}
+
+	ret = fr_emu_setup(emu);
+	if (ret)
+		goto error_pdev;
+
+	fr_emu = emu;
+
+	return 0;
+
+error_pdev:
+	platform_device_unregister(emu->pdev);
+error_free:
+	mutex_destroy(&emu->lock);
+	kfree(emu);
+
+	return ret;
+}
+
+static void __exit fr_emu_exit(void)
+{
+	struct fr_emu *emu = fr_emu;
+
+	fr_emu_teardown(emu);
+	platform_device_unregister(emu->pdev);
+	mutex_destroy(&emu->lock);
+	kfree(emu);
+}
+
+module_init(fr_emu_init);
+module_exit(fr_emu_exit);
+
+MODULE_DESCRIPTION("Emulated FRAMOS IMX sensors for hardware-free testing");
+MODULE_AUTHOR("FRAMOS GmbH");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,945 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_serdes_emu.c - emulated MAX96792/MAX96793 GMSL pair for hardware-free
+ * testing
+ *
+ * Registers a virtual I2C adapter with an emulated MAX96792 deserializer and
+ * one emulated MAX96793 serializer per GMSL link ("links" module parameter),
+ * and instantiates the real fr_max96792 and fr_max96793 drivers on it from
+ * software nodes. The emulated devices model what the drivers rely on:
+ *
+ *  - writing CTRL0 with RESET_ONESHOT selects the links given by LINK_CFG
+ *    and makes them lock again, RESET_ALL restores the power-up state,
+ *  - a link needs "lock_ms" to lock, and its serializer does not
+ *    acknowledge its address until then; CTRL3 reports the lock state,
+ *  - a serializer answers on the address programmed in DEV_ADDR, falling
+ *    back to its strapped address on RESET_ALL,
+ *  - every "nak_every"-th transfer forwarded over a link is not
+ *    acknowledged, to exercise the driver retry paths,
+ *  - a link can be dropped from debugfs, for a given time or until the
+ *    next link reset.
+ *
+ * Other registers, such as the pipe and lane maps or the GPIO forwarding
+ * setup, are plain storage that can be inspected afterwards. Transfers take
+ * "latency_us" plus the bus time at "bus_khz", and "tunnel_us" more when
+ * they are forwarded over a link.
+ *
+ * Writing 1 to the debugfs "bringup" file runs the sequence the sensor
+ * drivers use to bring up the link of every serializer, in link order, and
+ * records the latency of each step in the "latency" file; writing 0 resets
+ * the links again.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/delay.h>
+#include <linux/i2c.h>
+#include <linux/ktime.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/platform_device.h>
+#include <linux/property.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+
+#include "fr_max96792.h"
+#include "fr_max96793.h"
+#include "fr_stats.h"
+
+#define FR_SERDES_EMU_MAX_LINKS		2
+#define FR_SERDES_EMU_NUM_REGS		0x10000
+
+#define FR_SERDES_EMU_DSER_ADDR		0x6a
+#define FR_SERDES_EMU_SER_ADDR		0x42
+#define FR_SERDES_EMU_SENSOR_ADDR	0x1a
+
+#define FR_SERDES_EMU_DEV_ADDR		0x00
+#define FR_SERDES_EMU_CTRL0		0x10
+#define FR_SERDES_EMU_CTRL3		0x13
+
+#define FR_SERDES_EMU_RESET_ALL		0x80
+#define FR_SERDES_EMU_RESET_ONESHOT	0x20
+#define FR_SERDES_EMU_LINK_CFG		0x03
+#define FR_SERDES_EMU_LOCKED		0x08
+
+static unsigned int links = 1;
+module_param(links, uint, 0444);
+MODULE_PARM_DESC(links, "Number of GMSL links with a serializer (1 or 2)");
+
+static unsigned int lock_ms = 45;
+module_param(lock_ms, uint, 0644);
+MODULE_PARM_DESC(lock_ms, "Time a link needs to lock after a reset in milliseconds");
+
+static unsigned int nak_every;
+module_param(nak_every, uint, 0644);
+MODULE_PARM_DESC(nak_every, "Do not acknowledge every n-th transfer forwarded over a link, 0 to disable");
+
+static unsigned int latency_us;
+module_param(latency_us, uint, 0644);
+MODULE_PARM_DESC(latency_us, "Fixed latency of every I2C transfer in microseconds");
+
+static unsigned int tunnel_us;
+module_param(tunnel_us, uint, 0644);
+MODULE_PARM_DESC(tunnel_us, "Additional latency of transfers forwarded over a link in microseconds");
+
+static unsigned int bus_khz = 400;
+module_param(bus_khz, uint, 0644);
+MODULE_PARM_DESC(bus_khz, "Emulated I2C bus clock in kHz, 0 for infinitely fast");
+
+enum {
+	FR_SERDES_EMU_STAGE_POWER_ON,
+	FR_SERDES_EMU_STAGE_DSER_GMSL3,
+	FR_SERDES_EMU_STAGE_SER_GMSL3,
+	FR_SERDES_EMU_STAGE_LINK,
+	FR_SERDES_EMU_STAGE_SER_CONTROL,
+	FR_SERDES_EMU_STAGE_DSER_CONTROL,
+	FR_SERDES_EMU_STAGE_BRINGUP,
+	FR_SERDES_EMU_STAGE_RESET,
+	FR_SERDES_EMU_NUM_STAGES,
+};
+
+static const char * const fr_serdes_emu_stage_names[] = {
+	[FR_SERDES_EMU_STAGE_POWER_ON] = "power_on",
+	[FR_SERDES_EMU_STAGE_DSER_GMSL3] = "dser_gmsl3",
+	[FR_SERDES_EMU_STAGE_SER_GMSL3] = "ser_gmsl3",
+	[FR_SERDES_EMU_STAGE_LINK] = "link",
+	[FR_SERDES_EMU_STAGE_SER_CONTROL] = "ser_control",
+	[FR_SERDES_EMU_STAGE_DSER_CONTROL] = "dser_control",
+	[FR_SERDES_EMU_STAGE_BRINGUP] = "bringup",
+	[FR_SERDES_EMU_STAGE_RESET] = "reset",
+};
+
+struct fr_serdes_emu;
+
+struct fr_serdes_emu_link {
+	struct fr_serdes_emu *emu;
+	unsigned int index;
+	u16 def_addr;
+	u16 addr;
+	u16 ptr;
+
+	/* Selected by the deserializer LINK_CFG */
+	bool enabled;
+	/* Cleared by a drop without timeout, until the next link reset */
+	bool up;
+	ktime_t lock_at;
+
+	char node_name[24];
+	struct property_entry props[3];
+	struct software_node node;
+	struct i2c_client *client;
+	struct dentry *debugfs;
+
+	struct gmsl_link_ctx g_ctx;
+	bool paired;
+	bool powered;
+
+	u64 reads;
+	u64 writes;
+	u64 resets;
+	u64 drops;
+	u64 lock_nacks;
+	u64 injected_nacks;
+
+	u8 regs[FR_SERDES_EMU_NUM_REGS];
+};
+
+struct fr_serdes_emu {
+	struct platform_device *pdev;
+	struct i2c_adapter adap;
+	struct dentry *debugfs;
+
+	/* Serializes bus transfers and link state changes */
+	struct mutex lock;
+	/* Serializes bring-up and reset through the SerDes drivers */
+	struct mutex setup_lock;
+
+	u16 ptr;
+	u64 forwarded;
+	u64 reads;
+	u64 writes;
+
+	struct property_entry props[3];
+	struct software_node node;
+	struct i2c_client *client;
+
+	unsigned int num_links;
+	struct fr_serdes_emu_link links[FR_SERDES_EMU_MAX_LINKS];
+
+	struct fr_latency latency;
+	struct fr_latency_stage latency_stages[FR_SERDES_EMU_NUM_STAGES];
+
+	u8 regs[FR_SERDES_EMU_NUM_REGS];
+};
+
+static struct fr_serdes_emu *fr_serdes_emu;
+
+static bool fr_serdes_emu_locked(struct fr_serdes_emu_link *link, ktime_t now)
+{
+	return link->enabled && link->up && ktime_compare(now, link->lock_at) >= 0;
+}
+
+static void fr_serdes_emu_relock(struct fr_serdes_emu_link *link)
+{
+	link->up = true;
+	link->lock_at = ktime_add_ms(ktime_get(), lock_ms);
+}
+
+static void fr_serdes_emu_link_cfg(struct fr_serdes_emu *emu, u8 cfg)
+{
+	struct fr_serdes_emu_link *link;
+	unsigned int i;
+
+	for (i = 0; i < emu->num_links; i++) {
+		link = &emu->links[i];
+		link->enabled = cfg & BIT(i);
+		if (link->enabled)
+			fr_serdes_emu_relock(link);
+	}
+}
+
+/* Power-up state: both links selected and locking */
+static void fr_serdes_emu_dser_reset(struct fr_serdes_emu *emu)
+{
+	memset(emu->regs, 0, sizeof(emu->regs));
+	emu->regs[FR_SERDES_EMU_DEV_ADDR] = FR_SERDES_EMU_DSER_ADDR << 1;
+	emu->regs[FR_SERDES_EMU_CTRL0] = FR_SERDES_EMU_LINK_CFG;
+
+	fr_serdes_emu_link_cfg(emu, FR_SERDES_EMU_LINK_CFG);
+}
+
+static void fr_serdes_emu_ser_reset(struct fr_serdes_emu_link *link)
+{
+	memset(link->regs, 0, sizeof(link->regs));
+	link->addr = link->def_addr;
+	link->regs[FR_SERDES_EMU_DEV_ADDR] = link->def_addr << 1;
+	link->resets++;
+
+	fr_serdes_emu_relock(link);
+}
+
+static u8 fr_serdes_emu_read(struct fr_serdes_emu *emu,
+			     struct fr_serdes_emu_link *link, u16 addr)
+{
+	ktime_t now = ktime_get();
+	bool locked = false;
+	unsigned int i;
+
+	if (addr != FR_SERDES_EMU_CTRL3)
+		return link ? link->regs[addr] : emu->regs[addr];
+
+	if (link)
+		return fr_serdes_emu_locked(link, now) ? FR_SERDES_EMU_LOCKED : 0;
+
+	/* The deserializer is locked once all selected links are */
+	for (i = 0; i < emu->num_links; i++) {
+		if (!emu->links[i].enabled)
+			continue;
+		if (!fr_serdes_emu_locked(&emu->links[i], now))
+			return 0;
+		locked = true;
+	}
+
+	return locked ? FR_SERDES_EMU_LOCKED : 0;
+}
+
+static void fr_serdes_emu_dser_write(struct fr_serdes_emu *emu, u16 addr,
+				     u8 val)
+{
+	if (addr == FR_SERDES_EMU_CTRL3)
+		return;
+
+	if (addr != FR_SERDES_EMU_CTRL0) {
+		emu->regs[addr] = val;
+		return;
+	}
+
+	if (val & FR_SERDES_EMU_RESET_ALL) {
+		fr_serdes_emu_dser_reset(emu);
+		return;
+	}
+
+	/* The reset bits clear themselves */
+	emu->regs[addr] = val & FR_SERDES_EMU_LINK_CFG;
+	fr_serdes_emu_link_cfg(emu, val & FR_SERDES_EMU_LINK_CFG);
+}
+
+static void fr_serdes_emu_ser_write(struct fr_serdes_emu_link *link, u16 addr,
+				    u8 val)
+{
+	switch (addr) {
+	case FR_SERDES_EMU_CTRL3:
+		return;
+	case FR_SERDES_EMU_DEV_ADDR:
+		link->regs[addr] = val;
+		link->addr = val >> 1;
+		return;
+	case FR_SERDES_EMU_CTRL0:
+		if (val & FR_SERDES_EMU_RESET_ALL) {
+			fr_serdes_emu_ser_reset(link);
+			return;
+		}
+
+		link->regs[addr] = val & ~FR_SERDES_EMU_RESET_ONESHOT;
+		if (val & FR_SERDES_EMU_RESET_ONESHOT)
+			fr_serdes_emu_relock(link);
+		return;
+	default:
+		link->regs[addr] = val;
+	}
+}
+
+static int fr_serdes_emu_xfer_msg(struct fr_serdes_emu *emu,
+				  struct fr_serdes_emu_link *link,
+				  struct i2c_msg *msg)
+{
+	u16 *ptr = link ? &link->ptr : &emu->ptr;
+	unsigned int i;
+
+	if (msg->flags & I2C_M_RD) {
+		for (i = 0; i < msg->len; i++)
+			msg->buf[i] = fr_serdes_emu_read(emu, link, (*ptr)++);
+		if (link)
+			link->reads++;
+		else
+			emu->reads++;
+		return 0;
+	}
+
+	if (msg->len < 2)
+		return -EIO;
+
+	*ptr = (msg->buf[0] << 8) | msg->buf[1];
+	for (i = 2; i < msg->len; i++) {
+		if (link)
+			fr_serdes_emu_ser_write(link, (*ptr)++, msg->buf[i]);
+		else
+			fr_serdes_emu_dser_write(emu, (*ptr)++, msg->buf[i]);
+	}
+
+	if (msg->len > 2) {
+		if (link)
+			link->writes++;
+		else
+			emu->writes++;
+	}
+
+	return 0;
+}
+
+/*
+ * Serializers sharing an address on locked links all receive the transfer,
+ * as the deserializer broadcasts it over every selected link.
+ */
+static int fr_serdes_emu_forward(struct fr_serdes_emu *emu,
+				 struct i2c_msg *msg)
+{
+	struct fr_serdes_emu_link *link;
+	ktime_t now = ktime_get();
+	bool acked = false;
+	unsigned int i;
+	int ret;
+
+	for (i = 0; i < emu->num_links; i++) {
+		link = &emu->links[i];
+		if (link->addr != msg->addr)
+			continue;
+
+		if (!fr_serdes_emu_locked(link, now)) {
+			link->lock_nacks++;
+			continue;
+		}
+
+		if (nak_every && ++emu->forwarded % nak_every == 0) {
+			link->injected_nacks++;
+			return -ENXIO;
+		}
+
+		ret = fr_serdes_emu_xfer_msg(emu, link, msg);
+		if (ret)
+			return ret;
+
+		acked = true;
+	}
+
+	return acked ? 0 : -ENXIO;
+}
+
+static void fr_serdes_emu_delay(unsigned int bytes, bool forwarded)
+{
+	u64 ns = (u64)latency_us * NSEC_PER_USEC;
+
+	if (forwarded)
+		ns += (u64)tunnel_us * NSEC_PER_USEC;
+
+	/* Address byte plus the payload, 9 clocks each */
+	if (bus_khz)
+		ns += div_u64((u64)(bytes + 1) * 9 * NSEC_PER_MSEC, bus_khz);
+
+	if (ns >= NSEC_PER_USEC)
+		fsleep(div_u64(ns, NSEC_PER_USEC));
+}
+
+static int fr_serdes_emu_master_xfer(struct i2c_adapter *adap,
+				     struct i2c_msg *msgs, int num)
+{
+	struct fr_serdes_emu *emu = i2c_get_adapdata(adap);
+	bool forwarded = false;
+	unsigned int bytes = 0;
+	int ret = num;
+	int err;
+	int i;
+
+	mutex_lock(&emu->lock);
+
+	for (i = 0; i < num; i++) {
+		if (msgs[i].addr == FR_SERDES_EMU_DSER_ADDR) {
+			err = fr_serdes_emu_xfer_msg(emu, NULL, &msgs[i]);
+		} else {
+			err = fr_serdes_emu_forward(emu, &msgs[i]);
+			forwarded = true;
+		}
+
+		if (err) {
+			ret = err;
+			break;
+		}
+
+		bytes += msgs[i].len;
+	}
+
+	mutex_unlock(&emu->lock);
+
+	fr_serdes_emu_delay(bytes, forwarded);
+
+	return ret;
+}
+
+static u32 fr_serdes_emu_functionality(struct i2c_adapter *adap)
+{
+	return I2C_FUNC_I2C;
+}
+
+static const struct i2c_algorithm fr_serdes_emu_algo = {
+	.master_xfer = fr_serdes_emu_master_xfer,
+	.functionality = fr_serdes_emu_functionality,
+};
+
+static int fr_serdes_emu_link_bringup(struct fr_serdes_emu_link *link)
+{
+	struct fr_serdes_emu *emu = link->emu;
+	struct device *dev = &emu->pdev->dev;
+	struct device *dser_dev = &emu->client->dev;
+	struct device *ser_dev = &link->client->dev;
+	struct device *s_dev = link->g_ctx.s_dev;
+	ktime_t begin = ktime_get();
+	ktime_t start = begin;
+	int ret;
+
+	if (!link->paired) {
+		ret = max96793_sdev_pair(ser_dev, &link->g_ctx);
+		if (ret) {
+			dev_err(dev, "%s: gmsl ser pairing failed\n", __func__);
+			return ret;
+		}
+
+		ret = max96792_sdev_register(dser_dev, &link->g_ctx);
+		if (ret) {
+			dev_err(dev, "%s: gmsl deserializer register failed\n",
+								__func__);
+			max96793_sdev_unpair(ser_dev, s_dev);
+			return ret;
+		}
+
+		link->paired = true;
+	}
+
+	if (!link->powered) {
+		max96792_power_on(dser_dev, &link->g_ctx);
+		link->powered = true;
+	}
+	start = fr_latency_record(&emu->latency, FR_SERDES_EMU_STAGE_POWER_ON,
+									start);
+
+	max96792_reset_control(dser_dev, s_dev);
+
+	ret = max96792_gmsl3_setup(dser_dev);
+	if (ret) {
+		dev_err(dev, "%s: deserializer gmsl setup failed\n", __func__);
+		return ret;
+	}
+	start = fr_latency_record(&emu->latency,
+				FR_SERDES_EMU_STAGE_DSER_GMSL3, start);
+
+	ret = max96793_gmsl3_setup(ser_dev);
+	if (ret) {
+		dev_err(dev, "%s: serializer gmsl setup failed\n", __func__);
+		return ret;
+	}
+	start = fr_latency_record(&emu->latency, FR_SERDES_EMU_STAGE_SER_GMSL3,
+									start);
+
+	ret = max96792_setup_link(dser_dev, s_dev);
+	if (ret) {
+		dev_err(dev, "%s: gmsl deserializer link config failed\n",
+								__func__);
+		return ret;
+	}
+	start = fr_latency_record(&emu->latency, FR_SERDES_EMU_STAGE_LINK,
+									start);
+
+	ret = max96793_setup_control(ser_dev);
+	if (ret) {
+		dev_err(dev, "%s: gmsl serializer setup failed\n", __func__);
+		return ret;
+	}
+	start = fr_latency_record(&emu->latency,
+				FR_SERDES_EMU_STAGE_SER_CONTROL, start);
+
+	ret = max96792_setup_control(dser_dev, s_dev);
+	if (ret) {
+		dev_err(dev, "%s: gmsl deserializer setup failed\n", __func__);
+		return ret;
+	}
+	fr_latency_record(&emu->latency, FR_SERDES_EMU_STAGE_DSER_CONTROL,
+									start);
+
+	fr_latency_record(&emu->latency, FR_SERDES_EMU_STAGE_BRINGUP, begin);
+
+	return 0;
+}
+
+static void fr_serdes_emu_link_reset(struct fr_serdes_emu_link *link)
+{
+	struct fr_serdes_emu *emu = link->emu;
+	struct device *dser_dev = &emu->client->dev;
+	ktime_t start = ktime_get();
+
+	if (!link->powered)
+		return;
+
+	max96793_reset_control(&link->client->dev);
+	max96792_reset_control(dser_dev, link->g_ctx.s_dev);
+	max96792_power_off(dser_dev, &link->g_ctx);
+	link->powered = false;
+
+	fr_latency_record(&emu->latency, FR_SERDES_EMU_STAGE_RESET, start);
+}
+
+static void fr_serdes_emu_link_unpair(struct fr_serdes_emu_link *link)
+{
+	struct device *s_dev = link->g_ctx.s_dev;
+
+	if (!link->paired)
+		return;
+
+	max96793_sdev_unpair(&link->client->dev, s_dev);
+	max96792_sdev_unregister(&link->emu->client->dev, s_dev);
+	link->paired = false;
+}
+
+static ssize_t fr_serdes_emu_bringup_write(struct file *file,
+					   const char __user *buf,
+					   size_t count, loff_t *ppos)
+{
+	struct fr_serdes_emu *emu = file->private_data;
+	unsigned int i;
+	bool enable;
+	int ret;
+
+	ret = kstrtobool_from_user(buf, count, &enable);
+	if (ret)
+		return ret;
+
+	if (!emu->client->dev.driver)
+		return -ENODEV;
+
+	for (i = 0; i < emu->num_links; i++)
+		if (!emu->links[i].client->dev.driver)
+			return -ENODEV;
+
+	mutex_lock(&emu->setup_lock);
+
+	for (i = 0; i < emu->num_links; i++) {
+		if (!enable) {
+			fr_serdes_emu_link_reset(&emu->links[i]);
+			continue;
+		}
+
+		ret = fr_serdes_emu_link_bringup(&emu->links[i]);
+		if (ret)
+			break;
+	}
+
+	mutex_unlock(&emu->setup_lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations fr_serdes_emu_bringup_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.write = fr_serdes_emu_bringup_write,
+	.llseek = noop_llseek,
+};
+
+static int fr_serdes_emu_state_show(struct seq_file *s, void *unused)
+{
+	struct fr_serdes_emu *emu = s->private;
+
+	mutex_lock(&emu->lock);
+
+	seq_printf(s, "address: 0x%02x\n", FR_SERDES_EMU_DSER_ADDR);
+	seq_printf(s, "link_cfg: 0x%x\n",
+			emu->regs[FR_SERDES_EMU_CTRL0] & FR_SERDES_EMU_LINK_CFG);
+	seq_printf(s, "locked: %d\n",
+			!!fr_serdes_emu_read(emu, NULL, FR_SERDES_EMU_CTRL3));
+	seq_printf(s, "lane_map: 0x%02x 0x%02x\n", emu->regs[0x333],
+							emu->regs[0x334]);
+	seq_printf(s, "forwarded: %llu\n", emu->forwarded);
+	seq_printf(s, "reads: %llu\n", emu->reads);
+	seq_printf(s, "writes: %llu\n", emu->writes);
+
+	mutex_unlock(&emu->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(fr_serdes_emu_state);
+
+static int fr_serdes_emu_link_state_show(struct seq_file *s, void *unused)
+{
+	struct fr_serdes_emu_link *link = s->private;
+	struct fr_serdes_emu *emu = link->emu;
+	ktime_t now;
+
+	mutex_lock(&emu->lock);
+
+	now = ktime_get();
+
+	seq_printf(s, "address: 0x%02x\n", link->addr);
+	seq_printf(s, "strap_address: 0x%02x\n", link->def_addr);
+	seq_printf(s, "enabled: %d\n", link->enabled);
+	seq_printf(s, "up: %d\n", link->up);
+	seq_printf(s, "locked: %d\n", fr_serdes_emu_locked(link, now));
+	seq_printf(s, "paired: %d\n", link->paired);
+	seq_printf(s, "powered: %d\n", link->powered);
+	seq_printf(s, "resets: %llu\n", link->resets);
+	seq_printf(s, "drops: %llu\n", link->drops);
+	seq_printf(s, "reads: %llu\n", link->reads);
+	seq_printf(s, "writes: %llu\n", link->writes);
+	seq_printf(s, "lock_nacks: %llu\n", link->lock_nacks);
+	seq_printf(s, "injected_nacks: %llu\n", link->injected_nacks);
+
+	mutex_unlock(&emu->lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(fr_serdes_emu_link_state);
+
+/*
+ * Writing a time in milliseconds drops the link for that long, after which
+ * it locks again. Writing 0 keeps it down until the next link reset.
+ */
+static ssize_t fr_serdes_emu_drop_write(struct file *file,
+					const char __user *buf,
+					size_t count, loff_t *ppos)
+{
+	struct fr_serdes_emu_link *link = file->private_data;
+	struct fr_serdes_emu *emu = link->emu;
+	unsigned int ms;
+	int ret;
+
+	ret = kstrtouint_from_user(buf, count, 0, &ms);
+	if (ret)
+		return ret;
+
+	mutex_lock(&emu->lock);
+
+	if (ms)
+		link->lock_at = ktime_add_ms(ktime_get(), ms);
+	else
+		link->up = false;
+	link->drops++;
+
+	mutex_unlock(&emu->lock);
+
+	return count;
+}
+
+static const struct file_operations fr_serdes_emu_drop_fops = {
+	.owner = THIS_MODULE,
+	.open = simple_open,
+	.write = fr_serdes_emu_drop_write,
+	.llseek = noop_llseek,
+};
+
+static void fr_serdes_emu_link_init(struct fr_serdes_emu *emu,
+				    unsigned int index)
+{
+	struct fr_serdes_emu_link *link = &emu->links[index];
+
+	link->emu = emu;
+	link->index = index;
+	link->def_addr = FR_SERDES_EMU_SER_ADDR + 2 * index;
+	fr_serdes_emu_ser_reset(link);
+	link->resets = 0;
+
+	snprintf(link->node_name, sizeof(link->node_name), "max96793-emu.%u",
+									index);
+
+	link->props[0] = PROPERTY_ENTRY_U32("reg", link->def_addr);
+	if (index == 0)
+		link->props[1] = PROPERTY_ENTRY_BOOL("is-prim-ser");
+
+	link->node = (struct software_node) {
+		.name = link->node_name,
+		.properties = link->props,
+	};
+
+	link->g_ctx.serdes_csi_link = index ? GMSL_SERDES_CSI_LINK_B :
+						GMSL_SERDES_CSI_LINK_A;
+	link->g_ctx.src_csi_port = GMSL_CSI_PORT_B;
+	link->g_ctx.dst_csi_port = GMSL_CSI_PORT_A;
+	link->g_ctx.csi_mode = GMSL_CSI_1X4_MODE;
+	link->g_ctx.num_csi_lanes = 4;
+	link->g_ctx.st_vc = 0;
+	link->g_ctx.dst_vc = index;
+	link->g_ctx.ser_reg = link->def_addr;
+	link->g_ctx.sdev_reg = FR_SERDES_EMU_SENSOR_ADDR + index;
+	link->g_ctx.sdev_def = FR_SERDES_EMU_SENSOR_ADDR;
+	link->g_ctx.num_streams = 1;
+	link->g_ctx.streams[0].st_data_type = GMSL_CSI_DT_RAW_12;
+}
+
+static struct i2c_client *fr_serdes_emu_new_client(struct fr_serdes_emu *emu,
+						   const char *type, u16 addr,
+						   const struct software_node *node)
+{
+	struct i2c_board_info info;
+
+	memset(&info, 0, sizeof(info));
+	strscpy(info.type, type, sizeof(info.type));
+	info.addr = addr;
+	info.swnode = node;
+
+	return i2c_new_client_device(&emu->adap, &info);
+}
+
+static int fr_serdes_emu_instantiate(struct fr_serdes_emu *emu)
+{
+	struct fr_serdes_emu_link *link;
+	unsigned int i;
+
+	emu->client = fr_serdes_emu_new_client(emu, "fr_max96792",
+					FR_SERDES_EMU_DSER_ADDR, &emu->node);
+	if (IS_ERR(emu->client)) {
+		dev_err(&emu->pdev->dev, "%s: failed to add deserializer\n",
+								__func__);
+		return PTR_ERR(emu->client);
+	}
+
+	for (i = 0; i < emu->num_links; i++) {
+		link = &emu->links[i];
+
+		link->client = fr_serdes_emu_new_client(emu, "fr_max96793",
+						link->def_addr, &link->node);
+		if (IS_ERR(link->client)) {
+			dev_err(&emu->pdev->dev, "%s: failed to add %s\n",
+						__func__, link->node_name);
+			return PTR_ERR(link->client);
+		}
+
+		/* The serializer stands in for the sensor behind it */
+		link->g_ctx.s_dev = &link->client->dev;
+	}
+
+	return 0;
+}
+
+static void fr_serdes_emu_remove_clients(struct fr_serdes_emu *emu)
+{
+	struct fr_serdes_emu_link *link;
+	unsigned int i;
+
+	for (i = 0; i < emu->num_links; i++) {
+		link = &emu->links[i];
+		if (IS_ERR_OR_NULL(link->client))
+			continue;
+
+		if (link->client->dev.driver && !IS_ERR_OR_NULL(emu->client) &&
+		    emu->client->dev.driver) {
+			fr_serdes_emu_link_reset(link);
+			fr_serdes_emu_link_unpair(link);
+		}
+
+		i2c_unregister_device(link->client);
+		link->client = NULL;
+	}
+
+	if (!IS_ERR_OR_NULL(emu->client))
+		i2c_unregister_device(emu->client);
+	emu->client = NULL;
+}
+
+static int fr_serdes_emu_setup(struct fr_serdes_emu *emu)
+{
+	struct device *dev = &emu->pdev->dev;
+	struct fr_serdes_emu_link *link;
+	unsigned int i;
+	int ret;
+
+	if (!links || links > FR_SERDES_EMU_MAX_LINKS) {
+		dev_err(dev, "%s: invalid number of links %u\n", __func__,
+									links);
+		return -EINVAL;
+	}
+
+	emu->num_links = links;
+	for (i = 0; i < emu->num_links; i++)
+		fr_serdes_emu_link_init(emu, i);
+	fr_serdes_emu_dser_reset(emu);
+
+	fr_latency_init(&emu->latency, fr_serdes_emu_stage_names,
+			emu->latency_stages, FR_SERDES_EMU_NUM_STAGES);
+
+	emu->props[0] = PROPERTY_ENTRY_STRING("csi-mode", "2x4");
+	emu->props[1] = PROPERTY_ENTRY_U32("max-src", emu->num_links);
+	emu->node = (struct software_node) {
+		.name = "max96792-emu",
+		.properties = emu->props,
+	};
+
+	ret = software_node_register(&emu->node);
+	if (ret) {
+		dev_err(dev, "%s: failed to register software nodes\n",
+								__func__);
+		return ret;
+	}
+
+	for (i = 0; i < emu->num_links; i++) {
+		ret = software_node_register(&emu->links[i].node);
+		if (ret) {
+			dev_err(dev, "%s: failed to register software nodes\n",
+								__func__);
+			goto error_nodes;
+		}
+	}
+
+	emu->adap.owner = THIS_MODULE;
+	emu->adap.algo = &fr_serdes_emu_algo;
+	emu->adap.dev.parent = dev;
+	strscpy(emu->adap.name, "fr-serdes-emu", sizeof(emu->adap.name));
+	i2c_set_adapdata(&emu->adap, emu);
+
+	ret = i2c_add_adapter(&emu->adap);
+	if (ret) {
+		dev_err(dev, "%s: failed to add i2c adapter\n", __func__);
+		goto error_nodes;
+	}
+
+	ret = fr_serdes_emu_instantiate(emu);
+	if (ret)
+		goto error_clients;
+
+	emu->debugfs = debugfs_create_dir("fr_serdes_emu", NULL);
+	debugfs_create_file("state", 0444, emu->debugfs, emu,
+						&fr_serdes_emu_state_fops);
+	debugfs_create_file("bringup", 0200, emu->debugfs, emu,
+						&fr_serdes_emu_bringup_fops);
+	fr_latency_debugfs_create(&emu->latency, "latency", emu->debugfs);
+
+	for (i = 0; i < emu->num_links; i++) {
+		link = &emu->links[i];
+		link->debugfs = debugfs_create_dir(link->node_name,
+							emu->debugfs);
+		debugfs_create_file("state", 0444, link->debugfs, link,
+					&fr_serdes_emu_link_state_fops);
+		debugfs_create_file("drop", 0200, link->debugfs, link,
+					&fr_serdes_emu_drop_fops);
+	}
+
+	return 0;
+
+error_clients:
+	fr_serdes_emu_remove_clients(emu);
+	i2c_del_adapter(&emu->adap);
+error_nodes:
+	while (i--)
+		software_node_unregister(&emu->links[i].node);
+	software_node_unregister(&emu->node);
+
+	return ret;
+}
+
+static void fr_serdes_emu_teardown(struct fr_serdes_emu *emu)
+{
+	unsigned int i;
+
+	debugfs_remove_recursive(emu->debugfs);
+
+	mutex_lock(&emu->setup_lock);
+	fr_serdes_emu_remove_clients(emu);
+	mutex_unlock(&emu->setup_lock);
+
+	i2c_del_adapter(&emu->adap);
+
+	for (i = 0; i < emu->num_links; i++)
+		software_node_unregister(&emu->links[i].node);
+	software_node_unregister(&emu->node);
+}
+
+static int __init fr_serdes_emu_init(void)
+{
+	struct fr_serdes_emu *emu;
+	int ret;
+
+	emu = kvzalloc(sizeof(*emu), GFP_KERNEL);
+	if (!emu)
+		return -ENOMEM;
+
+	mutex_init(&emu->lock);
+	mutex_init(&emu->setup_lock);
+
+	emu->pdev = platform_device_register_simple("fr-serdes-emu",
+						PLATFORM_DEVID_NONE, NULL, 0);
+	if (IS_ERR(emu->pdev)) {
+		ret = PTR_ERR(emu->pdev);
+		goto error_free;
+	}
+
+	ret = fr_serdes_emu_setup(emu);
+	if (ret)
+		goto error_pdev;
+
+	fr_serdes_emu = emu;
+
+	return 0;
+
+error_pdev:
+	platform_device_unregister(emu->pdev);
+error_free:
+	mutex_destroy(&emu->setup_lock);
+	mutex_destroy(&emu->lock);
+	kvfree(emu);
+
+	return ret;
+}
+
+static void __exit fr_serdes_emu_exit(void)
+{
+	struct fr_serdes_emu *emu = fr_serdes_emu;
+
+	fr_serdes_emu_teardown(emu);
+	platform_device_unregister(emu->pdev);
+	mutex_destroy(&emu->setup_lock);
+	mutex_destroy(&emu->lock);
+	kvfree(emu);
+}
+
+module_init(fr_serdes_emu_init);
+module_exit(fr_serdes_emu_exit);
+
+MODULE_DESCRIPTION("Emulated MAX96792/MAX96793 GMSL pair for hardware-free testing");
+MODULE_AUTHOR("FRAMOS GmbH");
+MODULE_LICENSE("GPL v2");
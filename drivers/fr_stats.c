@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_stats.c - runtime statistics of FRAMOS sensor drivers
+ *
+ * The statistics are kept by each sensor driver in its private data and
+ * exposed in its debugfs directory. Writing anything to a statistics file
+ * resets it.
+ */
+
+#include <linux/fs.h>
+#include <linux/module.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+
+#include "fr_stats.h"
+
+void fr_latency_init(struct fr_latency *lat, const char * const *names,
+		     struct fr_latency_stage *stages, unsigned int num_stages)
+{
+	spin_lock_init(&lat->lock);
+	lat->names = names;
+	lat->stages = stages;
+	lat->num_stages = num_stages;
+
+	fr_latency_reset(lat);
+}
+EXPORT_SYMBOL(fr_latency_init);
+
+/*
+ * Record the time elapsed since start for the given stage and return the
+ * current time, so that consecutive stages can be chained.
+ */
+ktime_t fr_latency_record(struct fr_latency *lat, unsigned int stage,
+			  ktime_t start)
+{
+	ktime_t now = ktime_get();
+	struct fr_latency_stage *st;
+	unsigned long flags;
+
+	if (stage >= lat->num_stages)
+		return now;
+
+	st = &lat->stages[stage];
+
+	spin_lock_irqsave(&lat->lock, flags);
+	st->samples[st->count % FR_LATENCY_WINDOW] = ktime_to_ns(now - start);
+	st->count++;
+	spin_unlock_irqrestore(&lat->lock, flags);
+
+	return now;
+}
+EXPORT_SYMBOL(fr_latency_record);
+
+void fr_latency_reset(struct fr_latency *lat)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&lat->lock, flags);
+	memset(lat->stages, 0, lat->num_stages * sizeof(*lat->stages));
+	spin_unlock_irqrestore(&lat->lock, flags);
+}
+EXPORT_SYMBOL(fr_latency_reset);
+
+static int fr_latency_cmp(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a;
+	u64 y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int fr_latency_show(struct seq_file *s, void *unused)
+{
+	struct fr_latency *lat = s->private;
+	unsigned long flags;
+	unsigned int i, n;
+	u64 *samples;
+	u64 count, sum;
+
+	samples = kmalloc_array(FR_LATENCY_WINDOW, sizeof(*samples),
+							GFP_KERNEL);
+	if (!samples)
+		return -ENOMEM;
+
+	seq_printf(s, "%-16s %10s %10s %10s %10s %10s\n", "stage (us)",
+				"count", "min", "avg", "p99", "max");
+
+	for (i = 0; i < lat->num_stages; i++) {
+		spin_lock_irqsave(&lat->lock, flags);
+		count = lat->stages[i].count;
+		n = min_t(u64, count, FR_LATENCY_WINDOW);
+		memcpy(samples, lat->stages[i].samples, n * sizeof(*samples));
+		spin_unlock_irqrestore(&lat->lock, flags);
+
+		if (!n) {
+			seq_printf(s, "%-16s %10llu\n", lat->names[i], count);
+			continue;
+		}
+
+		sort(samples, n, sizeof(*samples), fr_latency_cmp, NULL);
+
+		for (sum = 0; n--; )
+			sum += samples[n];
+		n = min_t(u64, count, FR_LATENCY_WINDOW);
+
+		seq_printf(s, "%-16s %10llu %10llu %10llu %10llu %10llu\n",
+			   lat->names[i], count,
+			   samples[0] / NSEC_PER_USEC,
+			   div_u64(sum, n) / NSEC_PER_USEC,
+			   samples[DIV_ROUND_UP(n * 99, 100) - 1] / NSEC_PER_USEC,
+			   samples[n - 1] / NSEC_PER_USEC);
+	}
+
+	kfree(samples);
+
+	return 0;
+}
+
+static int fr_latency_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fr_latency_show, inode->i_private);
+}
+
+static ssize_t fr_latency_write(struct file *file, const char __user *buf,
+				size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+
+	fr_latency_reset(s->private);
+
+	return count;
+}
+
+static const struct file_operations fr_latency_fops = {
+	.owner = THIS_MODULE,
+	.open = fr_latency_open,
+	.read = seq_read,
+	.write = fr_latency_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void fr_latency_debugfs_create(struct fr_latency *lat, const char *name,
+			       struct dentry *parent)
+{
+	debugfs_create_file(name, 0644, parent, lat, &fr_latency_fops);
+}
+EXPORT_SYMBOL(fr_latency_debugfs_create);
+
+static const char * const fr_i2c_class_names[] = {
+	[FR_I2C_TABLE] = "table",
+	[FR_I2C_CONTROL] = "control",
+	[FR_I2C_HOLD] = "hold",
+	[FR_I2C_IDENTIFY] = "identify",
+	[FR_I2C_OTHER] = "other",
+};
+
+void fr_i2c_stats_init(struct fr_i2c_stats *stats)
+{
+	spin_lock_init(&stats->lock);
+
+	fr_i2c_stats_reset(stats);
+}
+EXPORT_SYMBOL(fr_i2c_stats_init);
+
+void fr_i2c_stats_record(struct fr_i2c_stats *stats, enum fr_i2c_class cls,
+			 unsigned int bytes, unsigned int retries,
+			 u64 duration_ns, int ret)
+{
+	struct fr_i2c_counters *c;
+	unsigned long flags;
+
+	if (cls >= FR_I2C_NUM_CLASSES)
+		cls = FR_I2C_OTHER;
+
+	c = &stats->classes[cls];
+
+	spin_lock_irqsave(&stats->lock, flags);
+	c->transactions++;
+	c->bytes += bytes;
+	c->retries += retries;
+	c->busy_ns += duration_ns;
+	if (ret)
+		c->errors++;
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+EXPORT_SYMBOL(fr_i2c_stats_record);
+
+void fr_i2c_stats_reset(struct fr_i2c_stats *stats)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	memset(stats->classes, 0, sizeof(stats->classes));
+	spin_unlock_irqrestore(&stats->lock, flags);
+}
+EXPORT_SYMBOL(fr_i2c_stats_reset);
+
+static int fr_i2c_stats_show(struct seq_file *s, void *unused)
+{
+	struct fr_i2c_stats *stats = s->private;
+	struct fr_i2c_counters c[FR_I2C_NUM_CLASSES];
+	struct fr_i2c_counters total = { 0 };
+	unsigned long flags;
+	unsigned int i;
+
+	spin_lock_irqsave(&stats->lock, flags);
+	memcpy(c, stats->classes, sizeof(c));
+	spin_unlock_irqrestore(&stats->lock, flags);
+
+	seq_printf(s, "%-10s %12s %12s %8s %8s %12s\n", "class",
+			"transfers", "bytes", "errors", "retries", "busy (us)");
+
+	for (i = 0; i < FR_I2C_NUM_CLASSES; i++) {
+		seq_printf(s, "%-10s %12llu %12llu %8llu %8llu %12llu\n",
+			   fr_i2c_class_names[i], c[i].transactions, c[i].bytes,
+			   c[i].errors, c[i].retries,
+			   div_u64(c[i].busy_ns, NSEC_PER_USEC));
+
+		total.transactions += c[i].transactions;
+		total.bytes += c[i].bytes;
+		total.errors += c[i].errors;
+		total.retries += c[i].retries;
+		total.busy_ns += c[i].busy_ns;
+	}
+
+	seq_printf(s, "%-10s %12llu %12llu %8llu %8llu %12llu\n", "total",
+		   total.transactions, total.bytes, total.errors, total.retries,
+		   div_u64(total.busy_ns, NSEC_PER_USEC));
+
+	return 0;
+}
+
+static int fr_i2c_stats_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, fr_i2c_stats_show, inode->i_private);
+}
+
+static ssize_t fr_i2c_stats_write(struct file *file, const char __user *buf,
+				  size_t count, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+
+	fr_i2c_stats_reset(s->private);
+
+	return count;
+}
+
+static const struct file_operations fr_i2c_stats_fops = {
+	.owner = THIS_MODULE,
+	.open = fr_i2c_stats_open,
+	.read = seq_read,
+	.write = fr_i2c_stats_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void fr_i2c_stats_debugfs_create(struct fr_i2c_stats *stats, const char *name,
+				 struct dentry *parent)
+{
+	debugfs_create_file(name, 0644, parent, stats, &fr_i2c_stats_fops);
+}
+EXPORT_SYMBOL(fr_i2c_stats_debugfs_create);
+
+MODULE_DESCRIPTION("Runtime statistics of FRAMOS sensor drivers");
+MODULE_AUTHOR("FRAMOS GmbH");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_stats.h - runtime statistics of FRAMOS sensor drivers header
+ */
+
+#ifndef __FR_STATS_H__
+#define __FR_STATS_H__
+
+#include <linux/debugfs.h>
+#include <linux/ktime.h>
+#include <linux/spinlock.h>
+#include <linux/types.h>
+
+#define FR_LATENCY_WINDOW	128
+
+struct fr_latency_stage {
+	u64 samples[FR_LATENCY_WINDOW];
+	u64 count;
+};
+
+/*
+ * Latency of a fixed set of named stages. The last FR_LATENCY_WINDOW
+ * samples of every stage are kept, and min/avg/p99/max over them are
+ * reported in debugfs, so a regression shows up after a handful of
+ * stream starts without being averaged away by the device's history.
+ */
+struct fr_latency {
+	spinlock_t lock;
+	const char * const *names;
+	struct fr_latency_stage *stages;
+	unsigned int num_stages;
+};
+
+/* What a sensor driver was doing when it accessed the bus */
+enum fr_i2c_class {
+	FR_I2C_TABLE,
+	FR_I2C_CONTROL,
+	FR_I2C_HOLD,
+	FR_I2C_IDENTIFY,
+	FR_I2C_OTHER,
+	FR_I2C_NUM_CLASSES,
+};
+
+struct fr_i2c_counters {
+	u64 transactions;
+	u64 bytes;
+	u64 errors;
+	u64 retries;
+	u64 busy_ns;
+};
+
+/*
+ * I2C traffic of a device split by operation class. Bytes count everything
+ * put on the bus for the transaction, register address included, so the
+ * totals can be used to size control update rates on a bus shared with the
+ * GPIO expander and the SerDes.
+ */
+struct fr_i2c_stats {
+	spinlock_t lock;
+	struct fr_i2c_counters classes[FR_I2C_NUM_CLASSES];
+};
+
+void fr_latency_init(struct fr_latency *lat, const char * const *names,
+		     struct fr_latency_stage *stages, unsigned int num_stages);
+ktime_t fr_latency_record(struct fr_latency *lat, unsigned int stage,
+			  ktime_t start);
+void fr_latency_reset(struct fr_latency *lat);
+void fr_latency_debugfs_create(struct fr_latency *lat, const char *name,
+			       struct dentry *parent);
+
+void fr_i2c_stats_init(struct fr_i2c_stats *stats);
+void fr_i2c_stats_record(struct fr_i2c_stats *stats, enum fr_i2c_class cls,
+			 unsigned int bytes, unsigned int retries,
+			 u64 duration_ns, int ret);
+void fr_i2c_stats_reset(struct fr_i2c_stats *stats);
+void fr_i2c_stats_debugfs_create(struct fr_i2c_stats *stats, const char *name,
+				 struct dentry *parent);
+
+#endif /* __FR_STATS_H__ */
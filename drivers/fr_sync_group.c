@@ -0,0 +1,229 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_sync_group.c - synchronized stream start of several sensors
+ *
+ * Sensors sharing the same "sync-group" DT property value are started
+ * together: each one is brought out of standby on its own STREAMON and
+ * left waiting, and when the last one arrives the slaves are released
+ * first and the master last. The slaves are therefore already waiting for
+ * vertical sync when the master outputs its first XVS, and all sensors
+ * start on the same frame.
+ */
+
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/seq_file.h>
+#include <linux/slab.h>
+
+#include "fr_sync_group.h"
+
+struct fr_sync_group {
+	struct list_head list;
+	struct list_head members;
+	unsigned int num_members;
+	unsigned int num_armed;
+	u32 id;
+};
+
+static LIST_HEAD(fr_sync_groups);
+static DEFINE_MUTEX(fr_sync_lock);
+
+int fr_sync_group_join(struct fr_sync_member *member, u32 id)
+{
+	struct fr_sync_group *group;
+
+	if (!member || !member->dev || !member->release)
+		return -EINVAL;
+
+	mutex_lock(&fr_sync_lock);
+
+	list_for_each_entry(group, &fr_sync_groups, list) {
+		if (group->id == id)
+			goto join;
+	}
+
+	group = kzalloc(sizeof(*group), GFP_KERNEL);
+	if (!group) {
+		mutex_unlock(&fr_sync_lock);
+		return -ENOMEM;
+	}
+
+	group->id = id;
+	INIT_LIST_HEAD(&group->members);
+	list_add_tail(&group->list, &fr_sync_groups);
+
+join:
+	member->group = group;
+	member->armed = false;
+	list_add_tail(&member->list, &group->members);
+	group->num_members++;
+
+	mutex_unlock(&fr_sync_lock);
+
+	dev_dbg(member->dev, "%s: joined sync group %u (%u members)\n",
+					__func__, id, group->num_members);
+
+	return 0;
+}
+EXPORT_SYMBOL(fr_sync_group_join);
+
+void fr_sync_group_leave(struct fr_sync_member *member)
+{
+	struct fr_sync_group *group = member->group;
+
+	if (!group)
+		return;
+
+	mutex_lock(&fr_sync_lock);
+
+	if (member->armed)
+		group->num_armed--;
+
+	list_del(&member->list);
+	member->group = NULL;
+	member->armed = false;
+
+	if (--group->num_members == 0) {
+		list_del(&group->list);
+		kfree(group);
+	}
+
+	mutex_unlock(&fr_sync_lock);
+}
+EXPORT_SYMBOL(fr_sync_group_leave);
+
+static int fr_sync_release_member(struct fr_sync_member *member)
+{
+	int ret;
+
+	member->armed = false;
+
+	ret = member->release(member);
+	if (ret)
+		dev_err(member->dev, "%s: release failed\n", __func__);
+
+	return ret;
+}
+
+int fr_sync_group_arm(struct fr_sync_member *member, bool master)
+{
+	struct fr_sync_group *group = member->group;
+	struct fr_sync_member *m;
+	int ret = 0;
+	int err;
+
+	member->master = master;
+
+	if (!group)
+		return member->release(member);
+
+	mutex_lock(&fr_sync_lock);
+
+	if (!member->armed) {
+		member->armed = true;
+		member->armed_at = ktime_get();
+		group->num_armed++;
+	}
+
+	if (group->num_armed < group->num_members) {
+		dev_dbg(member->dev, "%s: armed, %u of %u members waiting\n",
+			__func__, group->num_armed, group->num_members);
+		goto unlock;
+	}
+
+	/* Slaves have to wait for the master's first XVS, release it last */
+	list_for_each_entry(m, &group->members, list) {
+		if (m->master)
+			continue;
+		err = fr_sync_release_member(m);
+		if (m == member)
+			ret = err;
+	}
+
+	list_for_each_entry(m, &group->members, list) {
+		if (!m->armed)
+			continue;
+		err = fr_sync_release_member(m);
+		if (m == member)
+			ret = err;
+	}
+
+	group->num_armed = 0;
+
+	dev_dbg(member->dev, "%s: released sync group %u\n", __func__,
+								group->id);
+
+unlock:
+	mutex_unlock(&fr_sync_lock);
+
+	return ret;
+}
+EXPORT_SYMBOL(fr_sync_group_arm);
+
+void fr_sync_group_disarm(struct fr_sync_member *member)
+{
+	if (!member->group)
+		return;
+
+	mutex_lock(&fr_sync_lock);
+
+	if (member->armed) {
+		member->armed = false;
+		member->group->num_armed--;
+	}
+
+	mutex_unlock(&fr_sync_lock);
+}
+EXPORT_SYMBOL(fr_sync_group_disarm);
+
+static int fr_sync_group_show(struct seq_file *s, void *data)
+{
+	struct fr_sync_member *member = s->private;
+	struct fr_sync_group *group;
+	struct fr_sync_member *m;
+	ktime_t now = ktime_get();
+
+	mutex_lock(&fr_sync_lock);
+
+	group = member->group;
+	if (!group) {
+		seq_puts(s, "group: none\n");
+		goto unlock;
+	}
+
+	seq_printf(s, "group: %u\n", group->id);
+	seq_printf(s, "armed: %u of %u\n", group->num_armed,
+						group->num_members);
+	seq_printf(s, "%-24s %-8s %-8s %12s\n", "member", "role", "state",
+							"waiting (ms)");
+
+	list_for_each_entry(m, &group->members, list) {
+		if (m->armed)
+			seq_printf(s, "%-24s %-8s %-8s %12lld\n",
+				   dev_name(m->dev),
+				   m->master ? "master" : "slave", "armed",
+				   ktime_ms_delta(now, m->armed_at));
+		else
+			seq_printf(s, "%-24s %-8s %-8s\n", dev_name(m->dev),
+				   m->master ? "master" : "slave", "idle");
+	}
+
+unlock:
+	mutex_unlock(&fr_sync_lock);
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(fr_sync_group);
+
+void fr_sync_group_debugfs_create(struct fr_sync_member *member,
+				  const char *name, struct dentry *parent)
+{
+	debugfs_create_file(name, 0444, parent, member, &fr_sync_group_fops);
+}
+EXPORT_SYMBOL(fr_sync_group_debugfs_create);
+
+MODULE_DESCRIPTION("Synchronized stream start of FRAMOS sensors");
+MODULE_AUTHOR("FRAMOS GmbH");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_sync_group.h - synchronized stream start of several sensors header
+ */
+
+#ifndef __FR_SYNC_GROUP_H__
+#define __FR_SYNC_GROUP_H__
+
+#include <linux/debugfs.h>
+#include <linux/device.h>
+#include <linux/ktime.h>
+#include <linux/list.h>
+#include <linux/types.h>
+
+struct fr_sync_group;
+
+/*
+ * A sensor taking part in a synchronized stream start. The sensor driver
+ * embeds it in its private data, joins a group at probe and arms it at the
+ * end of STREAMON, with the sensor out of standby but not yet started.
+ * Once every member of the group is armed, release() is called for all
+ * slaves and then for the master, from the context of the last member to
+ * arm. release() must not take the sensor driver's own lock, as it may run
+ * on behalf of another member.
+ *
+ * STREAMON of an armed member returns before the rest of the group has
+ * arrived, so a member whose peers never stream waits indefinitely. The
+ * state of the group, and how long each armed member has been waiting,
+ * can be read from the debugfs file created by
+ * fr_sync_group_debugfs_create().
+ */
+struct fr_sync_member {
+	struct device *dev;
+	int (*release)(struct fr_sync_member *member);
+
+	struct fr_sync_group *group;
+	struct list_head list;
+	bool master;
+	bool armed;
+	ktime_t armed_at;
+};
+
+int fr_sync_group_join(struct fr_sync_member *member, u32 id);
+void fr_sync_group_leave(struct fr_sync_member *member);
+int fr_sync_group_arm(struct fr_sync_member *member, bool master);
+void fr_sync_group_disarm(struct fr_sync_member *member);
+void fr_sync_group_debugfs_create(struct fr_sync_member *member,
+				  const char *name, struct dentry *parent);
+
+#endif /* __FR_SYNC_GROUP_H__ */
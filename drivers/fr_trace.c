@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_trace.c - tracepoints of the FRAMOS sensor and SerDes drivers
+ *
+ * The events are defined once here and used by all FRAMOS modules, so a
+ * single "fr_sensor" trace system covers register traffic, mode
+ * programming, power and stream transitions of every sensor and of the
+ * GMSL SerDes, e.g.
+ *
+ *	trace-cmd record -e fr_sensor
+ */
+
+#include <linux/module.h>
+
+#define CREATE_TRACE_POINTS
+#include "fr_trace.h"
+
+EXPORT_TRACEPOINT_SYMBOL_GPL(fr_reg_write);
+EXPORT_TRACEPOINT_SYMBOL_GPL(fr_reg_read);
+EXPORT_TRACEPOINT_SYMBOL_GPL(fr_table_start);
+EXPORT_TRACEPOINT_SYMBOL_GPL(fr_table_end);
+EXPORT_TRACEPOINT_SYMBOL_GPL(fr_hold_begin);
+EXPORT_TRACEPOINT_SYMBOL_GPL(fr_hold_commit);
+EXPORT_TRACEPOINT_SYMBOL_GPL(fr_power);
+EXPORT_TRACEPOINT_SYMBOL_GPL(fr_stream_enter);
+EXPORT_TRACEPOINT_SYMBOL_GPL(fr_stream_exit);
+EXPORT_TRACEPOINT_SYMBOL_GPL(fr_serdes_step);
+
+MODULE_DESCRIPTION("Tracepoints of FRAMOS sensor drivers");
+MODULE_AUTHOR("FRAMOS GmbH");
+MODULE_LICENSE("GPL v2");
@@ -0,0 +1,184 @@
+/* SPDX-License-Identifier: GPL-2.0
+ *
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_trace.h - tracepoints of the FRAMOS sensor and SerDes drivers
+ */
+
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM fr_sensor
+
+#if !defined(__FR_TRACE_H__) || defined(TRACE_HEADER_MULTI_READ)
+#define __FR_TRACE_H__
+
+#include <linux/device.h>
+#include <linux/tracepoint.h>
+
+DECLARE_EVENT_CLASS(fr_reg,
+
+	TP_PROTO(struct device *dev, u16 addr, u32 len, u32 val,
+		 u64 duration_ns, int ret),
+
+	TP_ARGS(dev, addr, len, val, duration_ns, ret),
+
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+		__field(u16, addr)
+		__field(u32, len)
+		__field(u32, val)
+		__field(u64, duration_ns)
+		__field(int, ret)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+		__entry->addr = addr;
+		__entry->len = len;
+		__entry->val = val;
+		__entry->duration_ns = duration_ns;
+		__entry->ret = ret;
+	),
+
+	TP_printk("%s addr=0x%04x len=%u val=0x%x duration=%llu ns ret=%d",
+		  __get_str(dev), __entry->addr, __entry->len, __entry->val,
+		  __entry->duration_ns, __entry->ret)
+);
+
+DEFINE_EVENT(fr_reg, fr_reg_write,
+	TP_PROTO(struct device *dev, u16 addr, u32 len, u32 val,
+		 u64 duration_ns, int ret),
+	TP_ARGS(dev, addr, len, val, duration_ns, ret)
+);
+
+DEFINE_EVENT(fr_reg, fr_reg_read,
+	TP_PROTO(struct device *dev, u16 addr, u32 len, u32 val,
+		 u64 duration_ns, int ret),
+	TP_ARGS(dev, addr, len, val, duration_ns, ret)
+);
+
+DECLARE_EVENT_CLASS(fr_table,
+
+	TP_PROTO(struct device *dev, const char *name, u32 count, int ret),
+
+	TP_ARGS(dev, name, count, ret),
+
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+		__string(name, name)
+		__field(u32, count)
+		__field(int, ret)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+		__assign_str(name, name);
+		__entry->count = count;
+		__entry->ret = ret;
+	),
+
+	TP_printk("%s table=%s count=%u ret=%d", __get_str(dev),
+		  __get_str(name), __entry->count, __entry->ret)
+);
+
+DEFINE_EVENT(fr_table, fr_table_start,
+	TP_PROTO(struct device *dev, const char *name, u32 count, int ret),
+	TP_ARGS(dev, name, count, ret)
+);
+
+DEFINE_EVENT(fr_table, fr_table_end,
+	TP_PROTO(struct device *dev, const char *name, u32 count, int ret),
+	TP_ARGS(dev, name, count, ret)
+);
+
+DECLARE_EVENT_CLASS(fr_dev,
+
+	TP_PROTO(struct device *dev),
+
+	TP_ARGS(dev),
+
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+	),
+
+	TP_printk("%s", __get_str(dev))
+);
+
+DEFINE_EVENT(fr_dev, fr_hold_begin,
+	TP_PROTO(struct device *dev),
+	TP_ARGS(dev)
+);
+
+DEFINE_EVENT(fr_dev, fr_hold_commit,
+	TP_PROTO(struct device *dev),
+	TP_ARGS(dev)
+);
+
+DECLARE_EVENT_CLASS(fr_state,
+
+	TP_PROTO(struct device *dev, bool on, int ret),
+
+	TP_ARGS(dev, on, ret),
+
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+		__field(bool, on)
+		__field(int, ret)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+		__entry->on = on;
+		__entry->ret = ret;
+	),
+
+	TP_printk("%s %s ret=%d", __get_str(dev), __entry->on ? "on" : "off",
+		  __entry->ret)
+);
+
+DEFINE_EVENT(fr_state, fr_power,
+	TP_PROTO(struct device *dev, bool on, int ret),
+	TP_ARGS(dev, on, ret)
+);
+
+DEFINE_EVENT(fr_state, fr_stream_enter,
+	TP_PROTO(struct device *dev, bool on, int ret),
+	TP_ARGS(dev, on, ret)
+);
+
+DEFINE_EVENT(fr_state, fr_stream_exit,
+	TP_PROTO(struct device *dev, bool on, int ret),
+	TP_ARGS(dev, on, ret)
+);
+
+TRACE_EVENT(fr_serdes_step,
+
+	TP_PROTO(struct device *dev, const char *step),
+
+	TP_ARGS(dev, step),
+
+	TP_STRUCT__entry(
+		__string(dev, dev_name(dev))
+		__string(step, step)
+	),
+
+	TP_fast_assign(
+		__assign_str(dev, dev_name(dev));
+		__assign_str(step, step);
+	),
+
+	TP_printk("%s %s", __get_str(dev), __get_str(step))
+);
+
+#endif /* __FR_TRACE_H__ */
+
+/* The module is built out of tree, look for this header next to it */
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE fr_trace
+
+#include <trace/define_trace.h>
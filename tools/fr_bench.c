@@ -0,0 +1,1180 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_bench.c - mode switch, control and SerDes latency benchmark
+ *
+ * Measures, against an emulated sensor (fr_sensor_emu, fr_serdes_emu) or a
+ * real module, the latencies that matter to applications using the FRAMOS
+ * sensor drivers, and writes them out as JSON so that runs can be compared
+ * between driver versions:
+ *
+ *  - modes: for every ordered pair of modes A -> B, the time to set the
+ *    format B after streaming A, to start streaming and for the sensor to
+ *    settle. With the emulator the sensor has settled once it streams with
+ *    no register held back by REGHOLD, on a real module when the first
+ *    frame start (FRAME_SYNC event, or first buffer) is seen after STREAMON.
+ *  - controls: the S_EXT_CTRLS latency of exposure and gain updates issued
+ *    at a fixed rate (120 Hz by default) while streaming, together with the
+ *    G_EXT_CTRLS read back, and the number of missed update periods.
+ *  - serdes: the time fr_serdes_emu needs to bring up its GMSL links, and
+ *    the per step latencies it records.
+ *
+ * The driver's own "latency" and "i2c" debugfs statistics are reset before
+ * and collected after every test when its debugfs directory is given.
+ *
+ * Emulated IMX900, serdes test included:
+ *
+ *   modprobe fr_sensor_emu sensors=imx900 bus_khz=400
+ *   modprobe fr_serdes_emu links=2
+ *   fr_bench -s /dev/v4l-subdev0 \
+ *	-e /sys/kernel/debug/fr_sensor_emu/imx900-emu.0 \
+ *	-d /sys/kernel/debug/imx900-<bus>-001a \
+ *	-S /sys/kernel/debug/fr_serdes_emu -o imx900.json
+ *
+ * Real module connected to the RP1 CFE:
+ *
+ *   fr_bench -s /dev/v4l-subdev2 -v /dev/video0 -o imx900.json
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/utsname.h>
+#include <linux/v4l2-subdev.h>
+#include <linux/videodev2.h>
+
+#define FR_BENCH_MAX_MODES		64
+#define FR_BENCH_NUM_BUFFERS		4
+#define FR_BENCH_SETTLE_TIMEOUT_MS	2000
+#define FR_BENCH_POLL_US		100
+#define FR_BENCH_JSON_DEPTH		16
+
+#define FR_BENCH_TEST_MODES		(1 << 0)
+#define FR_BENCH_TEST_CONTROLS		(1 << 1)
+#define FR_BENCH_TEST_SERDES		(1 << 2)
+
+#define ARRAY_SIZE(a)			(sizeof(a) / sizeof((a)[0]))
+
+struct fr_bench_mode {
+	uint32_t code;
+	uint32_t width;
+	uint32_t height;
+};
+
+struct fr_bench_samples {
+	double *v;
+	size_t n;
+	size_t cap;
+};
+
+struct fr_bench_json {
+	FILE *f;
+	int depth;
+	bool first[FR_BENCH_JSON_DEPTH];
+};
+
+struct fr_bench_ctrl {
+	uint32_t id;
+	const char *name;
+	int64_t val[2];
+	bool present;
+};
+
+struct fr_bench {
+	const char *subdev;
+	const char *emu;
+	const char *video;
+	const char *driver;
+	const char *serdes;
+	const char *output;
+
+	unsigned int tests;
+	unsigned int iterations;
+	unsigned int rate;
+	unsigned int mode_index;
+	double duration;
+
+	int sd_fd;
+	int video_fd;
+	bool frame_sync;
+
+	struct fr_bench_mode modes[FR_BENCH_MAX_MODES];
+	unsigned int num_modes;
+
+	struct fr_bench_json json;
+	unsigned int errors;
+};
+
+static const char * const fr_bench_latency_cols[] = {
+	"count", "min", "avg", "p99", "max",
+};
+
+static const char * const fr_bench_i2c_cols[] = {
+	"transfers", "bytes", "errors", "retries", "busy_us",
+};
+
+static uint64_t fr_bench_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static double fr_bench_us(uint64_t start, uint64_t end)
+{
+	return (end - start) / 1000.0;
+}
+
+static int fr_bench_ioctl(int fd, unsigned long req, void *arg)
+{
+	int ret;
+
+	do {
+		ret = ioctl(fd, req, arg);
+	} while (ret < 0 && errno == EINTR);
+
+	return ret < 0 ? -errno : 0;
+}
+
+/* Samples */
+
+static void fr_bench_samples_add(struct fr_bench_samples *s, double v)
+{
+	if (s->n == s->cap) {
+		size_t cap = s->cap ? s->cap * 2 : 64;
+		double *p = realloc(s->v, cap * sizeof(*p));
+
+		if (!p)
+			return;
+		s->v = p;
+		s->cap = cap;
+	}
+
+	s->v[s->n++] = v;
+}
+
+static void fr_bench_samples_free(struct fr_bench_samples *s)
+{
+	free(s->v);
+	memset(s, 0, sizeof(*s));
+}
+
+static int fr_bench_cmp(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* JSON output */
+
+static void fr_bench_json_key(struct fr_bench_json *j, const char *key)
+{
+	if (j->depth) {
+		fprintf(j->f, "%s\n", j->first[j->depth] ? "" : ",");
+		j->first[j->depth] = false;
+	}
+
+	fprintf(j->f, "%*s", j->depth * 2, "");
+
+	if (key)
+		fprintf(j->f, "\"%s\": ", key);
+}
+
+static void fr_bench_json_open(struct fr_bench_json *j, const char *key,
+			       char c)
+{
+	fr_bench_json_key(j, key);
+	fputc(c, j->f);
+
+	if (j->depth < FR_BENCH_JSON_DEPTH - 1)
+		j->depth++;
+	j->first[j->depth] = true;
+}
+
+static void fr_bench_json_close(struct fr_bench_json *j, char c)
+{
+	bool empty = j->first[j->depth];
+
+	j->depth--;
+
+	if (!empty)
+		fprintf(j->f, "\n%*s", j->depth * 2, "");
+	fputc(c, j->f);
+
+	if (!j->depth)
+		fputc('\n', j->f);
+}
+
+static void fr_bench_json_str(struct fr_bench_json *j, const char *key,
+			      const char *val)
+{
+	fr_bench_json_key(j, key);
+
+	fputc('"', j->f);
+	for (; *val; val++) {
+		if (*val == '"' || *val == '\\')
+			fprintf(j->f, "\\%c", *val);
+		else if ((unsigned char)*val < 0x20)
+			fprintf(j->f, "\\u%04x", *val);
+		else
+			fputc(*val, j->f);
+	}
+	fputc('"', j->f);
+}
+
+static void fr_bench_json_u64(struct fr_bench_json *j, const char *key,
+			      unsigned long long val)
+{
+	fr_bench_json_key(j, key);
+	fprintf(j->f, "%llu", val);
+}
+
+static void fr_bench_json_double(struct fr_bench_json *j, const char *key,
+				 double val)
+{
+	fr_bench_json_key(j, key);
+	fprintf(j->f, "%.1f", val);
+}
+
+static void fr_bench_json_samples(struct fr_bench_json *j, const char *key,
+				  struct fr_bench_samples *s)
+{
+	double sum = 0;
+	size_t i;
+
+	fr_bench_json_open(j, key, '{');
+	fr_bench_json_u64(j, "n", s->n);
+
+	if (s->n) {
+		qsort(s->v, s->n, sizeof(*s->v), fr_bench_cmp);
+
+		for (i = 0; i < s->n; i++)
+			sum += s->v[i];
+
+		fr_bench_json_double(j, "min", s->v[0]);
+		fr_bench_json_double(j, "mean", sum / s->n);
+		fr_bench_json_double(j, "p50", s->v[(s->n - 1) / 2]);
+		fr_bench_json_double(j, "p99",
+				     s->v[(s->n * 99 + 99) / 100 - 1]);
+		fr_bench_json_double(j, "max", s->v[s->n - 1]);
+	}
+
+	fr_bench_json_close(j, '}');
+}
+
+/* debugfs and sysfs files */
+
+static int fr_bench_write(const char *dir, const char *name, const char *val)
+{
+	char path[512];
+	ssize_t len;
+	int fd, ret;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+	fd = open(path, O_WRONLY);
+	if (fd < 0)
+		return -errno;
+
+	len = write(fd, val, strlen(val));
+	ret = len < 0 ? -errno : 0;
+	close(fd);
+
+	return ret;
+}
+
+static int fr_bench_read(const char *dir, const char *name, char *buf,
+			 size_t size)
+{
+	char path[512];
+	ssize_t len;
+	size_t pos = 0;
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/%s", dir, name);
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return -errno;
+
+	while (pos < size - 1) {
+		len = read(fd, buf + pos, size - 1 - pos);
+		if (len < 0 && errno == EINTR)
+			continue;
+		if (len <= 0)
+			break;
+		pos += len;
+	}
+
+	close(fd);
+	buf[pos] = '\0';
+
+	return 0;
+}
+
+/* Value of a "key: value" line of a debugfs state file */
+static long long fr_bench_state(const char *buf, const char *key)
+{
+	size_t len = strlen(key);
+	const char *p = buf;
+
+	while (p && *p) {
+		if (!strncmp(p, key, len) && p[len] == ':')
+			return strtoll(p + len + 1, NULL, 0);
+
+		p = strchr(p, '\n');
+		if (p)
+			p++;
+	}
+
+	return -1;
+}
+
+/* Table of named rows as printed by the fr_stats debugfs files */
+static void fr_bench_json_table(struct fr_bench_json *j, const char *dir,
+				const char *name, const char * const *cols,
+				unsigned int num_cols)
+{
+	unsigned long long vals[8];
+	char buf[4096], row[32];
+	char *line, *save;
+	unsigned int i;
+	int n, pos, len;
+
+	if (fr_bench_read(dir, name, buf, sizeof(buf)))
+		return;
+
+	fr_bench_json_open(j, name, '{');
+
+	line = strtok_r(buf, "\n", &save);
+	while ((line = strtok_r(NULL, "\n", &save))) {
+		if (sscanf(line, "%31s%n", row, &pos) != 1)
+			continue;
+
+		for (n = 0; n < (int)num_cols && n < (int)ARRAY_SIZE(vals);
+		     n++, pos += len)
+			if (sscanf(line + pos, "%llu%n", &vals[n], &len) != 1)
+				break;
+
+		fr_bench_json_open(j, row, '{');
+		for (i = 0; i < (unsigned int)n; i++)
+			fr_bench_json_u64(j, cols[i], vals[i]);
+		fr_bench_json_close(j, '}');
+	}
+
+	fr_bench_json_close(j, '}');
+}
+
+static void fr_bench_driver_reset(struct fr_bench *b)
+{
+	if (!b->driver)
+		return;
+
+	fr_bench_write(b->driver, "latency", "0");
+	fr_bench_write(b->driver, "i2c", "0");
+}
+
+static void fr_bench_driver_stats(struct fr_bench *b)
+{
+	if (!b->driver)
+		return;
+
+	fr_bench_json_open(&b->json, "driver", '{');
+	fr_bench_json_table(&b->json, b->driver, "latency",
+			    fr_bench_latency_cols,
+			    ARRAY_SIZE(fr_bench_latency_cols));
+	fr_bench_json_table(&b->json, b->driver, "i2c", fr_bench_i2c_cols,
+			    ARRAY_SIZE(fr_bench_i2c_cols));
+	fr_bench_json_close(&b->json, '}');
+}
+
+/* Sensor sub-device */
+
+static int fr_bench_enum_modes(struct fr_bench *b)
+{
+	struct v4l2_subdev_mbus_code_enum code = {
+		.which = V4L2_SUBDEV_FORMAT_ACTIVE,
+	};
+	struct v4l2_subdev_frame_size_enum fse;
+	struct fr_bench_mode *mode;
+
+	for (; !fr_bench_ioctl(b->sd_fd, VIDIOC_SUBDEV_ENUM_MBUS_CODE, &code);
+	     code.index++) {
+		memset(&fse, 0, sizeof(fse));
+		fse.which = V4L2_SUBDEV_FORMAT_ACTIVE;
+		fse.code = code.code;
+
+		for (; !fr_bench_ioctl(b->sd_fd, VIDIOC_SUBDEV_ENUM_FRAME_SIZE,
+				       &fse); fse.index++) {
+			if (b->num_modes == FR_BENCH_MAX_MODES)
+				return 0;
+
+			mode = &b->modes[b->num_modes++];
+			mode->code = code.code;
+			mode->width = fse.max_width;
+			mode->height = fse.max_height;
+		}
+	}
+
+	if (!b->num_modes) {
+		fprintf(stderr, "%s: no modes found\n", b->subdev);
+		return -ENODEV;
+	}
+
+	return 0;
+}
+
+static int fr_bench_video_fmt(struct fr_bench *b,
+			      const struct fr_bench_mode *mode)
+{
+	struct v4l2_format fmt = {
+		.type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
+	};
+	int ret;
+
+	ret = fr_bench_ioctl(b->video_fd, VIDIOC_G_FMT, &fmt);
+	if (ret)
+		return ret;
+
+	fmt.fmt.pix.width = mode->width;
+	fmt.fmt.pix.height = mode->height;
+	fmt.fmt.pix.bytesperline = 0;
+	fmt.fmt.pix.sizeimage = 0;
+
+	return fr_bench_ioctl(b->video_fd, VIDIOC_S_FMT, &fmt);
+}
+
+static int fr_bench_set_mode(struct fr_bench *b,
+			     const struct fr_bench_mode *mode)
+{
+	struct v4l2_subdev_format fmt = {
+		.which = V4L2_SUBDEV_FORMAT_ACTIVE,
+		.format = {
+			.code = mode->code,
+			.width = mode->width,
+			.height = mode->height,
+			.field = V4L2_FIELD_NONE,
+		},
+	};
+	int ret;
+
+	ret = fr_bench_ioctl(b->sd_fd, VIDIOC_SUBDEV_S_FMT, &fmt);
+	if (ret)
+		return ret;
+
+	if (fmt.format.code != mode->code || fmt.format.width != mode->width ||
+	    fmt.format.height != mode->height)
+		return -EINVAL;
+
+	if (b->video_fd >= 0)
+		return fr_bench_video_fmt(b, mode);
+
+	return 0;
+}
+
+/* Streaming, through the emulator or the video device */
+
+static int fr_bench_stream_on(struct fr_bench *b)
+{
+	struct v4l2_requestbuffers req = {
+		.count = FR_BENCH_NUM_BUFFERS,
+		.type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
+		.memory = V4L2_MEMORY_MMAP,
+	};
+	struct v4l2_buffer buf;
+	int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	unsigned int i;
+	int ret;
+
+	if (b->video_fd < 0)
+		return fr_bench_write(b->emu, "stream", "1");
+
+	ret = fr_bench_ioctl(b->video_fd, VIDIOC_REQBUFS, &req);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < req.count; i++) {
+		memset(&buf, 0, sizeof(buf));
+		buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buf.memory = V4L2_MEMORY_MMAP;
+		buf.index = i;
+
+		ret = fr_bench_ioctl(b->video_fd, VIDIOC_QBUF, &buf);
+		if (ret)
+			return ret;
+	}
+
+	return fr_bench_ioctl(b->video_fd, VIDIOC_STREAMON, &type);
+}
+
+static int fr_bench_stream_off(struct fr_bench *b)
+{
+	struct v4l2_requestbuffers req = {
+		.count = 0,
+		.type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
+		.memory = V4L2_MEMORY_MMAP,
+	};
+	int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+	int ret;
+
+	if (b->video_fd < 0)
+		return fr_bench_write(b->emu, "stream", "0");
+
+	ret = fr_bench_ioctl(b->video_fd, VIDIOC_STREAMOFF, &type);
+	fr_bench_ioctl(b->video_fd, VIDIOC_REQBUFS, &req);
+
+	return ret;
+}
+
+static int fr_bench_emu_settled(struct fr_bench *b)
+{
+	uint64_t end = fr_bench_now() +
+			FR_BENCH_SETTLE_TIMEOUT_MS * 1000000ull;
+	char buf[1024];
+	int ret;
+
+	do {
+		ret = fr_bench_read(b->emu, "state", buf, sizeof(buf));
+		if (ret)
+			return ret;
+
+		if (fr_bench_state(buf, "streaming") == 1 &&
+		    fr_bench_state(buf, "hold") == 0 &&
+		    fr_bench_state(buf, "pending") == 0)
+			return 0;
+
+		usleep(FR_BENCH_POLL_US);
+	} while (fr_bench_now() < end);
+
+	return -ETIMEDOUT;
+}
+
+static int fr_bench_settled(struct fr_bench *b)
+{
+	struct pollfd pfd;
+	struct v4l2_event ev;
+	struct v4l2_buffer buf = {
+		.type = V4L2_BUF_TYPE_VIDEO_CAPTURE,
+		.memory = V4L2_MEMORY_MMAP,
+	};
+	int ret;
+
+	if (b->video_fd < 0)
+		return fr_bench_emu_settled(b);
+
+	pfd.fd = b->frame_sync ? b->sd_fd : b->video_fd;
+	pfd.events = b->frame_sync ? POLLPRI : POLLIN;
+
+	ret = poll(&pfd, 1, FR_BENCH_SETTLE_TIMEOUT_MS);
+	if (ret < 0)
+		return -errno;
+	if (!ret)
+		return -ETIMEDOUT;
+
+	if (b->frame_sync)
+		return fr_bench_ioctl(b->sd_fd, VIDIOC_DQEVENT, &ev);
+
+	return fr_bench_ioctl(b->video_fd, VIDIOC_DQBUF, &buf);
+}
+
+/* Drop frame starts left over from the previous stream */
+static void fr_bench_flush_events(struct fr_bench *b)
+{
+	struct pollfd pfd = { .fd = b->sd_fd, .events = POLLPRI };
+	struct v4l2_event ev;
+
+	if (!b->frame_sync)
+		return;
+
+	while (poll(&pfd, 1, 0) > 0 &&
+	       !fr_bench_ioctl(b->sd_fd, VIDIOC_DQEVENT, &ev))
+		;
+}
+
+static int fr_bench_start(struct fr_bench *b, const struct fr_bench_mode *mode)
+{
+	int ret;
+
+	ret = fr_bench_set_mode(b, mode);
+	if (ret)
+		return ret;
+
+	fr_bench_flush_events(b);
+
+	ret = fr_bench_stream_on(b);
+	if (ret)
+		return ret;
+
+	ret = fr_bench_settled(b);
+	if (ret)
+		fr_bench_stream_off(b);
+
+	return ret;
+}
+
+/* Tests */
+
+static void fr_bench_json_mode(struct fr_bench_json *j, const char *key,
+			       const struct fr_bench_mode *mode)
+{
+	char code[16];
+
+	snprintf(code, sizeof(code), "0x%04x", mode->code);
+
+	fr_bench_json_open(j, key, '{');
+	fr_bench_json_str(j, "code", code);
+	fr_bench_json_u64(j, "width", mode->width);
+	fr_bench_json_u64(j, "height", mode->height);
+	fr_bench_json_close(j, '}');
+}
+
+static int fr_bench_transition(struct fr_bench *b, unsigned int from,
+			       unsigned int to)
+{
+	struct fr_bench_samples set_fmt = { 0 }, stream_on = { 0 };
+	struct fr_bench_samples settle = { 0 }, total = { 0 };
+	struct fr_bench_json *j = &b->json;
+	uint64_t t0, t1, t2, t3, t4;
+	unsigned int i, errors = 0;
+	int ret;
+
+	for (i = 0; i < b->iterations; i++) {
+		ret = fr_bench_start(b, &b->modes[from]);
+		if (!ret)
+			ret = fr_bench_stream_off(b);
+		if (ret) {
+			errors++;
+			continue;
+		}
+
+		t0 = fr_bench_now();
+		ret = fr_bench_set_mode(b, &b->modes[to]);
+		t1 = fr_bench_now();
+		if (ret) {
+			errors++;
+			continue;
+		}
+
+		fr_bench_flush_events(b);
+
+		t2 = fr_bench_now();
+		ret = fr_bench_stream_on(b);
+		t3 = fr_bench_now();
+		if (!ret)
+			ret = fr_bench_settled(b);
+		t4 = fr_bench_now();
+
+		fr_bench_stream_off(b);
+
+		if (ret) {
+			errors++;
+			continue;
+		}
+
+		fr_bench_samples_add(&set_fmt, fr_bench_us(t0, t1));
+		fr_bench_samples_add(&stream_on, fr_bench_us(t2, t3));
+		fr_bench_samples_add(&settle, fr_bench_us(t3, t4));
+		fr_bench_samples_add(&total, fr_bench_us(t0, t4));
+	}
+
+	fr_bench_json_open(j, NULL, '{');
+	fr_bench_json_u64(j, "from", from);
+	fr_bench_json_u64(j, "to", to);
+	fr_bench_json_u64(j, "errors", errors);
+	fr_bench_json_samples(j, "set_fmt_us", &set_fmt);
+	fr_bench_json_samples(j, "stream_on_us", &stream_on);
+	fr_bench_json_samples(j, "settle_us", &settle);
+	fr_bench_json_samples(j, "total_us", &total);
+	fr_bench_json_close(j, '}');
+
+	fr_bench_samples_free(&set_fmt);
+	fr_bench_samples_free(&stream_on);
+	fr_bench_samples_free(&settle);
+	fr_bench_samples_free(&total);
+
+	if (errors)
+		fprintf(stderr, "mode %u -> %u: %u of %u iterations failed\n",
+			from, to, errors, b->iterations);
+
+	b->errors += errors;
+
+	return 0;
+}
+
+static int fr_bench_modes(struct fr_bench *b)
+{
+	struct fr_bench_json *j = &b->json;
+	unsigned int from, to;
+
+	fr_bench_driver_reset(b);
+
+	fr_bench_json_open(j, "modes", '{');
+
+	fr_bench_json_open(j, "modes", '[');
+	for (from = 0; from < b->num_modes; from++)
+		fr_bench_json_mode(j, NULL, &b->modes[from]);
+	fr_bench_json_close(j, ']');
+
+	fr_bench_json_open(j, "transitions", '[');
+	for (from = 0; from < b->num_modes; from++)
+		for (to = 0; to < b->num_modes; to++)
+			if (from != to)
+				fr_bench_transition(b, from, to);
+	fr_bench_json_close(j, ']');
+
+	fr_bench_driver_stats(b);
+
+	fr_bench_json_close(j, '}');
+
+	return 0;
+}
+
+static void fr_bench_ctrl_query(struct fr_bench *b, struct fr_bench_ctrl *ctrl)
+{
+	struct v4l2_query_ext_ctrl qc = { .id = ctrl->id };
+	int64_t range, step;
+
+	ctrl->present = !fr_bench_ioctl(b->sd_fd, VIDIOC_QUERY_EXT_CTRL, &qc) &&
+			qc.type == V4L2_CTRL_TYPE_INTEGER &&
+			qc.maximum > qc.minimum;
+	if (!ctrl->present)
+		return;
+
+	/* Alternate between two values, so that every write hits the sensor */
+	range = qc.maximum - qc.minimum;
+	step = qc.step ? qc.step : 1;
+	ctrl->val[0] = qc.minimum + (range / 4) / step * step;
+	ctrl->val[1] = qc.minimum + (range / 2) / step * step;
+}
+
+static int fr_bench_controls(struct fr_bench *b)
+{
+	struct fr_bench_ctrl ctrls[] = {
+		{ .id = V4L2_CID_EXPOSURE, .name = "exposure" },
+		{ .id = V4L2_CID_ANALOGUE_GAIN, .name = "analogue_gain" },
+	};
+	struct v4l2_ext_control c[ARRAY_SIZE(ctrls)];
+	struct v4l2_ext_controls ec = {
+		.which = V4L2_CTRL_WHICH_CUR_VAL,
+		.controls = c,
+	};
+	struct fr_bench_samples write_us = { 0 }, round_trip = { 0 };
+	struct fr_bench_json *j = &b->json;
+	const struct fr_bench_mode *mode = &b->modes[b->mode_index];
+	uint64_t period = 1000000000ull / b->rate;
+	uint64_t end, next, t0, t1, t2;
+	unsigned long long writes = 0, missed = 0, errors = 0;
+	struct timespec ts;
+	unsigned int i, n;
+	int ret;
+
+	fr_bench_driver_reset(b);
+
+	ret = fr_bench_start(b, mode);
+	if (ret) {
+		fprintf(stderr, "%s: failed to start streaming: %s\n",
+			b->subdev, strerror(-ret));
+		b->errors++;
+		return ret;
+	}
+
+	for (i = 0, n = 0; i < ARRAY_SIZE(ctrls); i++) {
+		fr_bench_ctrl_query(b, &ctrls[i]);
+		if (ctrls[i].present)
+			c[n++].id = ctrls[i].id;
+	}
+	ec.count = n;
+
+	next = fr_bench_now() + period;
+	end = next + (uint64_t)(b->duration * 1000000000.0);
+
+	while (n && next < end) {
+		ts.tv_sec = next / 1000000000ull;
+		ts.tv_nsec = next % 1000000000ull;
+		while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts,
+				       NULL) == EINTR)
+			;
+
+		for (i = 0, n = 0; i < ARRAY_SIZE(ctrls); i++)
+			if (ctrls[i].present)
+				c[n++].value64 = ctrls[i].val[writes & 1];
+		ec.which = V4L2_CTRL_WHICH_CUR_VAL;
+
+		t0 = fr_bench_now();
+		ret = fr_bench_ioctl(b->sd_fd, VIDIOC_S_EXT_CTRLS, &ec);
+		t1 = fr_bench_now();
+		if (!ret)
+			ret = fr_bench_ioctl(b->sd_fd, VIDIOC_G_EXT_CTRLS, &ec);
+		t2 = fr_bench_now();
+
+		writes++;
+		if (ret) {
+			errors++;
+		} else {
+			fr_bench_samples_add(&write_us, fr_bench_us(t0, t1));
+			fr_bench_samples_add(&round_trip, fr_bench_us(t0, t2));
+		}
+
+		/* Periods that went by while the update was still running */
+		for (next += period; next <= t2; next += period)
+			missed++;
+	}
+
+	fr_bench_stream_off(b);
+
+	fr_bench_json_open(j, "controls", '{');
+	fr_bench_json_mode(j, "mode", mode);
+	fr_bench_json_u64(j, "rate_hz", b->rate);
+	fr_bench_json_double(j, "duration_s", b->duration);
+	fr_bench_json_open(j, "controls", '[');
+	for (i = 0; i < ARRAY_SIZE(ctrls); i++)
+		if (ctrls[i].present)
+			fr_bench_json_str(j, NULL, ctrls[i].name);
+	fr_bench_json_close(j, ']');
+	fr_bench_json_u64(j, "writes", writes);
+	fr_bench_json_u64(j, "missed_periods", missed);
+	fr_bench_json_u64(j, "errors", errors);
+	fr_bench_json_samples(j, "write_us", &write_us);
+	fr_bench_json_samples(j, "round_trip_us", &round_trip);
+	fr_bench_driver_stats(b);
+	fr_bench_json_close(j, '}');
+
+	fr_bench_samples_free(&write_us);
+	fr_bench_samples_free(&round_trip);
+
+	if (!ec.count)
+		fprintf(stderr, "%s: no exposure or gain control\n", b->subdev);
+	if (errors)
+		fprintf(stderr, "%s: %llu of %llu control writes failed\n",
+			b->subdev, errors, writes);
+
+	b->errors += errors;
+
+	return 0;
+}
+
+static int fr_bench_serdes(struct fr_bench *b)
+{
+	struct fr_bench_samples bringup = { 0 };
+	struct fr_bench_json *j = &b->json;
+	unsigned int i, errors = 0;
+	uint64_t t0, t1;
+	int ret;
+
+	fr_bench_write(b->serdes, "bringup", "0");
+	fr_bench_write(b->serdes, "latency", "0");
+
+	for (i = 0; i < b->iterations; i++) {
+		t0 = fr_bench_now();
+		ret = fr_bench_write(b->serdes, "bringup", "1");
+		t1 = fr_bench_now();
+
+		if (ret)
+			errors++;
+		else
+			fr_bench_samples_add(&bringup, fr_bench_us(t0, t1));
+
+		fr_bench_write(b->serdes, "bringup", "0");
+	}
+
+	fr_bench_json_open(j, "serdes", '{');
+	fr_bench_json_u64(j, "iterations", b->iterations);
+	fr_bench_json_u64(j, "errors", errors);
+	fr_bench_json_samples(j, "bringup_us", &bringup);
+	fr_bench_json_table(j, b->serdes, "latency", fr_bench_latency_cols,
+			    ARRAY_SIZE(fr_bench_latency_cols));
+	fr_bench_json_close(j, '}');
+
+	fr_bench_samples_free(&bringup);
+
+	if (errors)
+		fprintf(stderr, "%s: %u of %u bring-ups failed\n", b->serdes,
+			errors, b->iterations);
+
+	b->errors += errors;
+
+	return 0;
+}
+
+/* Setup */
+
+static void fr_bench_json_params(struct fr_bench_json *j, const char *key,
+				 const char *module)
+{
+	static const char * const params[] = {
+		"sensors", "chromacity", "links", "latency_us", "bus_khz",
+		"tunnel_us", "lock_ms", "nak_every",
+	};
+	char dir[128], buf[128];
+	unsigned int i;
+
+	snprintf(dir, sizeof(dir), "/sys/module/%s/parameters", module);
+	if (access(dir, F_OK))
+		return;
+
+	fr_bench_json_open(j, key, '{');
+	for (i = 0; i < ARRAY_SIZE(params); i++) {
+		if (fr_bench_read(dir, params[i], buf, sizeof(buf)))
+			continue;
+		buf[strcspn(buf, "\n")] = '\0';
+		fr_bench_json_str(j, params[i], buf);
+	}
+	fr_bench_json_close(j, '}');
+}
+
+static void fr_bench_json_setup(struct fr_bench *b)
+{
+	struct fr_bench_json *j = &b->json;
+	struct utsname uts;
+	char name[64] = "";
+	char dir[512];
+	const char *base;
+
+	fr_bench_json_open(j, "setup", '{');
+
+	if (!uname(&uts))
+		fr_bench_json_str(j, "kernel", uts.release);
+
+	if (b->subdev) {
+		base = strrchr(b->subdev, '/');
+		snprintf(dir, sizeof(dir), "/sys/class/video4linux/%s",
+			 base ? base + 1 : b->subdev);
+		if (!fr_bench_read(dir, "name", name, sizeof(name)))
+			name[strcspn(name, "\n")] = '\0';
+
+		fr_bench_json_str(j, "subdev", b->subdev);
+		fr_bench_json_str(j, "sensor", name);
+		fr_bench_json_str(j, "stream", b->video ? b->video : b->emu);
+		fr_bench_json_str(j, "settle", b->video ? (b->frame_sync ?
+				  "frame_sync" : "first_buffer") : "registers");
+	}
+
+	fr_bench_json_u64(j, "iterations", b->iterations);
+	fr_bench_json_params(j, "sensor_emu", "fr_sensor_emu");
+	fr_bench_json_params(j, "serdes_emu", "fr_serdes_emu");
+
+	fr_bench_json_close(j, '}');
+}
+
+static int fr_bench_open(struct fr_bench *b)
+{
+	struct v4l2_event_subscription sub = {
+		.type = V4L2_EVENT_FRAME_SYNC,
+	};
+	int ret;
+
+	if (!(b->tests & (FR_BENCH_TEST_MODES | FR_BENCH_TEST_CONTROLS)))
+		return 0;
+
+	if (!b->subdev || (!b->emu && !b->video)) {
+		fprintf(stderr, "modes and controls tests need a sub-device and an emulator directory or a video device\n");
+		return -EINVAL;
+	}
+
+	b->sd_fd = open(b->subdev, O_RDWR);
+	if (b->sd_fd < 0) {
+		fprintf(stderr, "%s: %s\n", b->subdev, strerror(errno));
+		return -errno;
+	}
+
+	if (b->video) {
+		b->video_fd = open(b->video, O_RDWR | O_NONBLOCK);
+		if (b->video_fd < 0) {
+			fprintf(stderr, "%s: %s\n", b->video, strerror(errno));
+			return -errno;
+		}
+
+		b->frame_sync = !fr_bench_ioctl(b->sd_fd,
+					VIDIOC_SUBSCRIBE_EVENT, &sub);
+	}
+
+	ret = fr_bench_enum_modes(b);
+	if (ret)
+		return ret;
+
+	if (b->mode_index >= b->num_modes) {
+		fprintf(stderr, "%s: mode %u out of range (%u modes)\n",
+			b->subdev, b->mode_index, b->num_modes);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static unsigned int fr_bench_parse_tests(const char *arg)
+{
+	static const char * const names[] = { "modes", "controls", "serdes" };
+	unsigned int tests = 0, i;
+	char *buf = strdup(arg), *tok, *save;
+
+	for (tok = strtok_r(buf, ",", &save); tok;
+	     tok = strtok_r(NULL, ",", &save)) {
+		for (i = 0; i < ARRAY_SIZE(names); i++)
+			if (!strcmp(tok, names[i]))
+				break;
+
+		if (i < ARRAY_SIZE(names))
+			tests |= 1 << i;
+		else
+			fprintf(stderr, "unknown test %s\n", tok);
+	}
+
+	free(buf);
+
+	return tests;
+}
+
+static void fr_bench_usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"\n"
+		"  -s, --subdev DEV      sensor sub-device (/dev/v4l-subdevN)\n"
+		"  -e, --emu DIR         fr_sensor_emu debugfs directory of the sensor\n"
+		"  -v, --video DEV       video device streaming from the sensor\n"
+		"  -d, --driver DIR      sensor driver debugfs directory\n"
+		"  -S, --serdes DIR      fr_serdes_emu debugfs directory\n"
+		"  -t, --tests LIST      comma separated: modes,controls,serdes\n"
+		"  -n, --iterations N    iterations per mode transition and bring-up (5)\n"
+		"  -r, --rate HZ         control update rate (120)\n"
+		"  -D, --duration SEC    control test duration (5)\n"
+		"  -m, --mode N          mode used by the control test (0)\n"
+		"  -o, --output FILE     JSON output, stdout by default\n",
+		argv0);
+}
+
+int main(int argc, char *argv[])
+{
+	static const struct option options[] = {
+		{ "subdev", required_argument, NULL, 's' },
+		{ "emu", required_argument, NULL, 'e' },
+		{ "video", required_argument, NULL, 'v' },
+		{ "driver", required_argument, NULL, 'd' },
+		{ "serdes", required_argument, NULL, 'S' },
+		{ "tests", required_argument, NULL, 't' },
+		{ "iterations", required_argument, NULL, 'n' },
+		{ "rate", required_argument, NULL, 'r' },
+		{ "duration", required_argument, NULL, 'D' },
+		{ "mode", required_argument, NULL, 'm' },
+		{ "output", required_argument, NULL, 'o' },
+		{ "help", no_argument, NULL, 'h' },
+		{ }
+	};
+	struct fr_bench bench = {
+		.iterations = 5,
+		.rate = 120,
+		.duration = 5.0,
+		.sd_fd = -1,
+		.video_fd = -1,
+	};
+	struct fr_bench *b = &bench;
+	int opt, ret;
+
+	while ((opt = getopt_long(argc, argv, "s:e:v:d:S:t:n:r:D:m:o:h",
+				  options, NULL)) != -1) {
+		switch (opt) {
+		case 's':
+			b->subdev = optarg;
+			break;
+		case 'e':
+			b->emu = optarg;
+			break;
+		case 'v':
+			b->video = optarg;
+			break;
+		case 'd':
+			b->driver = optarg;
+			break;
+		case 'S':
+			b->serdes = optarg;
+			break;
+		case 't':
+			b->tests = fr_bench_parse_tests(optarg);
+			break;
+		case 'n':
+			b->iterations = strtoul(optarg, NULL, 0);
+			break;
+		case 'r':
+			b->rate = strtoul(optarg, NULL, 0);
+			break;
+		case 'D':
+			b->duration = strtod(optarg, NULL);
+			break;
+		case 'm':
+			b->mode_index = strtoul(optarg, NULL, 0);
+			break;
+		case 'o':
+			b->output = optarg;
+			break;
+		default:
+			fr_bench_usage(argv[0]);
+			return opt == 'h' ? 0 : 1;
+		}
+	}
+
+	if (!b->tests) {
+		if (b->subdev)
+			b->tests |= FR_BENCH_TEST_MODES | FR_BENCH_TEST_CONTROLS;
+		if (b->serdes)
+			b->tests |= FR_BENCH_TEST_SERDES;
+	}
+
+	if (!b->tests || !b->iterations || !b->rate) {
+		fr_bench_usage(argv[0]);
+		return 1;
+	}
+
+	if ((b->tests & FR_BENCH_TEST_SERDES) && !b->serdes) {
+		fprintf(stderr, "serdes test needs the fr_serdes_emu directory\n");
+		return 1;
+	}
+
+	ret = fr_bench_open(b);
+	if (ret)
+		goto out;
+
+	b->json.f = b->output ? fopen(b->output, "w") : stdout;
+	if (!b->json.f) {
+		fprintf(stderr, "%s: %s\n", b->output, strerror(errno));
+		ret = -errno;
+		goto out;
+	}
+
+	fr_bench_json_open(&b->json, NULL, '{');
+	fr_bench_json_setup(b);
+
+	if (b->tests & FR_BENCH_TEST_MODES)
+		fr_bench_modes(b);
+	if (b->tests & FR_BENCH_TEST_CONTROLS)
+		fr_bench_controls(b);
+	if (b->tests & FR_BENCH_TEST_SERDES)
+		fr_bench_serdes(b);
+
+	fr_bench_json_u64(&b->json, "errors", b->errors);
+	fr_bench_json_close(&b->json, '}');
+
+	if (b->json.f != stdout)
+		fclose(b->json.f);
+
+out:
+	if (b->video_fd >= 0)
+		close(b->video_fd);
+	if (b->sd_fd >= 0)
+		close(b->sd_fd);
+
+	return ret || b->errors ? 1 : 0;
+}
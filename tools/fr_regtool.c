@@ -0,0 +1,899 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (c) 2024, Framos. All rights reserved.
+ *
+ * fr_regtool.c - register table checker and diff tool
+ *
+ * Parses the {address, value} tables of a drivers/fr_*_regs.h header, with
+ * the register name and value macros they use, and works on "sequences":
+ * comma separated lists of tables written one after the other, the way the
+ * drivers program the sensor (e.g. mode_common_regs,mode_1920x1080).
+ *
+ *   list  FILE
+ *	tables with their number of entries
+ *
+ *   check FILE [SEQ...]
+ *	addresses written more than once within a table, then within every
+ *	sequence, split into redundant writes (same value again) and
+ *	overwrites (the earlier write is lost). Without a sequence, every
+ *	table is checked following mode_common_regs. Exits with 1 when a
+ *	table writes an address twice.
+ *
+ *   diff  FILE [SEQ_A SEQ_B]
+ *	registers whose final value differs between two sequences, i.e. the
+ *	writes needed to switch from A to B. Without sequences, a summary of
+ *	the differences between every pair of mode_ tables.
+ *
+ * Built with "make regtool"; "make regcheck" checks every header.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FR_REG_MAX_DEPTH	16
+#define FR_REG_NUM_ADDRS	0x10000
+
+struct fr_reg_define {
+	char *name;
+	char *param;
+	char *body;
+};
+
+struct fr_reg_entry {
+	unsigned int addr;
+	unsigned int val;
+	unsigned int line;
+	const char *name;
+};
+
+struct fr_reg_table {
+	char *name;
+	unsigned int line;
+	struct fr_reg_entry *entries;
+	unsigned int num_entries;
+};
+
+struct fr_reg_file {
+	const char *path;
+	struct fr_reg_define *defines;
+	unsigned int num_defines;
+	struct fr_reg_table *tables;
+	unsigned int num_tables;
+};
+
+/* Final state of the registers written by a sequence */
+struct fr_reg_state {
+	bool written[FR_REG_NUM_ADDRS];
+	unsigned int val[FR_REG_NUM_ADDRS];
+	const char *name[FR_REG_NUM_ADDRS];
+};
+
+struct fr_reg_eval {
+	const struct fr_reg_file *file;
+	const char *p;
+	int depth;
+	bool error;
+};
+
+static void *fr_reg_alloc(void *p, size_t n, size_t size)
+{
+	p = realloc(p, n * size);
+	if (!p) {
+		perror("realloc");
+		exit(2);
+	}
+
+	return p;
+}
+
+static char *fr_reg_strndup(const char *s, size_t len)
+{
+	char *d = fr_reg_alloc(NULL, len + 1, 1);
+
+	memcpy(d, s, len);
+	d[len] = '\0';
+
+	return d;
+}
+
+static bool fr_reg_ident(int c)
+{
+	return isalnum(c) || c == '_';
+}
+
+/* Expression evaluation */
+
+static const struct fr_reg_define *
+fr_reg_find_define(const struct fr_reg_file *file, const char *name,
+		   size_t len)
+{
+	unsigned int i;
+
+	for (i = 0; i < file->num_defines; i++)
+		if (strlen(file->defines[i].name) == len &&
+		    !strncmp(file->defines[i].name, name, len))
+			return &file->defines[i];
+
+	return NULL;
+}
+
+static long long fr_reg_eval_str(const struct fr_reg_file *file,
+				 const char *s, int depth, bool *error);
+static long long fr_reg_eval_or(struct fr_reg_eval *e);
+
+static void fr_reg_skip(struct fr_reg_eval *e)
+{
+	while (isspace((unsigned char)*e->p))
+		e->p++;
+}
+
+/* Body of a function-like macro with its parameter replaced by arg */
+static char *fr_reg_expand(const struct fr_reg_define *def, const char *arg,
+			   size_t arg_len)
+{
+	size_t plen = strlen(def->param);
+	size_t size = strlen(def->body) + 1, len = 0;
+	const char *p = def->body;
+	char *out = fr_reg_alloc(NULL, size, 1);
+
+	while (*p) {
+		if (fr_reg_ident(*p) && !strncmp(p, def->param, plen) &&
+		    !fr_reg_ident(p[plen]) &&
+		    (p == def->body || !fr_reg_ident(p[-1]))) {
+			size += arg_len + 2;
+			out = fr_reg_alloc(out, size, 1);
+			out[len++] = '(';
+			memcpy(out + len, arg, arg_len);
+			len += arg_len;
+			out[len++] = ')';
+			p += plen;
+			continue;
+		}
+		out[len++] = *p++;
+	}
+	out[len] = '\0';
+
+	return out;
+}
+
+static long long fr_reg_eval_ident(struct fr_reg_eval *e)
+{
+	const struct fr_reg_define *def;
+	const char *name = e->p, *arg;
+	size_t len, arg_len;
+	long long val;
+	char *body;
+	int level;
+
+	while (fr_reg_ident(*e->p))
+		e->p++;
+	len = e->p - name;
+
+	def = fr_reg_find_define(e->file, name, len);
+	if (!def) {
+		fprintf(stderr, "%s: unknown symbol %.*s\n", e->file->path,
+			(int)len, name);
+		e->error = true;
+		return 0;
+	}
+
+	if (!def->param)
+		return fr_reg_eval_str(e->file, def->body, e->depth + 1,
+				       &e->error);
+
+	fr_reg_skip(e);
+	if (*e->p != '(') {
+		e->error = true;
+		return 0;
+	}
+
+	arg = ++e->p;
+	for (level = 1; *e->p && level; e->p++)
+		level += (*e->p == '(') - (*e->p == ')');
+	if (level) {
+		e->error = true;
+		return 0;
+	}
+	arg_len = e->p - 1 - arg;
+
+	body = fr_reg_expand(def, arg, arg_len);
+	val = fr_reg_eval_str(e->file, body, e->depth + 1, &e->error);
+	free(body);
+
+	return val;
+}
+
+static long long fr_reg_eval_unary(struct fr_reg_eval *e)
+{
+	long long val;
+	char *end;
+
+	fr_reg_skip(e);
+
+	switch (*e->p) {
+	case '(':
+		e->p++;
+		val = fr_reg_eval_or(e);
+		fr_reg_skip(e);
+		if (*e->p != ')')
+			e->error = true;
+		else
+			e->p++;
+		return val;
+	case '-':
+		e->p++;
+		return -fr_reg_eval_unary(e);
+	case '~':
+		e->p++;
+		return ~fr_reg_eval_unary(e);
+	}
+
+	if (isdigit((unsigned char)*e->p)) {
+		val = strtoll(e->p, &end, 0);
+		e->p = end;
+		while (*e->p == 'u' || *e->p == 'U' || *e->p == 'l' ||
+		       *e->p == 'L')
+			e->p++;
+		return val;
+	}
+
+	if (fr_reg_ident(*e->p))
+		return fr_reg_eval_ident(e);
+
+	e->error = true;
+
+	return 0;
+}
+
+static long long fr_reg_eval_mul(struct fr_reg_eval *e)
+{
+	long long val = fr_reg_eval_unary(e), rhs;
+	char op;
+
+	for (fr_reg_skip(e); *e->p == '*' || *e->p == '/' || *e->p == '%';
+	     fr_reg_skip(e)) {
+		op = *e->p++;
+		rhs = fr_reg_eval_unary(e);
+		if (op != '*' && !rhs) {
+			e->error = true;
+			return 0;
+		}
+		val = op == '*' ? val * rhs : op == '/' ? val / rhs : val % rhs;
+	}
+
+	return val;
+}
+
+static long long fr_reg_eval_add(struct fr_reg_eval *e)
+{
+	long long val = fr_reg_eval_mul(e);
+	char op;
+
+	for (fr_reg_skip(e); *e->p == '+' || *e->p == '-'; fr_reg_skip(e)) {
+		op = *e->p++;
+		val = op == '+' ? val + fr_reg_eval_mul(e) :
+				  val - fr_reg_eval_mul(e);
+	}
+
+	return val;
+}
+
+static long long fr_reg_eval_shift(struct fr_reg_eval *e)
+{
+	long long val = fr_reg_eval_add(e);
+	char op;
+
+	for (fr_reg_skip(e); (e->p[0] == '<' || e->p[0] == '>') &&
+	     e->p[1] == e->p[0]; fr_reg_skip(e)) {
+		op = *e->p;
+		e->p += 2;
+		val = op == '<' ? val << fr_reg_eval_add(e) :
+				  val >> fr_reg_eval_add(e);
+	}
+
+	return val;
+}
+
+static long long fr_reg_eval_and(struct fr_reg_eval *e)
+{
+	long long val = fr_reg_eval_shift(e);
+
+	for (fr_reg_skip(e); *e->p == '&'; fr_reg_skip(e)) {
+		e->p++;
+		val &= fr_reg_eval_shift(e);
+	}
+
+	return val;
+}
+
+static long long fr_reg_eval_or(struct fr_reg_eval *e)
+{
+	long long val = fr_reg_eval_and(e);
+
+	for (fr_reg_skip(e); *e->p == '|' || *e->p == '^'; fr_reg_skip(e)) {
+		if (*e->p++ == '|')
+			val |= fr_reg_eval_and(e);
+		else
+			val ^= fr_reg_eval_and(e);
+	}
+
+	return val;
+}
+
+static long long fr_reg_eval_str(const struct fr_reg_file *file,
+				 const char *s, int depth, bool *error)
+{
+	struct fr_reg_eval e = {
+		.file = file,
+		.p = s,
+		.depth = depth,
+	};
+	long long val;
+
+	if (depth > FR_REG_MAX_DEPTH) {
+		fprintf(stderr, "%s: macro recursion in %s\n", file->path, s);
+		*error = true;
+		return 0;
+	}
+
+	val = fr_reg_eval_or(&e);
+	fr_reg_skip(&e);
+
+	if (e.error || *e.p)
+		*error = true;
+
+	return val;
+}
+
+/* Header parsing */
+
+/* Blank out comments, keeping the line structure */
+static void fr_reg_strip_comments(char *s)
+{
+	char *end;
+
+	while (*s) {
+		if (s[0] == '/' && s[1] == '*') {
+			end = strstr(s + 2, "*/");
+			end = end ? end + 2 : s + strlen(s);
+			for (; s < end; s++)
+				if (*s != '\n')
+					*s = ' ';
+		} else if (s[0] == '/' && s[1] == '/') {
+			for (; *s && *s != '\n'; s++)
+				*s = ' ';
+		} else {
+			s++;
+		}
+	}
+}
+
+static void fr_reg_parse_define(struct fr_reg_file *file, char *line)
+{
+	struct fr_reg_define *def;
+	char *name, *end;
+
+	name = line + strlen("#define");
+	while (isspace((unsigned char)*name))
+		name++;
+	for (end = name; fr_reg_ident(*end); end++)
+		;
+	if (end == name)
+		return;
+
+	file->defines = fr_reg_alloc(file->defines, file->num_defines + 1,
+				     sizeof(*file->defines));
+	def = &file->defines[file->num_defines++];
+	def->name = fr_reg_strndup(name, end - name);
+	def->param = NULL;
+
+	if (*end == '(') {
+		name = ++end;
+		end = strchr(end, ')');
+		if (!end) {
+			file->num_defines--;
+			return;
+		}
+		def->param = fr_reg_strndup(name, end - name);
+		end++;
+	}
+
+	while (isspace((unsigned char)*end))
+		end++;
+	def->body = fr_reg_strndup(end, strcspn(end, "\n"));
+}
+
+static int fr_reg_parse_entry(struct fr_reg_file *file,
+			      struct fr_reg_table *table, char *p,
+			      unsigned int line)
+{
+	struct fr_reg_entry *entry;
+	char *addr, *val, *end;
+	bool error = false;
+	int level = 0;
+
+	/* p points after '{', split at the top level comma */
+	addr = p;
+	for (val = p; *val && (level || *val != ','); val++)
+		level += (*val == '(') - (*val == ')');
+	if (*val != ',')
+		return -EINVAL;
+	*val++ = '\0';
+
+	end = strrchr(val, '}');
+	if (!end)
+		return -EINVAL;
+	*end = '\0';
+
+	table->entries = fr_reg_alloc(table->entries, table->num_entries + 1,
+				      sizeof(*table->entries));
+	entry = &table->entries[table->num_entries++];
+	entry->line = line;
+	entry->addr = fr_reg_eval_str(file, addr, 0, &error);
+	entry->val = fr_reg_eval_str(file, val, 0, &error);
+	entry->name = NULL;
+
+	while (isspace((unsigned char)*addr))
+		addr++;
+	if (!isdigit((unsigned char)*addr)) {
+		for (end = addr; fr_reg_ident(*end); end++)
+			;
+		entry->name = fr_reg_strndup(addr, end - addr);
+	}
+
+	if (error || entry->addr >= FR_REG_NUM_ADDRS) {
+		fprintf(stderr, "%s:%u: cannot evaluate entry of %s\n",
+			file->path, line, table->name);
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+static int fr_reg_parse(struct fr_reg_file *file, const char *path)
+{
+	struct fr_reg_table *table = NULL;
+	char *buf, *line, *next, *p, *name;
+	unsigned int lineno = 0;
+	size_t size = 0, len;
+	FILE *f;
+	int ret = 0;
+
+	f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return -errno;
+	}
+
+	buf = NULL;
+	do {
+		buf = fr_reg_alloc(buf, size + 4096 + 1, 1);
+		len = fread(buf + size, 1, 4096, f);
+		size += len;
+	} while (len);
+	buf[size] = '\0';
+	fclose(f);
+
+	memset(file, 0, sizeof(*file));
+	file->path = path;
+
+	fr_reg_strip_comments(buf);
+
+	for (line = buf; line; line = next) {
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+		lineno++;
+
+		for (p = line; isspace((unsigned char)*p); p++)
+			;
+
+		if (!strncmp(p, "#define", 7)) {
+			fr_reg_parse_define(file, p);
+			continue;
+		}
+
+		if (table) {
+			if (*p == '}') {
+				table = NULL;
+			} else if (*p == '{') {
+				if (fr_reg_parse_entry(file, table, p + 1,
+						       lineno))
+					ret = -EINVAL;
+			}
+			continue;
+		}
+
+		/* static const struct fr_sensor_reg name[] = { */
+		if (strncmp(p, "static const struct ", 20) ||
+		    !strstr(p, "_reg ") || !strstr(p, "[]"))
+			continue;
+
+		name = strstr(p, "_reg ") + 5;
+		while (isspace((unsigned char)*name))
+			name++;
+
+		file->tables = fr_reg_alloc(file->tables, file->num_tables + 1,
+					    sizeof(*file->tables));
+		table = &file->tables[file->num_tables++];
+		memset(table, 0, sizeof(*table));
+		table->name = fr_reg_strndup(name, strcspn(name, "[ \t"));
+		table->line = lineno;
+	}
+
+	if (!file->num_tables) {
+		fprintf(stderr, "%s: no register tables found\n", path);
+		ret = -EINVAL;
+	}
+
+	return ret;
+}
+
+static const struct fr_reg_table *fr_reg_find_table(
+				const struct fr_reg_file *file,
+				const char *name, size_t len)
+{
+	unsigned int i;
+
+	for (i = 0; i < file->num_tables; i++)
+		if (strlen(file->tables[i].name) == len &&
+		    !strncmp(file->tables[i].name, name, len))
+			return &file->tables[i];
+
+	return NULL;
+}
+
+/* Register names, as used in the tables */
+static void fr_reg_format_addr(char *buf, size_t size,
+			       const struct fr_reg_entry *entry)
+{
+	if (entry->name)
+		snprintf(buf, size, "0x%04x %-20s", entry->addr, entry->name);
+	else
+		snprintf(buf, size, "0x%04x %-20s", entry->addr, "");
+}
+
+/* Sequences */
+
+/* Apply a sequence, calling dup for every address written before */
+static int fr_reg_apply(const struct fr_reg_file *file, const char *seq,
+			struct fr_reg_state *state,
+			void (*dup)(const struct fr_reg_table *,
+				    const struct fr_reg_entry *,
+				    unsigned int prev, void *),
+			void *priv)
+{
+	const struct fr_reg_table *table;
+	const struct fr_reg_entry *entry;
+	const char *name = seq;
+	unsigned int i;
+	size_t len;
+
+	memset(state, 0, sizeof(*state));
+
+	while (*name) {
+		len = strcspn(name, ",");
+		table = fr_reg_find_table(file, name, len);
+		if (!table) {
+			fprintf(stderr, "%s: unknown table %.*s\n", file->path,
+				(int)len, name);
+			return -EINVAL;
+		}
+
+		for (i = 0; i < table->num_entries; i++) {
+			entry = &table->entries[i];
+
+			if (state->written[entry->addr] && dup)
+				dup(table, entry, state->val[entry->addr],
+				    priv);
+
+			state->written[entry->addr] = true;
+			state->val[entry->addr] = entry->val;
+			if (entry->name)
+				state->name[entry->addr] = entry->name;
+		}
+
+		name += len;
+		if (*name == ',')
+			name++;
+	}
+
+	return 0;
+}
+
+/* Commands */
+
+static int fr_reg_list(const struct fr_reg_file *file)
+{
+	unsigned int i, total = 0;
+
+	for (i = 0; i < file->num_tables; i++) {
+		printf("%-44s %4u\n", file->tables[i].name,
+		       file->tables[i].num_entries);
+		total += file->tables[i].num_entries;
+	}
+
+	printf("%-44s %4u\n", "total", total);
+
+	return 0;
+}
+
+struct fr_reg_check {
+	const struct fr_reg_file *file;
+	unsigned int redundant;
+	unsigned int overwritten;
+	bool quiet;
+};
+
+static void fr_reg_check_dup(const struct fr_reg_table *table,
+			     const struct fr_reg_entry *entry,
+			     unsigned int prev, void *priv)
+{
+	struct fr_reg_check *check = priv;
+	char addr[40];
+
+	if (prev == entry->val)
+		check->redundant++;
+	else
+		check->overwritten++;
+
+	if (check->quiet)
+		return;
+
+	fr_reg_format_addr(addr, sizeof(addr), entry);
+
+	if (prev == entry->val)
+		printf("  %s:%u: %s 0x%02x again (%s)\n", check->file->path,
+		       entry->line, addr, entry->val, table->name);
+	else
+		printf("  %s:%u: %s 0x%02x -> 0x%02x (%s)\n",
+		       check->file->path, entry->line, addr, prev, entry->val,
+		       table->name);
+}
+
+static int fr_reg_check_tables(const struct fr_reg_file *file)
+{
+	struct fr_reg_state *state = fr_reg_alloc(NULL, 1, sizeof(*state));
+	struct fr_reg_check check = { .file = file };
+	unsigned int i, dups = 0;
+
+	for (i = 0; i < file->num_tables; i++) {
+		check.redundant = check.overwritten = 0;
+		check.quiet = true;
+		fr_reg_apply(file, file->tables[i].name, state,
+			     fr_reg_check_dup, &check);
+		if (!check.redundant && !check.overwritten)
+			continue;
+
+		printf("%s: %u redundant, %u overwritten\n",
+		       file->tables[i].name, check.redundant,
+		       check.overwritten);
+		check.quiet = false;
+		fr_reg_apply(file, file->tables[i].name, state,
+			     fr_reg_check_dup, &check);
+		dups += check.redundant + check.overwritten;
+	}
+
+	free(state);
+
+	return dups;
+}
+
+static int fr_reg_check_seq(const struct fr_reg_file *file, const char *seq,
+			    bool verbose)
+{
+	struct fr_reg_state *state = fr_reg_alloc(NULL, 1, sizeof(*state));
+	struct fr_reg_check check = { .file = file, .quiet = !verbose };
+	unsigned int i, writes = 0;
+	const char *name = seq;
+	size_t len;
+	int ret;
+
+	ret = fr_reg_apply(file, seq, state, fr_reg_check_dup, &check);
+	if (ret)
+		goto out;
+
+	for (i = 0; i < FR_REG_NUM_ADDRS; i++)
+		writes += state->written[i];
+
+	/* Writes issued versus registers actually programmed */
+	for (ret = 0; *name; name += len + (name[len] == ',')) {
+		len = strcspn(name, ",");
+		ret += fr_reg_find_table(file, name, len)->num_entries;
+	}
+
+	printf("%s: %d writes, %u registers, %u redundant, %u overwritten\n",
+	       seq, ret, writes, check.redundant, check.overwritten);
+	ret = 0;
+
+out:
+	free(state);
+
+	return ret;
+}
+
+static int fr_reg_check(const struct fr_reg_file *file, int argc,
+			char *argv[])
+{
+	const char *common = "mode_common_regs";
+	char seq[256];
+	unsigned int i;
+	int dups, ret = 0;
+
+	printf("# duplicate addresses within a table\n");
+	dups = fr_reg_check_tables(file);
+	if (!dups)
+		printf("none\n");
+
+	printf("\n# sequences\n");
+
+	if (argc) {
+		for (i = 0; i < (unsigned int)argc; i++)
+			ret |= fr_reg_check_seq(file, argv[i], true);
+		return ret ? 2 : dups ? 1 : 0;
+	}
+
+	if (!fr_reg_find_table(file, common, strlen(common))) {
+		printf("no %s table\n", common);
+		return dups ? 1 : 0;
+	}
+
+	for (i = 0; i < file->num_tables; i++) {
+		if (!strcmp(file->tables[i].name, common))
+			continue;
+		snprintf(seq, sizeof(seq), "%s,%s", common,
+			 file->tables[i].name);
+		ret |= fr_reg_check_seq(file, seq, false);
+	}
+
+	return ret ? 2 : dups ? 1 : 0;
+}
+
+static void fr_reg_diff_count(const struct fr_reg_state *a,
+			      const struct fr_reg_state *b,
+			      unsigned int *changed, unsigned int *only_a,
+			      unsigned int *only_b)
+{
+	unsigned int i;
+
+	*changed = *only_a = *only_b = 0;
+
+	for (i = 0; i < FR_REG_NUM_ADDRS; i++) {
+		if (a->written[i] && b->written[i])
+			*changed += a->val[i] != b->val[i];
+		else if (a->written[i])
+			(*only_a)++;
+		else if (b->written[i])
+			(*only_b)++;
+	}
+}
+
+static int fr_reg_diff_seq(const struct fr_reg_file *file, const char *seq_a,
+			   const char *seq_b)
+{
+	struct fr_reg_state *a = fr_reg_alloc(NULL, 1, sizeof(*a));
+	struct fr_reg_state *b = fr_reg_alloc(NULL, 1, sizeof(*b));
+	unsigned int i, changed, only_a, only_b;
+	const char *name;
+	int ret;
+
+	ret = fr_reg_apply(file, seq_a, a, NULL, NULL);
+	if (!ret)
+		ret = fr_reg_apply(file, seq_b, b, NULL, NULL);
+	if (ret)
+		goto out;
+
+	printf("%-6s %-20s %6s %6s\n", "addr", "name", "A", "B");
+
+	for (i = 0; i < FR_REG_NUM_ADDRS; i++) {
+		if (!a->written[i] && !b->written[i])
+			continue;
+		if (a->written[i] && b->written[i] && a->val[i] == b->val[i])
+			continue;
+
+		name = b->name[i] ? b->name[i] : a->name[i];
+		printf("0x%04x %-20s ", i, name ? name : "");
+		if (a->written[i])
+			printf("  0x%02x ", a->val[i]);
+		else
+			printf("%6s ", "-");
+		if (b->written[i])
+			printf("  0x%02x\n", b->val[i]);
+		else
+			printf("%6s\n", "-");
+	}
+
+	fr_reg_diff_count(a, b, &changed, &only_a, &only_b);
+
+	/* Registers only A writes keep its value when switching to B */
+	printf("\n%u changed, %u only in A, %u only in B: %u writes to switch from A to B\n",
+	       changed, only_a, only_b, changed + only_b);
+
+out:
+	free(a);
+	free(b);
+
+	return ret ? 2 : 0;
+}
+
+static int fr_reg_diff_modes(const struct fr_reg_file *file)
+{
+	struct fr_reg_state *a = fr_reg_alloc(NULL, 1, sizeof(*a));
+	struct fr_reg_state *b = fr_reg_alloc(NULL, 1, sizeof(*b));
+	const struct fr_reg_table *ta, *tb;
+	unsigned int i, j, changed, only_a, only_b;
+
+	printf("%-28s %-28s %7s %6s %6s\n", "A", "B", "changed", "only A",
+	       "only B");
+
+	for (i = 0; i < file->num_tables; i++) {
+		ta = &file->tables[i];
+		if (strncmp(ta->name, "mode_", 5) ||
+		    !strcmp(ta->name, "mode_common_regs"))
+			continue;
+
+		for (j = i + 1; j < file->num_tables; j++) {
+			tb = &file->tables[j];
+			if (strncmp(tb->name, "mode_", 5) ||
+			    !strcmp(tb->name, "mode_common_regs"))
+				continue;
+
+			fr_reg_apply(file, ta->name, a, NULL, NULL);
+			fr_reg_apply(file, tb->name, b, NULL, NULL);
+			fr_reg_diff_count(a, b, &changed, &only_a, &only_b);
+
+			printf("%-28s %-28s %7u %6u %6u\n", ta->name, tb->name,
+			       changed, only_a, only_b);
+		}
+	}
+
+	free(a);
+	free(b);
+
+	return 0;
+}
+
+static void fr_reg_usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s list  FILE\n"
+		"       %s check FILE [SEQ...]\n"
+		"       %s diff  FILE [SEQ_A SEQ_B]\n"
+		"\n"
+		"SEQ is a comma separated list of tables written in order,\n"
+		"e.g. mode_common_regs,mode_1920x1080,raw12_framefmt_regs\n",
+		argv0, argv0, argv0);
+}
+
+int main(int argc, char *argv[])
+{
+	struct fr_reg_file file;
+	const char *cmd;
+
+	if (argc < 3) {
+		fr_reg_usage(argv[0]);
+		return 2;
+	}
+
+	cmd = argv[1];
+
+	if (fr_reg_parse(&file, argv[2]))
+		return 2;
+
+	if (!strcmp(cmd, "list") && argc == 3)
+		return fr_reg_list(&file);
+	if (!strcmp(cmd, "check"))
+		return fr_reg_check(&file, argc - 3, argv + 3);
+	if (!strcmp(cmd, "diff") && argc == 3)
+		return fr_reg_diff_modes(&file);
+	if (!strcmp(cmd, "diff") && argc == 5)
+		return fr_reg_diff_seq(&file, argv[3], argv[4]);
+
+	fr_reg_usage(argv[0]);
+
+	return 2;
+}